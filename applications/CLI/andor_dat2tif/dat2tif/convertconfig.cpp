@@ -9,7 +9,7 @@ ConvertConfig::ConvertConfig() :
     stride(100),
     imagesperfile(1),
     dt(kipl::base::UInt8),
-    endian(kipl::base::BigEndian),
+    endian(kipl::base::SmallEndian),
     imageindex(0),
     reverseindex(false),
     rotate(false),
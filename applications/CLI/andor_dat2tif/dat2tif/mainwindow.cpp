@@ -58,7 +58,7 @@ void MainWindow::on_buttonProcess_clicked()
                          0,stride,
                          1,
                          static_cast<kipl::base::eDataType>(type),
-                         kipl::base::BigEndian,
+                         kipl::base::SmallEndian,
                          nullptr);
 
     kipl::base::TImage<float,2> img;
@@ -18,6 +18,7 @@
 #include <strings/miscstring.h>
 #include <base/KiplException.h>
 #include <utilities/nodelocker.h>
+#include <profile/Tracer.h>
 
 #include "../../../kiptool/src/ImageIO.h"
 
@@ -67,14 +68,20 @@ int QtKipToolCLI::exec()
             engine=factory.BuildEngine(config,nullptr);
 
               if (engine!=nullptr) {
+                    m_Tracing.setup(args);
                     logger(kipl::logging::Logger::LogMessage, "Loading image");
 
+                    kipl::profile::TraceSpan loadSpan("Load image","io");
                     kipl::base::TImage<float,3> img = LoadVolumeImage(config);
+                    loadSpan.stop();
+                    kipl::profile::Tracer::addCounter("Bytes read",static_cast<double>(img.Size()*sizeof(float)));
+
                     logger(kipl::logging::Logger::LogMessage, "Starting processing");
                     engine->Run(&img);
                     logger(kipl::logging::Logger::LogMessage, "Processing done");
                     engine->SaveImage();
                     logger(kipl::logging::Logger::LogMessage, "Image saved");
+                    m_Tracing.report();
 
               }
               else{
@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <logging/logger.h>
+#include <profile/Tracer.h>
 
 class QCoreApplication;
 
@@ -18,6 +19,7 @@ public:
 private:
      QCoreApplication *app;
      std::vector<std::string> args;
+     kipl::profile::TraceArguments m_Tracing; ///< Trace options trace:file=<filename> and trace:summary=true
 };
 
 #endif // QTKIPTOOLCLI_H
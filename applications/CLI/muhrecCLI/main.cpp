@@ -11,5 +11,9 @@ int main(int argc, char *argv[])
 
     MuhRecCLI reconstructor(&a);
 
-    return reconstructor.exec();
+    int res=reconstructor.exec();
+
+    kipl::logging::Logger::Flush();
+
+    return res;
 }
@@ -2,6 +2,7 @@
 
 #include "stdafx.h"
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <vector>
 
@@ -13,17 +14,22 @@
 #include <ReconEngine.h>
 #include <ReconConfig.h>
 #include <ReconException.h>
+#include <ReconShard.h>
 
 #include <ModuleException.h>
 
 #include <base/KiplException.h>
 #include <strings/filenames.h>
+#include <profile/Tracer.h>
 
 #include "muhreccli.h"
 
 MuhRecCLI::MuhRecCLI(QCoreApplication *a) :
     logger("MuhRecCLI"),
-    app(a)
+    app(a),
+    m_nShardIndex(0),
+    m_nShardCount(1),
+    m_bShardMerge(false)
 {
     QVector<QString> qargs=app->arguments().toVector();
 
@@ -40,6 +46,8 @@ int MuhRecCLI::exec()
     omp_set_nested(1);
 #endif
 
+    setupLogging();
+
     if (2<args.size()) {
         if (args[1]=="-f") {
             logger(kipl::logging::Logger::LogMessage,"MuhRec3 is running in CLI mode");
@@ -51,23 +59,39 @@ int MuhRecCLI::exec()
                 config.GetCommandLinePars(args);
                 config.MatrixInfo.bAutomaticSerialize=true;
 
+                const bool bSharded=setupSharding();
+
+                if (m_bShardMerge) {
+                    logger(kipl::logging::Logger::LogMessage, "Merging the reconstructed shards");
+                    ReconShard::merge(config,m_nShardCount);
+                    writeReconConfig(config);
+
+                    return 0;
+                }
+
+                ReconShard shard(m_nShardIndex,m_nShardCount);
+                if (bSharded && !shard.apply(config)) {
+                    logger(kipl::logging::Logger::LogMessage, "The shard has no slices, skipping reconstruction");
+                    shard.writeManifest(config);
+
+                    return 0;
+                }
+
                 ReconFactory factory;
                 ReconEngine *pEngine=factory.BuildEngine(config,nullptr);
 
                 if (pEngine!=nullptr) {
+                    m_Tracing.setup(args);
                     logger(kipl::logging::Logger::LogMessage, "Starting reconstruction");
                     pEngine->Run3D();
                     logger(kipl::logging::Logger::LogMessage, "Reconstruction done");
+                    m_Tracing.report();
 
-                    std::string confname=config.MatrixInfo.sDestinationPath;
-                    kipl::strings::filenames::CheckPathSlashes(confname,true);
-                    std::string basename=config.MatrixInfo.sFileMask.substr(0,config.MatrixInfo.sFileMask.find_first_of('#'));
-                    confname+=basename+"_recon.xml";
-
-                    ofstream conffile(confname.c_str());
-
-                    conffile<<config.WriteXML();
-                    conffile.close();
+                    // The configuration of a sharded reconstruction is written by the merge
+                    if (bSharded)
+                        shard.writeManifest(config);
+                    else
+                        writeReconConfig(config);
                 }
                 else {
                     logger(kipl::logging::Logger::LogError, "There is no reconstruction engine, skipping reconstruction");
@@ -109,3 +133,63 @@ int MuhRecCLI::exec()
 
     return 0;
 }
+
+void MuhRecCLI::setupLogging()
+{
+    // Lives until the program exits since the logger keeps a reference to the target
+    static std::unique_ptr<kipl::logging::LogStreamWriter> logfile;
+
+    for (const auto &arg : args)
+    {
+        if (arg.find("log:level=")==0)
+        {
+            kipl::logging::Logger::LogLevel level;
+            try {
+                string2enum(arg.substr(std::string("log:level=").size()),level);
+                kipl::logging::Logger::SetLogLevel(level);
+            }
+            catch (kipl::base::KiplException &e) {
+                logger.warning("Ignoring the argument "+arg+": "+e.what());
+            }
+        }
+
+        if ((arg.find("log:file=")==0) && !logfile)
+        {
+            logfile.reset(new kipl::logging::LogStreamWriter(arg.substr(std::string("log:file=").size())));
+            kipl::logging::Logger::AddLogTarget(*logfile);
+        }
+
+        if (arg=="log:async=true")
+            kipl::logging::Logger::SetAsynchronous(true);
+    }
+}
+
+bool MuhRecCLI::setupSharding()
+{
+    for (const auto &arg : args)
+    {
+        if (arg.find("shard:index=")==0)
+            m_nShardIndex=std::stoul(arg.substr(std::string("shard:index=").size()));
+
+        if (arg.find("shard:count=")==0)
+            m_nShardCount=std::stoul(arg.substr(std::string("shard:count=").size()));
+
+        if (arg=="shard:merge=true")
+            m_bShardMerge=true;
+    }
+
+    return (1<m_nShardCount);
+}
+
+void MuhRecCLI::writeReconConfig(ReconConfig &config)
+{
+    std::string confname=config.MatrixInfo.sDestinationPath;
+    kipl::strings::filenames::CheckPathSlashes(confname,true);
+    std::string basename=config.MatrixInfo.sFileMask.substr(0,config.MatrixInfo.sFileMask.find_first_of('#'));
+    confname+=basename+"_recon.xml";
+
+    ofstream conffile(confname.c_str());
+
+    conffile<<config.WriteXML();
+    conffile.close();
+}
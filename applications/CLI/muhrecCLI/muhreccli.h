@@ -4,8 +4,10 @@
 #include <string>
 #include <vector>
 #include <logging/logger.h>
+#include <profile/Tracer.h>
 
 class QCoreApplication;
+class ReconConfig;
 
 class MuhRecCLI
 {
@@ -16,8 +18,21 @@ public:
     int exec();
 
 private:
+    /// \brief Configures the logging from the arguments log:level=<level>, log:file=<filename> and log:async=true.
+    /// The asynchronous mode writes the messages from a background thread.
+    void setupLogging();
+    /// \brief Reads the sharding arguments shard:index=<k>, shard:count=<n> and shard:merge=true.
+    /// \returns true if the reconstruction is split into shards
+    bool setupSharding();
+    /// \brief Writes the configuration used for the reconstruction as <basename>_recon.xml to the destination path.
+    void writeReconConfig(ReconConfig &config);
+
     QCoreApplication *app;
     std::vector<std::string> args;
+    kipl::profile::TraceArguments m_Tracing; ///< Trace options trace:file=<filename> and trace:summary=true
+    size_t m_nShardIndex;  ///< Index of the slice range shard reconstructed by this process
+    size_t m_nShardCount;  ///< Number of shards the reconstruction is split into, 1 means no sharding
+    bool m_bShardMerge;    ///< Merge the results of the shards instead of reconstructing
 };
 
 #endif // MUHRECCLI_H
@@ -2,6 +2,7 @@
 #include <iostream>
 #include <sstream>
 #include <map>
+#include <memory>
 
 #include <QCoreApplication>
 #include <QVector>
@@ -12,6 +13,8 @@
 #include <base/timage.h>
 #include <base/KiplException.h>
 #include <base/kiplenums.h>
+#include <base/trotate.h>
+#include <io/io_multiframetiff.h>
 #include <logging/logger.h>
 #include <strings/filenames.h>
 
@@ -61,9 +64,19 @@ int process(int argc, char *argv[])
     ImageReader reader;
 
     std::string srcfname=args["infile"];
+    // Multi-frame TIFFs are read through the frame index, the file is opened once instead of once per frame
+    std::unique_ptr<kipl::io::MultiFrameTIFF> tiffreader;
     qDebug() << "Pre size check";
     try {
-        nDims=reader.GetImageSize(srcfname,1.0f,dims);
+        if (readers::GetFileExtensionType(srcfname)==readers::ExtensionTIFF) {
+            tiffreader.reset(new kipl::io::MultiFrameTIFF(srcfname));
+            dims[0]=tiffreader->dims()[0];
+            dims[1]=tiffreader->dims()[1];
+            dims[2]=tiffreader->frames();
+            nDims=dims[2]<2 ? 2 : 3;
+        }
+        else
+            nDims=reader.GetImageSize(srcfname,1.0f,dims);
     } catch (ReaderException &e) {
         logger.error(e.what());
         exit(0);
@@ -122,9 +135,15 @@ int process(int argc, char *argv[])
     std::string destname,ext;
     ImageWriter writer;
     kipl::base::TImage<float,2> img;
+    kipl::base::TRotate<float> rotator;
     try {
         for (int i=first; i<=last; ++i) {
-            img=reader.Read(srcfname,kipl::base::ImageFlipNone,rotate,1.0,nullptr,i);
+            if (tiffreader) {
+                tiffreader->read(img,static_cast<size_t>(i));
+                img=rotator.Rotate(img,kipl::base::ImageFlipNone,rotate);
+            }
+            else
+                img=reader.Read(srcfname,kipl::base::ImageFlipNone,rotate,1.0,nullptr,i);
             kipl::strings::filenames::MakeFileName(fmask,i,destname,ext,'#','0');
 
             writer.write(img,destname);
@@ -206,7 +225,7 @@ int showHelp()
     std::cout<<"Usage: multiframesplitter [args] \n";
     std::cout<<"(c) Anders Kaestner, 2018\n";
     std::cout<<"Arguments:\n";
-    std::cout<<"-i <file name> : The image file to split can be either a multi-frame fits or vivaseq\n";
+    std::cout<<"-i <file name> : The image file to split can be either a multi-frame tiff, fits or vivaseq\n";
     std::cout<<"-o <file_#####.tif> : The file mask of the output images. If skiped the base name of the input is used with index. \n";
     std::cout<<"-first <value> : first frame default is first=0\n";
     std::cout<<"-last <value> : last frame, default is the last available frame\n";
@@ -14,6 +14,7 @@
 #include <base/timage.h>
 #include <base/KiplException.h>
 #include <base/kiplenums.h>
+#include <io/io_stackreslicer.h>
 #include <logging/logger.h>
 #include <strings/filenames.h>
 
@@ -64,24 +65,29 @@ int process(int argc, char *argv[])
     size_t slicex=dims[1]/2;
     size_t slicey=dims[0]/2;
 
-    kipl::base::TImage<float,2> img;
-
     size_t dimsXZ[2]={dims[0],last-first+1};
     kipl::base::TImage<float,2> sliceXZ(dimsXZ);
 
     size_t dimsYZ[2]={dims[1],last-first+1};
     kipl::base::TImage<float,2> sliceYZ(dimsYZ);
 
-    for (size_t i=first; i<=last; ++i) {
-        img=reader.Read("",srcfname,i,kipl::base::ImageFlipNone,kipl::base::ImageRotateNone,1.0,nullptr);
-        std::copy_n(img.GetLinePtr(slicex),img.Size(0),sliceXZ.GetLinePtr(i-first));
-
-        float *pLine=sliceYZ.GetLinePtr(i-first);
-        float *pImg=img.GetDataPtr()+slicey;
-        for (size_t j=0; j<img.Size(1); ++j) {
-            pLine[j]=pImg[j*img.Size(0)];
-        }
-    }
+    // The slices are read in parallel, each call uses its own reader
+    kipl::io::StackReslicer reslicer(dims[0],dims[1],last-first+1,sizeof(float));
+    reslicer.AddPlanes(kipl::base::ImagePlaneXZ,slicex,slicex);
+    reslicer.AddPlanes(kipl::base::ImagePlaneYZ,slicey,slicey);
+
+    reslicer.Process(
+        [&](size_t index, char *slice) {
+            ImageReader slicereader;
+            kipl::base::TImage<float,2> img=slicereader.Read("",srcfname,first+index,kipl::base::ImageFlipNone,kipl::base::ImageRotateNone,1.0,nullptr);
+            if ((img.Size(0)!=dims[0]) || (img.Size(1)!=dims[1]))
+                throw kipl::base::KiplException("The slices have different sizes",__FILE__,__LINE__);
+            std::copy_n(img.GetDataPtr(),img.Size(),reinterpret_cast<float *>(slice));
+        },
+        [&](kipl::base::eImagePlanes plane, size_t /*position*/, const char *data, size_t width, size_t height) {
+            kipl::base::TImage<float,2> &res = plane==kipl::base::ImagePlaneXZ ? sliceXZ : sliceYZ;
+            std::copy_n(reinterpret_cast<const float *>(data),width*height,res.GetDataPtr());
+        });
 
     ImageWriter writer;
 
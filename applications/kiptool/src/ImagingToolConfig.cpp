@@ -340,6 +340,7 @@ ImagingToolConfig::FileConversionConfig::FileConversionConfig() :
     nImgSizeX(100),
     nImgSizeY(100),
     datatype(kipl::base::UInt16),
+    endian(kipl::base::SmallEndian),
     bCrop(false),
     flip(kipl::base::ImageFlipNone),
     rotate(kipl::base::ImageRotateNone),
@@ -414,6 +415,9 @@ void ImagingToolConfig::FileConversionConfig::ParseXML(xmlTextReaderPtr reader)
             if (sName=="datatype") {
                 string2enum(sValue,datatype);
             }
+            if (sName=="endian") {
+                string2enum(sValue,endian);
+            }
 
 			if (sName=="dstpath")
 				sDestPath=sValue;
@@ -491,6 +495,7 @@ std::string ImagingToolConfig::FileConversionConfig::WriteXML(int indent)
         xml<<std::setw(indent+blockindent)<<" "<<"<sizex>"<<nImgSizeX<<"</sizex>\n";
         xml<<std::setw(indent+blockindent)<<" "<<"<sizey>"<<nImgSizeY<<"</sizey>\n";
         xml<<std::setw(indent+blockindent)<<" "<<"<datatype>"<<enum2string(datatype)<<"</datatype>\n";
+        xml<<std::setw(indent+blockindent)<<" "<<"<endian>"<<enum2string(endian)<<"</endian>\n";
 		xml<<std::setw(indent+blockindent)<<" "<<"<crop>"<<(bCrop ? "true":"false")<<"</crop>\n";
 		xml<<std::setw(indent+blockindent)<<" "<<"<roi>"<<nCrop[0]<<" "
 				<<nCrop[1]<<" "
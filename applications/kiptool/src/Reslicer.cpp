@@ -13,13 +13,13 @@
 #include <strings/filenames.h>
 #include <strings/miscstring.h>
 #include <base/KiplException.h>
+#include <io/io_stackreslicer.h>
 
 #include "Reslicer.h"
 
 
 TIFFReslicer::TIFFReslicer() :
     logger("TIFFReslicer"),
-    m_nMaxBlock(128),
     m_sSourceMask("/data/slices_####.tif"),
     m_sDestinationPath("/data"),
     m_sDestinationMask("verticalslices_####.tif"),
@@ -27,32 +27,22 @@ TIFFReslicer::TIFFReslicer() :
     m_nFirst(0),
     m_nLast(100),
     m_nFirstXZ(0),
-    m_nLastXZ(0),
+    m_nLastXZ(-1),
     m_nFirstYZ(0),
-    m_nLastYZ(0),
+    m_nLastYZ(-1),
 
     m_bResliceXZ(true),
     m_bResliceYZ(true),
+    m_nMemoryBudget(size_t(4)<<30),
 
-    m_nSliceCount(0),
-    m_nCurrentFile(0),
-    m_nCurrentBlock(0),
-    m_nBlocks(0),
-    buffer(nullptr)
+    m_nBytesPerPixel(0)
 {
-	memset(m_DstImages,0,m_nMaxBlock*sizeof(TIFF *));
+    m_nImageDims[0]=0;
+    m_nImageDims[1]=0;
     TIFFSetWarningHandler(nullptr);
 }
 
 TIFFReslicer::~TIFFReslicer() {
-	for (size_t i=0; i<m_nMaxBlock; i++) {
-        if (m_DstImages[i]!=nullptr) {
-			TIFFClose(m_DstImages[i]);
-            m_DstImages[i]=nullptr;
-        }
-	}
-    if (buffer!=nullptr)
-		delete [] buffer;
 }
 
 std::string TIFFReslicer::WriteXML(size_t indent)
@@ -65,6 +55,7 @@ std::string TIFFReslicer::WriteXML(size_t indent)
         xml<<std::setw(indent+blockindent)<<" "<<"<dstpath>"<<m_sDestinationPath<<"</dstpath>\n";
         xml<<std::setw(indent+blockindent)<<" "<<"<first>"<<m_nFirst<<"</first>\n";
         xml<<std::setw(indent+blockindent)<<" "<<"<last>"<<m_nLast<<"</last>\n";
+        xml<<std::setw(indent+blockindent)<<" "<<"<planeranges>"<<kipl::strings::bool2string(true)<<"</planeranges>\n";
         xml<<std::setw(indent+blockindent)<<" "<<"<reslicexz>"<<kipl::strings::bool2string(m_bResliceXZ)<<"</reslicexz>\n";
         xml<<std::setw(indent+blockindent)<<" "<<"<firstxz>"<<m_nFirstXZ<<"</firstxz>\n";
         xml<<std::setw(indent+blockindent)<<" "<<"<lastxz>"<<m_nLastXZ<<"</lastxz>\n";
@@ -107,6 +98,9 @@ void TIFFReslicer::ParseXML(std::string fname)
 
         logger.verbose("Got reslice project");
 
+        // Configurations written before the plane ranges were applied store 0 as last plane but meant all planes
+        bool bPlaneRanges=false;
+
         ret = xmlTextReaderRead(reader);
 
         while (ret == 1) {
@@ -140,6 +134,9 @@ void TIFFReslicer::ParseXML(std::string fname)
                 if (sName=="last")
                     m_nLast  = std::stoi(sValue);
 
+                if (sName=="planeranges")
+                    bPlaneRanges   = kipl::strings::string2bool(sValue);
+
                 if (sName=="reslicexz")
                     m_bResliceXZ   = kipl::strings::string2bool(sValue);
 
@@ -169,6 +166,14 @@ void TIFFReslicer::ParseXML(std::string fname)
             logger.error(str.str());
             throw kipl::base::KiplException(str.str(),__FILE__,__LINE__);
         }
+
+        if (!bPlaneRanges) {
+            logger.message("The configuration has no plane ranges, all planes will be resliced");
+            m_nFirstXZ = 0;
+            m_nLastXZ  = -1;
+            m_nFirstYZ = 0;
+            m_nLastYZ  = -1;
+        }
     } else {
         std::stringstream str;
         str<<"Reslicer config could not open "<<fname;
@@ -194,46 +199,46 @@ int TIFFReslicer::process()
 
     std::ostringstream msg;
 
-    if (m_bResliceXZ){
-        fmask=a+"XZ_"+b;
-        logger(kipl::logging::Logger::LogMessage,fmask);
-        try {
-            process(m_sSourceMask,m_nFirst,m_nLast,fmask,kipl::base::ImagePlaneXZ);
-        }
-        catch (kipl::base::KiplException &E) {
-            msg.str("");
-            msg<<"XZ-Reslicing failed with an exception\n"<<E.what();
-            logger(kipl::logging::Logger::LogError,msg.str());
+    // Both orientations are produced in the same pass over the slices
+    std::string sMaskXZ = m_bResliceXZ ? a+"XZ_"+b : std::string();
+    std::string sMaskYZ = m_bResliceYZ ? a+"YZ_"+b : std::string();
 
-            return -1;
-        }
-        logger(kipl::logging::Logger::LogMessage,"Reslice XZ done.");
+    if (sMaskXZ.empty() && sMaskYZ.empty())
+        return 0;
 
+    try {
+        reslice(m_sSourceMask,m_nFirst,m_nLast,sMaskXZ,sMaskYZ);
     }
+    catch (kipl::base::KiplException &E) {
+        msg.str("");
+        msg<<"Reslicing failed with an exception\n"<<E.what();
+        logger(kipl::logging::Logger::LogError,msg.str());
 
-    if (m_bResliceYZ) {
-        fmask=a+"YZ_"+b;
-        logger(kipl::logging::Logger::LogMessage,fmask);
-        try {
-            process(m_sSourceMask,m_nFirst,m_nLast,fmask,kipl::base::ImagePlaneYZ);
-        }
-        catch (kipl::base::KiplException &E) {
-            msg.str("");
-            msg<<"YZ-Reslicing failed with an exception\n"<<E.what();
-            logger(kipl::logging::Logger::LogError,msg.str());
-
-            return -1;
-        }
-        logger(kipl::logging::Logger::LogMessage,"Reslice YZ done.");
+        return -1;
     }
+    logger(kipl::logging::Logger::LogMessage,"Reslicing done.");
 
+    return 0;
+}
 
-
+int TIFFReslicer::process(std::string sSrcMask, int nFirst, int nLast, std::string sDstMask, kipl::base::eImagePlanes plane)
+{
+    switch (plane) {
+    case kipl::base::ImagePlaneXY :
+        logger(kipl::logging::Logger::LogWarning,"Plane XY is irrelevant for the reslicer.");
+        return -1;
+    case kipl::base::ImagePlaneXZ :
+        reslice(sSrcMask,nFirst,nLast,sDstMask,std::string());
+        break;
+    case kipl::base::ImagePlaneYZ :
+        reslice(sSrcMask,nFirst,nLast,std::string(),sDstMask);
+        break;
+    }
 
     return 0;
 }
 
-int TIFFReslicer::process(std::string sSrcMask, int nFirst, int nLast, std::string sDstMask, kipl::base::eImagePlanes plane)
+void TIFFReslicer::reslice(std::string sSrcMask, int nFirst, int nLast, std::string sMaskXZ, std::string sMaskYZ)
 {
 	std::ostringstream msg;
 	std::string fname, ext;
@@ -250,145 +255,59 @@ int TIFFReslicer::process(std::string sSrcMask, int nFirst, int nLast, std::stri
 		throw kipl::base::KiplException(e.what(),__FILE__,__LINE__);
 	}
 
+    if (nLast<nFirst)
+        throw kipl::base::KiplException("The last slice index is less than the first",__FILE__,__LINE__);
 
-	size_t nSliceBlocks = 0;
-	size_t nBlockRest   = 0;
-    size_t nImages      = static_cast<size_t>(nLast - nFirst + 1);
-
-    m_nBytesPerReadLine = m_nBytesPerPixel * m_nImageDims[0];
-	switch (plane) {
-			case kipl::base::ImagePlaneXY : logger(kipl::logging::Logger::LogWarning,"Plane XY is irrelevant for the reslicer."); return -1;
-			case kipl::base::ImagePlaneXZ :
-                m_nBytesPerWriteLine = m_nBytesPerPixel * m_nImageDims[0];
-				nSliceBlocks = m_nImageDims[1] / m_nMaxBlock;
-				nBlockRest   = m_nImageDims[1] % m_nMaxBlock;
-				break;
-			case kipl::base::ImagePlaneYZ :
-                m_nBytesPerWriteLine = m_nBytesPerPixel * m_nImageDims[1];
-                nSliceBlocks = m_nImageDims[0] / m_nMaxBlock;
-                nBlockRest   = m_nImageDims[0] % m_nMaxBlock;
-				break;
-	}
-
-	size_t nFirstSlice=0;
-	size_t nLastSlice=0;
-	size_t nBlock=0;
-
-    char *pLineBuffer=new char[m_nBytesPerWriteLine+16];
-
-	try {
-		for (nBlock=0; nBlock<nSliceBlocks; nBlock++) {
-			size_t nFirstSlice = nBlock*m_nMaxBlock;
-			size_t nLastSlice  = (nBlock+1)*m_nMaxBlock-1;
-
-                switch (plane) {
-                case kipl::base::ImagePlaneXY :
-                    logger(kipl::logging::Logger::LogWarning,"Plane XY is irrelevant for the reslicer.");
-                    return -1;
-                case kipl::base::ImagePlaneXZ :
-                    CreateHeaders(sDstMask,nFirstSlice,nLastSlice,m_nImageDims[0],nImages);
-                    break;
-                case kipl::base::ImagePlaneYZ :
-                    CreateHeaders(sDstMask,nFirstSlice,nLastSlice,m_nImageDims[1],nImages); // now YZ images have the right dimensions
-                    break;
-                }
+    const size_t nImages = static_cast<size_t>(nLast - nFirst + 1);
+    const size_t nWidth  = static_cast<size_t>(m_nImageDims[0]);
+    const size_t nHeight = static_cast<size_t>(m_nImageDims[1]);
+    const size_t nSliceBytes = nWidth*nHeight*m_nBytesPerPixel;
 
+    kipl::io::StackReslicer reslicer(nWidth,nHeight,nImages,m_nBytesPerPixel);
+    reslicer.SetMemoryBudget(m_nMemoryBudget);
 
+    size_t nPlaneFirst=0;
+    size_t nPlaneLast=0;
+    if (!sMaskXZ.empty()) {
+        PlaneRange(m_nFirstXZ,m_nLastXZ,nHeight,nPlaneFirst,nPlaneLast);
+        reslicer.AddPlanes(kipl::base::ImagePlaneXZ,nPlaneFirst,nPlaneLast);
+    }
 
-            for (int nFileIndex=nFirst; nFileIndex<=nLast; nFileIndex++) {
-				kipl::strings::filenames::MakeFileName(sSrcMask,nFileIndex,fname,ext,'#','0');
-				LoadBuffer(fname);
-                msg.str("");
-                msg<<"Bytes/pixel="<<m_nBytesPerPixel<<", Bytes/line="<<m_nBytesPerReadLine<<", dims="<<m_nImageDims[0]<<", "<<m_nImageDims[1];
-             //   logger(kipl::logging::Logger::LogMessage,msg.str());
-                for (int nSliceIndex=0; nSliceIndex<m_nMaxBlock; nSliceIndex++) {
-                    int idx=nSliceIndex+nFirstSlice;
-					if (plane == kipl::base::ImagePlaneXZ )
-                        WriteLine(m_DstImages[nSliceIndex],nFileIndex-nFirst,m_nBytesPerWriteLine, buffer+idx*m_nBytesPerReadLine);
-					else {
-
-                        for (int i=0; i<m_nImageDims[1]; i++) {
-//                            std::copy_n(buffer+idx*m_nBytesPerPixel+i*m_nBytesPerLine,pLineBuffer+i*m_nBytesPerPixel,m_nBytesPerPixel);
-                            for (int j=0; j<m_nBytesPerPixel; j++) {
-                                pLineBuffer[i*m_nBytesPerPixel+j]=buffer[idx*m_nBytesPerPixel+i*m_nBytesPerReadLine+j];
-                            }
-                        }
-                        WriteLine(m_DstImages[nSliceIndex],nFileIndex-nFirst,m_nBytesPerWriteLine,pLineBuffer);
-					}
-
-				}
-			}
-            CloseImages(m_nMaxBlock);
-		}
-	}
-	catch (kipl::base::KiplException & e)
-	{
-		msg.str("");
-		msg<<"Failed during full block processing with exception:\n"<<e.what();
-		throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-	}
-	catch (std::exception & e)
-	{
-		msg.str("");
-		msg<<"Failed during full block processing with exception:\n"<<e.what();
-		throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-	}
+    if (!sMaskYZ.empty()) {
+        PlaneRange(m_nFirstYZ,m_nLastYZ,nWidth,nPlaneFirst,nPlaneLast);
+        reslicer.AddPlanes(kipl::base::ImagePlaneYZ,nPlaneFirst,nPlaneLast);
+    }
 
-    // Handling the block rest
-    try {
-        if (nBlockRest!=0) {
-            nFirstSlice = nSliceBlocks*m_nMaxBlock;
-            nLastSlice  = nFirstSlice+nBlockRest;
-
-            switch (plane)
-            {
-            case kipl::base::ImagePlaneXY :
-                logger(kipl::logging::Logger::LogWarning,"Plane XY is irrelevant for the reslicer.");
-                return -1;
-            case kipl::base::ImagePlaneXZ :
-                CreateHeaders(sDstMask,nFirstSlice,nLastSlice,m_nImageDims[0],nImages);
-                break;
-            case kipl::base::ImagePlaneYZ :
-                CreateHeaders(sDstMask,nFirstSlice,nLastSlice,m_nImageDims[1],nImages); // now YZ images have the right dimensions
-                break;
-            }
+    msg.str("");
+    msg<<"Reslicing "<<nImages<<" slices ("<<nWidth<<"x"<<nHeight<<", "<<m_nBytesPerPixel<<" bytes/pixel) into "
+       <<reslicer.PlaneCount()<<" planes, "<<reslicer.ChunkDepth()<<" slices per chunk";
+    logger(kipl::logging::Logger::LogMessage,msg.str());
+
+    reslicer.Process(
+        [&](size_t index, char *slice) {
+            std::string srcname, srcext;
+            kipl::strings::filenames::MakeFileName(sSrcMask,nFirst+static_cast<int>(index),srcname,srcext,'#','0');
+            LoadBuffer(srcname,slice,nSliceBytes);
+        },
+        [&](kipl::base::eImagePlanes plane, size_t position, const char *data, size_t width, size_t height) {
+            std::string dstname, dstext;
+            kipl::strings::filenames::MakeFileName(plane==kipl::base::ImagePlaneXZ ? sMaskXZ : sMaskYZ,
+                                                   static_cast<int>(position),dstname,dstext,'#','0');
+            WritePlane(dstname,data,width,height);
+        });
+}
 
-            for (int nFileIndex=nFirst; nFileIndex<=nLast; nFileIndex++) {
-                kipl::strings::filenames::MakeFileName(sSrcMask,nFileIndex,fname,ext,'#','0');
-                LoadBuffer(fname);
-
-                for (size_t nSliceIndex=0; nSliceIndex<nBlockRest; nSliceIndex++) {
-                    int idx=nSliceIndex+nFirstSlice;
-                    if (plane == kipl::base::ImagePlaneXZ )
-                        WriteLine(m_DstImages[nSliceIndex],nFileIndex-nFirst,m_nBytesPerWriteLine,buffer+idx*m_nBytesPerReadLine);
-                    else {
-                        for (int i=0; i<m_nImageDims[1]; i++)
-                            for (int j=0; j<m_nBytesPerPixel; j++)
-                                pLineBuffer[i*m_nBytesPerPixel+j]=buffer[idx*m_nBytesPerPixel+i*m_nBytesPerReadLine+j];
-
-                        WriteLine(m_DstImages[nSliceIndex],nFileIndex-nFirst, m_nBytesPerWriteLine,pLineBuffer);
-                    }
-                }
-            }
-            CloseImages(nBlockRest);
-        }
-    }
-    catch (kipl::base::KiplException & e)
-    {
-        msg.str("");
-        msg<<"Failed during rest block processing with kipl exception:\n"<<e.what();
-        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-    }
-    catch (std::exception & e)
-    {
-        msg.str("");
-        msg<<"Failed during rest block processing with STL exception:\n"<<e.what();
-        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+void TIFFReslicer::PlaneRange(int first, int last, size_t nLimit, size_t &nFirst, size_t &nLast)
+{
+    // A negative or inverted range selects all planes, the range is clipped to the slice size
+    if ((last<0) || (last<first)) {
+        nFirst = 0;
+        nLast  = nLimit-1;
+        return;
     }
 
-	delete [] pLineBuffer;
-
-	return 0;
+    nLast  = std::min(static_cast<size_t>(last),nLimit-1);
+    nFirst = std::min(static_cast<size_t>(std::max(first,0)),nLast);
 }
 
 float TIFFReslicer::progress()
@@ -465,82 +384,42 @@ int TIFFReslicer::GetHeader(std::string fname)
 	return 0;
 }
 
-int TIFFReslicer::LoadBuffer(std::string fname)
+void TIFFReslicer::LoadBuffer(std::string fname, char *pBuffer, size_t nBufferSize)
 {
 	std::stringstream msg;
 	TIFF *image;
-	uint16 photo, spp, fillorder,bps, sformat;
-	tsize_t stripSize, stripCount;
-	unsigned long imageOffset;
-	long result;
-	int stripMax;
-	unsigned char tempbyte;
-	unsigned long bufferSize, count;
+	uint16 photo, spp, fillorder, bps;
+	uint32 dimx=0, dimy=0;
 
-    TIFFSetWarningHandler(nullptr);
 	// Open the TIFF image
     if((image = TIFFOpen(fname.c_str(), "r")) == nullptr){
-		msg.str();
 		msg<<"LoadBuffer: Could not open image "<<fname;
 		throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
 	}
 
-	// Check that it is of a type that we support
-	if((TIFFGetField(image, TIFFTAG_BITSPERSAMPLE, &bps) == 0) ){
-		throw kipl::base::KiplException("LoadBuffer: Either undefined or unsupported number of bits per pixel",__FILE__,__LINE__);
-	}
-    m_nBytesPerPixel=bps/8;
-
-	if((TIFFGetField(image, TIFFTAG_SAMPLEFORMAT, &sformat) == 0) ){
-		sformat=1; // Assuming unsigned integer data if unknown
-	}
-	//std::cout<<"sformat "<<sformat<<std::endl;
+    TIFFGetField(image, TIFFTAG_IMAGEWIDTH,  &dimx);
+    TIFFGetField(image, TIFFTAG_IMAGELENGTH, &dimy);
 
-	if((TIFFGetField(image, TIFFTAG_SAMPLESPERPIXEL, &spp) == 0) || (spp != 1)){
-		throw kipl::base::KiplException("LoadBuffer: Either undefined or unsupported number of samples per pixel",__FILE__,__LINE__);
-	}
-
-	// Read in the possibly multiple strips
-	stripSize = TIFFStripSize (image);
-	stripMax = TIFFNumberOfStrips (image);
-	imageOffset = 0;
-
-	//bufferSize = TIFFNumberOfStrips (image) * stripSize * stripMax;
-	bufferSize = stripSize * stripMax;
-	//std::cout<<"buffer size: "<<bufferSize<<", number of strips:"<<TIFFNumberOfStrips (image)<<", stripSize:" <<stripSize<<", stripMax:"<<stripMax<<std::endl;
-
-	try {
-        if (buffer!=nullptr) {
-			delete [] buffer;
-            buffer=nullptr;
-		}
-        if((buffer = new char[bufferSize]) == nullptr){
-			msg.str("");
-			msg<<"LoadBuffer: Could not allocate"<<bufferSize<<" bytes for the uncompressed image";
-			throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-		}
-	}
-	catch (std::bad_alloc & E) {
-		msg.str("");
-		msg<<"LoadBuffer: Could not allocate"<<bufferSize<<" bytes for the uncompressed image ("<<E.what()<<")";
-		throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-	}
-	catch (kipl::base::KiplException &E) {
-		throw E;
+	// Check that it is of a type that we support
+    if ((TIFFGetField(image, TIFFTAG_BITSPERSAMPLE, &bps) == 0) || (bps/8 != static_cast<uint16>(m_nBytesPerPixel)) ||
+        (TIFFGetField(image, TIFFTAG_SAMPLESPERPIXEL, &spp) == 0) || (spp != 1) ||
+        (dimx != static_cast<uint32>(m_nImageDims[0])) || (dimy != static_cast<uint32>(m_nImageDims[1]))) {
+        TIFFClose(image);
+        msg<<"LoadBuffer: The format of "<<fname<<" doesn't match the first slice";
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
 	}
 
-
-    int dimx,dimy;
-	// We need to set some values for basic tags before we can add any data
-    TIFFGetField(image, TIFFTAG_IMAGEWIDTH,&dimx);
-	TIFFGetField(image, TIFFTAG_IMAGELENGTH, &dimy);
-
-	for (stripCount = 0; stripCount < stripMax; stripCount++){
-		if((result = TIFFReadEncodedStrip (image, stripCount,
-						  buffer + imageOffset,
-						  stripSize)) == -1){
-			msg.str("");
-			msg<<"Read error on input strip number "<<static_cast<size_t>(stripCount);
+	// Read in the possibly multiple strips, the last strip can be shorter
+	tsize_t stripSize = TIFFStripSize (image);
+	tstrip_t stripMax = TIFFNumberOfStrips (image);
+	size_t imageOffset = 0;
+
+	for (tstrip_t stripCount = 0; (stripCount < stripMax) && (imageOffset < nBufferSize); stripCount++){
+		const tsize_t nRead = static_cast<tsize_t>(std::min(static_cast<size_t>(stripSize),nBufferSize-imageOffset));
+		tsize_t result = TIFFReadEncodedStrip (image, stripCount, pBuffer + imageOffset, nRead);
+		if (result == -1) {
+			TIFFClose(image);
+			msg<<"Read error on input strip number "<<static_cast<size_t>(stripCount)<<" of "<<fname;
 			throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
 		}
 		imageOffset += result;
@@ -548,15 +427,14 @@ int TIFFReslicer::LoadBuffer(std::string fname)
 
 	// Deal with photometric interpretations
 	if(TIFFGetField(image, TIFFTAG_PHOTOMETRIC, &photo) == 0){
+		TIFFClose(image);
 		throw kipl::base::KiplException("Image has an undefined photometric interpretation",__FILE__,__LINE__);
 	}
 
 	if(photo == PHOTOMETRIC_MINISWHITE){
 		// Flip bits
-		logger(kipl::logging::Logger::LogWarning,"Fixing the photometric interpretation");
-
-		for(count = 0; count < bufferSize; count++)
-			buffer[count] = ~buffer[count];
+		for(size_t count = 0; count < nBufferSize; count++)
+			pBuffer[count] = ~pBuffer[count];
 	}
 
 	// Deal with fillorder
@@ -566,96 +444,61 @@ int TIFFReslicer::LoadBuffer(std::string fname)
 
 	if(fillorder != FILLORDER_MSB2LSB){
 		// We need to swap bits -- ABCDEFGH becomes HGFEDCBA
-		logger(kipl::logging::Logger::LogWarning,"Fixing the fillorder");
-
-		for(count = 0; count < bufferSize; count++){
-			tempbyte = 0;
-			if(buffer[count] & 128) tempbyte += (char)1;
-			if(buffer[count] & 64) tempbyte += (char)2;
-			if(buffer[count] & 32) tempbyte += (char)4;
-			if(buffer[count] & 16) tempbyte += (char)8;
-			if(buffer[count] & 8) tempbyte += (char)16;
-			if(buffer[count] & 4) tempbyte += (char)32;
-			if(buffer[count] & 2) tempbyte += (char)64;
-			if(buffer[count] & 1) tempbyte += (char)128;
-			buffer[count] = tempbyte;
+		for(size_t count = 0; count < nBufferSize; count++){
+			unsigned char tempbyte = 0;
+			if(pBuffer[count] & 128) tempbyte += (char)1;
+			if(pBuffer[count] & 64) tempbyte += (char)2;
+			if(pBuffer[count] & 32) tempbyte += (char)4;
+			if(pBuffer[count] & 16) tempbyte += (char)8;
+			if(pBuffer[count] & 8) tempbyte += (char)16;
+			if(pBuffer[count] & 4) tempbyte += (char)32;
+			if(pBuffer[count] & 2) tempbyte += (char)64;
+			if(pBuffer[count] & 1) tempbyte += (char)128;
+			pBuffer[count] = tempbyte;
 		}
 	}
 
 	TIFFClose(image);
-
-	return bps;
 }
 
-int TIFFReslicer::CreateHeaders(std::string mask, size_t nFirst, size_t nLast, size_t width, size_t height)
+void TIFFReslicer::WritePlane(std::string fname, const char *pData, size_t width, size_t height)
 {
 	std::ostringstream msg;
-	msg<<"Creating headers for slabs "<<nFirst<<"-"<<nLast;
-	logger(kipl::logging::Logger::LogMessage,msg.str());
+	TIFF *image;
 
-	std::string fname,ext;
+    if((image = TIFFOpen(fname.c_str(), "w")) == nullptr){
+		msg<<"WritePlane: Could not open "<<fname<<" for writing";
+		throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+	}
 
-	for (size_t idx=nFirst, i=0; idx<=nLast; idx++, i++) {
-		kipl::strings::filenames::MakeFileName(mask,idx,fname,ext,'#','0');
-        if((m_DstImages[i] = TIFFOpen(fname.c_str(), "w")) == nullptr){
-			msg.str("");
-			msg<<"WriteTIFF: Could not open "<<fname<<" for writing";
-			logger(kipl::logging::Logger::LogError,msg.str());
+	TIFFSetField(image, TIFFTAG_IMAGEWIDTH,      static_cast<uint32>(width));
+	TIFFSetField(image, TIFFTAG_IMAGELENGTH,     static_cast<uint32>(height));
+	TIFFSetField(image, TIFFTAG_BITSPERSAMPLE,   m_SrcInfo.nBitsPerSample);
+	TIFFSetField(image, TIFFTAG_SAMPLESPERPIXEL, m_SrcInfo.nSamplesPerPixel);
+	TIFFSetField(image, TIFFTAG_SAMPLEFORMAT,    m_SrcInfo.nSampleFormat);
+	TIFFSetField(image, TIFFTAG_ROWSPERSTRIP,    TIFFDefaultStripSize(image,0));
+
+	TIFFSetField(image, TIFFTAG_COMPRESSION,     COMPRESSION_NONE);
+	TIFFSetField(image, TIFFTAG_PHOTOMETRIC,     PHOTOMETRIC_MINISBLACK);
+	TIFFSetField(image, TIFFTAG_FILLORDER,       FILLORDER_MSB2LSB);
+	TIFFSetField(image, TIFFTAG_PLANARCONFIG,    PLANARCONFIG_CONTIG);
+
+	TIFFSetField(image, TIFFTAG_XRESOLUTION,     m_SrcInfo.GetDPIX());
+	TIFFSetField(image, TIFFTAG_YRESOLUTION,     m_SrcInfo.GetDPIY());
+	TIFFSetField(image, TIFFTAG_RESOLUTIONUNIT,  RESUNIT_INCH);
+	TIFFSetField(image, TIFFTAG_COPYRIGHT,       m_SrcInfo.sCopyright.c_str());
+	TIFFSetField(image, TIFFTAG_ARTIST,          m_SrcInfo.sArtist.c_str());
+	TIFFSetField(image, TIFFTAG_SOFTWARE,        m_SrcInfo.sSoftware.c_str());
+	TIFFSetField(image, 270,                     m_SrcInfo.sDescription.c_str()); // Description tag
+
+	const size_t nLineBytes=width*m_nBytesPerPixel;
+	for (size_t y=0; y<height; ++y) {
+		if (TIFFWriteScanline(image, const_cast<char *>(pData+y*nLineBytes), static_cast<uint32>(y), 0) == -1) {
+			TIFFClose(image);
+			msg<<"WritePlane: Failed to write line "<<y<<" of "<<fname;
 			throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
 		}
-
-		size_t fileIdx=i;
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_IMAGEWIDTH,      width);
-        TIFFSetField(m_DstImages[fileIdx], TIFFTAG_IMAGELENGTH,     0);
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_BITSPERSAMPLE,   m_SrcInfo.nBitsPerSample);
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_SAMPLESPERPIXEL, m_SrcInfo.nSamplesPerPixel);
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_SAMPLEFORMAT,    m_SrcInfo.nSampleFormat);
-
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_ROWSPERSTRIP,    1);
-
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_COMPRESSION,     COMPRESSION_NONE);
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_PHOTOMETRIC,     PHOTOMETRIC_MINISBLACK);
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_FILLORDER,       FILLORDER_MSB2LSB);
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_PLANARCONFIG,    PLANARCONFIG_CONTIG);
-
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_XRESOLUTION,     m_SrcInfo.GetDPIX());
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_YRESOLUTION,     m_SrcInfo.GetDPIY());
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_RESOLUTIONUNIT,  RESUNIT_INCH);
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_COPYRIGHT,       m_SrcInfo.sCopyright.c_str());
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_ARTIST,          m_SrcInfo.sArtist.c_str());
-		TIFFSetField(m_DstImages[fileIdx], TIFFTAG_SOFTWARE,        m_SrcInfo.sSoftware.c_str());
-		TIFFSetField(m_DstImages[fileIdx], 270,                     m_SrcInfo.sDescription.c_str()); // Description tag
-	}
-
-	logger(kipl::logging::Logger::LogMessage,"Headers are created");
-	return 0;
-}
-
-int TIFFReslicer::WriteLine(TIFF *img, size_t line, size_t bytesPerLine, char * pLineBuffer)
-{
-    TIFFSetField(img, TIFFTAG_IMAGELENGTH, line+1);
-    if (TIFFWriteEncodedStrip(img, line, pLineBuffer, bytesPerLine)==-1)
-	{
-		throw kipl::base::KiplException("Failed to write strip",__FILE__,__LINE__);
 	}
 
-	return 0;
-}
-
-int TIFFReslicer::CloseImages(int N)
-{
-	size_t i;
-    for (i=0; i<N; i++) {
-        if (m_DstImages[i]!=nullptr) {
-			TIFFClose(m_DstImages[i]);
-            m_DstImages[i]=nullptr;
-        }
-    }
-
-	return i;
+	TIFFClose(image);
 }
-
-
-
-
-
@@ -11,11 +11,18 @@
 class TIFFReslicer {
 private:
 	kipl::logging::Logger logger;
-	size_t m_nMaxBlock;
 public:
 	TIFFReslicer();
 	virtual ~TIFFReslicer();
+    /// \brief Reslices a stack of TIFF images into planes of one orientation
+    /// \param sSrcMask File mask of the slices
+    /// \param nFirst Index of the first slice
+    /// \param nLast Index of the last slice
+    /// \param sDstMask File mask of the planes, the index is the position of the plane
+    /// \param plane The orientation of the planes, ImagePlaneXZ or ImagePlaneYZ
     int process(std::string sSrcMask, int nFirst, int nLast, std::string sDstMask, kipl::base::eImagePlanes plane);
+
+    /// \brief Reslices the configured stack, the XZ and YZ planes are produced in a single pass over the slices
     int process();
 	float progress();
 
@@ -28,37 +35,46 @@ public:
 
     int m_nFirst;
     int m_nLast;
-    int m_nFirstXZ;
-    int m_nLastXZ;
-    int m_nFirstYZ;
-    int m_nLastYZ;
+    int m_nFirstXZ; ///< First XZ plane
+    int m_nLastXZ;  ///< Last XZ plane, a negative value or a value less than the first selects all planes
+    int m_nFirstYZ; ///< First YZ plane
+    int m_nLastYZ;  ///< Last YZ plane, a negative value or a value less than the first selects all planes
 
     bool m_bResliceXZ;
     bool m_bResliceYZ;
+
+    size_t m_nMemoryBudget; ///< Memory for the slice and plane buffers in bytes
 protected:
+    /// \brief Reslices a stack into XZ and YZ planes in a single pass
+    /// \param sSrcMask File mask of the slices
+    /// \param nFirst Index of the first slice
+    /// \param nLast Index of the last slice
+    /// \param sMaskXZ File mask of the XZ planes, no XZ planes are produced if the mask is empty
+    /// \param sMaskYZ File mask of the YZ planes, no YZ planes are produced if the mask is empty
+    void reslice(std::string sSrcMask, int nFirst, int nLast, std::string sMaskXZ, std::string sMaskYZ);
+
+    /// \brief Computes the planes to produce from a configured range
+    void PlaneRange(int first, int last, size_t nLimit, size_t &nFirst, size_t &nLast);
+
 	int GetHeader(std::string fname);
-	int CreateHeaders(std::string mask, size_t nFirst, size_t nLast, size_t width, size_t height);
-    int WriteLine(TIFF *img, size_t line, size_t bytesPerLine, char * pLineBuffer);
-    /// \brief Closes the open destination image files
-    /// \param N number of open files
-    int CloseImages(int N);
-	int LoadBuffer(std::string fname);
 
-	kipl::base::ImageInfo m_SrcInfo;
-	kipl::base::ImageInfo m_DstInfo;
+    /// \brief Reads the pixels of a slice, can be called concurrently
+    /// \param fname File name of the slice
+    /// \param pBuffer Receives the pixels
+    /// \param nBufferSize Size of the buffer in bytes
+    void LoadBuffer(std::string fname, char *pBuffer, size_t nBufferSize);
 
-	int m_nImageDims[2];
+    /// \brief Writes a plane as TIFF image with the pixel format of the slices, can be called concurrently
+    /// \param fname File name of the plane
+    /// \param pData The pixels
+    /// \param width Width of the plane
+    /// \param height Height of the plane
+    void WritePlane(std::string fname, const char *pData, size_t width, size_t height);
 
-	TIFF *m_DstImages[256];
-	size_t m_nSliceCount;
-	size_t m_nCurrentFile;
-	size_t m_nCurrentBlock;
-	size_t m_nBlocks;
+	kipl::base::ImageInfo m_SrcInfo;
 
-	char *buffer;
+	int m_nImageDims[2];
 	int m_nBytesPerPixel;
-    int m_nBytesPerWriteLine;
-    int m_nBytesPerReadLine;
 };
 
 #endif /* RESLICER_H_ */
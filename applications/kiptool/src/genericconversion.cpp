@@ -133,7 +133,7 @@ void GenericConversion::on_pushButton_Preview_clicked()
                          m_offset,m_stride,
                          1,
                          static_cast<kipl::base::eDataType>(m_type),
-                         kipl::base::BigEndian,
+                         kipl::base::SmallEndian,
                          nullptr);
     }
     catch (kipl::base::KiplException &e) {
@@ -127,112 +127,6 @@ kipl::base::TImage<float,2> ConfigureGeometryDialog::ThresholdProjection(const k
     return result;
 }
 
-float ConfigureGeometryDialog::CorrelationCenter(	kipl::base::TImage<float,2> proj_0,
-                                                    kipl::base::TImage<float,2> proj_180,
-                                                    size_t *roi)
-{
-    std::ostringstream msg;
-    logger(kipl::logging::Logger::LogMessage,"Center estimation using correlation");
-
- //   size_t *roi = m_Config.ProjectionInfo.roi;
-    msg<<"Corr center: Current ROI ["<<roi[0]<<", "<<roi[1]<<", "<<roi[2]<<", "<<roi[3]<<"]";
-    logger(kipl::logging::Logger::LogMessage,msg.str());
-
-    std::ofstream cogfile("cog_corr.txt");
-
-    kipl::base::TImage<float,2> limg0,limg180;
-    size_t start[2]={roi[0],roi[1]};
-    size_t length[2]={roi[2]-roi[0],roi[3]-roi[1]};
-    kipl::base::TSubImage<float,2> cropper;
-    limg0=cropper.Get(proj_0,start,length);
-    limg180 = kipl::base::Mirror(cropper.Get(m_Proj180Deg,start,length),kipl::base::ImageAxisX);
-
-    size_t len=limg0.Size(0)/3;
-
-    size_t dims[2]={len*2,limg0.Size(1)};
-    kipl::base::TImage<float,2> corrimg(dims);
-
-    for (size_t y=0; y<limg0.Size(1); y++) {
-        float *corr=corrimg.GetLinePtr(y);
-        const float * const p0   = limg0.GetLinePtr(y)+len;
-        const float * const p180 = limg180.GetLinePtr(y);
-
-        for (size_t idx=0; idx<2*len; idx++ )
-        {
-            corr[idx]=0.0f;
-            for (size_t x=0; x<len; x++)
-            {
-                corr[idx]+=p0[x]*p180[idx+x];
-            }
-        }
-        size_t pos=0;
-        for (size_t i=1; i<2*len; i++)
-            if (corr[pos]<corr[i]) pos=i;
-        float value=(static_cast<float>(pos)-static_cast<float>(len))*0.5f+(static_cast<float>(limg0.Size(0))*0.5f);
-
-        cogfile<<y<<" "<<len<<" "<<limg0.Size(0)<<" "<<pos<<" "<<value<<std::endl;
-        m_vCoG.push_back(value);
-    }
-
-    return 0.0f;
-}
-
-float ConfigureGeometryDialog::LeastSquareCenter(	kipl::base::TImage<float,2> proj_0,
-                                                    kipl::base::TImage<float,2> proj_180, size_t *roi)
-{
-    std::ostringstream msg;
-    logger(kipl::logging::Logger::LogMessage,"Center estimation using least squared error");
-
-  //  size_t *roi = m_Config.ProjectionInfo.roi;
-    msg<<"LS center: Current ROI ["<<roi[0]<<", "<<roi[1]<<", "<<roi[2]<<", "<<roi[3]<<"]";
-    logger(kipl::logging::Logger::LogMessage,msg.str());
-    kipl::base::TImage<float,2> limg0,limg180;
-    size_t start[2]={roi[0],roi[1]};
-    size_t length[2]={roi[2]-roi[0],roi[3]-roi[1]};
-    kipl::base::TSubImage<float,2> cropper;
-
-    msg.str("");
-    msg<<"x ["<<start[0]<<", "<<length[0]<<"], y ["<<start[1]<<", "<<length[1]<<"]";
-
-    logger(kipl::logging::Logger::LogMessage,msg.str());
-    limg0=cropper.Get(proj_0,start,length);
-    limg180 = kipl::base::Mirror(cropper.Get(proj_180,start,length),kipl::base::ImageAxisX);
-
-    ofstream cogfile("cog_lsc.txt");
-
-    size_t len=limg0.Size(0)/3;
-
-    size_t dims[2]={len*2,limg0.Size(1)};
-    kipl::base::TImage<float,2> corrimg(dims);
-    float diff=0.0f;
-    for (size_t y=0; y<limg0.Size(1); y++)
-    {
-        float *corr=corrimg.GetLinePtr(y);
-        const float * const p0   = limg0.GetLinePtr(y)+len;
-        const float * const p180 = limg180.GetLinePtr(y);
-
-        for (size_t idx=0; idx<2*len; idx++ )
-        {
-            corr[idx]=0.0f;
-            for (size_t x=0; x<len; x++)
-            {
-                diff=p0[x]-p180[idx+x];
-                corr[idx]+=diff*diff;
-            }
-        }
-        size_t pos=0;
-        for (size_t i=1; i<2*len; i++)
-            if (corr[i]<corr[pos]) pos=i;
-        float value=(static_cast<float>(len)-static_cast<float>(pos))*0.5f+(static_cast<float>(limg0.Size(0))*0.5f);
-
-        cogfile<<y<<" "<<len<<" "<<limg0.Size(0)<<" "<<pos<<" "<<value<<std::endl;
-
-        m_vCoG.push_back(value);
-    }
-
-    return 0.0f;
-}
-
 float ConfigureGeometryDialog::CenterOfGravity(const kipl::base::TImage<float,2> img, size_t start, size_t end)
 {
     m_vCoG.clear();
@@ -748,9 +642,13 @@ void ConfigureGeometryDialog::on_buttonFindCenter_clicked()
 
     tomoCenter.setFraction(fraction);
 
+    const ImagingAlgorithms::TomoCenter::eEstimator estimators[3]={ImagingAlgorithms::TomoCenter::leastSquare,
+                                                                    ImagingAlgorithms::TomoCenter::correlation,
+                                                                    ImagingAlgorithms::TomoCenter::phaseCorrelation};
+
     tomoCenter.estimate(    m_Proj0Deg,
                             m_Proj180Deg,
-                            static_cast<ImagingAlgorithms::TomoCenter::eEstimator>(ui->comboEstimatationMethod->currentIndex()),
+                            estimators[ui->comboEstimatationMethod->currentIndex()],
                             roi,
                             ui->groupUseTilt->isChecked(),
                             m_Config.ProjectionInfo.fCenter,
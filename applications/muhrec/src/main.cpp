@@ -18,6 +18,7 @@
 #include <strings/miscstring.h>
 #include <strings/filenames.h>
 #include <utilities/nodelocker.h>
+#include <fft/fftplancache.h>
 
 #include <ReconException.h>
 #include <ModuleException.h>
@@ -46,6 +47,10 @@ int main(int argc, char *argv[])
     msg.str(""); msg<<"Home dir: "<<homedir;
     logger.message(msg.str());
 
+    // Measured FFT plans are kept as wisdom between the sessions
+    kipl::math::fft::FFTPlanCache::instance().setPlanning(kipl::math::fft::FFTPlanMeasure);
+    kipl::math::fft::FFTPlanCache::instance().setWisdomFile(homedir+".imagingtools/fftwf_wisdom.dat");
+
     std::string application_path=app.applicationDirPath().toStdString();
 
     kipl::strings::filenames::CheckPathSlashes(application_path,true);
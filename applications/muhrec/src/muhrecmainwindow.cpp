@@ -2556,16 +2556,17 @@ void MuhRecMainWindow::on_sliceViewer_levelsChanged(float low, float high)
 void MuhRecMainWindow::on_pushButton_levels95p_clicked()
 {
     if (m_pEngine!=nullptr) {
-        const int nBins=256;
-        float x[nBins];
-        size_t y[nBins];
-        m_pEngine->GetHistogram(x,y,nBins);
-
-        size_t lowlevel=0;
-        size_t highlevel=0;
-        kipl::base::FindLimits(y, nBins, 95.0, &lowlevel, &highlevel);
-        ui->dspinGrayLow->setValue(static_cast<double>(x[lowlevel]));
-        ui->dspinGrayHigh->setValue(static_cast<double>(x[highlevel]));
+        // The interval is taken from the statistics collected during the reconstruction
+        float interval[2];
+        try {
+            m_pEngine->GetGrayInterval(95.0f,interval);
+        }
+        catch (ReconException &e) {
+            logger.warning(e.what());
+            return;
+        }
+        ui->dspinGrayLow->setValue(static_cast<double>(interval[0]));
+        ui->dspinGrayHigh->setValue(static_cast<double>(interval[1]));
     }
     else
         logger(logger.LogMessage,"Level 95%: Missing engine");
@@ -2574,16 +2575,17 @@ void MuhRecMainWindow::on_pushButton_levels95p_clicked()
 void MuhRecMainWindow::on_pushButton_levels99p_clicked()
 {
     if (m_pEngine!=nullptr) {
-        const int nBins=256;
-        float x[nBins];
-        size_t y[nBins];
-        m_pEngine->GetHistogram(x,y,nBins);
-
-        size_t lowlevel=0;
-        size_t highlevel=0;
-        kipl::base::FindLimits(y, nBins, 99.0, &lowlevel, &highlevel);
-        ui->dspinGrayLow->setValue(x[lowlevel]);
-        ui->dspinGrayHigh->setValue(x[highlevel]);
+        // The interval is taken from the statistics collected during the reconstruction
+        float interval[2];
+        try {
+            m_pEngine->GetGrayInterval(99.0f,interval);
+        }
+        catch (ReconException &e) {
+            logger.warning(e.what());
+            return;
+        }
+        ui->dspinGrayLow->setValue(static_cast<double>(interval[0]));
+        ui->dspinGrayHigh->setValue(static_cast<double>(interval[1]));
     }
     else
         logger(logger.LogMessage,"Level 99%: Missing engine");
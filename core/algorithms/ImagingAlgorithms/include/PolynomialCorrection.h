@@ -22,6 +22,10 @@ public:
     std::vector<float> process(const std::vector<float> &x);
     void processInplace(float *data, size_t N);
     void processInplace(double *data,size_t N);
+    /// \brief Serial in place evaluation of a span, intended for callers that already run on multiple threads.
+    /// \param data The span to process
+    /// \param N Number of elements in the span
+    void processSpan(float *data, size_t N) const;
     std::vector<float> coefficients();
     int polynomialOrder() {return static_cast<int>(m_fCoef.size())-1;}
 protected:
@@ -5,7 +5,9 @@
 #include "ImagingAlgorithms_global.h"
 
 #include <map>
+#include <list>
 #include <string>
+#include <vector>
 
 #include <base/timage.h>
 #include <logging/logger.h>
@@ -107,6 +109,7 @@ public:
     float* ComputeInterpolationParameters(kipl::base::TImage<float,2>&mask, kipl::base::TImage<float,2>&img, float &error); /// compute interpolation parameters from img and mask and give as output interpolation error
     kipl::base::TImage<float,2>  InterpolateBlackBodyImage(float *parameters, size_t *roi); /// compute interpolated image from polynomial parameters
     kipl::base::TImage<float,2> InterpolateBlackBodyImagewithSplines(float *parameters, std::map<std::pair<int,int>,float> &values, size_t *roi); /// compute interpolated image from splines parameters
+    void InterpolateBlackBodyImageswithSplines(float *parameters, size_t nSets, std::map<std::pair<int,int>,float> &values, size_t *roi, float *result); /// compute nSets interpolated images from consecutive sets of splines parameters (values.size()+3 each), result must hold nSets images of the roi size
     float ComputeInterpolationError(kipl::base::TImage<float,2>&interpolated_img, kipl::base::TImage<float,2>&mask, kipl::base::TImage<float, 2> &img); /// compute interpolation error from interpolated image, original image and mask that highlights the pixels to be considered
 
     void SetExternalBBimages(kipl::base::TImage<float, 2> &bb_ext, kipl::base::TImage<float, 3> &bb_sample_ext, float &dose, float *doselist); /// set the BB externally computed images and corresponding doses
@@ -139,6 +142,15 @@ protected:
     int* repeat_matrix(int* source, int count, int expand); /// repeat matrix. not used.
     float computedose(kipl::base::TImage<float,2>&img); /// duplicate.. to move in timage probably or something like this
 
+    /// thin plate spline kernels of the control points evaluated on a roi, each row of the roi has one line per control point
+    struct SplineBasis {
+        size_t roi[4];
+        std::vector<std::pair<int,int> > points;
+        std::vector<float> kernels; /// empty when the basis is larger than the cache budget, the kernels are then computed row by row
+    };
+    const SplineBasis & GetSplineBasis(std::map<std::pair<int,int>,float> &values, size_t *roi); /// returns the cached basis for the control points and roi, it is computed when the geometry is new
+    static void ComputeSplineKernels(const SplineBasis &basis, size_t y, float *kernels); /// computes the kernels of all control points for row y of the roi
+
 	bool m_bHaveOpenBeam;
 	bool m_bHaveDarkCurrent;
 	bool m_bHaveBlackBody;
@@ -210,6 +222,9 @@ protected:
 
     std::map<std::pair<int, int>, float> spline_ob_values; /// map to be used for interpolation with splines and ob image. should be in principle the same number of images with BB, i start now with 1
     std::map<std::pair<int, int>, float> spline_sample_values; /// map to be used for interpolation with splines and sample image
+    std::list<SplineBasis> m_SplineBases; /// cached spline bases, one per geometry (control points and roi)
+    SplineBasis m_UncachedSplineBasis; /// geometry of the last basis that was larger than the cache budget, it has no kernels and isn't cached
+    size_t m_nSplineBasisBudget; /// max number of bytes used by the cached spline bases
 
 
 
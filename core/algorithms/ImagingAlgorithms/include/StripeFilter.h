@@ -5,10 +5,11 @@
 
 #include "ImagingAlgorithms_global.h"
 #include <iostream>
+#include <complex>
+#include <vector>
 
 #include <base/timage.h>
 #include <math/mathconstants.h>
-#include <fft/fftbase.h>
 #include <logging/logger.h>
 #include <wavelets/wavelets.h>
 
@@ -72,33 +73,16 @@ private:
     /// \param img The vertical component to manipulate
 	void VerticalStripesZero(kipl::base::TImage<float,2> &img);
 
-    /// \brief Copies a selected vertical line to a line buffer
-    /// \param pSrc pointer to the image data buffer
-    /// \param pLine pointer to the line buffer
-    /// \param pos index of the vertical line to copy
-    /// \param stride number of pixels between two horizontal lines
-    /// \param len length of a line
-	void GetVerticalLine(float *pSrc, float *pLine, size_t pos, size_t stride, size_t len);
-
-    /// \brief Copies a line buffer to a vertical line in the target image.
-    /// \param pLine pointer to the line buffer
-    /// \param pDest pointer to the image data buffer
-    /// \param pos index of the vertical line to copy
-    /// \param stride number of pixels between two horizontal lines
-    /// \param len length of a line
-	void SetVerticalLine(float *pLine, float *pDest, size_t pos, size_t stride, size_t len);
-
     kipl::wavelets::WaveletTransform<float> m_wt; ///< Instance of the wavelete transform
     int m_nScale;                              ///< Number of decomposition levels
     float m_fSigma;                               ///< Width of the Gaussian used to implement the highpass filter
     size_t m_nFFTlength[NLevels];                      ///< Length of the fft transforms performed on the different decomposition levels
 
     float *m_pDamping[NLevels];                        ///< Filter coefficients for the filter windows
-    float *m_pLine;                               ///< Pointer to the line buffer
-    std::complex<float> *m_pCLine;                ///< Pointer to the Fourier transformed line
+    std::vector<float> m_Lines;                   ///< Buffer for the zero padded columns of a component
+    std::vector<std::complex<float>> m_FTLines;   ///< Buffer for the Fourier transformed columns
 
     std::vector<int> wdims;                              ///< Dimensions of the image for which the filter is configured
-    kipl::math::fft::FFTBaseFloat *fft[NLevels];       ///< FFT instances for each decomposition level.
 };
 }
 
@@ -10,7 +10,6 @@
 
 #include <logging/logger.h>
 #include <base/timage.h>
-#include <fft/fftbase.h>
 #include <interactors/interactionbase.h>
 
 namespace ImagingAlgorithms {
@@ -91,8 +90,6 @@ private:
     std::vector<float> mFilter;
     kipl::base::TImage<float,1> mPadData;
 
-    kipl::math::fft::FFTBaseFloat *fft;
-
     size_t nInsert;
 
 };
@@ -13,9 +13,10 @@ class IMAGINGALGORITHMSSHARED_EXPORT TomoCenter
     kipl::logging::Logger logger;
 public:
     enum eEstimator {
-        leastSquare,
-        correlation,
-        centerOfGravity
+        leastSquare,       ///< Minimizes the squared difference between the rows
+        correlation,       ///< Maximizes the cross-correlation of the rows
+        centerOfGravity,   ///< Not implemented, falls back on correlation
+        phaseCorrelation   ///< Maximizes the phase correlation, insensitive to intensity differences between the projections
     };
 
     TomoCenter();
@@ -47,9 +48,12 @@ public:
     void setPointsFileName(const std::string & fname);
 private:
     double computeR2(std::vector<double> &vec,double k, double m);
-    float CorrelationCenter();
-
-    float LeastSquareCenter();
+    /// \brief Estimates the center of each row by matching the 0 degree row with the mirrored 180 degree row.
+    ///
+    /// The matching scores of all shifts are computed by FFT cross-correlation and the best shift is refined to
+    /// sub-pixel precision by a parabola through the neighboring scores. The rows are processed in parallel.
+    /// \param est Selects the matching score (leastSquare, correlation, or phaseCorrelation)
+    void RowMatchingCenter(eEstimator est);
 
     float CenterOfGravity(const kipl::base::TImage<float,2> img, size_t start, size_t end);
 
@@ -11,6 +11,23 @@
 #include "../include/PolynomialCorrection.h"
 #include "../include/ImagingException.h"
 
+namespace {
+
+/// Horner evaluation with the degree as compile time constant to let the compiler unroll and vectorize the loop
+template <int degree>
+void hornerSpan(const float *c, float *data, size_t N)
+{
+    for (size_t i=0; i<N; ++i) {
+        const float x=data[i];
+        float y=c[degree];
+        for (int k=degree-1; 0<=k; --k)
+            y=y*x+c[k];
+        data[i]=y;
+    }
+}
+
+}
+
 namespace ImagingAlgorithms {
 
 PolynomialCorrection::PolynomialCorrection() : logger("ImagingAlgorithms::PolynomialCorrection"),
@@ -183,6 +200,24 @@ void PolynomialCorrection::processInplace(double *data,size_t N)
         data[i]=static_cast<double>(computePolynomial(static_cast<float>(data[i])));
 }
 
+void PolynomialCorrection::processSpan(float *data, size_t N) const
+{
+    const float *c=m_fCoef.data();
+
+    switch (m_nDegree)
+    {
+    case 1: hornerSpan<1>(c,data,N); break;
+    case 2: hornerSpan<2>(c,data,N); break;
+    case 3: hornerSpan<3>(c,data,N); break;
+    case 4: hornerSpan<4>(c,data,N); break;
+    case 5: hornerSpan<5>(c,data,N); break;
+    case 6: hornerSpan<6>(c,data,N); break;
+    case 7: hornerSpan<7>(c,data,N); break;
+    case 8: hornerSpan<8>(c,data,N); break;
+    case 9: hornerSpan<9>(c,data,N); break;
+    }
+}
+
 inline float PolynomialCorrection::computePolynomial(float x)
 {
     float y=0;
@@ -57,7 +57,8 @@ ReferenceImageCorrection::ReferenceImageCorrection() :
     thresh(0.0f),
     bSaveBG(false),
     m_Interactor(nullptr),
-    bExtSingleFile(true)
+    bExtSingleFile(true),
+    m_nSplineBasisBudget(size_t(512)<<20)
 {
     m_nDoseROI[0]=0;
     m_nDoseROI[1]=0;
@@ -286,6 +287,16 @@ void ReferenceImageCorrection::Process(kipl::base::TImage<float,3> &img, float *
 {
 	kipl::base::TImage<float, 2> slice(img.Dims());
 
+    // The spline backgrounds are evaluated for a batch of projections at a time to reuse the basis
+    const size_t nSplineBatch = 16;
+    const size_t nSplineParams = spline_sample_values.size()+3;
+    size_t roiDims[2] = {m_nROI[2]-m_nROI[0], m_nROI[3]-m_nROI[1]};
+    size_t doseDims[2] = {m_nDoseROI[2]-m_nDoseROI[0], m_nDoseROI[3]-m_nDoseROI[1]};
+    std::vector<float> bgBatch;
+    std::vector<float> doseBatch;
+    size_t nBatchFirst = 0;
+    size_t nBatchSize = 0;
+
 
     for (size_t i=0; (i<img.Size(2) && (updateStatus(float(i)/img.Size(2),"BBLogNorm: Referencing iteration")==false)); i++) {
 
@@ -304,13 +315,21 @@ void ReferenceImageCorrection::Process(kipl::base::TImage<float,3> &img, float *
                 break;
             }
             case ThinPlateSplines:{
-                current_param =new float[spline_sample_values.size()+3];
-
-                memcpy(current_param, sample_bb_interp_parameters+i*(spline_sample_values.size()+3), sizeof(float)*(spline_sample_values.size()+3));
+                if (nBatchFirst+nBatchSize<=i) {
+                    nBatchFirst = i;
+                    nBatchSize  = std::min(nSplineBatch, img.Size(2)-i);
+                    bgBatch.resize(nBatchSize*roiDims[0]*roiDims[1]);
+                    doseBatch.resize(nBatchSize*doseDims[0]*doseDims[1]);
+
+                    InterpolateBlackBodyImageswithSplines(sample_bb_interp_parameters+i*nSplineParams, nBatchSize, spline_sample_values, m_nROI, bgBatch.data());
+                    InterpolateBlackBodyImageswithSplines(sample_bb_interp_parameters+i*nSplineParams, nBatchSize, spline_sample_values, m_nDoseROI, doseBatch.data());
+                }
 
-                m_BB_sample_Interpolated = InterpolateBlackBodyImagewithSplines(current_param, spline_sample_values, m_nROI);
-                m_DoseBBsample_image = InterpolateBlackBodyImagewithSplines(current_param, spline_sample_values, m_nDoseROI);
-                    delete[] current_param;
+                // new images are needed since the previous ones may be referenced elsewhere
+                m_BB_sample_Interpolated = kipl::base::TImage<float,2>(roiDims);
+                memcpy(m_BB_sample_Interpolated.GetDataPtr(), bgBatch.data()+(i-nBatchFirst)*m_BB_sample_Interpolated.Size(), sizeof(float)*m_BB_sample_Interpolated.Size());
+                m_DoseBBsample_image = kipl::base::TImage<float,2>(doseDims);
+                memcpy(m_DoseBBsample_image.GetDataPtr(), doseBatch.data()+(i-nBatchFirst)*m_DoseBBsample_image.Size(), sizeof(float)*m_DoseBBsample_image.Size());
                 break;
             }
             default: throw ImagingException("Unknown m_InterpMethod in ReferenceImageCorrection::SetReferenceImages", __FILE__, __LINE__);
@@ -1647,46 +1666,132 @@ float * ReferenceImageCorrection::SolveThinPlateSplines(std::map<std::pair<int,i
 
 kipl::base::TImage<float,2> ReferenceImageCorrection::InterpolateBlackBodyImagewithSplines(float *parameters, std::map<std::pair<int, int>, float> &values, size_t *roi){
 
+    size_t dims[2] = {roi[2]-roi[0], roi[3]-roi[1]};
+    kipl::base::TImage <float,2> interpolated_img(dims);
 
+    InterpolateBlackBodyImageswithSplines(parameters, 1, values, roi, interpolated_img.GetDataPtr());
 
-    size_t dimx = roi[2]-roi[0];
-    size_t dimy = roi[3]-roi[1];
+    return interpolated_img;
 
+}
 
-    size_t dims[2] = {dimx,dimy};
-    kipl::base::TImage <float,2> interpolated_img(dims);
-    interpolated_img = 0.0f;
+void ReferenceImageCorrection::InterpolateBlackBodyImageswithSplines(float *parameters, size_t nSets, std::map<std::pair<int, int>, float> &values, size_t *roi, float *result){
 
-    float sumdist;
-    std::map<std::pair<int,int>, float>::const_iterator it_i;
+    const SplineBasis &basis = GetSplineBasis(values, roi);
 
-    for (size_t x=0; x<dimx; ++x) {
-        for (size_t y=0; y<dimy; ++y){
-             it_i = values.begin();
+    const size_t nPoints = basis.points.size();
+    const size_t nParams = nPoints+3;
+    const size_t dimx = roi[2]-roi[0];
+    const size_t dimy = roi[3]-roi[1];
+    const size_t nPix = dimx*dimy;
+    const bool bCached = !basis.kernels.empty();
 
-                sumdist = 0.0;
-                float *dist = new float[values.size()];
+    // The background is f(x,y) = sum_k p_k*U(|(x,y)-c_k|) + p_n + p_n+1*y + p_n+2*x, i.e. a product of the parameter sets with the basis.
+    // Each row of the basis is applied to all parameter sets while it is in the cache.
+    #pragma omp parallel
+    {
+        std::vector<float> rowKernels(bCached ? 0 : nPoints*dimx);
 
-            for (size_t ind=0; ind<values.size(); ++ind) {
-                dist[ind] = ((it_i->first.first-(x+roi[0]))*(it_i->first.first-(x+roi[0]))+(it_i->first.second-(y+roi[1]))*(it_i->first.second-(y+roi[1])));
-                if (dist[ind]!=0){
-                    sumdist += (0.5*dist[ind]*log(dist[ind])*parameters[ind]); // correct?                }
-                }
+        #pragma omp for schedule(static)
+        for (ptrdiff_t y=0; y<static_cast<ptrdiff_t>(dimy); ++y) {
+            const float *pKernels = nullptr;
+            if (bCached) {
+                pKernels = basis.kernels.data()+y*nPoints*dimx;
+            }
+            else {
+                ComputeSplineKernels(basis, y, rowKernels.data());
+                pKernels = rowKernels.data();
+            }
+
+            for (size_t j=0; j<nSets; ++j) {
+                const float *p = parameters+j*nParams;
+                float *pRes = result+j*nPix+y*dimx;
+
+                const float offset = p[nPoints]+p[nPoints+1]*static_cast<float>(y+roi[1]);
+                for (size_t x=0; x<dimx; ++x)
+                    pRes[x] = offset+p[nPoints+2]*static_cast<float>(x+roi[0]);
 
-                ++it_i;
+                for (size_t k=0; k<nPoints; ++k) {
+                    const float pk = p[k];
+                    const float *pK = pKernels+k*dimx;
+                    for (size_t x=0; x<dimx; ++x)
+                        pRes[x] += pk*pK[x];
+                }
             }
+        }
+    }
+
+}
+
+const ReferenceImageCorrection::SplineBasis & ReferenceImageCorrection::GetSplineBasis(std::map<std::pair<int, int>, float> &values, size_t *roi){
+
+    std::vector<std::pair<int,int> > points;
+    for (auto it=values.begin(); it!=values.end(); ++it)
+        points.push_back(it->first);
 
-                delete [] dist;
+    for (auto it=m_SplineBases.begin(); it!=m_SplineBases.end(); ++it) {
+        if (std::equal(roi, roi+4, it->roi) && (it->points==points))
+            return *it;
+    }
+
+    SplineBasis basis;
+    std::copy(roi, roi+4, basis.roi);
+    basis.points.swap(points);
+
+    const size_t dimx = roi[2]-roi[0];
+    const size_t dimy = roi[3]-roi[1];
+    const size_t nBytes = basis.points.size()*dimx*dimy*sizeof(float);
 
-            interpolated_img(x,y) = sumdist+parameters[values.size()]+parameters[values.size()+1]*(y+roi[1])+parameters[values.size()+2]*(x+roi[0]);
+    if (nBytes<=m_nSplineBasisBudget) {
+        // The oldest geometries are dropped to keep the cache inside the budget
+        size_t nUsed = nBytes;
+        for (auto it=m_SplineBases.begin(); it!=m_SplineBases.end(); ++it)
+            nUsed += it->kernels.size()*sizeof(float);
+
+        while ((m_nSplineBasisBudget<nUsed) && !m_SplineBases.empty()) {
+            nUsed -= m_SplineBases.front().kernels.size()*sizeof(float);
+            m_SplineBases.pop_front();
         }
+
+        basis.kernels.resize(basis.points.size()*dimx*dimy);
+        float *pKernels = basis.kernels.data();
+        const size_t nRow = basis.points.size()*dimx;
+
+        #pragma omp parallel for schedule(static)
+        for (ptrdiff_t y=0; y<static_cast<ptrdiff_t>(dimy); ++y)
+            ComputeSplineKernels(basis, y, pKernels+y*nRow);
     }
+    else {
+        std::ostringstream msg;
+        msg<<"The spline basis needs "<<(nBytes>>20)<<" MB, the kernels are computed for each evaluation";
+        logger(kipl::logging::Logger::LogVerbose,msg.str());
 
-    return interpolated_img;
+        // Only the geometry is needed to compute the kernels row by row, it is not kept in the cache
+        m_UncachedSplineBasis = basis;
+
+        return m_UncachedSplineBasis;
+    }
 
+    m_SplineBases.push_back(basis);
 
+    return m_SplineBases.back();
+}
+
+void ReferenceImageCorrection::ComputeSplineKernels(const SplineBasis &basis, size_t y, float *kernels){
+
+    const size_t dimx = basis.roi[2]-basis.roi[0];
+    const double py = static_cast<double>(y+basis.roi[1]);
 
+    for (size_t k=0; k<basis.points.size(); ++k) {
+        const double dy = basis.points[k].second-py;
+        float *pK = kernels+k*dimx;
 
+        for (size_t x=0; x<dimx; ++x) {
+            const double dx = basis.points[k].first-static_cast<double>(x+basis.roi[0]);
+            const double dist = dx*dx+dy*dy;
+            pK[x] = dist!=0.0 ? static_cast<float>(0.5*dist*log(dist)) : 0.0f;
+        }
+    }
 }
 
 kipl::base::TImage<float,2> ReferenceImageCorrection::InterpolateBlackBodyImage(float *parameters, size_t *roi) {
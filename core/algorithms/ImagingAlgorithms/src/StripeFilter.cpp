@@ -4,7 +4,7 @@
 #include <iostream>
 
 #include <fft/zeropadding.h>
-#include <fft/fftbase.h>
+#include <fft/fftplancache.h>
 #include <base/trotate.h>
 #include <base/tpermuteimage.h>
 #include <io/io_tiff.h>
@@ -19,11 +19,8 @@ namespace ImagingAlgorithms {
 StripeFilter::StripeFilter(size_t const * const dims, const string &wname, int scale, float sigma) :
 	logger("StripeFilter"),
 	m_wt(wname),
-    m_pLine(nullptr),
-    m_pCLine(nullptr),
     wdims{static_cast<int>(dims[0]), static_cast<int>(dims[1])}
 {
-    std::fill_n(fft,NLevels,nullptr);
     std::fill_n(m_pDamping,NLevels,nullptr);
     configure(wdims,wname,scale,sigma);
 }
@@ -36,11 +33,8 @@ StripeFilter::StripeFilter(size_t const * const dims, const string &wname, int s
 /// \param sigma High pass cut-off frequency
 StripeFilter::StripeFilter(const std::vector<int> &dims, const std::string &wname, int scale, float sigma) :
     logger("StripeFilter"),
-    m_wt(wname),
-    m_pLine(nullptr),
-    m_pCLine(nullptr)
+    m_wt(wname)
 {
-    std::fill_n(fft,NLevels,nullptr);
     std::fill_n(m_pDamping,NLevels,nullptr);
     configure(dims,wname,scale,sigma);
 }
@@ -50,18 +44,6 @@ StripeFilter::~StripeFilter()
     if (m_pDamping[0]!=nullptr)
         for (int i=0; i<m_nScale; i++)
 			delete [] m_pDamping[i];
-
-    if (m_pLine!=nullptr)
-		delete [] m_pLine;
-
-    if (m_pCLine!=nullptr)
-		delete [] m_pCLine;
-
-    if (fft[0]!=nullptr) 
-    {
-        for (int i=0; i<m_nScale; i++)
-		    delete fft[i];
-	}
 }
 
 
@@ -114,49 +96,38 @@ void StripeFilter::process(kipl::base::TImage<float,2> &img, eStripeFilterOperat
 void StripeFilter::FilterVerticalStripes(kipl::base::TImage<float,2> &img, size_t level)
 {
 	const size_t nLines=img.Size(0);
+	const size_t nLength=img.Size(1);
+	const size_t N=2*m_nFFTlength[level];
+	const size_t NFT=N/2+1;
 
-	float *pData=img.GetDataPtr();
+	// The columns are transformed by one batched transform, the samples of a column are nLines apart
+	m_Lines.resize(N*nLines);
+	m_FTLines.resize(NFT*nLines);
 
-	for (size_t line=0; line<nLines; line++) 
-    {
-        std::fill_n(m_pLine,2*m_nFFTlength[level],0.0f);
-		GetVerticalLine(pData,m_pLine,line,nLines,img.Size(1));
+	std::copy_n(img.GetDataPtr(),img.Size(),m_Lines.begin());
+	std::fill(m_Lines.begin()+img.Size(),m_Lines.begin()+N*nLines,0.0f);
 
-		(*fft[level])(m_pLine,m_pCLine);
+	kipl::math::fft::FFTBatchFloat fft(&N,1,nLines,nLines,1,nLines,1);
 
-		for (size_t i=0; i< 2*m_nFFTlength[level]; i++) 
-        {
-			m_pCLine[i]*=m_pDamping[level][i];
-		}
+	fft.forward(m_Lines.data(),m_FTLines.data());
 
-		(*fft[level])(m_pCLine, m_pLine);
-		SetVerticalLine(m_pLine,pData,line,nLines,img.Size(1));
-	}
-}
+	for (size_t i=0; i<NFT; i++)
+	{
+		std::complex<float> *pFTLine=m_FTLines.data()+i*nLines;
+		const float damping=m_pDamping[level][i];
 
-void StripeFilter::VerticalStripesZero(kipl::base::TImage<float,2> &img)
-{
-	img=0.0f;
-}
+		for (size_t line=0; line<nLines; line++)
+			pFTLine[line]*=damping;
+	}
 
-void StripeFilter::GetVerticalLine(float *pSrc, float *pLine, size_t pos, size_t stride, size_t len)
-{
-	float *pData=pSrc+pos;
+	fft.inverse(m_FTLines.data(),m_Lines.data());
 
-	for (size_t i=0; i<len; i++, pData+=stride) 
-    {
-		pLine[i]=*pData;
-	}
+	std::copy_n(m_Lines.begin(),nLength*nLines,img.GetDataPtr());
 }
 
-void StripeFilter::SetVerticalLine(float *pLine, float *pDest, size_t pos, size_t stride, size_t len)
+void StripeFilter::VerticalStripesZero(kipl::base::TImage<float,2> &img)
 {
-	float *pData=pDest+pos;
-
-	for (size_t i=0; i<len; i++, pData+=stride) 
-    {
-		*pData=pLine[i];
-	}
+	img=0.0f;
 }
 
 std::vector<int> StripeFilter::dims()
@@ -210,10 +181,6 @@ void StripeFilter::configure(const std::vector<int> &dims, const string &wname,
     {
         m_nFFTlength[i]=kipl::math::fft::NextPower2(static_cast<size_t>(1.25*dims[1])>>i);
         size_t N=2*m_nFFTlength[i];
-        if ( fft[i] != nullptr ) 
-            delete fft[i];
-
-        fft[i]=new kipl::math::fft::FFTBaseFloat(&N,1);
 
         if (m_pDamping[i]!= nullptr)
             delete [] m_pDamping[i];
@@ -221,16 +188,6 @@ void StripeFilter::configure(const std::vector<int> &dims, const string &wname,
         m_pDamping[i] = new float[N];
     }
 
-    size_t N=2*m_nFFTlength[0];
-
-    if (m_pLine != nullptr)
-        delete [] m_pLine;
-    m_pLine    = new float[N];
-
-    if (m_pCLine != nullptr)
-        delete [] m_pCLine;
-    m_pCLine   = new complex<float>[N];
-
     CreateFilterWindow();
 }
 
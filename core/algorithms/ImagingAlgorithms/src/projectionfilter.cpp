@@ -12,6 +12,7 @@
 #include <strings/miscstring.h>
 #include <math/compleximage.h>
 #include <base/imagecast.h>
+#include <fft/fftplancache.h>
 #include <io/io_matlab.h>
 #include <visualization/GNUPlot.h>
 
@@ -254,15 +255,12 @@ bool ProjectionFilterBase::updateStatus(float val, const std::string & msg)
 //------------------------------------------------------------
 // Projection filter w. float
 ProjectionFilter::ProjectionFilter(kipl::interactors::InteractionBase *interactor) :
-    ProjectionFilterBase("ProjectionFilter",interactor),
-    fft(nullptr)
+    ProjectionFilterBase("ProjectionFilter",interactor)
 {
 }
 
 ProjectionFilter::~ProjectionFilter(void)
 {
-    if (fft!=nullptr)
-        delete fft;
 }
 
 
@@ -275,14 +273,6 @@ void ProjectionFilter::buildFilter(const size_t N)
     nFFTsize=ComputeFilterSize(N);
     const size_t N2=nFFTsize/2;
 
-    if ((fft!=nullptr) && (fft->size(0)!=static_cast<int>(nFFTsize)))
-    {
-        delete fft;
-        fft=nullptr;
-    }
-    if (fft==nullptr)
-        fft=new kipl::math::fft::FFTBaseFloat(&nFFTsize,1);
-
     mFilter.resize(N2);
     std::fill_n(mFilter.begin(),N2,0.0f);
 
@@ -351,39 +341,47 @@ void ProjectionFilter::filterProjection(kipl::base::TImage<float,2> & img)
 
     const size_t cnFilterLength=mFilter.size();
     const size_t cnLoopCnt=nFFTsize/2;
-    kipl::base::TImage<complex<float>,1> ft1Dimg(&nFFTsize);
-
-  //  float *pFilter=mFilter.GetDataPtr();
-    complex<float> *pFTLine=ft1Dimg.GetDataPtr();
     const size_t nLenPad=nFFTsize+16;
-    float *pLine=new float[nLenPad];
+    const size_t nLenFT=nFFTsize/2+1;
+    const float scale=fPi/(4.0f*cnLoopCnt);
+    const size_t cnBatchLines=32;
 
-    for (size_t line=0; line<(nLines); line++)
+    // The lines are transformed in blocks by batched transforms with the padded lines nLenPad apart
+    const size_t nBlock=std::min(nLines,cnBatchLines);
+    std::vector<float> lines(nBlock*nLenPad);
+    std::vector<complex<float>> ftLines(nBlock*nLenFT);
+
+    for (size_t firstLine=0; firstLine<nLines; firstLine+=nBlock)
     {
-        std::fill_n(pLine,nLenPad,0.0f);
-        std::fill_n(pFTLine,nLenPad,0.0f);
+        const size_t nBatch=std::min(nBlock,nLines-firstLine);
+        kipl::math::fft::FFTBatchFloat fft(&nFFTsize,1,nBatch,1,nLenPad,1,nLenFT);
 
-        size_t insert=Pad(img.GetLinePtr(line),img.Size(0),pLine,nLenPad);
+        for (size_t i=0; i<nBatch; i++)
+            Pad(img.GetLinePtr(firstLine+i),img.Size(0),lines.data()+i*nLenPad,nLenPad);
 
-        fft->operator()(pLine,pFTLine);
+        fft.forward(lines.data(),ftLines.data());
 
-        for (size_t i=0; i< cnFilterLength; i++)
+        for (size_t i=0; i<nBatch; i++)
         {
-            pFTLine[i]*=mFilter[i];
+            complex<float> *pFTLine=ftLines.data()+i*nLenFT;
+            for (size_t j=0; j< cnFilterLength; j++)
+            {
+                pFTLine[j]*=mFilter[j];
+            }
         }
 
-        fft->operator ()(pFTLine, pLine);
+        fft.inverse(ftLines.data(),lines.data());
 
-        float *pImg=img.GetLinePtr(line);
-        const float scale=fPi/(4.0f*cnLoopCnt);
-        for (size_t i=0; i<img.Size(0); i++)
+        for (size_t i=0; i<nBatch; i++)
         {
-            pImg[i]=pLine[i+insert]*scale;
+            const float *pLine=lines.data()+i*nLenPad+nInsert;
+            float *pImg=img.GetLinePtr(firstLine+i);
+            for (size_t j=0; j<img.Size(0); j++)
+            {
+                pImg[j]=pLine[j]*scale;
+            }
         }
-
     }
-
-    delete [] pLine;
 }
 
 size_t ProjectionFilter::Pad(float const * const pSrc,
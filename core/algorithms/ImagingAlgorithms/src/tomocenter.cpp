@@ -6,6 +6,9 @@
 #include <vector>
 #include <map>
 #include <numeric>
+#include <complex>
+#include <fstream>
+#include <cmath>
 
 #if !defined(NO_QT)
 #include <QDebug>
@@ -16,8 +19,41 @@
 #include <base/KiplException.h>
 #include <math/mathconstants.h>
 #include <base/tpermuteimage.h>
+#include <fft/fftbase.h>
 
 namespace ImagingAlgorithms {
+
+namespace {
+
+/// \brief Finds the smallest transform length not less than n with only small prime factors
+size_t fftFriendlySize(size_t n)
+{
+    const size_t factors[4]={2,3,5,7};
+
+    for ( ; ; ++n) {
+        size_t m=n;
+        for (size_t f : factors)
+            while (m%f==0)
+                m/=f;
+
+        if (m==1)
+            return n;
+    }
+}
+
+/// \brief Refines the position of an extreme value with a parabola through the neighbors
+/// \returns The sub-pixel offset in [-0.5,0.5]
+double parabolicPeakOffset(double left, double center, double right)
+{
+    const double curvature=left-2.0*center+right;
+
+    if (curvature==0.0)
+        return 0.0;
+
+    return std::max(-0.5,std::min(0.5,0.5*(left-right)/curvature));
+}
+
+}
 TomoCenter::TomoCenter() :
     logger("TomoCenter"),
     roi{0,0,0,0},
@@ -54,13 +90,12 @@ void TomoCenter::estimate(kipl::base::TImage<float, 2> &img0,
     switch (est)
     {
         case leastSquare:
-            LeastSquareCenter();
-            break;
         case correlation:
-            CorrelationCenter();
+        case phaseCorrelation:
+            RowMatchingCenter(est);
             break;
         default:
-            CorrelationCenter();
+            RowMatchingCenter(correlation);
             break;
     }
 
@@ -185,19 +220,18 @@ double TomoCenter::computeR2(std::vector<double> &vec,double k, double m)
     return mR2;
 }
 
-float TomoCenter::CorrelationCenter()
+void TomoCenter::RowMatchingCenter(eEstimator est)
 {
     std::ostringstream msg;
-    logger(kipl::logging::Logger::LogMessage,"Center estimation using correlation");
+    switch (est) {
+        case leastSquare      : logger(kipl::logging::Logger::LogMessage,"Center estimation using least squared error"); break;
+        case phaseCorrelation : logger(kipl::logging::Logger::LogMessage,"Center estimation using phase correlation"); break;
+        default               : logger(kipl::logging::Logger::LogMessage,"Center estimation using correlation"); break;
+    }
 
-    msg<<"Corr center: Current ROI ["<<roi[0]<<", "<<roi[1]<<", "<<roi[2]<<", "<<roi[3]<<"]";
+    msg<<"Matching center: Current ROI ["<<roi[0]<<", "<<roi[1]<<", "<<roi[2]<<", "<<roi[3]<<"]";
     logger(kipl::logging::Logger::LogMessage,msg.str());
 
-    std::ofstream cogfile;
-
-    if (bSavePoints)
-        cogfile.open(pointsFileName.c_str());
-
     kipl::base::TImage<float,2> limg0,limg180;
     size_t start[2]={roi[0],roi[1]};
     size_t length[2]={roi[2]-roi[0],roi[3]-roi[1]};
@@ -205,98 +239,120 @@ float TomoCenter::CorrelationCenter()
     limg0=cropper.Get(m_Proj0Deg,start,length);
     limg180 = kipl::base::Mirror(cropper.Get(m_Proj180Deg,start,length),kipl::base::ImageAxisX);
 
-    size_t len=limg0.Size(0)/3;
-
-    size_t dims[2]={len*2,limg0.Size(1)};
-    kipl::base::TImage<float,2> corrimg(dims);
-
-    for (size_t y=0; y<limg0.Size(1); y++) {
-        float *corr=corrimg.GetLinePtr(y);
-        const float * const p0   = limg0.GetLinePtr(y)+len;
-        const float * const p180 = limg180.GetLinePtr(y);
-
-        for (size_t idx=0; idx<2*len; idx++ ) {
-            corr[idx]=0.0f;
-            for (size_t x=0; x<len; x++) {
-                corr[idx]+=p0[x]*p180[idx+x];
-            }
+    // The middle third of the 0 degree row is matched against the shifts [-len,len) of the mirrored 180 degree row
+    const size_t len=limg0.Size(0)/3;
+    if (len<2)
+        throw kipl::base::KiplException("The ROI is too narrow for the center estimation",__FILE__,__LINE__);
+
+    const ptrdiff_t nLen    = static_cast<ptrdiff_t>(len);
+    const ptrdiff_t nShifts = 2*nLen;
+    const ptrdiff_t nRows   = static_cast<ptrdiff_t>(limg0.Size(1));
+    const double    width   = static_cast<double>(limg0.Size(0));
+    size_t fftLength        = fftFriendlySize(3*len);
+    const ptrdiff_t N       = static_cast<ptrdiff_t>(fftLength);
+
+    // The whitened cross spectrum is tapered to give the phase correlation peak a width for the sub-pixel refinement
+    std::vector<float> lowpass(N);
+    if (est==phaseCorrelation) {
+        const double sigma=0.05*N;
+        for (ptrdiff_t k=0; k<N; ++k) {
+            const double f=static_cast<double>(std::min(k,N-k));
+            lowpass[k]=static_cast<float>(exp(-0.5*f*f/(sigma*sigma)));
         }
-        size_t pos=0;
-        for (size_t i=1; i<2*len; i++)
-            if (corr[pos]<corr[i]) pos=i;
-        double value=0.5*((static_cast<double>(pos)-static_cast<double>(len))+(static_cast<double>(limg0.Size(0))));
+    }
 
-        if (bSavePoints)
-            cogfile<<y<<", "<<len<<", "<<limg0.Size(0)<<", "<<pos<<", "<<value<<std::endl;
+    m_vCoG.resize(nRows);
+    std::vector<ptrdiff_t> peakPos(nRows);
 
-        m_vCoG.push_back(value);
-    }
+    #pragma omp parallel
+    {
+        std::vector<std::complex<float>> templateRow(N);
+        std::vector<std::complex<float>> searchRow(N);
+        std::vector<double> score(nShifts);
+        std::vector<double> energy(3*len+1);
+
+        // The thread local transforms share their plans through the plan cache
+        kipl::math::fft::FFTBaseFloat fft(&fftLength,1);
+
+        #pragma omp for
+        for (ptrdiff_t y=0; y<nRows; ++y) {
+            const float * const p0   = limg0.GetLinePtr(y)+len;
+            const float * const p180 = limg180.GetLinePtr(y);
+
+            float mean0=0.0f;
+            float mean180=0.0f;
+            if (est==phaseCorrelation) {
+                mean0   = std::accumulate(p0,p0+len,0.0f)/len;
+                mean180 = std::accumulate(p180,p180+3*len,0.0f)/(3*len);
+            }
 
-    return 0.0f;
-}
+            std::fill(templateRow.begin(),templateRow.end(),std::complex<float>(0.0f,0.0f));
+            std::fill(searchRow.begin(),searchRow.end(),std::complex<float>(0.0f,0.0f));
+            for (size_t x=0; x<len; ++x)
+                templateRow[x]=p0[x]-mean0;
+            for (size_t x=0; x<3*len; ++x)
+                searchRow[x]=p180[x]-mean180;
+
+            fft(templateRow.data(),templateRow.data(),-1);
+            fft(searchRow.data(),searchRow.data(),-1);
+
+            for (ptrdiff_t k=0; k<N; ++k) {
+                std::complex<float> cross=std::conj(templateRow[k])*searchRow[k];
+                if (est==phaseCorrelation) {
+                    const float magnitude=std::abs(cross);
+                    cross = magnitude<1e-12f ? std::complex<float>(0.0f,0.0f) : cross*(lowpass[k]/magnitude);
+                }
+                searchRow[k]=cross;
+            }
 
-float TomoCenter::CenterOfGravity(const kipl::base::TImage<float, 2> img,
-                                  size_t start,
-                                  size_t end)
-{
-    return 0.0f;
-}
+            fft(searchRow.data(),searchRow.data(),1);
 
-float TomoCenter::LeastSquareCenter()
-{
-    std::ostringstream msg;
-    logger(kipl::logging::Logger::LogMessage,"Center estimation using least squared error");
+            // The inverse transform is unnormalized
+            for (ptrdiff_t idx=0; idx<nShifts; ++idx)
+                score[idx]=static_cast<double>(searchRow[idx].real())/N;
 
-    msg<<"LS center: Current ROI ["<<roi[0]<<", "<<roi[1]<<", "<<roi[2]<<", "<<roi[3]<<"]";
-    logger(kipl::logging::Logger::LogMessage,msg.str());
-    kipl::base::TImage<float,2> limg0,limg180;
-    size_t start[2]={roi[0],roi[1]};
-    size_t length[2]={roi[2]-roi[0],roi[3]-roi[1]};
-    kipl::base::TSubImage<float,2> cropper;
+            if (est==leastSquare) {
+                // sum (p0-p180)^2 = sum p0^2 - 2 corr + sum p180^2, the last sum is taken over the shifted window
+                double energy0=0.0;
+                for (size_t x=0; x<len; ++x)
+                    energy0+=static_cast<double>(p0[x])*p0[x];
 
-    msg.str("");
-    msg<<"x ["<<start[0]<<", "<<length[0]<<"], y ["<<start[1]<<", "<<length[1]<<"]";
+                energy[0]=0.0;
+                for (size_t x=0; x<3*len; ++x)
+                    energy[x+1]=energy[x]+static_cast<double>(p180[x])*p180[x];
 
-    logger(kipl::logging::Logger::LogMessage,msg.str());
-    limg0=cropper.Get(m_Proj0Deg,start,length);
-    limg180 = kipl::base::Mirror(cropper.Get(m_Proj180Deg,start,length),kipl::base::ImageAxisX);
+                // Negated to let all estimators search for the maximum
+                for (ptrdiff_t idx=0; idx<nShifts; ++idx)
+                    score[idx]=-(energy0-2.0*score[idx]+energy[idx+nLen]-energy[idx]);
+            }
 
-    ofstream cogfile;
-    if (bSavePoints)
-        cogfile.open(pointsFileName.c_str());
+            ptrdiff_t pos=0;
+            for (ptrdiff_t i=1; i<nShifts; ++i)
+                if (score[pos]<score[i]) pos=i;
 
-    size_t len=limg0.Size(0)/3;
+            double offset=0.0;
+            if ((0<pos) && (pos<nShifts-1))
+                offset=parabolicPeakOffset(score[pos-1],score[pos],score[pos+1]);
 
-    size_t dims[2]={len*2,limg0.Size(1)};
-    kipl::base::TImage<float,2> corrimg(dims);
-    float diff=0.0f;
-    for (size_t y=0; y<limg0.Size(1); y++)
-    {
-        float *corr=corrimg.GetLinePtr(y);
-        const float * const p0   = limg0.GetLinePtr(y)+len;
-        const float * const p180 = limg180.GetLinePtr(y);
+            const double shift=static_cast<double>(pos)+offset-static_cast<double>(len);
 
-        for (size_t idx=0; idx<2*len; idx++ )
-        {
-            corr[idx]=0.0f;
-            for (size_t x=0; x<len; x++)
-            {
-                diff=p0[x]-p180[idx+x];
-                corr[idx]+=diff*diff;
-            }
+            peakPos[y] = pos;
+            m_vCoG[y]  = 0.5*(width-shift);
         }
+    }
 
-        size_t pos=0;
-        for (size_t i=1; i<2*len; i++)
-            if (corr[i]<corr[pos]) pos=i;
-        double value=0.5*((static_cast<double>(len)-static_cast<double>(pos))+(static_cast<double>(limg0.Size(0))));
-
-        if (bSavePoints)
-            cogfile<<y<<", "<<len<<", "<<limg0.Size(0)<<", "<<pos<<", "<<value<<std::endl;
+    if (bSavePoints) {
+        std::ofstream cogfile(pointsFileName.c_str());
 
-        m_vCoG.push_back(value);
+        for (ptrdiff_t y=0; y<nRows; ++y)
+            cogfile<<y<<", "<<len<<", "<<limg0.Size(0)<<", "<<peakPos[y]<<", "<<m_vCoG[y]<<std::endl;
     }
+}
 
+float TomoCenter::CenterOfGravity(const kipl::base::TImage<float, 2> img,
+                                  size_t start,
+                                  size_t end)
+{
     return 0.0f;
 }
 
@@ -21,6 +21,8 @@
 #include <projectionfilter.h>
 #include <ImagingException.h>
 #include <StripeFilter.h>
+#include <ReferenceImageCorrection.h>
+#include <tomocenter.h>
 
 class TestImagingAlgorithms : public QObject
 {
@@ -51,6 +53,10 @@ private Q_SLOTS:
     void StripeFilterParameters();
     void StripeFilterProcessing2D();
 
+    void ReferenceImageCorrection_Splines();
+
+    void TomoCenter_Estimators();
+
 private:
     void MorphSpotClean_ListAlgorithm();
 private:
@@ -570,6 +576,104 @@ void TestImagingAlgorithms::StripeFilterProcessing2D()
 
 }
 
+void TestImagingAlgorithms::ReferenceImageCorrection_Splines()
+{
+    ImagingAlgorithms::ReferenceImageCorrection rc;
+
+    std::map<std::pair<int,int>,float> values;
+    for (int i=0; i<4; ++i)
+        for (int j=0; j<3; ++j)
+            values[std::make_pair(10+i*17,5+j*23)]=1.0f;
+
+    const size_t nPoints=values.size();
+    const size_t nParams=nPoints+3;
+    const size_t nSets=3;
+    std::vector<float> param(nSets*nParams);
+    for (size_t i=0; i<param.size(); ++i)
+        param[i]=1e-4f*std::sin(0.3f*i);
+
+    for (size_t j=0; j<nSets; ++j)
+        param[j*nParams+nPoints]=1.0f+j;
+
+    size_t roi[4]={3,2,73,61};
+    const size_t dimx=roi[2]-roi[0];
+    const size_t dimy=roi[3]-roi[1];
+    std::vector<float> batch(nSets*dimx*dimy);
+
+    rc.InterpolateBlackBodyImageswithSplines(param.data(),nSets,values,roi,batch.data());
+
+    for (size_t j=0; j<nSets; ++j) {
+        float *p=param.data()+j*nParams;
+        kipl::base::TImage<float,2> img=rc.InterpolateBlackBodyImagewithSplines(p,values,roi);
+
+        QCOMPARE(img.Size(0),dimx);
+        QCOMPARE(img.Size(1),dimy);
+
+        for (size_t y=0; y<dimy; ++y) {
+            for (size_t x=0; x<dimx; ++x) {
+                double sum=p[nPoints]+p[nPoints+1]*(y+roi[1])+p[nPoints+2]*(x+roi[0]);
+                size_t k=0;
+                for (auto it=values.begin(); it!=values.end(); ++it, ++k) {
+                    double dx=it->first.first-double(x+roi[0]);
+                    double dy=it->first.second-double(y+roi[1]);
+                    double dist=dx*dx+dy*dy;
+                    if (dist!=0.0)
+                        sum+=0.5*dist*std::log(dist)*p[k];
+                }
+
+                QVERIFY(std::fabs(img(x,y)-sum)<1e-4);
+                QCOMPARE(batch[j*dimx*dimy+y*dimx+x],img(x,y));
+            }
+        }
+    }
+}
+
+void TestImagingAlgorithms::TomoCenter_Estimators()
+{
+    // The 180 degree projection is the 0 degree projection mirrored about the center
+    const double trueCenter=163.3;
+    size_t dims[2]={300,8};
+    kipl::base::TImage<float,2> proj0(dims);
+    kipl::base::TImage<float,2> proj180(dims);
+    kipl::base::TImage<float,2> proj180Scaled(dims);
+
+    auto profile=[](double u) {
+        return exp(-u*u/200.0)+0.6*exp(-(u-25)*(u-25)/20.0)+0.3*exp(-(u+40)*(u+40)/50.0);
+    };
+
+    for (size_t y=0; y<dims[1]; ++y) {
+        for (size_t x=0; x<dims[0]; ++x) {
+            proj0(x,y)         = static_cast<float>(profile(x-trueCenter));
+            proj180(x,y)       = static_cast<float>(profile(trueCenter-x));
+            proj180Scaled(x,y) = 0.7f*proj180(x,y)+0.2f;
+        }
+    }
+
+    size_t roi[4]={0,0,dims[0],dims[1]};
+    std::ostringstream msg;
+    double center=0.0;
+    double tilt=0.0;
+    double pivot=0.0;
+
+    // The estimators report the center with a half pixel offset
+    ImagingAlgorithms::TomoCenter tc;
+    tc.estimate(proj0,proj180,ImagingAlgorithms::TomoCenter::leastSquare,roi,false,center,tilt,pivot);
+    msg.str("");
+    msg<<"center="<<center;
+    QVERIFY2(fabs(center-(trueCenter+0.5))<0.1,msg.str().c_str());
+    QCOMPARE(tc.centers().size(),dims[1]);
+
+    tc.estimate(proj0,proj180,ImagingAlgorithms::TomoCenter::correlation,roi,false,center,tilt,pivot);
+    msg.str("");
+    msg<<"center="<<center;
+    QVERIFY2(fabs(center-(trueCenter+0.5))<0.1,msg.str().c_str());
+
+    tc.estimate(proj0,proj180Scaled,ImagingAlgorithms::TomoCenter::phaseCorrelation,roi,false,center,tilt,pivot);
+    msg.str("");
+    msg<<"center="<<center;
+    QVERIFY2(fabs(center-(trueCenter+0.5))<0.1,msg.str().c_str());
+}
+
 QTEST_APPLESS_MAIN(TestImagingAlgorithms)
 
 #include "tst_testImagingAlgorithms.moc"
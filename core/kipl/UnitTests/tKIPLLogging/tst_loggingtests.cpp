@@ -0,0 +1,198 @@
+#include <QtTest>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <logging/logger.h>
+#include <containers/mpscringbuffer.h>
+
+kipl::logging::LogWriter console;
+
+class CountingWriter : public kipl::logging::LogWriter
+{
+public:
+    CountingWriter() : count(0) {}
+    virtual size_t Write(std::string str) { ++count; last=str; return 0; }
+
+    std::atomic<size_t> count;
+    std::string last;
+};
+
+/// Log target that logs and flushes from inside Write, i.e. on the asynchronous writer thread
+class FlushingWriter : public kipl::logging::LogWriter
+{
+public:
+    FlushingWriter() : count(0) {}
+    virtual size_t Write(std::string str)
+    {
+        ++count;
+        if (str.find("trigger")!=std::string::npos) {
+            kipl::logging::Logger logger("FlushingWriter");
+            logger(kipl::logging::Logger::LogMessage,"nested");
+            kipl::logging::Logger::Flush();
+        }
+        return 0;
+    }
+
+    std::atomic<size_t> count;
+};
+
+class LoggingTests : public QObject
+{
+    Q_OBJECT
+
+public:
+    LoggingTests();
+    ~LoggingTests();
+
+private slots:
+    void test_RingBuffer();
+    void test_LevelFilter();
+    void test_AsyncLogging();
+    void test_AsyncFlushFromWriter();
+
+};
+
+LoggingTests::LoggingTests()
+{
+
+}
+
+LoggingTests::~LoggingTests()
+{
+
+}
+
+void LoggingTests::test_RingBuffer()
+{
+    kipl::containers::MPSCRingBuffer<int> buffer(5);
+    QCOMPARE(buffer.Size(),size_t(8));
+
+    int val=0;
+    QVERIFY(!buffer.Pop(val));
+
+    for (int i=0; i<8; ++i)
+        QVERIFY(buffer.Push(i));
+
+    val=8;
+    QVERIFY(!buffer.Push(val));
+
+    for (int i=0; i<8; ++i) {
+        QVERIFY(buffer.Pop(val));
+        QCOMPARE(val,i);
+    }
+    QVERIFY(!buffer.Pop(val));
+
+    // Concurrent producers, every item must arrive exactly once
+    const int nThreads=4;
+    const int nItems=10000;
+    std::vector<int> received(nThreads*nItems,0);
+    std::vector<std::thread> producers;
+
+    for (int t=0; t<nThreads; ++t)
+        producers.emplace_back([&buffer,t]() {
+            for (int i=0; i<nItems; ++i) {
+                int item=t*nItems+i;
+                while (!buffer.Push(item))
+                    std::this_thread::yield();
+            }
+        });
+
+    for (int n=0; n<nThreads*nItems; ) {
+        if (buffer.Pop(val)) {
+            ++received[val];
+            ++n;
+        }
+    }
+
+    for (auto &t : producers)
+        t.join();
+
+    for (auto cnt : received)
+        QCOMPARE(cnt,1);
+}
+
+void LoggingTests::test_LevelFilter()
+{
+    CountingWriter writer;
+    kipl::logging::Logger::AddLogTarget(writer);
+    kipl::logging::Logger logger("LoggingTests");
+
+    kipl::logging::Logger::SetLogLevel(kipl::logging::Logger::LogWarning);
+    QVERIFY(kipl::logging::Logger::IsEnabled(kipl::logging::Logger::LogError));
+    QVERIFY(!kipl::logging::Logger::IsEnabled(kipl::logging::Logger::LogMessage));
+
+    logger(kipl::logging::Logger::LogMessage,"discarded");
+    logger.verbose("discarded");
+    QCOMPARE(writer.count.load(),size_t(0));
+
+    logger(kipl::logging::Logger::LogWarning,"written");
+    QCOMPARE(writer.count.load(),size_t(1));
+    QVERIFY(writer.last.find("LoggingTests: written")!=std::string::npos);
+
+    kipl::logging::Logger::SetLogLevel(kipl::logging::Logger::LogMessage);
+    kipl::logging::Logger::AddLogTarget(console);
+}
+
+void LoggingTests::test_AsyncLogging()
+{
+    CountingWriter writer;
+    kipl::logging::Logger::AddLogTarget(writer);
+    kipl::logging::Logger::SetLogLevel(kipl::logging::Logger::LogVerbose);
+
+    kipl::logging::Logger::SetAsynchronous(true,64);
+    QVERIFY(kipl::logging::Logger::IsAsynchronous());
+
+    const int nThreads=4;
+    const int nMessages=2000;
+    std::vector<std::thread> threads;
+    for (int t=0; t<nThreads; ++t)
+        threads.emplace_back([]() {
+            kipl::logging::Logger logger("producer");
+            for (int i=0; i<nMessages; ++i)
+                logger(kipl::logging::Logger::LogVerbose,"message");
+        });
+
+    for (auto &t : threads)
+        t.join();
+
+    kipl::logging::Logger::Flush();
+    QCOMPARE(writer.count.load(),size_t(nThreads*nMessages));
+
+    // Errors are written before the call returns
+    kipl::logging::Logger logger("LoggingTests");
+    logger(kipl::logging::Logger::LogError,"error");
+    QCOMPARE(writer.count.load(),size_t(nThreads*nMessages+1));
+
+    kipl::logging::Logger::SetAsynchronous(false);
+    QVERIFY(!kipl::logging::Logger::IsAsynchronous());
+
+    logger(kipl::logging::Logger::LogMessage,"sync");
+    QCOMPARE(writer.count.load(),size_t(nThreads*nMessages+2));
+
+    kipl::logging::Logger::SetLogLevel(kipl::logging::Logger::LogMessage);
+    kipl::logging::Logger::AddLogTarget(console);
+}
+
+void LoggingTests::test_AsyncFlushFromWriter()
+{
+    FlushingWriter writer;
+    kipl::logging::Logger::AddLogTarget(writer);
+    kipl::logging::Logger::SetLogLevel(kipl::logging::Logger::LogMessage);
+    kipl::logging::Logger::SetAsynchronous(true,64);
+
+    // The flush in the writer must not wait for the writer thread itself
+    kipl::logging::Logger logger("LoggingTests");
+    logger(kipl::logging::Logger::LogMessage,"trigger");
+    kipl::logging::Logger::Flush();
+    QCOMPARE(writer.count.load(),size_t(2));
+
+    kipl::logging::Logger::SetAsynchronous(false);
+    kipl::logging::Logger::AddLogTarget(console);
+}
+
+QTEST_APPLESS_MAIN(LoggingTests)
+
+#include "tst_loggingtests.moc"
@@ -8,7 +8,11 @@
 #include <thread>
 #include <typeinfo>
 
+#include <fstream>
+#include <sstream>
+
 #include <profile/Timer.h>
+#include <profile/Tracer.h>
 
 // the function f() does some time-consuming work
 void f()
@@ -31,6 +35,8 @@ private slots:
     void test_case1();
     void test_BasicTiming();
     void test_ThreadedTiming();
+    void test_Tracer();
+    void test_TraceArguments();
 
 };
 
@@ -111,6 +117,81 @@ void TimerTests::test_ThreadedTiming()
 
 }
 
+void TimerTests::test_Tracer()
+{
+    kipl::profile::Tracer::clear();
+
+    // Nothing is recorded while the tracer is disabled
+    kipl::profile::Tracer::enable(false);
+    {
+        kipl::profile::TraceSpan span("disabled","test");
+        QCOMPARE(span.stop(),0.0);
+    }
+    kipl::profile::Tracer::addCounter("disabled counter",1.0);
+    QVERIFY(kipl::profile::Tracer::summary().find("disabled")==std::string::npos);
+
+    kipl::profile::Tracer::enable(true);
+    for (int i=0; i<3; ++i)
+    {
+        kipl::profile::TraceSpan span("block","test");
+        f();
+        QVERIFY(0.0<span.stop());
+        kipl::profile::Tracer::addCounter("bytes",100.0);
+    }
+
+    std::thread t1([](){kipl::profile::TraceSpan span("thread","test"); f();});
+    t1.join();
+    kipl::profile::Tracer::enable(false);
+
+    std::string summary=kipl::profile::Tracer::summary();
+    QVERIFY(summary.find("block")!=std::string::npos);
+    QVERIFY(summary.find("thread")!=std::string::npos);
+    QVERIFY(summary.find("bytes")!=std::string::npos);
+
+    kipl::profile::Tracer::writeChromeTrace("tracertest.json");
+    std::ifstream file("tracertest.json");
+    QVERIFY(file.is_open());
+    std::stringstream content;
+    content<<file.rdbuf();
+    std::string json=content.str();
+
+    size_t cntSpans=0;
+    for (size_t pos=json.find("\"ph\":\"X\""); pos!=std::string::npos; pos=json.find("\"ph\":\"X\"",pos+1))
+        ++cntSpans;
+    QCOMPARE(cntSpans,size_t(4));
+    QVERIFY(json.find("\"tid\":1")!=std::string::npos);
+
+    kipl::profile::Tracer::clear();
+}
+
+void TimerTests::test_TraceArguments()
+{
+    kipl::profile::Tracer::enable(false);
+
+    // The tracer stays disabled without trace arguments
+    kipl::profile::TraceArguments noTrace;
+    QVERIFY(!noTrace.setup({"muhrecCLI","-f","config.xml"}));
+    QVERIFY(!kipl::profile::Tracer::enabled());
+
+    kipl::profile::TraceArguments trace;
+    QVERIFY(trace.setup({"muhrecCLI","-f","config.xml","trace:file=traceargs.json"}));
+    QVERIFY(kipl::profile::Tracer::enabled());
+    {
+        kipl::profile::TraceSpan span("arguments","test");
+    }
+
+    trace.report();
+    QVERIFY(!kipl::profile::Tracer::enabled());
+
+    std::ifstream file("traceargs.json");
+    QVERIFY(file.is_open());
+    std::stringstream content;
+    content<<file.rdbuf();
+    QVERIFY(content.str().find("arguments")!=std::string::npos);
+
+    kipl::profile::Tracer::clear();
+}
+
 QTEST_APPLESS_MAIN(TimerTests)
 
 #include "tst_timertests.moc"
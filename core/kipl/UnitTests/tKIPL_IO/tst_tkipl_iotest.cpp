@@ -1,10 +1,14 @@
 #include <sstream>
+#include <vector>
+#include <cmath>
 
 #include <QString>
 #include <QtTest>
 
 #include <base/timage.h>
+#include <base/KiplException.h>
 #include <io/io_tiff.h>
+#include <io/io_multiframetiff.h>
 
 class tKIPL_IOTest : public QObject
 {
@@ -15,6 +19,8 @@ public:
 
 private Q_SLOTS:
     void testBasicReadWriteTIFF();
+    void testMultiFrameTIFF();
+    void testCompressedTIFF();
 };
 
 tKIPL_IOTest::tKIPL_IOTest()
@@ -57,6 +63,128 @@ void tKIPL_IOTest::testBasicReadWriteTIFF()
 
 }
 
+void tKIPL_IOTest::testMultiFrameTIFF()
+{
+    size_t dims[3]={13,7,5};
+
+    kipl::base::TImage<float,3> vol(dims);
+
+    for (size_t i=0; i<vol.Size(); i++)
+        vol[i]=static_cast<float>(i);
+
+    kipl::io::WriteTIFF32(vol,"multiframe.tif");
+
+    size_t readDims[3]={0,0,0};
+    QCOMPARE(kipl::io::GetTIFFDims("multiframe.tif",readDims),5);
+    QCOMPARE(readDims[0],dims[0]);
+    QCOMPARE(readDims[1],dims[1]);
+
+    // Single frames
+    kipl::base::TImage<float,2> img;
+    kipl::io::ReadTIFF(img,"multiframe.tif",3);
+    QCOMPARE(img.Size(0),dims[0]);
+    QCOMPARE(img.Size(1),dims[1]);
+    for (size_t i=0; i<img.Size(); i++)
+        QCOMPARE(img[i],vol.GetLinePtr(0,3)[i]);
+
+    kipl::io::MultiFrameTIFF mft("multiframe.tif");
+    QCOMPARE(mft.frames(),dims[2]);
+
+    for (size_t idx : {size_t(4), size_t(0), size_t(2)}) {
+        mft.read(img,idx);
+        for (size_t i=0; i<img.Size(); i++)
+            QCOMPARE(img[i],vol.GetLinePtr(0,idx)[i]);
+    }
+
+    // Cropped frame
+    size_t crop[4]={2,1,10,5};
+    mft.read(img,1,crop);
+    QCOMPARE(img.Size(0),crop[2]-crop[0]);
+    QCOMPARE(img.Size(1),crop[3]-crop[1]);
+    for (size_t y=0; y<img.Size(1); y++)
+        for (size_t x=0; x<img.Size(0); x++)
+            QCOMPARE(img(x,y),vol.GetLinePtr(y+crop[1],1)[x+crop[0]]);
+
+    // Range of frames
+    kipl::base::TImage<float,3> sub;
+    mft.read(sub,1,4);
+    QCOMPARE(sub.Size(2),size_t(4));
+    for (size_t i=0; i<sub.Size(); i++)
+        QCOMPARE(sub[i],vol.GetLinePtr(0,1)[i]);
+
+    // Whole volume
+    kipl::io::ReadTIFF(sub,"multiframe.tif");
+    QCOMPARE(sub.Size(2),dims[2]);
+    for (size_t i=0; i<sub.Size(); i++)
+        QCOMPARE(sub[i],vol[i]);
+
+    QVERIFY_EXCEPTION_THROWN(mft.read(img,5),kipl::base::KiplException);
+    QVERIFY_EXCEPTION_THROWN(kipl::io::ReadTIFF(img,"multiframe.tif",5),kipl::base::KiplException);
+}
+
+void tKIPL_IOTest::testCompressedTIFF()
+{
+    size_t dims[3]={70,45,3};
+
+    kipl::base::TImage<float,3> vol(dims);
+    kipl::base::TImage<unsigned short,3> vol16(dims);
+
+    for (size_t z=0; z<dims[2]; z++)
+        for (size_t y=0; y<dims[1]; y++)
+            for (size_t x=0; x<dims[0]; x++) {
+                vol(x,y,z)   = static_cast<float>(sin(0.1*x)*cos(0.2*y)+z);
+                vol16(x,y,z) = static_cast<unsigned short>(100*x+10*y+z);
+            }
+
+    std::vector<kipl::io::TIFFWriteOptions> layouts;
+
+    kipl::io::TIFFWriteOptions options(kipl::io::TIFFCompressionDeflate);
+    layouts.push_back(options);                 // Automatic strips
+    options.rowsPerStrip=7;
+    layouts.push_back(options);                 // Short strips, the last strip is partial
+    options.rowsPerStrip=0;
+    options.tileSize[0]=32;
+    options.tileSize[1]=16;
+    layouts.push_back(options);                 // Tiles with padding at the borders
+    options.compression=kipl::io::TIFFCompressionLZW;
+    layouts.push_back(options);
+    options.predictor=false;
+    layouts.push_back(options);
+    layouts.push_back(kipl::io::TIFFWriteOptions(kipl::io::TIFFCompressionNone));
+
+    for (const auto &layout : layouts) {
+        kipl::io::WriteTIFF(vol,"compressed.tif",layout);
+
+        kipl::base::TImage<float,3> res;
+        kipl::io::ReadTIFF(res,"compressed.tif");
+        QCOMPARE(res.Size(0),dims[0]);
+        QCOMPARE(res.Size(1),dims[1]);
+        QCOMPARE(res.Size(2),dims[2]);
+        for (size_t i=0; i<vol.Size(); i++)
+            QCOMPARE(res[i],vol[i]);
+
+        kipl::io::WriteTIFF(vol16,"compressed16.tif",layout);
+
+        kipl::base::TImage<unsigned short,2> res16;
+        kipl::io::ReadTIFF(res16,"compressed16.tif",2);
+        for (size_t i=0; i<res16.Size(); i++)
+            QCOMPARE(res16[i],vol16.GetLinePtr(0,2)[i]);
+
+        size_t crop[4]={5,3,60,40};
+        kipl::io::ReadTIFF(res16,"compressed16.tif",crop,1);
+        QCOMPARE(res16.Size(0),crop[2]-crop[0]);
+        QCOMPARE(res16.Size(1),crop[3]-crop[1]);
+        for (size_t y=0; y<res16.Size(1); y++)
+            for (size_t x=0; x<res16.Size(0); x++)
+                QCOMPARE(res16(x,y),vol16.GetLinePtr(y+crop[1],1)[x+crop[0]]);
+    }
+
+    options=kipl::io::TIFFWriteOptions(kipl::io::TIFFCompressionNone);
+    options.tileSize[0]=20;
+    options.tileSize[1]=16;
+    QVERIFY_EXCEPTION_THROWN(kipl::io::WriteTIFF(vol,"compressed.tif",options),kipl::base::KiplException);
+}
+
 QTEST_APPLESS_MAIN(tKIPL_IOTest)
 
 #include "tst_tkipl_iotest.moc"
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <vector>
+#include <cmath>
 
 #include <QString>
 #include <QtTest>
@@ -7,6 +8,7 @@
 #include <base/timage.h>
 #include <io/io_tiff.h>
 #include <filters/nonlocalmeans.h>
+#include <scalespace/NonLinDiffAOS.h>
 #include <base/KiplException.h>
 
 
@@ -23,6 +25,7 @@ private Q_SLOTS:
     void NLMeans_WindowEnum();
     void NLMeans_AlgorithmEnum();
     void NLMeans_process();
+    void NonLinDiffusion_AOS();
 
 };
 
@@ -132,6 +135,60 @@ void TKiplAdvFiltersTest::NLMeans_process()
     kipl::io::WriteTIFF32(res,"nl_test.tif");
 
 }
+void TKiplAdvFiltersTest::NonLinDiffusion_AOS()
+{
+    size_t dims[3]={24,20,16};
+    kipl::base::TImage<float,3> img(dims);
+    for (size_t i=0; i<img.Size(); ++i)
+        img[i]=static_cast<float>((i*7919) % 101);
+
+    double mean0=0.0;
+    double var0=0.0;
+    for (size_t i=0; i<img.Size(); ++i)
+        mean0+=img[i];
+    mean0/=img.Size();
+    for (size_t i=0; i<img.Size(); ++i)
+        var0+=(img[i]-mean0)*(img[i]-mean0);
+
+    // The AOS scheme conserves the mean and smooths the image
+    akipl::scalespace::NonLinDiffusionFilter<float,3> nld(1.0f,5.0f,10.0f,2);
+    nld(img);
+
+    QCOMPARE(img.Size(0),dims[0]);
+    QCOMPARE(img.Size(1),dims[1]);
+    QCOMPARE(img.Size(2),dims[2]);
+
+    double mean1=0.0;
+    double var1=0.0;
+    for (size_t i=0; i<img.Size(); ++i)
+        mean1+=img[i];
+    mean1/=img.Size();
+    for (size_t i=0; i<img.Size(); ++i)
+        var1+=(img[i]-mean1)*(img[i]-mean1);
+
+    QVERIFY(std::fabs(mean1-mean0)<1e-3);
+    QVERIFY(var1<0.5*var0);
+
+    // A constant image is not changed
+    kipl::base::TImage<float,3> flat(dims);
+    flat=3.0f;
+    akipl::scalespace::NonLinDiffusionFilter<float,3> nld2(1.0f,5.0f,10.0f,2);
+    nld2(flat);
+
+    for (size_t i=0; i<flat.Size(); ++i)
+        QVERIFY(std::fabs(flat[i]-3.0f)<1e-4f);
+
+    // 2D images are supported
+    size_t dims2[2]={30,25};
+    kipl::base::TImage<float,2> img2(dims2);
+    for (size_t i=0; i<img2.Size(); ++i)
+        img2[i]=static_cast<float>((i*7919) % 101);
+
+    akipl::scalespace::NonLinDiffusionFilter<float,2> nld3(1.0f,5.0f,10.0f,2);
+    nld3(img2);
+    QCOMPARE(img2.Size(0),dims2[0]);
+    QCOMPARE(img2.Size(1),dims2[1]);
+}
 
 
 QTEST_APPLESS_MAIN(TKiplAdvFiltersTest)
@@ -1,5 +1,7 @@
 #include <sstream>
 #include <list>
+#include <vector>
+#include <limits>
 
 #include <QString>
 #include <QtTest>
@@ -13,12 +15,15 @@
 #include <filters/filter.h>
 #include <drawing/drawing.h>
 #include <math/statistics.h>
+#include <math/volumestatistics.h>
 #include <math/mathfunctions.h>
 #include <math/findpeaks.h>
 #include <math/image_statistics.h>
 #include <math/covariance.h>
 #include <math/gradient.h>
 #include <math/linfit.h>
+#include <fft/fftbase.h>
+#include <fft/fftplancache.h>
 
 #include <io/io_tiff.h>
 
@@ -36,12 +41,15 @@ public:
 private Q_SLOTS:
     void testCOG();
     void testCircularHoughTransform();
+    void testCircularHoughTransformRadii();
+    void testFFTBatchFloat();
     void testNonLinFit_enums();
     void testNonLinFit_GaussianFunction();
     void testNonLinFit_fitter();
     void testFindPeaks();
 
     void testStatistics();
+    void testVolumeStatistics();
     void testImageStats();
     void testSignFunction();
     void testCovDims();
@@ -167,6 +175,110 @@ void TKiplMathTest::testCircularHoughTransform()
     kipl::io::WriteTIFF32(chm,"chtg_map.tif");
 }
 
+void TKiplMathTest::testCircularHoughTransformRadii()
+{
+    size_t dims[2]={100,100};
+
+    kipl::base::TImage<float,2> img(dims);
+
+    kipl::drawing::Circle<float> circ1(10.0);
+    kipl::drawing::Circle<float> circ2(5.0);
+
+    circ1.Draw(img,50,50,1.1);
+    circ2.Draw(img,25,75,1.5);
+
+    kipl::math::CircularHoughTransform cht;
+
+    std::vector<float> radii={4.0f,5.0f,6.0f,8.0f,10.0f,12.0f};
+    kipl::base::TImage<float,2> bestRadius;
+    kipl::base::TImage<float,2> chm=cht(img,radii,bestRadius,true);
+
+    QCOMPARE(bestRadius.Size(0),img.Size(0));
+    QCOMPARE(bestRadius.Size(1),img.Size(1));
+    QCOMPARE(bestRadius(50,50),10.0f);
+    QCOMPARE(bestRadius(25,75),5.0f);
+
+    // The multi radius map is the pixel wise maximum of the single radius maps
+    kipl::base::TImage<float,2> maxmap(dims);
+    maxmap=-std::numeric_limits<float>::max();
+    for (auto r : radii) {
+        kipl::base::TImage<float,2> single=cht(img,r,true);
+        for (size_t i=0; i<maxmap.Size(); ++i)
+            maxmap[i]=std::max(maxmap[i],single[i]);
+    }
+
+    for (size_t i=0; i<chm.Size(); ++i)
+        QVERIFY(qFuzzyCompare(chm[i],maxmap[i],1e-5));
+
+    QVERIFY_EXCEPTION_THROWN(cht(img,std::vector<float>(),bestRadius),kipl::base::KiplException);
+    QVERIFY_EXCEPTION_THROWN(cht(img,0.0f),kipl::base::KiplException);
+    QVERIFY_EXCEPTION_THROWN(cht(img,std::vector<float>({4.0f,-1.0f}),bestRadius),kipl::base::KiplException);
+}
+
+void TKiplMathTest::testFFTBatchFloat()
+{
+    const size_t dims[2]={12,10};
+    kipl::base::TImage<float,2> img(dims);
+    for (size_t y=0; y<dims[1]; ++y)
+        for (size_t x=0; x<dims[0]; ++x)
+            img(x,y)=std::sin(0.3f*x)+0.1f*y*y+((x*7+y*3)%5);
+
+    // The 2D real transform agrees with the complex transform on the first half of each line
+    kipl::base::TImage<std::complex<float>,2> cimg(dims);
+    for (size_t i=0; i<img.Size(); ++i)
+        cimg[i]=img[i];
+
+    kipl::math::fft::FFTBaseFloat fft2(dims,2);
+    kipl::base::TImage<std::complex<float>,2> ft2(dims);
+    kipl::base::TImage<std::complex<float>,2> ftr2(dims);
+    fft2(cimg.GetDataPtr(),ft2.GetDataPtr(),-1);
+    fft2(img.GetDataPtr(),ftr2.GetDataPtr());
+
+    const size_t NFT=dims[0]/2+1;
+    for (size_t y=0; y<dims[1]; ++y)
+        for (size_t x=0; x<NFT; ++x)
+            QVERIFY(std::abs(ftr2[y*NFT+x]-ft2(x,y))<1e-3f*std::abs(ft2(0,0)));
+
+    // Batched transforms of the columns with the samples dims[0] apart
+    const size_t N=16;
+    std::vector<float> columns(N*dims[0],0.0f);
+    std::copy_n(img.GetDataPtr(),img.Size(),columns.begin());
+    std::vector<std::complex<float>> ftColumns((N/2+1)*dims[0]);
+
+    kipl::math::fft::FFTBatchFloat batch(&N,1,dims[0],dims[0],1,dims[0],1);
+    QCOMPARE(batch.batchSize(),dims[0]);
+    QCOMPARE(batch.halfComplexSize(),N/2+1);
+    batch.forward(columns.data(),ftColumns.data());
+
+    kipl::math::fft::FFTBaseFloat fft1(&N,1);
+    std::vector<std::complex<float>> column(N);
+    std::vector<std::complex<float>> ftColumn(N);
+    for (size_t x=0; x<dims[0]; ++x) {
+        std::fill(column.begin(),column.end(),std::complex<float>(0.0f,0.0f));
+        for (size_t y=0; y<dims[1]; ++y)
+            column[y]=img(x,y);
+
+        fft1(column.data(),ftColumn.data(),-1);
+        for (size_t k=0; k<N/2+1; ++k)
+            QVERIFY(std::abs(ftColumns[k*dims[0]+x]-ftColumn[k])<1e-4f*N*10.0f);
+    }
+
+    // The inverse is unnormalized and overwrites its input
+    std::vector<float> result(N*dims[0]);
+    batch.inverse(ftColumns.data(),result.data());
+    for (size_t i=0; i<img.Size(); ++i)
+        QVERIFY(std::abs(result[i]/N-img[i])<1e-4f*10.0f);
+
+    // Repeated transforms reuse the cached plans
+    size_t nPlans=kipl::math::fft::FFTPlanCache::instance().size();
+    kipl::math::fft::FFTBatchFloat batch2(&N,1,dims[0],dims[0],1,dims[0],1);
+    std::copy_n(img.GetDataPtr(),img.Size(),columns.begin());
+    batch2.forward(columns.data(),ftColumns.data());
+    QCOMPARE(kipl::math::fft::FFTPlanCache::instance().size(),nPlans);
+
+    QVERIFY_EXCEPTION_THROWN(kipl::math::fft::FFTBatchFloat(dims,0),kipl::base::KiplException);
+}
+
 void TKiplMathTest::testNonLinFit_enums()
 {
     std::string val;
@@ -325,6 +437,66 @@ void TKiplMathTest::testStatistics()
 
 }
 
+void TKiplMathTest::testVolumeStatistics()
+{
+    kipl::math::VolumeStatistics stats;
+
+    QVERIFY(stats.n()==0UL);
+    QVERIFY(stats.Min()==0.0);
+    QVERIFY(stats.Max()==0.0);
+
+    std::vector<float> data(100000);
+    for (size_t i=0; i<data.size(); ++i)
+        data[i]=static_cast<float>(i%1000)*0.001f-0.25f;
+
+    data[17]=std::numeric_limits<float>::quiet_NaN();
+
+    stats.put(data.data(),data.size());
+
+    // Statistics collected in blocks and merged in a different order must give the same result
+    kipl::math::VolumeStatistics blockA, blockB, merged;
+    blockA.put(data.data(),30000);
+    blockB.put(data.data()+30000,data.size()-30000);
+    merged.merge(blockB);
+    merged.merge(blockA);
+
+    double eps=1e-6;
+    QCOMPARE(stats.n(),data.size()-1);
+    QCOMPARE(merged.n(),stats.n());
+    QVERIFY(fabs(stats.Min()+0.25)<eps);
+    QVERIFY(fabs(stats.Max()-0.749)<eps);
+    QVERIFY(fabs(merged.Min()-stats.Min())<eps);
+    QVERIFY(fabs(merged.Max()-stats.Max())<eps);
+    QVERIFY(fabs(merged.E()-stats.E())<eps);
+    QVERIFY(fabs(merged.V()-stats.V())<eps);
+
+    double mean=0.0;
+    for (size_t i=0; i<data.size(); ++i)
+        if (i!=17) mean+=data[i];
+    mean/=stats.n();
+    QVERIFY(fabs(stats.E()-mean)<eps);
+
+    // Uniform data with a spacing of 0.001, the percentiles are limited by the spacing and the bin width
+    const double tol=0.001+2*stats.binWidth();
+    QVERIFY(fabs(stats.Percentile(50.0)-0.2495)<tol);
+    QVERIFY(fabs(merged.Percentile(50.0)-0.2495)<tol);
+
+    float lo=0.0f, hi=0.0f;
+    stats.GrayInterval(90.0f,lo,hi);
+    QVERIFY(fabs(lo+0.2)<tol);
+    QVERIFY(fabs(hi-0.7)<tol);
+
+    const size_t nBins=100;
+    std::vector<float> axis(nBins);
+    std::vector<size_t> hist(nBins);
+    merged.GetHistogram(axis.data(),hist.data(),nBins);
+    size_t sum=0;
+    for (auto &h : hist)
+        sum+=h;
+    QCOMPARE(sum,merged.n());
+    QVERIFY(axis.front()<axis.back());
+}
+
 void TKiplMathTest::testImageStats()
 {
     double data[10]={ 4.49201549,  3.63910658,  1.14245381,  2.42364998,  2.12082273,
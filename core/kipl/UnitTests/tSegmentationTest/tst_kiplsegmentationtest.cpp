@@ -1,4 +1,5 @@
 #include <sstream>
+#include <cmath>
 #include <vector>
 
 #include <QString>
@@ -8,6 +9,7 @@
 #include <io/io_tiff.h>
 #include <segmentation/thresholds.h>
 #include <segmentation/gradientguidedthreshold.h>
+#include <segmentation/histogramfuzzycmeans.h>
 
 class kiplSegmentationTest : public QObject
 {
@@ -23,6 +25,7 @@ private Q_SLOTS:
     void testMultiThreshold();
     void testGradientGuidedThreshold();
     void testCmpType();
+    void testHistogramFuzzyCMeans();
 };
 
 kiplSegmentationTest::kiplSegmentationTest()
@@ -181,6 +184,67 @@ void kiplSegmentationTest::testCmpType()
 
 }
 
+void kiplSegmentationTest::testHistogramFuzzyCMeans()
+{
+    std::ostringstream msg;
+    size_t dims[2]={120,100};
+    kipl::base::TImage<unsigned short,2> img(dims);
+    kipl::base::TImage<unsigned char,2> seg;
+    const unsigned short levels[3]={500,1000,2000};
+
+    // Three classes with a deterministic spread of +/-40 gray levels
+    for (size_t i=0; i<img.Size(); ++i)
+        img[i]=levels[(i/7)%3]+static_cast<unsigned short>((i*37)%81)-40;
+
+    for (float sigma : {0.0f, 400.0f}) {
+        kipl::segmentation::HistogramFuzzyCMeans<unsigned short,unsigned char,2> fcm;
+        fcm.set(3,2.0f,100,sigma);
+        fcm(img,seg);
+
+        QVERIFY2(img.Size(0)==seg.Size(0),"x-size error");
+        QVERIFY2(img.Size(1)==seg.Size(1),"y-size error");
+
+        for (int c=0; c<3; ++c) {
+            msg.str(""); msg<<"Center "<<c<<" error, got "<<fcm.getCenters()[c]<<" for sigma="<<sigma;
+            QVERIFY2(std::fabs(fcm.getCenters()[c]-levels[c])<1.0f, msg.str().c_str());
+        }
+
+        size_t errors=0;
+        for (size_t i=0; i<img.Size(); ++i)
+            errors += seg[i]!=(i/7)%3;
+        msg.str(""); msg<<"Label errors "<<errors<<" for sigma="<<sigma;
+        QVERIFY2(errors==0, msg.str().c_str());
+
+        // The voxel wise update must keep the centers, i.e. they are a fixed point of the FCM
+        const bool bKernel=0.0f<sigma;
+        double sum[3]={0.0,0.0,0.0};
+        double uxSum[3]={0.0,0.0,0.0};
+        kipl::base::TImage<float,2> u[3];
+        for (int c=0; c<3; ++c)
+            fcm.membership(img,c,u[c]);
+
+        for (size_t i=0; i<img.Size(); ++i) {
+            QVERIFY(std::fabs(u[0][i]+u[1][i]+u[2][i]-1.0f)<1e-5f);
+            for (int c=0; c<3; ++c) {
+                const double diff=img[i]-fcm.getCenters()[c];
+                const double w=u[c][i]*u[c][i]*(bKernel ? std::exp(-diff*diff/(sigma*sigma)) : 1.0);
+                sum[c]+=w;
+                uxSum[c]+=w*img[i];
+            }
+        }
+
+        for (int c=0; c<3; ++c) {
+            msg.str(""); msg<<"Voxel wise center "<<c<<" differs, got "<<uxSum[c]/sum[c]<<" expected "<<fcm.getCenters()[c];
+            QVERIFY2(std::fabs(uxSum[c]/sum[c]-fcm.getCenters()[c])<0.01, msg.str().c_str());
+        }
+    }
+
+    kipl::segmentation::HistogramFuzzyCMeans<unsigned short,unsigned char,2> fcm;
+    kipl::base::TImage<float,2> u;
+    QVERIFY_EXCEPTION_THROWN(fcm.set(3,1.0f),kipl::base::KiplException);
+    QVERIFY_EXCEPTION_THROWN(fcm.membership(img,0,u),kipl::base::KiplException);
+}
+
 QTEST_APPLESS_MAIN(kiplSegmentationTest)
 
 #include "tst_kiplsegmentationtest.moc"
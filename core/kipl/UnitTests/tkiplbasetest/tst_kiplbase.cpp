@@ -3,6 +3,8 @@
 #include <string>
 #include <numeric>
 #include <limits>
+#include <vector>
+#include <cmath>
 
 #include <QString>
 #include <QtTest>
@@ -12,6 +14,7 @@
 #include <base/imageinfo.h>
 #include <base/tsubimage.h>
 #include <base/trotate.h>
+#include <base/imagesamplers.h>
 #include <base/marginsetter.h>
 #include <base/tprofile.h>
 #include <base/imagecast.h>
@@ -44,6 +47,9 @@ private Q_SLOTS:
     /// Tests rotations
     void testRotateImage();
 
+    /// Tests the fused binning, rotation and flipping
+    void testBinAndOrient();
+
     /// Tests margin setter
     void testMarginSetter();
 
@@ -373,6 +379,71 @@ void TkiplbasetestTest::testRotateImage()
     }
 }
 
+void TkiplbasetestTest::testBinAndOrient()
+{
+    std::ostringstream msg;
+
+    size_t dims[2]={37,23};
+    kipl::base::TImage<float,2> img(dims);
+    for (size_t i=0; i<img.Size(); ++i)
+        img[i]=static_cast<float>((i*7919) % 1000);
+
+    // The binned value is the mean of the block
+    {
+        size_t bins[2]={2,2};
+        kipl::base::TImage<float,2> binned;
+        kipl::base::ReBin(img,binned,bins);
+
+        QCOMPARE(binned.Size(0),dims[0]/2);
+        QCOMPARE(binned.Size(1),dims[1]/2);
+        QCOMPARE(binned(1,2),0.25f*(img(2,4)+img(3,4)+img(2,5)+img(3,5)));
+    }
+
+    const kipl::base::eImageFlip flips[4]={kipl::base::ImageFlipNone,
+                                           kipl::base::ImageFlipHorizontal,
+                                           kipl::base::ImageFlipVertical,
+                                           kipl::base::ImageFlipHorizontalVertical};
+
+    const kipl::base::eImageRotate rotations[4]={kipl::base::ImageRotateNone,
+                                                 kipl::base::ImageRotate90,
+                                                 kipl::base::ImageRotate180,
+                                                 kipl::base::ImageRotate270};
+
+    // Compare with binning followed by rotation and flip, the destination lines are padded
+    for (size_t bin=1; bin<4; ++bin) {
+        size_t bins[2]={bin,bin};
+        kipl::base::TImage<float,2> binned;
+        kipl::base::ReBin(img,binned,bins);
+
+        for (const auto &rotate : rotations) {
+            for (const auto &flip : flips) {
+                kipl::base::TRotate<float> rot;
+                kipl::base::TImage<float,2> ref=rot.Rotate(binned,flip,rotate);
+
+                size_t resdims[2];
+                kipl::base::BinAndOrientDims(img.Dims(),bin,rotate,resdims);
+                QCOMPARE(resdims[0],ref.Size(0));
+                QCOMPARE(resdims[1],ref.Size(1));
+
+                const size_t stride=resdims[0]+3;
+                std::vector<float> res(stride*resdims[1],-1.0f);
+                kipl::base::BinAndOrient(img,bin,flip,rotate,res.data(),stride);
+
+                for (size_t y=0; y<resdims[1]; ++y) {
+                    for (size_t x=0; x<resdims[0]; ++x) {
+                        msg.str("");
+                        msg<<"bin="<<bin<<", rotate="<<rotate<<", flip="<<flip<<", x="<<x<<", y="<<y;
+                        QVERIFY2(std::fabs(res[y*stride+x]-ref(x,y))<1e-3f,msg.str().c_str());
+                    }
+                    QVERIFY2(res[y*stride+resdims[0]]==-1.0f,"BinAndOrient wrote outside the line");
+                }
+            }
+        }
+    }
+
+    QVERIFY_EXCEPTION_THROWN(kipl::base::BinAndOrientDims(img.Dims(),40,kipl::base::ImageRotateNone,dims),kipl::base::KiplException);
+}
+
 void TkiplbasetestTest::testMarginSetter()
 {
     // 1D
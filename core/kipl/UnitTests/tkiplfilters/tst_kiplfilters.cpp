@@ -1,7 +1,9 @@
 #include <QtTest>
 
 #include <vector>
+#include <cmath>
 #include <filters/savitzkygolayfilter.h>
+#include <wavelets/wavelets.h>
 
 
 class KiplFilters : public QObject
@@ -15,7 +17,10 @@ public:
 private slots:
     void test_SavGolCoeffs();
     void test_SavGolFilter();
+    void test_WaveletEngine();
 
+private:
+    kipl::base::TImage<float,2> referenceWavelet(kipl::base::TImage<float,2> &img, const std::string &name, bool rowHigh, bool colHigh);
 };
 
 KiplFilters::KiplFilters()
@@ -77,6 +82,144 @@ void KiplFilters::test_SavGolFilter()
     }
 }
 
+void KiplFilters::test_WaveletEngine()
+{
+    size_t dims[2]={67,52};
+    kipl::base::TImage<float,2> img(dims);
+    for (size_t i=0; i<img.Size(); ++i)
+        img[i]=static_cast<float>((i*7919) % 101);
+
+    // daub2 is computed by lifting, daub4 by the filter bank
+    for (std::string name : {"daub2","daub4"}) {
+        kipl::wavelets::WaveletKernel<float> kernel(name);
+        kipl::wavelets::WaveletEngine<float> engine(kernel);
+        QCOMPARE(engine.Lifting(),name=="daub2");
+
+        kipl::wavelets::WaveletQuad<float> q;
+        engine.Analysis(img,q);
+
+        kipl::base::TImage<float,2> bands[4]={q.a,q.v,q.h,q.d};
+        for (int b=0; b<4; ++b) {
+            kipl::base::TImage<float,2> ref=referenceWavelet(img,name,b & 1,b & 2);
+            QCOMPARE(bands[b].Size(0),ref.Size(0));
+            QCOMPARE(bands[b].Size(1),ref.Size(1));
+            for (size_t i=0; i<ref.Size(); ++i)
+                QVERIFY(std::fabs(bands[b][i]-ref[i])<1e-3f);
+        }
+
+        // A volume that is constant along z has no high pass along z
+        size_t dims3[3]={dims[0],dims[1],9};
+        kipl::base::TImage<float,3> vol(dims3);
+        for (size_t z=0; z<dims3[2]; ++z)
+            std::copy_n(img.GetDataPtr(),img.Size(),vol.GetLinePtr(0,z));
+
+        kipl::base::TImage<float,3> bands3[8];
+        engine.Analysis(vol,bands3);
+        for (int b=0; b<4; ++b) {
+            for (size_t z=0; z<bands3[b].Size(2); ++z) {
+                float *pLow=bands3[b].GetLinePtr(0,z);
+                float *pHigh=bands3[b+4].GetLinePtr(0,z);
+                for (size_t i=0; i<bands[b].Size(); ++i) {
+                    QVERIFY(std::fabs(pLow[i]-std::sqrt(2.0f)*bands[b][i])<1e-3f);
+                    QVERIFY(std::fabs(pHigh[i])<1e-3f);
+                }
+            }
+        }
+    }
+
+    // Synthesis of the analysis returns the image. Zero padding is exact up to the edges, the other
+    // paddings only at least one kernel length away from the edges. daub1 and daub2 are lifted.
+    size_t odims[2]={dims[0]-6,dims[1]};
+    kipl::base::TImage<float,2> oddimg(odims);
+    for (size_t i=0; i<oddimg.Size(); ++i)
+        oddimg[i]=static_cast<float>((i*7919) % 101);
+
+    const kipl::base::ePadType pads[]={kipl::base::PadMirror, kipl::base::PadPeriodic,
+                                       kipl::base::PadZero, kipl::base::PadSP0, kipl::base::PadSP1};
+    for (std::string name : {"daub1","daub2","daub4"}) {
+        for (auto pad : pads) {
+            kipl::wavelets::WaveletKernel<float> kernel(name);
+            kipl::wavelets::WaveletEngine<float> engine(kernel,pad);
+            const size_t margin = pad==kipl::base::PadZero ? 0 : static_cast<size_t>(kernel.size());
+
+            for (auto src : {&img, &oddimg}) {
+                kipl::wavelets::WaveletQuad<float> q;
+                engine.Analysis(*src,q);
+                kipl::base::TImage<float,2> res(src->Dims());
+                engine.Synthesis(q,res);
+
+                for (size_t y=margin; y<src->Size(1)-margin; ++y)
+                    for (size_t x=margin; x<src->Size(0)-margin; ++x)
+                        QVERIFY(std::fabs(res(x,y)-(*src)(x,y))<1e-3f);
+            }
+        }
+    }
+
+    size_t vdims[3]={23,18,11};
+    kipl::base::TImage<float,3> vol(vdims);
+    for (size_t i=0; i<vol.Size(); ++i)
+        vol[i]=static_cast<float>((i*7919) % 101);
+
+    for (auto pad : {kipl::base::PadZero, kipl::base::PadMirror}) {
+        kipl::wavelets::WaveletKernel<float> kernel("daub2");
+        kipl::wavelets::WaveletEngine<float> engine(kernel,pad);
+        const size_t margin = pad==kipl::base::PadZero ? 0 : static_cast<size_t>(kernel.size());
+
+        kipl::base::TImage<float,3> bands3[8];
+        engine.Analysis(vol,bands3);
+        kipl::base::TImage<float,3> res(vdims);
+        engine.Synthesis(bands3,res);
+
+        for (size_t z=margin; z<vdims[2]-margin; ++z)
+            for (size_t y=margin; y<vdims[1]-margin; ++y)
+                for (size_t x=margin; x<vdims[0]-margin; ++x)
+                    QVERIFY(std::fabs(res(x,y,z)-vol(x,y,z))<1e-3f);
+    }
+}
+
+kipl::base::TImage<float,2> KiplFilters::referenceWavelet(kipl::base::TImage<float,2> &img, const std::string &name, bool rowHigh, bool colHigh)
+{
+    // Direct convolution with mirror padding, the definition used by the wavelet transform
+    kipl::wavelets::WaveletTransform<float> wt(name);
+    const kipl::wavelets::WaveletKernel<float> &kernel=wt.Kernel();
+    const int L=kernel.size();
+    const float *H=rowHigh ? kernel.transG() : kernel.transH();
+    const float *V=colHigh ? kernel.transG() : kernel.transH();
+
+    size_t dims[2]={(img.Size(0)+L-1+(img.Size(0) & 1))/2, (img.Size(1)+L-1+(img.Size(1) & 1))/2};
+    size_t tdims[2]={dims[0],img.Size(1)};
+    kipl::base::TImage<float,2> tmp(tdims);
+    kipl::base::TImage<float,2> res(dims);
+
+    std::vector<float> line(std::max(img.Size(0),img.Size(1)));
+    std::vector<float> padded(line.size()+2*L+16);
+    float *pp=padded.data()+L;
+
+    for (size_t y=0; y<img.Size(1); ++y) {
+        wt.pad_mirror(img.GetLinePtr(y),img.Size(0),padded.data(),L);
+        for (size_t k=0; k<dims[0]; ++k) {
+            float sum=0.0f;
+            for (int j=kernel.begin(); j<=kernel.end(); ++j)
+                sum+=H[j]*pp[2*static_cast<int>(k)-j+1];
+            tmp(k,y)=sum;
+        }
+    }
+
+    for (size_t x=0; x<dims[0]; ++x) {
+        for (size_t y=0; y<img.Size(1); ++y)
+            line[y]=tmp(x,y);
+        wt.pad_mirror(line.data(),img.Size(1),padded.data(),L);
+        for (size_t k=0; k<dims[1]; ++k) {
+            float sum=0.0f;
+            for (int j=kernel.begin(); j<=kernel.end(); ++j)
+                sum+=V[j]*pp[2*static_cast<int>(k)-j+1];
+            res(x,k)=sum;
+        }
+    }
+
+    return res;
+}
+
 QTEST_APPLESS_MAIN(KiplFilters)
 
 #include "tst_kiplfilters.moc"
@@ -1,6 +1,11 @@
+#include <fstream>
 #include <vector>
 #include <string>
 #include <limits>
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <fcntl.h>
+#endif
 
 #include <QString>
 #include <QtTest>
@@ -10,9 +15,11 @@
 #include <io/io_fits.h>
 #include <io/DirAnalyzer.h>
 #include <io/io_vivaseq.h>
+#include <io/io_generic.h>
 #include <io/io_tiff.h>
 #include <strings/filenames.h>
 #include <io/io_stack.h>
+#include <io/io_stackreslicer.h>
 #include <io/analyzefileext.h>
 
 class kiplIOTest : public QObject
@@ -31,11 +38,15 @@ private Q_SLOTS:
     void testCroppedFITSreading();
     void testSEQHeader();
     void testSEQRead();
+    void testSEQMappedRead();
+    void testGenericByteOrder();
     void testTIFFBasicReadWrite();
     void testTIFFMultiFrame();
     void testTIFF32();
+    void testTIFFRewrite();
     void testTIFFclamp();
     void testIOStack_enums();
+    void testStackReslicer();
 };
 
 kiplIOTest::kiplIOTest()
@@ -67,8 +78,82 @@ void kiplIOTest::testFITSreadwrite()
 
 void kiplIOTest::testCroppedFITSreading()
 {
+    size_t dims[2]={100,256};
+    kipl::base::TImage<short,2> img(dims);
+
+    for (size_t i=0; i<img.Size(); ++i)
+        img[i]=static_cast<short>(i);
+
+    kipl::io::WriteFITS(img,"test_crop.fits");
+
+    size_t fdims[8];
+    QCOMPARE(kipl::io::GetFITSDims("test_crop.fits",fdims),2);
+    QCOMPARE(fdims[0],img.Size(0));
+    QCOMPARE(fdims[1],img.Size(1));
+
+    // The second call is served by the layout cache
+    kipl::io::FITSLayout layout=kipl::io::GetFITSLayout("test_crop.fits");
+    QCOMPARE(layout.naxis,2);
+    QCOMPARE(layout.dims[0],img.Size(0));
+    QCOMPARE(layout.dims[1],img.Size(1));
+    QVERIFY(layout.compressed==false);
+
+    size_t crop[4]={10,20,60,120};
+    kipl::base::TImage<float,2> res;
+    kipl::io::ReadFITS(res,"test_crop.fits",crop);
+
+    QCOMPARE(res.Size(0),crop[2]-crop[0]);
+    QCOMPARE(res.Size(1),crop[3]-crop[1]);
+
+    for (size_t y=0; y<res.Size(1); ++y)
+        for (size_t x=0; x<res.Size(0); ++x)
+            QCOMPARE(res(x,y),static_cast<float>(img(x+crop[0],y+crop[1])));
+
+    // A crop that reaches the image border is valid
+    size_t border[4]={50,200,100,256};
+    kipl::io::ReadFITS(res,"test_crop.fits",border);
+    QCOMPARE(res.Size(0),size_t(50));
+    QCOMPARE(res.Size(1),size_t(56));
+    QCOMPARE(res(49,55),static_cast<float>(img(99,255)));
+
+    size_t outside[4]={50,200,101,256};
+    QVERIFY_EXCEPTION_THROWN(kipl::io::ReadFITS(res,"test_crop.fits",outside),kipl::base::KiplException);
+
+    // Rewriting the file replaces the cached layout and the open file
+    size_t dims2[2]={64,32};
+    kipl::base::TImage<short,2> img2(dims2);
+    for (size_t i=0; i<img2.Size(); ++i)
+        img2[i]=static_cast<short>(3*i);
+    kipl::io::WriteFITS(img2,"test_crop.fits");
+
+    QCOMPARE(kipl::io::GetFITSDims("test_crop.fits",fdims),2);
+    QCOMPARE(fdims[0],img2.Size(0));
+    QCOMPARE(fdims[1],img2.Size(1));
+    size_t crop2[4]={10,5,60,30};
+    kipl::io::ReadFITS(res,"test_crop.fits",crop2);
+    QCOMPARE(res.Size(0),crop2[2]-crop2[0]);
+    QCOMPARE(res.Size(1),crop2[3]-crop2[1]);
+    QCOMPARE(res(5,6),static_cast<float>(img2(5+crop2[0],6+crop2[1])));
+    QVERIFY_EXCEPTION_THROWN(kipl::io::ReadFITS(res,"test_crop.fits",border),kipl::base::KiplException);
+
+    // More files than are kept open, the closed files are opened again when they are read
+    const int N=20;
+    for (int i=0; i<N; ++i) {
+        img2[0]=static_cast<short>(i);
+        kipl::io::WriteFITS(img2,("test_many_"+std::to_string(i)+".fits").c_str());
+    }
 
-    QVERIFY2(true, "Failure");
+    for (int k=0; k<2; ++k)
+        for (int i=0; i<N; ++i) {
+            kipl::io::ReadFITS(res,("test_many_"+std::to_string(i)+".fits").c_str(),nullptr);
+            QCOMPARE(res.Size(0),dims2[0]);
+            QCOMPARE(res(0,0),static_cast<float>(i));
+            QCOMPARE(res(1,1),static_cast<float>(img2(1,1)));
+        }
+
+    kipl::io::ClearFITSLayoutCache();
+    kipl::io::ReadFITS(res,"test_many_0.fits",nullptr);
+    QCOMPARE(res(0,0),0.0f);
 }
 
 void kiplIOTest::testSEQHeader()
@@ -121,6 +206,79 @@ void kiplIOTest::testSEQRead()
 
 }
 
+void kiplIOTest::testSEQMappedRead()
+{
+    kipl::io::ViVaSEQHeader header;
+    header.imageWidth     = 13;
+    header.imageHeight    = 7;
+    header.bytesPerPixel  = 2;
+    header.numberOfFrames = 5;
+
+    {
+        std::ofstream file("mapped.seq",std::ios::binary);
+        file.write(reinterpret_cast<char *>(&header),sizeof(header));
+        for (unsigned short k=0; k<header.numberOfFrames; ++k)
+            for (unsigned short y=0; y<header.imageHeight; ++y)
+                for (unsigned short x=0; x<header.imageWidth; ++x) {
+                    unsigned short val=k*1000+y*20+x;
+                    file.write(reinterpret_cast<char *>(&val),sizeof(val));
+                }
+    }
+
+    kipl::base::TImage<float,3> img;
+    size_t roi[]={2,1,9,6};
+    kipl::io::ReadViVaSEQ("mapped.seq",img,roi);
+
+    QCOMPARE(img.Size(0),roi[2]-roi[0]);
+    QCOMPARE(img.Size(1),roi[3]-roi[1]);
+    QCOMPARE(img.Size(2),static_cast<size_t>(header.numberOfFrames));
+
+    for (size_t k=0; k<img.Size(2); ++k)
+        for (size_t y=0; y<img.Size(1); ++y)
+            for (size_t x=0; x<img.Size(0); ++x)
+                QCOMPARE(img(x,y,k),static_cast<float>(k*1000+(y+roi[1])*20+x+roi[0]));
+
+    kipl::io::ReadViVaSEQ("mapped.seq",img,nullptr,1,5,2);
+    QCOMPARE(img.Size(2),static_cast<size_t>(2));
+    QCOMPARE(img(4,5,1),static_cast<float>(3000+5*20+4));
+
+    kipl::base::TImage<float,2> frame;
+    kipl::io::ReadViVaSEQ("mapped.seq",frame,4);
+    QCOMPARE(frame(12,6),static_cast<float>(4000+6*20+12));
+
+    QVERIFY_EXCEPTION_THROWN(kipl::io::ReadViVaSEQ("mapped.seq",frame,5),kipl::base::KiplException);
+}
+
+void kiplIOTest::testGenericByteOrder()
+{
+    const size_t sx=11, sy=4, N=2;
+    {
+        std::ofstream file("generic_be.raw",std::ios::binary);
+        for (size_t k=0; k<N; ++k)
+            for (size_t i=0; i<sx*sy; ++i) {
+                unsigned short val=static_cast<unsigned short>(k*1000+i+256);
+                char bytes[2]={static_cast<char>(val>>8), static_cast<char>(val & 0xff)};
+                file.write(bytes,2);
+            }
+    }
+
+    kipl::base::TImage<float,2> img;
+    kipl::io::ReadGeneric(img,"generic_be.raw",sx,sy,0,sx*2,N,kipl::base::UInt16,kipl::base::BigEndian,1);
+    QCOMPARE(img.Size(0),sx);
+    QCOMPARE(img.Size(1),sy);
+    for (size_t i=0; i<img.Size(); ++i)
+        QCOMPARE(img[i],static_cast<float>(1000+i+256));
+
+    std::list<kipl::base::TImage<float,2> > imglist;
+    kipl::io::ReadGeneric(imglist,"generic_be.raw",sx,sy,0,sx*2,N,kipl::base::UInt16,kipl::base::BigEndian);
+    QCOMPARE(imglist.size(),N);
+    QCOMPARE(imglist.front()[3],static_cast<float>(3+256));
+
+    // Reading the same data in the wrong byte order must not match
+    kipl::io::ReadGeneric(img,"generic_be.raw",sx,sy,0,sx*2,N,kipl::base::UInt16,kipl::base::SmallEndian,0);
+    QVERIFY(img[3]!=static_cast<float>(3+256));
+}
+
 void kiplIOTest::testTIFFBasicReadWrite()
 {
     size_t dims[2]={100,50};
@@ -285,6 +443,57 @@ void kiplIOTest::testTIFF32()
 
 }
 
+void kiplIOTest::testTIFFRewrite()
+{
+    // A file rewritten with other dimensions must not be served from the frame index cache
+    size_t dims[3]={16,16,3};
+    kipl::base::TImage<float,3> first(dims);
+    for (size_t i=0; i<first.Size(); ++i)
+        first[i]=static_cast<float>(i);
+    kipl::io::WriteTIFF32(first,"rewrite.tif");
+
+    size_t resdims[2]={0,0};
+    QCOMPARE(kipl::io::GetTIFFDims("rewrite.tif",resdims),3);
+    QCOMPARE(resdims[0],dims[0]);
+    QCOMPARE(resdims[1],dims[1]);
+
+#ifndef _WIN32
+    struct stat info;
+    QCOMPARE(stat("rewrite.tif",&info),0);
+#endif
+
+    size_t dims2[3]={32,8,3};
+    kipl::base::TImage<float,3> second(dims2);
+    for (size_t i=0; i<second.Size(); ++i)
+        second[i]=static_cast<float>(2*i+1);
+    kipl::io::WriteTIFF32(second,"rewrite.tif");
+
+#ifndef _WIN32
+    // Restores the time stamp, the file size is the same, i.e. the file looks unchanged to the stamp
+    struct timespec times[2]={info.st_atim, info.st_mtim};
+    QCOMPARE(utimensat(AT_FDCWD,"rewrite.tif",times,0),0);
+#endif
+
+    QCOMPARE(kipl::io::GetTIFFDims("rewrite.tif",resdims),3);
+    QCOMPARE(resdims[0],dims2[0]);
+    QCOMPARE(resdims[1],dims2[1]);
+
+    kipl::base::TImage<float,2> frame;
+    kipl::io::ReadTIFF(frame,"rewrite.tif",nullptr,2);
+    QCOMPARE(frame.Size(0),dims2[0]);
+    QCOMPARE(frame.Size(1),dims2[1]);
+    for (size_t i=0; i<frame.Size(); ++i)
+        QCOMPARE(frame[i],second[i+2*frame.Size()]);
+
+    kipl::base::TImage<float,3> img3;
+    kipl::io::ReadTIFF(img3,"rewrite.tif");
+    QCOMPARE(img3.Size(0),dims2[0]);
+    QCOMPARE(img3.Size(1),dims2[1]);
+    QCOMPARE(img3.Size(2),dims2[2]);
+    for (size_t i=0; i<img3.Size(); ++i)
+        QCOMPARE(img3[i],second[i]);
+}
+
 void kiplIOTest::testTIFFclamp()
 {
     QSKIP("Seems to crash");
@@ -401,6 +610,67 @@ void kiplIOTest::testIOStack_enums()
     QCOMPARE(enum2string(kipl::io::PNG8bits),    std::string("PNG8bits"));
     QCOMPARE(enum2string(kipl::io::PNG16bits),   std::string("PNG16bits"));
 
+    // TIFF compression
+    kipl::io::eTIFFCompression tc;
+    for (auto c : {kipl::io::TIFFCompressionNone, kipl::io::TIFFCompressionDeflate,
+                   kipl::io::TIFFCompressionLZW, kipl::io::TIFFCompressionZSTD}) {
+        string2enum(enum2string(c),tc);
+        QCOMPARE(tc,c);
+    }
+    QCOMPARE(enum2string(kipl::io::TIFFCompressionDeflate), std::string("TIFFCompressionDeflate"));
+    QVERIFY_EXCEPTION_THROWN(string2enum("zip",tc),kipl::base::KiplException);
+}
+
+void kiplIOTest::testStackReslicer()
+{
+    const size_t dims[3]={37,29,23};
+    kipl::base::TImage<unsigned short,3> stack(dims);
+    for (size_t i=0; i<stack.Size(); ++i)
+        stack[i]=static_cast<unsigned short>(i);
+
+    // The large budget keeps all planes in memory, the small budget spills chunks of a few slices to disk
+    for (size_t budget : {size_t(1)<<30, size_t(20000)}) {
+        kipl::io::StackReslicer reslicer(dims[0],dims[1],dims[2],sizeof(unsigned short));
+        reslicer.AddPlanes(kipl::base::ImagePlaneXZ,3,7);
+        reslicer.AddPlanes(kipl::base::ImagePlaneYZ,0,dims[0]-1);
+        reslicer.SetMemoryBudget(budget);
+        reslicer.SetTemporaryPath(dir.tempPath().toStdString());
+
+        QCOMPARE(reslicer.PlaneCount(),size_t(5+dims[0]));
+        if (budget<(size_t(1)<<30))
+            QVERIFY(reslicer.ChunkDepth()<dims[2]);
+        else
+            QCOMPARE(reslicer.ChunkDepth(),dims[2]);
+
+        std::vector<size_t> errors(dims[0]+dims[1],0);
+        std::vector<size_t> written(dims[0]+dims[1],0);
+
+        reslicer.Process(
+            [&](size_t index, char *slice) {
+                std::copy_n(stack.GetLinePtr(0,index),dims[0]*dims[1],reinterpret_cast<unsigned short *>(slice));
+            },
+            [&](kipl::base::eImagePlanes plane, size_t position, const char *data, size_t width, size_t height) {
+                const unsigned short *pData=reinterpret_cast<const unsigned short *>(data);
+                const size_t idx = plane==kipl::base::ImagePlaneXZ ? position : dims[1]+position;
+                written[idx]++;
+                for (size_t z=0; z<height; ++z)
+                    for (size_t i=0; i<width; ++i) {
+                        const unsigned short ref = plane==kipl::base::ImagePlaneXZ ? stack(i,position,z) : stack(position,i,z);
+                        if (pData[z*width+i]!=ref)
+                            errors[idx]++;
+                    }
+            });
+
+        for (size_t i=0; i<errors.size(); ++i) {
+            const bool selected = i<dims[1] ? ((3<=i) && (i<=7)) : true;
+            QCOMPARE(written[i],size_t(selected ? 1 : 0));
+            QCOMPARE(errors[i],size_t(0));
+        }
+    }
+
+    kipl::io::StackReslicer reslicer(dims[0],dims[1],dims[2],sizeof(unsigned short));
+    QVERIFY_EXCEPTION_THROWN(reslicer.AddPlanes(kipl::base::ImagePlaneXZ,0,dims[1]),kipl::base::KiplException);
+    QVERIFY_EXCEPTION_THROWN(reslicer.AddPlanes(kipl::base::ImagePlaneXY,0,1),kipl::base::KiplException);
 }
 
 QTEST_APPLESS_MAIN(kiplIOTest)
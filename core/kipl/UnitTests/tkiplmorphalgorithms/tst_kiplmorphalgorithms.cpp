@@ -9,6 +9,7 @@
 #include <morphology/morphology.h>
 #include <morphology/label.h>
 #include <morphology/morphdist.h>
+#include <morphology/palagyi_skeleton.h>
 
 #include <io/io_tiff.h>
 
@@ -27,6 +28,7 @@ private slots:
     void test_RemoveConnectedRegion();
     void test_LabelledItemsInfo();
     void test_pixdist();
+    void test_PalagyiSkeleton();
 
 private:
     void test_EuclideanDistance();
@@ -225,6 +227,45 @@ void kiplmorphalgorithms::test_EuclideanDistance2()
 
 }
 
+void kiplmorphalgorithms::test_PalagyiSkeleton()
+{
+    size_t dims[]={50,20,20};
+    kipl::base::TImage<unsigned char,3> bar(dims);
+    bar=0;
+
+    // A bar of 40x9x9 voxels along x
+    for (size_t z=5; z<14; ++z)
+        for (size_t y=5; y<14; ++y)
+            for (size_t x=5; x<45; ++x)
+                bar(x,y,z)=1;
+
+    kipl::base::TImage<unsigned char,3> skel;
+    skel.Clone(bar);
+
+    kipl::morphology::PalagyiSkeleton<unsigned char> skeleton;
+    skeleton.process(skel);
+
+    size_t cnt=0;
+    for (size_t i=0; i<skel.Size(); ++i) {
+        QVERIFY(skel[i]==0 || skel[i]==1);
+        QVERIFY(skel[i]<=bar[i]);
+        cnt+=skel[i];
+    }
+    QVERIFY(0<cnt);
+
+    // The interior of the bar is thinned to a curve
+    for (size_t x=15; x<35; ++x) {
+        size_t slicecnt=0;
+        for (size_t z=0; z<dims[2]; ++z)
+            for (size_t y=0; y<dims[1]; ++y)
+                slicecnt+=skel(x,y,z);
+
+        std::ostringstream msg;
+        msg<<"Slice "<<x<<" has "<<slicecnt<<" skeleton voxels";
+        QVERIFY2(slicecnt==1, msg.str().c_str());
+    }
+}
+
 QTEST_APPLESS_MAIN(kiplmorphalgorithms)
 
 #include "tst_kiplmorphalgorithms.moc"
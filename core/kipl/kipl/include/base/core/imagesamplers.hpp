@@ -4,8 +4,10 @@
 #define IMAGESAMPLERS_HPP
 
 #include <vector>
+#include <algorithm>
 #include "../KiplException.h"
 #include "../timage.h"
+#include "../kiplenums.h"
 
 namespace kipl { namespace base {
 
@@ -40,7 +42,6 @@ int ReBin(const kipl::base::TImage<ImgType,NDim> &img,
 				for (int yi=0; yi<bins[1]; yi++) {
 					ImgType const * pImg=img.GetLinePtr(y*bins[1]+yi,z*bins[2]+zi);
 					for (size_t x=0; x<dims[0]; x++) {
-						pWs[x]=0.0;
 						size_t bx=x*bins[0];
 						for (size_t xi=0; xi<bins[0]; xi++) {
 							pWs[x]+=pImg[bx++];
@@ -70,6 +71,130 @@ int ReBin(const kipl::base::TImage<ImgType,NDim> &img,
 	return 1;
 }
 
+namespace core {
+
+/// \brief Computes the mean of the bin x bin blocks along one line of the binned image
+/// \param img the source image
+/// \param bin number of bins in both directions
+/// \param v index of the binned line
+/// \param bw width of the binned line
+/// \param line receives bw mean values
+template <class ImgType>
+void BinLine(const kipl::base::TImage<ImgType,2> &img, size_t bin, size_t v, size_t bw, float *line)
+{
+	if (bin==1) {
+		ImgType const * pImg=img.GetLinePtr(v);
+		for (size_t x=0; x<bw; x++)
+			line[x]=static_cast<float>(pImg[x]);
+		return;
+	}
+
+	std::fill_n(line,bw,0.0f);
+	for (size_t yi=0; yi<bin; yi++) {
+		ImgType const * pImg=img.GetLinePtr(v*bin+yi);
+		for (size_t x=0; x<bw; x++) {
+			ImgType const * p=pImg+x*bin;
+			float sum=0.0f;
+			for (size_t xi=0; xi<bin; xi++)
+				sum+=static_cast<float>(p[xi]);
+			line[x]+=sum;
+		}
+	}
+
+	const float scale=1.0f/static_cast<float>(bin*bin);
+	for (size_t x=0; x<bw; x++)
+		line[x]*=scale;
+}
+
+}
+
+template <class ImgType>
+void BinAndOrient(const kipl::base::TImage<ImgType,2> &img,
+		size_t bin,
+		kipl::base::eImageFlip flip,
+		kipl::base::eImageRotate rotate,
+		ImgType *dest,
+		size_t destStride)
+{
+	size_t dims[2];
+	BinAndOrientDims(img.Dims(),bin,rotate,dims);
+
+	const size_t b  = bin<1 ? 1 : bin;
+	const size_t bw = img.Size(0)/b;
+	const size_t bh = img.Size(1)/b;
+	const size_t stride = destStride==0 ? dims[0] : destStride;
+
+	if (stride<dims[0])
+		throw kipl::base::KiplException("BinAndOrient: the destination stride is smaller than the width of the result",__FILE__,__LINE__);
+
+	const bool flipH = (flip==kipl::base::ImageFlipHorizontal) || (flip==kipl::base::ImageFlipHorizontalVertical);
+	const bool flipV = (flip==kipl::base::ImageFlipVertical)   || (flip==kipl::base::ImageFlipHorizontalVertical);
+
+	if ((rotate!=kipl::base::ImageRotate90) && (rotate!=kipl::base::ImageRotate270)) {
+		// Each destination line is a, possibly reversed, line of the binned image
+		const bool r180 = rotate==kipl::base::ImageRotate180;
+		const bool revX = r180!=flipH;
+		const bool revY = r180!=flipV;
+
+		std::vector<float> line(b==1 ? 0 : bw);
+		for (size_t y=0; y<bh; y++) {
+			const size_t v = revY ? bh-1-y : y;
+			ImgType *pDest = dest+y*stride;
+
+			if (b==1) {
+				ImgType const * pImg=img.GetLinePtr(v);
+				if (revX)
+					std::reverse_copy(pImg,pImg+bw,pDest);
+				else
+					std::copy(pImg,pImg+bw,pDest);
+			}
+			else {
+				core::BinLine(img,b,v,bw,line.data());
+				if (revX) {
+					for (size_t x=0; x<bw; x++)
+						pDest[bw-1-x]=static_cast<ImgType>(line[x]);
+				}
+				else {
+					for (size_t x=0; x<bw; x++)
+						pDest[x]=static_cast<ImgType>(line[x]);
+				}
+			}
+		}
+
+		return;
+	}
+
+	// The destination columns follow the binned lines. A strip of binned lines is kept in a buffer and each
+	// destination line receives a short contiguous segment from the strip.
+	const bool revX = (rotate==kipl::base::ImageRotate90)!=flipH;
+	const bool revY = (rotate==kipl::base::ImageRotate270)!=flipV;
+	const size_t nTile = 32;
+
+	std::vector<float> strip(nTile*bw);
+	for (size_t v0=0; v0<bh; v0+=nTile) {
+		const size_t nv=std::min(nTile,bh-v0);
+
+		for (size_t i=0; i<nv; i++)
+			core::BinLine(img,b,v0+i,bw,strip.data()+i*bw);
+
+		for (size_t u=0; u<bw; u++) {
+			const size_t y = revY ? bw-1-u : u;
+			float const * pStrip=strip.data()+u;
+
+			if (revX) {
+				ImgType *pDest=dest+y*stride+(bh-1-v0);
+				for (size_t i=0; i<nv; i++)
+					*(pDest-i)=static_cast<ImgType>(pStrip[i*bw]);
+			}
+			else {
+				ImgType *pDest=dest+y*stride+v0;
+				for (size_t i=0; i<nv; i++)
+					pDest[i]=static_cast<ImgType>(pStrip[i*bw]);
+			}
+		}
+	}
+}
+
 template <class ImgType, int NDim>
 int GaussianSampler(	const kipl::base::TImage<ImgType,NDim> &img, 
 						kipl::base::TImage<ImgType,NDim> &result, 
@@ -66,7 +66,8 @@ template <typename T>
 kipl::base::TImage<T,2> & TRotate<T>::Rotate90  ( kipl::base::TImage<T,2> & img)
 {
 	size_t dims[2]={img.Size(1), img.Size(0)};
-    dst.Resize(dims);
+    // A new buffer, img can be the result of a previous call sharing the buffer of dst
+    dst=kipl::base::TImage<T,2>(dims);
 
 	size_t sx=dst.Size(0);
 	T *pDst=dst.GetDataPtr();
@@ -112,7 +113,8 @@ template <typename T>
 kipl::base::TImage<T,2> & TRotate<T>::Rotate270 (kipl::base::TImage<T,2> &img)
 {
 	size_t dims[2]={img.Size(1), img.Size(0)};
-    dst.Resize(dims);
+    // A new buffer, img can be the result of a previous call sharing the buffer of dst
+    dst=kipl::base::TImage<T,2>(dims);
 
 	size_t sx=dst.Size(0);
 	size_t sy1=(dst.Size(1)-1);
@@ -162,7 +164,8 @@ kipl::base::TImage<T,2> & TRotate<T>::MirrorHorizontal  (kipl::base::TImage<T,2>
 template <typename T>
 kipl::base::TImage<T,2> & TRotate<T>::MirrorVertical  (kipl::base::TImage<T,2> & img)
 {
-    dst.Resize(img.Dims());
+    // A new buffer, img can be the result of a previous call sharing the buffer of dst
+    dst=kipl::base::TImage<T,2>(img.Dims());
 
 
 	size_t sy=dst.Size(1)-1;
@@ -5,6 +5,7 @@
 
 #include "../kipl_global.h"
 #include "timage.h"
+#include "kiplenums.h"
 
 namespace kipl { namespace base {
 // \todo Implement... but what is it used for?
@@ -19,6 +20,32 @@ int ReBin(const kipl::base::TImage<ImgType,NDim> &img,
 		kipl::base::TImage<ImgType,NDim> &result, 
 		size_t const * const nbin);
 
+/// \brief Computes the size of an image after binning and an orthogonal rotation
+/// \param dims dimensions of the source image
+/// \param bin number of bins in both directions, 0 is treated as 1
+/// \param rotate the rotation, 90 and 270 degrees swap the axes
+/// \param resdims receives the dimensions of the result
+KIPLSHARED_EXPORT void BinAndOrientDims(size_t const * const dims, size_t bin, kipl::base::eImageRotate rotate, size_t *resdims);
+
+/// \brief Bins, rotates, and flips an image in a single pass without intermediate images.
+///
+/// The result is the same as ReBin followed by TRotate::Rotate, i.e. the rotation is applied before the flip.
+/// Row preserving orientations are processed line by line, the transposing orientations (90 and 270 degrees)
+/// are processed in tiles to keep both the source and the destination lines in the cache.
+///	\param img input image
+/// \param bin number of bins in both directions, 0 is treated as 1
+/// \param flip the flip applied after the rotation
+/// \param rotate the rotation
+/// \param dest destination buffer, it must hold the size given by BinAndOrientDims
+/// \param destStride distance in elements between the lines of the destination, 0 uses the width of the result
+template <class ImgType>
+void BinAndOrient(const kipl::base::TImage<ImgType,2> &img,
+		size_t bin,
+		kipl::base::eImageFlip flip,
+		kipl::base::eImageRotate rotate,
+		ImgType *dest,
+		size_t destStride=0);
+
 /// \brief Downsizes an image by bining pixels
 ///	\param img input image
 ///	\param result resulting binned image
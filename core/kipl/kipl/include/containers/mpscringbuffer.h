@@ -0,0 +1,114 @@
+//<LICENCE>
+
+#ifndef MPSCRINGBUFFER_H
+#define MPSCRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace kipl { namespace containers {
+
+/// \brief Bounded lock-free queue for many producers and a single consumer.
+///
+/// Each cell carries a sequence number that tells if the cell is free for the producer of a given position or
+/// ready for the consumer. Producers claim positions with a compare-and-swap, i.e. they never block each other
+/// while they copy their item into the buffer.
+template <typename T>
+class MPSCRingBuffer
+{
+public:
+    /// \brief Allocates the buffer
+    /// \param capacity Number of cells, it is rounded up to the next power of two
+    MPSCRingBuffer(size_t capacity) :
+        m_nMask(0),
+        m_nEnqueuePos(0),
+        m_nDequeuePos(0)
+    {
+        size_t size=2;
+        while (size<capacity)
+            size<<=1;
+
+        m_nMask=size-1;
+        m_Cells.reset(new Cell[size]);
+        for (size_t i=0; i<size; ++i)
+            m_Cells[i].sequence.store(i,std::memory_order_relaxed);
+    }
+
+    /// \brief Adds an item, can be called concurrently from several threads.
+    /// \param item The item to add, it is moved into the buffer on success.
+    /// \returns false if the buffer is full
+    bool Push(T &item)
+    {
+        size_t pos=m_nEnqueuePos.load(std::memory_order_relaxed);
+        Cell *cell=nullptr;
+
+        for (;;) {
+            cell=&m_Cells[pos & m_nMask];
+            const size_t seq=cell->sequence.load(std::memory_order_acquire);
+            const ptrdiff_t diff=static_cast<ptrdiff_t>(seq)-static_cast<ptrdiff_t>(pos);
+
+            if (diff==0) {
+                if (m_nEnqueuePos.compare_exchange_weak(pos,pos+1,std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff<0) {
+                return false;
+            }
+            else {
+                pos=m_nEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data=std::move(item);
+        cell->sequence.store(pos+1,std::memory_order_release);
+
+        return true;
+    }
+
+    /// \brief Removes the oldest item, must only be called from the consumer thread.
+    /// \param item Receives the item
+    /// \returns false if the buffer is empty
+    bool Pop(T &item)
+    {
+        const size_t pos=m_nDequeuePos.load(std::memory_order_relaxed);
+        Cell &cell=m_Cells[pos & m_nMask];
+
+        if (cell.sequence.load(std::memory_order_acquire)!=pos+1)
+            return false;
+
+        item=std::move(cell.data);
+        cell.sequence.store(pos+m_nMask+1,std::memory_order_release);
+        m_nDequeuePos.store(pos+1,std::memory_order_release);
+
+        return true;
+    }
+
+    /// \returns The number of positions claimed by the producers
+    size_t Pushed() const { return m_nEnqueuePos.load(std::memory_order_acquire); }
+    /// \returns The number of items removed by the consumer
+    size_t Popped() const { return m_nDequeuePos.load(std::memory_order_acquire); }
+    /// \returns The number of cells
+    size_t Size() const { return m_nMask+1; }
+
+private:
+    MPSCRingBuffer(const MPSCRingBuffer &) = delete;
+    MPSCRingBuffer & operator=(const MPSCRingBuffer &) = delete;
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> m_Cells;
+    size_t m_nMask;
+    // The padding keeps the producer and consumer positions on separate cache lines
+    char m_Pad0[64];
+    std::atomic<size_t> m_nEnqueuePos;
+    char m_Pad1[64];
+    std::atomic<size_t> m_nDequeuePos;
+};
+
+}}
+#endif // MPSCRINGBUFFER_H
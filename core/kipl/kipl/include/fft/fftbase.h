@@ -7,6 +7,7 @@
 
 #include <complex>
 #include <cstring>
+#include <vector>
 #include <fftw3.h>
 
 #include "../logging/logger.h"
@@ -80,6 +81,11 @@ protected:
 };
 
 
+/// \brief Single precision version of FFTBase
+///
+/// The plans are taken from the FFTPlanCache, i.e. instances with the same transform size share their plans and
+/// instances can be created concurrently by several threads. Use FFTBatchFloat to transform many lines or strided
+/// data with one call.
 class KIPLSHARED_EXPORT FFTBaseFloat{
 public:
 	/// \brief Constructor that defines size and rank of the transform
@@ -111,15 +117,21 @@ public:
 
     int size(int idx);
     
-    /// \brief The destruct removes transform plans and deallocates buffer memory
+    /// \brief The destructor deallocates the buffer memory, the plans stay in the cache
     ~FFTBaseFloat();
 protected:
+    /// \returns The transform size with the slowest varying axis first
+    std::vector<int> planDims() const;
+
+    /// \brief Allocates the SIMD aligned buffers needed by a transform
+    void allocateBuffers(bool complexB, bool real);
+
 	kipl::logging::Logger logger;
 	bool have_r2cPlan;
 	bool have_c2cPlan;
 	bool have_c2rPlan;
 	bool have_c2cPlanI;
-	fftwf_plan r2cPlan;
+	fftwf_plan r2cPlan;  ///< Plans owned by the FFTPlanCache
 	fftwf_plan c2rPlan;
 	fftwf_plan c2cPlan;
 	fftwf_plan c2cPlanI;
@@ -0,0 +1,175 @@
+//<LICENCE>
+
+#ifndef FFTPLANCACHE_H
+#define FFTPLANCACHE_H
+
+#include "../kipl_global.h"
+
+#include <complex>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <fftw3.h>
+
+#include "../logging/logger.h"
+
+namespace kipl { namespace math { namespace fft {
+
+/// \brief Planning effort used when new plans are created
+enum eFFTPlanning {
+    FFTPlanEstimate, ///< Heuristic plans, no planning time
+    FFTPlanMeasure,  ///< Plans selected by timing a set of candidates
+    FFTPlanPatient   ///< Plans selected by timing a larger set of candidates
+};
+
+/// \brief Kinds of transforms handled by the plan cache
+enum eFFTKind {
+    FFTForwardC2C,  ///< Complex forward transform
+    FFTBackwardC2C, ///< Complex inverse transform, not normalized
+    FFTForwardR2C,  ///< Real to half complex forward transform
+    FFTBackwardC2R  ///< Half complex to real inverse transform, not normalized
+};
+
+/// \brief Process wide cache of single precision FFTW plans.
+///
+/// Plans are created once per transform geometry on scratch buffers and are then executed on the caller's arrays
+/// using the new-array execute functions of FFTW. Creating and executing plans through the cache is therefore thread
+/// safe, which is not the case for the plain FFTW planner. Plans can be computed with more effort than FFTW_ESTIMATE
+/// and the resulting wisdom can be kept in a file to avoid the planning time in the next session.
+///
+/// Multi-threaded transforms are available when the library is built with HAVE_FFTW_THREADS.
+class KIPLSHARED_EXPORT FFTPlanCache
+{
+    kipl::logging::Logger logger;
+public:
+    /// \returns The cache instance
+    static FFTPlanCache & instance();
+
+    ~FFTPlanCache();
+
+    /// \brief Gets a plan from the cache, the plan is created if it doesn't exist
+    /// \param kind The kind of transform
+    /// \param n Size of one transform with the slowest varying axis first, i.e. the FFTW order
+    /// \param howmany Number of transforms computed by one execution
+    /// \param istride Distance between two samples of the input
+    /// \param idist Distance between the first samples of two consecutive inputs
+    /// \param ostride Distance between two samples of the output
+    /// \param odist Distance between the first samples of two consecutive outputs
+    /// \param inPlace The plan will be executed with the same array as input and output
+    /// \param aligned The arrays passed to the plan are SIMD aligned
+    /// \returns The plan, it is owned by the cache
+    /// \throws KiplException if FFTW can't create a plan for the layout
+    fftwf_plan plan(eFFTKind kind, const std::vector<int> &n, int howmany,
+                    int istride, int idist, int ostride, int odist,
+                    bool inPlace, bool aligned);
+
+    /// \brief Sets the planning effort for plans created after the call
+    void setPlanning(eFFTPlanning planning);
+
+    /// \returns The planning effort
+    eFFTPlanning planning();
+
+    /// \brief Sets the number of threads used by each transform
+    /// \param nThreads Number of threads, 1 gives single threaded transforms
+    /// \returns false if the library was built without FFTW threads
+    bool setThreads(int nThreads);
+
+    /// \returns The number of threads used by each transform
+    int threads();
+
+    /// \brief Imports FFTW wisdom from a file
+    /// \param fname Name of the wisdom file
+    /// \returns true if the wisdom could be read
+    bool loadWisdom(const std::string &fname);
+
+    /// \brief Exports the accumulated FFTW wisdom to a file
+    /// \param fname Name of the wisdom file
+    /// \returns true if the file could be written
+    bool saveWisdom(const std::string &fname);
+
+    /// \brief Selects a wisdom file that is loaded now and updated when new measured plans are created
+    /// \param fname Name of the wisdom file, an empty string stops the updates
+    void setWisdomFile(const std::string &fname);
+
+    /// \returns The number of cached plans
+    size_t size();
+
+    /// \brief Destroys all cached plans, plans obtained before the call must not be used afterwards
+    void clear();
+
+    /// \returns true if the array has the alignment FFTW uses for its own buffers
+    static bool isAligned(const void *p);
+
+private:
+    FFTPlanCache();
+    FFTPlanCache(const FFTPlanCache &) = delete;
+    FFTPlanCache & operator=(const FFTPlanCache &) = delete;
+
+    std::mutex m_Mutex;
+    std::map<std::vector<int>,fftwf_plan> m_Plans;
+    eFFTPlanning m_ePlanning;
+    int m_nThreads;
+    std::string m_sWisdomFile;
+};
+
+/// \brief Batches of single precision transforms of the same size executed by one call.
+///
+/// The transforms use plans from the FFTPlanCache, an instance can be created in any thread and it can be shared by
+/// several threads as long as they work on different arrays. The data are not copied to internal buffers and the
+/// samples can be strided, e.g. the columns of an image are transformed with stride=width and distance=1.
+///
+/// The half complex side of the real transforms has Dims[0]/2+1 elements along the fastest axis. In place real
+/// transforms need the fastest axis of the real array padded to 2*(Dims[0]/2+1) elements. The inverse transforms are
+/// not normalized.
+class KIPLSHARED_EXPORT FFTBatchFloat
+{
+public:
+    /// \brief Defines the size and layout of the transforms
+    /// \param Dims Size of one transform, Dims[0] is the fastest varying axis
+    /// \param NDim Rank of the transform (1-3)
+    /// \param howmany Number of transforms per call
+    /// \param realStride Distance between two samples of the real (or complex input for c2c) arrays
+    /// \param realDist Distance between two transforms of the real arrays, 0 for packed transforms
+    /// \param complexStride Distance between two samples of the complex arrays
+    /// \param complexDist Distance between two transforms of the complex arrays, 0 for packed transforms
+    /// \throws KiplException for unsupported ranks
+    FFTBatchFloat(size_t const * const Dims, size_t NDim, size_t howmany=1,
+                  size_t realStride=1, size_t realDist=0,
+                  size_t complexStride=1, size_t complexDist=0);
+
+    /// \brief Real to half complex forward transforms
+    /// \param in The real input, it is not modified by out-of-place transforms
+    /// \param out The half complex result
+    void forward(float *in, std::complex<float> *out);
+
+    /// \brief Half complex to real inverse transforms
+    /// \param in The half complex input, it is overwritten
+    /// \param out The real result
+    void inverse(std::complex<float> *in, float *out);
+
+    /// \brief Complex forward transforms, the input uses the real layout and the output the complex layout
+    void forward(std::complex<float> *in, std::complex<float> *out);
+
+    /// \brief Complex inverse transforms, the input uses the complex layout and the output the real layout
+    void inverse(std::complex<float> *in, std::complex<float> *out);
+
+    /// \returns Number of transforms per call
+    size_t batchSize() const;
+
+    /// \returns Number of complex elements of one packed half complex transform
+    size_t halfComplexSize() const;
+
+private:
+    fftwf_plan getPlan(eFFTKind kind, const void *in, const void *out) const;
+
+    std::vector<int> n;
+    int howmany;
+    int realStride;
+    int realDist;
+    int complexStride;
+    int complexDist;
+};
+
+}}}
+#endif // FFTPLANCACHE_H
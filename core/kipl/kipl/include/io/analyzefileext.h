@@ -43,6 +43,14 @@ enum eFileType {
     PNG16bits
 };
 
+/// \brief Lossless compression schemes for TIFF output
+enum eTIFFCompression {
+    TIFFCompressionNone,    ///< Uncompressed strips
+    TIFFCompressionDeflate, ///< Deflate (zip) compression
+    TIFFCompressionLZW,     ///< Lempel-Ziv-Welch compression
+    TIFFCompressionZSTD     ///< Zstandard compression, needs libtiff 4.0.10 or later built with zstd
+};
+
 eExtensionTypes KIPLSHARED_EXPORT GetFileExtensionType(std::string fname);
 
 }}
@@ -66,5 +74,9 @@ std::string KIPLSHARED_EXPORT enum2string(kipl::io::eExtensionTypes et);
 std::ostream KIPLSHARED_EXPORT & operator<<(std::ostream &s, const kipl::io::eFileType &ft);
 void KIPLSHARED_EXPORT string2enum(const std::string &str, kipl::io::eFileType &ft);
 std::string KIPLSHARED_EXPORT enum2string(const kipl::io::eFileType &ft);
+
+std::ostream KIPLSHARED_EXPORT & operator<<(std::ostream &s, const kipl::io::eTIFFCompression &c);
+void KIPLSHARED_EXPORT string2enum(const std::string &str, kipl::io::eTIFFCompression &c);
+std::string KIPLSHARED_EXPORT enum2string(const kipl::io::eTIFFCompression &c);
 #endif // ANALYZEFILEEXT_H
 
@@ -33,98 +33,56 @@ int KIPLSHARED_EXPORT FITSDataType(double x);
 template <typename ImgType>
 int ReadFITS(kipl::base::TImage<ImgType,2> &src,char const * const fname, size_t const * const nCrop, size_t idx)
 {
-    using namespace std;
-    ostringstream msg;
-	fitsfile *fptr;
-	int status=0;
-	fits_open_image(&fptr, fname, READONLY, &status);
-    if (status!=0) {
-        msg.str("");
-        char errtext[2048];
-        fits_get_errstatus(status,errtext);
-        msg<<"Failed opening "<<fname<<std::endl<<errtext;
+    std::ostringstream msg;
+
+    const FITSLayout layout=GetFITSLayout(fname);
+    const size_t nx = layout.dims[0];
+    const size_t ny = layout.naxis < 2 ? 1 : layout.dims[1];
+
+    if ((2<layout.naxis) && (layout.dims[2]<=idx)) {
+        msg<<"Slice index "<<idx<<" out of bounds ("<<layout.dims[2]<<") for file "<<fname;
         throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
     }
 
-	int bitpix=0;
-	int naxis;
-    long naxes[10];
-	
-	try {
-		fits_get_img_param(fptr, 2,  &bitpix, &naxis, naxes, &status);
-	}
-	catch (std::exception &e) {
-		throw kipl::base::KiplException(e.what(), __FILE__, __LINE__);
-	}
-	catch (...) {
-		throw kipl::base::KiplException("Unknown exception",__FILE__,__LINE__);
-	}
-	if (status!=0) {
-		char err_text[512];
-		
-		fits_get_errstatus(status, err_text);
-		std::stringstream msg;
-		msg<<"ReadFITS: "<<err_text<<" ("<<fname<<")";
-		throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-	}
-	
-
-	size_t dims[3];
-    long coord[3]={1,0,long(naxis == 3 ? idx +1: 1)};
+    long first[8]={1,1,1,1,1,1,1,1};
+    long last[8]={1,1,1,1,1,1,1,1};
+
+    size_t dims[2]={nx,ny};
     if (nCrop==nullptr) {
-		dims[0]=static_cast<size_t>(naxes[0]);
-		dims[1]=naxis < 2 ? 1 : static_cast<size_t>(naxes[1]);
-	}
-	else {
-        if ((naxes[0]<=static_cast<long>(nCrop[0])) ||
-                (naxes[0]<=static_cast<long>(nCrop[2])) ||
-                (naxes[1]<=static_cast<long>(nCrop[1])) ||
-                (naxes[1]<=static_cast<long>(nCrop[3])))
+        last[0]=static_cast<long>(nx);
+        last[1]=static_cast<long>(ny);
+    }
+    else {
+        if ((nx<nCrop[2]) || (ny<nCrop[3]))
         {
-            msg.str("");
-            msg<<"Cropping region ("<<nCrop[0]<<", "<<nCrop[1]<<", "<<nCrop[2]<<", "<<nCrop[3]<<") out of bounds ("<<naxes[0]<<", "<<naxes[1]<<") for file "<<fname;
+            msg<<"Cropping region ("<<nCrop[0]<<", "<<nCrop[1]<<", "<<nCrop[2]<<", "<<nCrop[3]<<") out of bounds ("<<nx<<", "<<ny<<") for file "<<fname;
             throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
         }
 
         if ((nCrop[2]<=nCrop[0]) || (nCrop[3]<=nCrop[1])) {
-            msg.str("");
             msg<<"Invalid cropping region for file "<<fname<<" ("<<nCrop[0]<<", "<<nCrop[1]<<", "<<nCrop[2]<<", "<<nCrop[3]<<")";
             throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
         }
-			
-		dims[0]=nCrop[2]-nCrop[0];
-		dims[1]=nCrop[3]-nCrop[1];
-		coord[0]=static_cast<long>(nCrop[0]+1);
-	}
-	src.Resize(dims);
-	
-
-	int datatype=FITSDataType(static_cast<ImgType>(0));
-	
-    const size_t cnStart = nCrop==nullptr ? 0 : min(static_cast<size_t>(naxes[1]),nCrop[1]);
-    const size_t cnStop  = nCrop==nullptr ? dims[1] : min(static_cast<size_t>(naxes[1]),nCrop[3]);
-
-    ImgType *pLine=new ImgType[naxes[0]+16];
-	for (size_t i=cnStart, j=0; i<cnStop; i++,j++) {
-        coord[1]=static_cast<int>(i+1);
-
-		if (fits_read_pix(fptr, datatype, coord, static_cast<int>(dims[0]), 
-                nullptr, pLine, nullptr, &status))
-		{
-			char err_text[512];
-            fits_get_errstatus(status, err_text);
-            std::stringstream msg;
-            msg<<"ReadFITS: "<<err_text<<" ("<<fname<<")";
-            throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-		}
 
-        std::copy(pLine, pLine+src.Size(0), src.GetLinePtr(j));
-	}
+        dims[0]=nCrop[2]-nCrop[0];
+        dims[1]=nCrop[3]-nCrop[1];
+        first[0]=static_cast<long>(nCrop[0]+1);
+        first[1]=static_cast<long>(nCrop[1]+1);
+        last[0]=static_cast<long>(nCrop[2]);
+        last[1]=static_cast<long>(nCrop[3]);
+    }
 
-	delete [] pLine;
-	fits_close_file(fptr, &status);
-	
-	return 0;
+    if (2<layout.naxis) {
+        first[2]=static_cast<long>(idx+1);
+        last[2]=static_cast<long>(idx+1);
+    }
+
+    src.Resize(dims);
+
+    // The crop rows are contiguous in the destination, the whole region is read in one call
+    ReadFITSSubset(fname, FITSDataType(static_cast<ImgType>(0)), std::max(layout.naxis,2), first, last, src.GetDataPtr());
+
+    return 0;
 }
 
 template <typename ImgType>
@@ -149,6 +107,7 @@ int WriteFITS(kipl::base::TImage<ImgType,2> & src,char const * const filename)
 //    for( ii=1; ii<naxes[1]; ii++ )
 //      array[ii] = array[ii-1] + naxes[0];
 
+    ReleaseFITSFile(filename);                      // Close the cached handle of the old file
     remove(filename);                               // Delete old file if it already exists
 
     status = 0;                                     // initialize status before calling fitsio routines
@@ -9,6 +9,7 @@
 #include "../../base/kiplenums.h"
 #include "../../base/KiplException.h"
 #include "../../logging/logger.h"
+#include "../io_mappedfile.h"
 
 
 #include <list>
@@ -27,16 +28,13 @@ int ReadGeneric(kipl::base::TImage<ImgType,2> &img,
                 size_t imageindex,
                 size_t const * const nCrop)
 {
-    std::ifstream datfile(fname, ios_base::binary);
-
-    if (!datfile.good()) {
-        std::ostringstream msg;
-        msg<<"ReadGeneric failed to open file: "<<fname;
-        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    if (imagesperfile<=imageindex) {
+        throw kipl::base::KiplException("Tried to access a non-existing image",__FILE__,__LINE__);
     }
 
-    ReadGeneric(datfile,img,size_x,size_y,offset,stride,imagesperfile,dt,endian, imageindex,nCrop);
+    kipl::io::MappedFrameReader reader(fname,size_x,size_y,offset,stride,size_y*stride,dt,endian);
 
+    reader.readFrame(imageindex,img,nCrop);
 
     return 0;
 }
@@ -53,19 +51,19 @@ int ReadGeneric(std::list<kipl::base::TImage<ImgType,2> > &imglist,
                 kipl::base::eEndians endian,
                 size_t const * const nCrop)
 {
-    std::ifstream datfile(fname, ios_base::binary);
+    kipl::io::MappedFrameReader reader(fname,size_x,size_y,offset,stride,size_y*stride,dt,endian);
 
-    if (!datfile.good()) {
+    if (reader.numberOfFrames()<imagesperfile) {
         std::ostringstream msg;
-        msg<<"ReadGeneric failed to open file: "<<fname;
+        msg<<"ReadGeneric: "<<fname<<" only contains "<<reader.numberOfFrames()<<" of "<<imagesperfile<<" images";
         throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
     }
 
-    kipl::base::TImage<ImgType,2> tmp;
     imglist.clear();
 
     for (size_t i=0; i<imagesperfile; i++) {
-        ReadGeneric(datfile,tmp,size_x,size_y,offset,stride,imagesperfile,dt,endian,i,nCrop);
+        kipl::base::TImage<ImgType,2> tmp;
+        reader.readFrame(i,tmp,nCrop);
 
         imglist.push_back(tmp);
     }
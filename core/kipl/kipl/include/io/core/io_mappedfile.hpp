@@ -0,0 +1,118 @@
+//<LICENCE>
+
+#ifndef IO_MAPPEDFILE_HPP
+#define IO_MAPPEDFILE_HPP
+
+#include <cstring>
+#include <cstdint>
+#include <sstream>
+
+#include "../../base/KiplException.h"
+
+namespace kipl { namespace io {
+
+template <typename ImgType>
+void MappedFrameReader::convertLine(const char *src, ImgType *dst, size_t x0, size_t N) const
+{
+    const unsigned char *pSrc = reinterpret_cast<const unsigned char *>(src);
+
+    // The loops use memcpy for the loads since the mapped lines are not necessarily aligned,
+    // the compiler turns them into plain (vector) loads.
+    switch (m_DataType) {
+    case kipl::base::UInt4 :
+        // Same nibble order as the converter union, the first pixel is in the high nibble
+        for (size_t j=0; j<N; ++j) {
+            const size_t x=x0+j;
+            const unsigned char b=pSrc[x/2];
+            dst[j] = static_cast<ImgType>((x & 1) ? (b & 0x0f) : (b >> 4));
+        }
+        break;
+    case kipl::base::UInt8 :
+        pSrc+=x0;
+        for (size_t j=0; j<N; ++j)
+            dst[j] = static_cast<ImgType>(pSrc[j]);
+        break;
+    case kipl::base::UInt12 :
+        // Two pixels in three bytes, same bit order as the converter union
+        for (size_t j=0; j<N; ++j) {
+            const size_t x=x0+j;
+            const unsigned char *p=pSrc+3*(x/2);
+            dst[j] = static_cast<ImgType>((x & 1) ? ((p[1] >> 4) + (p[2] << 4)) : ((p[1] & 0x0f) + (p[0] << 4)));
+        }
+        break;
+    case kipl::base::UInt16 :
+        pSrc+=2*x0;
+        if (m_bSwap) {
+            for (size_t j=0; j<N; ++j) {
+                uint16_t v;
+                std::memcpy(&v,pSrc+2*j,sizeof(v));
+                dst[j] = static_cast<ImgType>(static_cast<uint16_t>((v>>8) | (v<<8)));
+            }
+        }
+        else {
+            for (size_t j=0; j<N; ++j) {
+                uint16_t v;
+                std::memcpy(&v,pSrc+2*j,sizeof(v));
+                dst[j] = static_cast<ImgType>(v);
+            }
+        }
+        break;
+    case kipl::base::Float32 :
+        pSrc+=4*x0;
+        for (size_t j=0; j<N; ++j) {
+            uint32_t v;
+            std::memcpy(&v,pSrc+4*j,sizeof(v));
+            if (m_bSwap)
+                v = (v>>24) | ((v>>8) & 0x0000ff00u) | ((v<<8) & 0x00ff0000u) | (v<<24);
+            float f;
+            std::memcpy(&f,&v,sizeof(f));
+            dst[j] = static_cast<ImgType>(f);
+        }
+        break;
+    }
+}
+
+template <typename ImgType>
+void MappedFrameReader::readFrame(size_t idx, kipl::base::TImage<ImgType,2> &img, size_t const * const roi) const
+{
+    size_t bounds[4];
+    checkROI(roi,bounds);
+
+    size_t dims[2]={bounds[2]-bounds[0], bounds[3]-bounds[1]};
+    img.Resize(dims);
+
+    for (size_t y=bounds[1]; y<bounds[3]; ++y)
+        convertLine(linePtr(idx,y),img.GetLinePtr(y-bounds[1]),bounds[0],dims[0]);
+}
+
+template <typename ImgType>
+void MappedFrameReader::readFrames(kipl::base::TImage<ImgType,3> &img, size_t first, size_t last, size_t step, size_t const * const roi) const
+{
+    if ((last<first) || (step==0))
+        throw kipl::base::KiplException("MappedFrameReader: invalid frame range",__FILE__,__LINE__);
+
+    if (m_nFrames<last) {
+        std::ostringstream msg;
+        msg<<"MappedFrameReader: frame "<<last-1<<" is out of range, "<<m_File.fileName()<<" has "<<m_nFrames<<" frames";
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    size_t bounds[4];
+    checkROI(roi,bounds);
+
+    const ptrdiff_t N = static_cast<ptrdiff_t>((last-first+step-1)/step);
+    size_t dims[3]={bounds[2]-bounds[0], bounds[3]-bounds[1], static_cast<size_t>(N)};
+    img.Resize(dims);
+
+    // Each thread touches different pages of the mapping, the page faults are served in parallel
+    #pragma omp parallel for schedule(dynamic)
+    for (ptrdiff_t i=0; i<N; ++i) {
+        const size_t idx=first+i*step;
+        for (size_t y=bounds[1]; y<bounds[3]; ++y)
+            convertLine(linePtr(idx,y),img.GetLinePtr(y-bounds[1],i),bounds[0],dims[0]);
+    }
+}
+
+}}
+
+#endif // IO_MAPPEDFILE_HPP
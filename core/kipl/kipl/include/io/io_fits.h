@@ -14,7 +14,12 @@ namespace kipl { namespace io {
 /// \param src the image to store the file contents
 /// \param fname File name of the file to read
 /// \param nCrop optional crop region. The entire image will be read if the value is set to nullptr.
+/// \param idx Index of the slice to read if the file contains a 3D image.
 /// \returns Always 0.
+///
+/// The region is read with a single subset read directly into the image buffer, CFITSIO converts the
+/// pixels to ImgType on the fly and only decompresses the tiles that intersect the region for tile
+/// compressed images.
 template <typename ImgType>
 int ReadFITS(kipl::base::TImage<ImgType,2> &src,char const * const fname, size_t const * const nCrop=nullptr, size_t idx=0L);
 
@@ -32,6 +37,39 @@ int WriteFITS(kipl::base::TImage<ImgType,2> &src,char const * const fname);
 /// \returns number of dimensions
 int KIPLSHARED_EXPORT GetFITSDims(char const * const filename,size_t * dims);
 
+/// \brief Layout of the first image HDU in a fits file
+struct KIPLSHARED_EXPORT FITSLayout {
+    int naxis;          ///< Number of axes
+    size_t dims[8];     ///< Axis lengths, only the first naxis are valid
+    int bitpix;         ///< Pixel type in the file
+    bool compressed;    ///< The image is stored as a tile compressed binary table
+};
+
+/// \brief Gets the image layout of a fits file.
+///
+/// The layouts are cached by file name, size and modification time. The file is kept open with the layout
+/// of the most recently used files, the layout query and the following ReadFITS of a file share one header
+/// parse and further crops of the same file, e.g. one per slice block, don't parse the header.
+/// \param filename Name of the fits file
+/// \returns The layout of the first image HDU
+FITSLayout KIPLSHARED_EXPORT GetFITSLayout(char const * const filename);
+
+/// \brief Removes all cached fits layouts and closes the cached files
+void KIPLSHARED_EXPORT ClearFITSLayoutCache();
+
+/// \brief Removes the cached layout of a file and closes it, e.g. before the file is rewritten
+/// \param filename Name of the fits file
+void KIPLSHARED_EXPORT ReleaseFITSFile(char const * const filename);
+
+/// \brief Reads a hyper-rectangle of pixels in a single call.
+/// \param filename Name of the fits file
+/// \param datatype CFITSIO data type of the destination buffer
+/// \param naxis Number of elements in first and last
+/// \param first One-based coordinates of the first pixel
+/// \param last One-based coordinates of the last pixel (inclusive)
+/// \param data Destination buffer, it must be large enough for the complete region
+void KIPLSHARED_EXPORT ReadFITSSubset(char const * const filename, int datatype, int naxis, long *first, long *last, void *data);
+
 
 }}
 
@@ -0,0 +1,129 @@
+//<LICENCE>
+
+#ifndef IO_MAPPEDFILE_H
+#define IO_MAPPEDFILE_H
+
+#include "../kipl_global.h"
+
+#include <string>
+
+#include "../base/timage.h"
+#include "../base/kiplenums.h"
+
+namespace kipl { namespace io {
+
+/// \brief Read-only memory map of a complete file.
+///
+/// The pages are loaded on demand by the operating system, i.e. reading a sub region of a large file only
+/// touches the pages that are needed and no read calls are issued.
+class KIPLSHARED_EXPORT MappedFile
+{
+public:
+    /// \brief Maps a file
+    /// \param fname Name of the file to map
+    /// \throws KiplException if the file can't be opened or mapped
+    MappedFile(const std::string &fname);
+    ~MappedFile();
+
+    /// \returns A pointer to the first byte of the file
+    const char * data() const { return m_pData; }
+    /// \returns The size of the file in bytes
+    size_t size() const { return m_nSize; }
+    /// \returns The name of the mapped file
+    const std::string & fileName() const { return m_sFileName; }
+
+private:
+    MappedFile(const MappedFile &) = delete;
+    MappedFile & operator=(const MappedFile &) = delete;
+
+    std::string m_sFileName;
+    const char *m_pData;
+    size_t m_nSize;
+#ifdef _MSC_VER
+    void *m_hFile;
+    void *m_hMapping;
+#else
+    int m_nFile;
+#endif
+};
+
+/// \brief Reader for files with fixed size frames, e.g. ViVa SEQ files or raw camera dumps.
+///
+/// The file is memory mapped and the frames are available as zero-copy views. The read methods convert
+/// the region of interest line by line directly from the mapped pages into the destination image.
+class KIPLSHARED_EXPORT MappedFrameReader
+{
+public:
+    /// \brief Maps a file with fixed size frames
+    /// \param fname Name of the file
+    /// \param width Number of pixels per line
+    /// \param height Number of lines per frame
+    /// \param offset Number of bytes before the first frame, e.g. a header
+    /// \param lineStride Number of bytes between the starts of two lines
+    /// \param frameStride Number of bytes between the starts of two frames
+    /// \param dt The pixel data type in the file
+    /// \param endian The byte order of the pixels in the file
+    /// \throws KiplException if the file is too small for a single frame
+    MappedFrameReader(const std::string &fname,
+                      size_t width,
+                      size_t height,
+                      size_t offset,
+                      size_t lineStride,
+                      size_t frameStride,
+                      kipl::base::eDataType dt,
+                      kipl::base::eEndians endian=kipl::base::SmallEndian);
+
+    /// \returns The number of complete frames in the file
+    size_t numberOfFrames() const { return m_nFrames; }
+    /// \returns The frame width (0) or height (1)
+    size_t size(size_t i) const { return i==0 ? m_nWidth : m_nHeight; }
+
+    /// \brief Zero-copy view of a frame in the file
+    /// \param idx Frame index
+    /// \returns A pointer to the first byte of the frame
+    const char * framePtr(size_t idx) const;
+
+    /// \brief Zero-copy view of a line in the file
+    /// \param idx Frame index
+    /// \param line Line index in the frame
+    /// \returns A pointer to the first byte of the line
+    const char * linePtr(size_t idx, size_t line) const;
+
+    /// \brief Reads a frame
+    /// \param idx Frame index
+    /// \param img Destination image, it is only reallocated if the size changes.
+    /// \param roi Region of interest (x0,y0,x1,y1), the full frame is read if nullptr
+    template <typename ImgType>
+    void readFrame(size_t idx, kipl::base::TImage<ImgType,2> &img, size_t const * const roi=nullptr) const;
+
+    /// \brief Reads a range of frames, the frames are converted in parallel.
+    /// \param img Destination image, slice i contains frame first+i*step
+    /// \param first First frame to read
+    /// \param last The frame after the last frame to read
+    /// \param step Frame increment
+    /// \param roi Region of interest (x0,y0,x1,y1), the full frames are read if nullptr
+    template <typename ImgType>
+    void readFrames(kipl::base::TImage<ImgType,3> &img, size_t first, size_t last, size_t step=1, size_t const * const roi=nullptr) const;
+
+private:
+    void checkROI(size_t const * const roi, size_t *bounds) const;
+
+    template <typename ImgType>
+    void convertLine(const char *src, ImgType *dst, size_t x0, size_t N) const;
+
+    MappedFile m_File;
+    size_t m_nWidth;
+    size_t m_nHeight;
+    size_t m_nOffset;
+    size_t m_nLineStride;
+    size_t m_nFrameStride;
+    size_t m_nFrames;
+    kipl::base::eDataType m_DataType;
+    bool m_bSwap;
+};
+
+}}
+
+#include "core/io_mappedfile.hpp"
+
+#endif // IO_MAPPEDFILE_H
@@ -0,0 +1,165 @@
+//<LICENCE>
+
+#ifndef IO_MULTIFRAMETIFF_H
+#define IO_MULTIFRAMETIFF_H
+
+#include "../kipl_global.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <algorithm>
+
+#include <tiffio.h>
+
+#include "../base/timage.h"
+#include "../base/KiplException.h"
+#include "io_tiff.h"
+
+namespace kipl { namespace io {
+
+/// \brief Random access to the frames of a multi-frame TIFF or BigTIFF file.
+///
+/// The frames are reached directly through the cached frame index instead of walking the directory chain for each
+/// frame. A libtiff handle can't be used by several threads at the same time, the reader therefore keeps a pool of
+/// open handles and each read borrows one handle. Frames can be read concurrently from several threads and the file
+/// is only opened once per thread.
+class KIPLSHARED_EXPORT MultiFrameTIFF
+{
+public:
+    /// \brief Opens the file and gets its frame index
+    /// \param fname file name of the image file
+    /// \throws KiplException if the file can't be opened
+    MultiFrameTIFF(const std::string &fname);
+
+    /// \brief Closes all handles
+    ~MultiFrameTIFF();
+
+    /// \returns The number of frames in the file
+    size_t frames() const;
+
+    /// \returns The size of the first frame
+    const size_t * dims() const;
+
+    /// \returns The name of the file
+    const std::string & fileName() const;
+
+    /// \brief Reads a frame
+    /// \param img the image to be stored
+    /// \param idx index of the frame
+    /// \param crop region to read (x0,y0,x1,y1), the full frame is read if crop is nullptr
+    /// \returns The number of bits per sample of the frame
+    /// \throws KiplException if the frame doesn't exist or can't be read
+    template <class ImgType>
+    int read(kipl::base::TImage<ImgType,2> &img, size_t idx, size_t const * const crop=nullptr);
+
+    /// \brief Reads a range of frames into a volume, the frames are read in parallel
+    /// \param img the volume to be stored, slice i is frame first+i
+    /// \param first index of the first frame
+    /// \param last index of the last frame (inclusive)
+    /// \param crop region to read from each frame, the full frames are read if crop is nullptr
+    /// \returns The number of bits per sample of the frames
+    /// \throws KiplException if the range is invalid or if a frame can't be read
+    template <class ImgType>
+    int read(kipl::base::TImage<ImgType,3> &img, size_t first, size_t last, size_t const * const crop=nullptr);
+
+private:
+    MultiFrameTIFF(const MultiFrameTIFF &) = delete;
+    MultiFrameTIFF & operator=(const MultiFrameTIFF &) = delete;
+
+    /// \brief Takes a handle from the pool, or opens a new one, and moves it to a frame
+    TIFF * acquire(size_t idx);
+
+    /// \brief Returns a handle to the pool
+    /// \param image the handle
+    /// \param reuse Put the handle back in the pool, otherwise it is closed
+    void release(TIFF *image, bool reuse=true);
+
+    std::string m_sFileName;
+    std::shared_ptr<const TIFFFrameIndex> m_Index;
+    std::mutex m_Mutex;
+    std::vector<TIFF *> m_Handles; ///< Open handles that are not in use
+};
+
+template <class ImgType>
+int MultiFrameTIFF::read(kipl::base::TImage<ImgType,2> &img, size_t idx, size_t const * const crop)
+{
+    TIFF *image=acquire(idx);
+
+    int bps=0;
+    try {
+        bps=ReadTIFFFrame(image,img,crop);
+    }
+    catch (...) {
+        release(image,false);
+        throw;
+    }
+    release(image);
+
+    return bps;
+}
+
+template <class ImgType>
+int MultiFrameTIFF::read(kipl::base::TImage<ImgType,3> &img, size_t first, size_t last, size_t const * const crop)
+{
+    std::ostringstream msg;
+
+    if ((last<first) || (frames()<=last)) {
+        msg<<"MultiFrameTIFF: The frame range "<<first<<"-"<<last<<" is outside the "<<frames()<<" frames of "<<m_sFileName;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    // The first frame gives the size of the volume
+    kipl::base::TImage<ImgType,2> frame;
+    int bps=read(frame,first,crop);
+
+    const size_t sliceSize=frame.Size();
+    const ptrdiff_t nFrames=static_cast<ptrdiff_t>(last-first+1);
+    size_t dims[3]={frame.Size(0),frame.Size(1),static_cast<size_t>(nFrames)};
+    img.Resize(dims);
+
+    ImgType *pData=img.GetDataPtr();
+    std::copy_n(frame.GetDataPtr(),sliceSize,pData);
+
+    std::string errorMessage;
+
+    #pragma omp parallel
+    {
+        kipl::base::TImage<ImgType,2> localFrame;
+
+        #pragma omp for schedule(dynamic)
+        for (ptrdiff_t i=1; i<nFrames; ++i) {
+            try {
+                read(localFrame,first+i,crop);
+                if (localFrame.Size()!=sliceSize) {
+                    std::ostringstream frameMsg;
+                    frameMsg<<"MultiFrameTIFF: Frame "<<first+i<<" of "<<m_sFileName<<" has a different size than frame "<<first;
+                    throw kipl::base::KiplException(frameMsg.str(),__FILE__,__LINE__);
+                }
+                std::copy_n(localFrame.GetDataPtr(),sliceSize,pData+i*sliceSize);
+            }
+            catch (kipl::base::KiplException &e) {
+                #pragma omp critical(MultiFrameTIFFError)
+                {
+                    errorMessage=e.what();
+                }
+            }
+            catch (std::exception &e) {
+                #pragma omp critical(MultiFrameTIFFError)
+                {
+                    errorMessage=e.what();
+                }
+            }
+        }
+    }
+
+    if (!errorMessage.empty())
+        throw kipl::base::KiplException(errorMessage,__FILE__,__LINE__);
+
+    return bps;
+}
+
+}}
+#endif // IO_MULTIFRAMETIFF_H
@@ -17,6 +17,13 @@
 #include <sstream>
 #include <vector>
 #include <map>
+#include <type_traits>
+#include <functional>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <nexus/napi.h>
 #include <nexus/NeXusFile.hpp>
@@ -719,6 +726,61 @@ int PrepareNeXusFile16bit(const char *fname, size_t *dims, float p_size, kipl::b
 }
 
 
+/// \brief Reads a range of slices from a volume written by WriteNeXusStack or WriteNeXusStack16bit without type conversion.
+/// \param img The slices, the image type must match the stored data type (float or unsigned short).
+/// \param fname file name of the source file
+/// \param start index of the first slice to read
+/// \param size number of slices to read
+/// \return The number of slices in the file
+template <class ImgType>
+size_t ReadNeXusSlab(kipl::base::TImage<ImgType,3> &img, const char *fname, size_t start, size_t size) {
+    std::ostringstream msg;
+    NXhandle file_id;
+
+    if (NXopen(fname, NXACC_READ, &file_id)!=NX_OK) {
+        msg<<"ReadNeXusSlab: Could not open "<<fname;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    int rank=0;
+    int type=0;
+    int dims[32];
+
+    NXopengroup (file_id, "entry", "NXentry");
+    NXopengroup (file_id, "Data1", "NXdata");
+    NXopendata (file_id, "signal");
+    NXgetinfo(file_id, &rank, dims, &type);
+
+    const bool bTypeMatch = ((type==NX_FLOAT32) && std::is_same<ImgType,float>::value) ||
+                            ((type==NX_UINT16)  && std::is_same<ImgType,unsigned short>::value);
+
+    if ((rank!=3) || !bTypeMatch || (static_cast<size_t>(dims[0])<start+size)) {
+        NXclosedata(file_id);
+        NXclosegroup(file_id);
+        NXclosegroup(file_id);
+        NXclose(&file_id);
+
+        msg<<"ReadNeXusSlab: Can't read slices "<<start<<"-"<<start+size<<" from "<<fname
+           <<" (rank="<<rank<<", slices="<<dims[0]<<", type="<<type<<")";
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    size_t imgDims[3]={static_cast<size_t>(dims[2]), static_cast<size_t>(dims[1]), size};
+    img.Resize(imgDims);
+
+    int slabstart[3] = {static_cast<int>(start), 0, 0};
+    int slabsize[3]  = {static_cast<int>(size), dims[1], dims[2]};
+
+    NXgetslab(file_id, img.GetDataPtr(), slabstart, slabsize);
+
+    NXclosedata(file_id);
+    NXclosegroup(file_id);
+    NXclosegroup(file_id);
+    NXclose(&file_id);
+
+    return static_cast<size_t>(dims[0]);
+}
+
 /// todo: Add Doxygen information
 template <class ImgType, size_t NDim>
 int WriteNeXusStack(kipl::base::TImage<ImgType,NDim> &img, const char *fname, size_t start, size_t size, const kipl::base::eImagePlanes imageplane=kipl::base::ImagePlaneYZ, size_t *roi=nullptr) {
@@ -1044,6 +1106,140 @@ int WriteNeXusStack16bit(kipl::base::TImage<ImgType,NDim> &img, const char *fnam
 }
 
 
+/// \brief Opens the signal data set of the first NXdata group that has one, the data set is left open.
+/// \param file an opened NeXus file
+/// \param dims receives the frame width, the frame height and the number of frames
+/// \throws KiplException if there is no signal data set or it is not three dimensional
+void KIPLSHARED_EXPORT OpenNexusSignal(NeXus::File &file, size_t *dims);
+
+/// \brief Reads a range of frames from the signal data set in pieces of consecutive frames.
+///
+/// One thread reads the next piece while the other threads convert and process the frames of the current piece,
+/// i.e. the NeXus library is only called from one thread at a time. Detectors write one frame per HDF5 chunk, the
+/// pieces are then aligned with the chunks and each chunk is read and decompressed once.
+/// \param fname file name of the NeXus file
+/// \param start index of the first frame
+/// \param end index after the last frame
+/// \param nCrop the region to read (x0,y0,x1,y1), the whole frame is read for nullptr
+/// \param process receives the frame index and the frame, it is called concurrently for different frames.
+/// The frame buffer is reused, the data must be copied to keep it.
+/// \param nPieceBytes approximate size of a piece in the file
+template <class ImgType>
+void ReadNexusFrames(const char *fname, size_t start, size_t end, size_t const * const nCrop,
+                     std::function<void(size_t index, kipl::base::TImage<ImgType,2> &frame)> process,
+                     size_t nPieceBytes=size_t(64)<<20)
+{
+    std::ostringstream msg;
+
+    NeXus::File file(fname);
+    size_t dims[3];
+    OpenNexusSignal(file,dims);
+
+    size_t crop[4]={0,0,dims[0],dims[1]};
+    if (nCrop!=nullptr)
+        std::copy(nCrop,nCrop+4,crop);
+
+    if ((end<=start) || (dims[2]<end) || (crop[2]<=crop[0]) || (crop[3]<=crop[1]) || (dims[0]<crop[2]) || (dims[1]<crop[3])) {
+        msg<<"ReadNexusFrames: frames "<<start<<"-"<<end<<" with crop ["<<crop[0]<<", "<<crop[1]<<", "<<crop[2]<<", "<<crop[3]
+           <<"] are outside the data set ("<<dims[0]<<"x"<<dims[1]<<"x"<<dims[2]<<")";
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    size_t frameDims[2]={crop[2]-crop[0], crop[3]-crop[1]};
+    const size_t nFramePixels=frameDims[0]*frameDims[1];
+
+#ifdef _OPENMP
+    const size_t nThreads=static_cast<size_t>(omp_get_max_threads());
+#else
+    const size_t nThreads=1;
+#endif
+    // At least one frame per thread, the frames are assumed to be int16 as in ReadNexusStack
+    const size_t nPiece=std::min(end-start,std::max(nThreads,nPieceBytes/(nFramePixels*sizeof(int16_t))));
+
+    std::vector<int16_t> current(nPiece*nFramePixels);
+    std::vector<int16_t> next(nPiece*nFramePixels);
+
+    auto readPiece = [&](size_t first, size_t n, int16_t *buffer) {
+        vector<int> slab_start={static_cast<int>(first), static_cast<int>(crop[1]), static_cast<int>(crop[0])};
+        vector<int> slab_size={static_cast<int>(n), static_cast<int>(frameDims[1]), static_cast<int>(frameDims[0])};
+
+        try {
+            file.getSlab(buffer, slab_start, slab_size);
+        }
+        catch (const std::exception & e) {
+            std::ostringstream errmsg;
+            errmsg<<"ReadNexusFrames file.getSlab caused an STL exception: "<<e.what();
+            throw kipl::base::KiplException(errmsg.str(),__FILE__,__LINE__);
+        }
+        catch (...) {
+            throw kipl::base::KiplException("ReadNexusFrames file.getSlab caused an unknown exception",__FILE__,__LINE__);
+        }
+    };
+
+    readPiece(start,nPiece,current.data());
+
+    for (size_t first=start; first<end; first+=nPiece) {
+        const size_t n=std::min(nPiece,end-first);
+        const size_t nNext=first+n<end ? std::min(nPiece,end-first-n) : 0;
+
+        bool bFailed=false;
+        std::string sError;
+
+        #pragma omp parallel
+        {
+            kipl::base::TImage<ImgType,2> frame(frameDims);
+
+            #pragma omp single nowait
+            {
+                if (nNext!=0) {
+                    try {
+                        readPiece(first+n,nNext,next.data());
+                    }
+                    catch (std::exception &e) {
+                        #pragma omp critical
+                        {
+                            bFailed=true;
+                            sError=e.what();
+                        }
+                    }
+                }
+            }
+
+            #pragma omp for schedule(dynamic)
+            for (ptrdiff_t i=0; i<static_cast<ptrdiff_t>(n); ++i) {
+                const int16_t *pSrc=current.data()+i*nFramePixels;
+                ImgType *pFrame=frame.GetDataPtr();
+
+                for (size_t j=0; j<nFramePixels; ++j)
+                    pFrame[j]=static_cast<ImgType>(pSrc[j]);
+
+                try {
+                    process(first+i,frame);
+                }
+                catch (std::exception &e) {
+                    #pragma omp critical
+                    {
+                        bFailed=true;
+                        sError=e.what();
+                    }
+                }
+            }
+        }
+
+        if (bFailed) {
+            msg<<"ReadNexusFrames failed for the frames "<<first<<"-"<<first+n+nNext-1<<" of "<<fname<<"\n"<<sError;
+            throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+        }
+
+        current.swap(next);
+    }
+
+    file.closeData();
+    file.closeGroup();
+    file.closeGroup();
+    file.close();
+}
+
 /// \brief Gets the dimensions of a Nexus image without reading the image
 /// \param fname file name of the image file
 /// \param dims array with the dimensions
@@ -7,6 +7,7 @@
 
 #include <sstream>
 #include <iostream>
+#include <algorithm>
 
 #include "../strings/filenames.h"
 #include "../base/timage.h"
@@ -92,6 +93,7 @@ int ReadImageStack(kipl::base::TImage<ImgType,3> & img,
 ///	\param start Index of first file in the sequence
 ///	\param stop Index of the first slice after the sequence
 ///	\param cntstart start value of the file counter
+///	\param tiffOptions compression and layout of the TIFF files. TIFF slices are written in parallel.
 ///	
 ///	\todo Implement cropping
 template<class ImgType>
@@ -100,7 +102,8 @@ int WriteImageStack(kipl::base::TImage<ImgType,3> img,const std::string fname,
 		const size_t start, const size_t stop, const size_t count_start=0,
 		kipl::io::eFileType filetype=kipl::io::MatlabSlices,
 		const kipl::base::eImagePlanes imageplane=kipl::base::ImagePlaneYZ,
-        size_t *roi=nullptr)
+        size_t *roi=nullptr,
+        const kipl::io::TIFFWriteOptions &tiffOptions=kipl::io::TIFFWriteOptions())
 {
 	if (stop<start)
 		kipl::base::KiplException("Stop index must be greater than start index.",__FILE__, __LINE__);
@@ -150,11 +153,81 @@ int WriteImageStack(kipl::base::TImage<ImgType,3> img,const std::string fname,
             filename=fname;
         }
         std::cerr<<filename<<std::endl;
-        WriteTIFF(img,filename.c_str());
+        if ((tiffOptions.compression==TIFFCompressionNone) && ((tiffOptions.tileSize[0]==0) || (tiffOptions.tileSize[1]==0))) {
+            WriteTIFF(img,filename.c_str());
+        }
+        else {
+            // The compressing writer needs the whole volume in 16 bits
+            kipl::base::TImage<unsigned short,3> vol16(img.Dims());
+            for (size_t i=0; i<img.Size(); ++i)
+                vol16[i]=static_cast<unsigned short>(img[i]);
+
+            vol16.info=img.info;
+            if (vol16.info.sDescription.empty())
+                vol16.info.sDescription="slope = 1.0E0\noffset = 0.0E0";
+
+            WriteTIFF(vol16,filename.c_str(),tiffOptions);
+        }
+        return 1;
+    }
+
+    if ((filetype==TIFF8bits) || (filetype==TIFF16bits) || (filetype==TIFFfloat))
+    {
+        // Each slice is a separate file, the slices are compressed and written in parallel
+        const ptrdiff_t nSlices=static_cast<ptrdiff_t>(stop-start);
+        std::string errorMessage;
+
+        // ExtractSlice reorders an inverted roi in place, it is done here before the threads share the roi
+        size_t sliceRoi[4]={0,0,0,0};
+        size_t *pRoi=nullptr;
+        if (roi!=nullptr) {
+            sliceRoi[0]=std::min(roi[0],roi[2]);
+            sliceRoi[1]=std::min(roi[1],roi[3]);
+            sliceRoi[2]=std::max(roi[0],roi[2]);
+            sliceRoi[3]=std::max(roi[1],roi[3]);
+            pRoi=sliceRoi;
+        }
+
+        #pragma omp parallel for schedule(dynamic)
+        for (ptrdiff_t i=0; i<nSlices; ++i) {
+            try {
+                std::string slicename, sliceext;
+                kipl::strings::filenames::MakeFileName(fname,static_cast<int>(start+i+count_start),slicename,sliceext,'#','0');
+
+                kipl::base::TImage<ImgType,2> slice=kipl::base::ExtractSlice(img,start+i,imageplane,pRoi);
+                slice.info=img.info;
+
+                if (filetype==TIFFfloat) {
+                    kipl::base::TImage<float,2> fslice(slice.Dims());
+                    for (size_t j=0; j<slice.Size(); ++j)
+                        fslice[j]=static_cast<float>(slice[j]);
+                    fslice.info=img.info;
+
+                    WriteTIFF(fslice,slicename.c_str(),tiffOptions);
+                }
+                else
+                    WriteTIFF(slice,slicename.c_str(),lo,hi,tiffOptions);
+            }
+            catch (kipl::base::KiplException &e) {
+                #pragma omp critical(WriteImageStackError)
+                {
+                    errorMessage=e.what();
+                }
+            }
+            catch (std::exception &e) {
+                #pragma omp critical(WriteImageStackError)
+                {
+                    errorMessage=e.what();
+                }
+            }
+        }
+
+        if (!errorMessage.empty())
+            throw kipl::base::KiplException(errorMessage,__FILE__,__LINE__);
+
         return 1;
     }
 
-	kipl::base::TImage<float,2> ftmp;
 	for (size_t i=start; i<stop; i++) {
 		kipl::strings::filenames::MakeFileName(fname,static_cast<int>(i+count_start),filename,ext,'#','0');	
 		tmp=kipl::base::ExtractSlice(img,i,imageplane,roi);
@@ -170,17 +243,9 @@ int WriteImageStack(kipl::base::TImage<ImgType,3> img,const std::string fname,
 			WriteMAT(tmp,filename.c_str(),varname.c_str());
 			break;
 		case TIFF8bits :
-			WriteTIFF(tmp,filename.c_str(),lo,hi);
-			break;
 		case TIFF16bits :
-			WriteTIFF(tmp,filename.c_str(),lo,hi);
-			break;
 		case TIFFfloat :
-			ftmp.Resize(tmp.Dims());
-			for (size_t i=0; i<tmp.Size(); i++) 
-				ftmp[i]=tmp[i];
-			WriteTIFF32(ftmp,filename.c_str());
-			break;
+			break; // written by the parallel slice writer
         case NeXusfloat :
             break; // it is handled somewhere else
         case NeXus16bits :
@@ -0,0 +1,98 @@
+//<LICENCE>
+
+#ifndef IO_STACKRESLICER_H
+#define IO_STACKRESLICER_H
+
+#include "../kipl_global.h"
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "../base/kiplenums.h"
+
+namespace kipl { namespace io {
+
+/// \brief Out-of-core reslicing of an image stack into vertical planes.
+///
+/// The stack is read once, slice by slice. The requested XZ and YZ planes are collected in chunks of
+/// consecutive slices that fit the memory budget. Chunks are spilled to a temporary file when the planes don't fit
+/// in memory at once, and the planes are assembled from the file when the stack is read. The slices of a chunk are
+/// read in parallel and the planes are written in parallel, i.e. the callbacks must be thread safe.
+///
+/// An XZ plane at position y has the width of the slices, line z is line y of slice z.
+/// A YZ plane at position x has the height of the slices as width, line z is column x of slice z.
+class KIPLSHARED_EXPORT StackReslicer
+{
+public:
+    /// \brief Reads slice index (0..slices-1) into a buffer of width*height*bytesPerPixel bytes.
+    typedef std::function<void(size_t index, char *slice)> SliceReader;
+
+    /// \brief Receives a complete plane with height lines of width pixels.
+    typedef std::function<void(kipl::base::eImagePlanes plane, size_t position, const char *data, size_t width, size_t height)> PlaneWriter;
+
+    /// \brief Prepares the reslicing of a stack
+    /// \param width Width of the slices
+    /// \param height Height of the slices
+    /// \param slices Number of slices
+    /// \param bytesPerPixel Size of a pixel in bytes, the pixels are copied without interpretation
+    StackReslicer(size_t width, size_t height, size_t slices, size_t bytesPerPixel);
+    ~StackReslicer();
+
+    /// \brief Adds a range of planes
+    /// \param plane ImagePlaneXZ or ImagePlaneYZ
+    /// \param first Position of the first plane
+    /// \param last Position of the last plane (inclusive)
+    /// \throws KiplException for an XY plane or a range outside the slices
+    void AddPlanes(kipl::base::eImagePlanes plane, size_t first, size_t last);
+
+    /// \brief Sets the memory used for the slice and plane buffers, default is 1 GB.
+    /// \param bytes Memory budget in bytes
+    void SetMemoryBudget(size_t bytes);
+
+    /// \brief Sets the directory for the temporary file, default is the system temp directory.
+    /// \param path The directory
+    void SetTemporaryPath(const std::string &path);
+
+    /// \returns The number of requested planes
+    size_t PlaneCount() const { return m_Planes.size(); }
+
+    /// \returns The number of slices that are collected before the planes are written or spilled
+    size_t ChunkDepth() const;
+
+    /// \brief Reads the stack and writes the planes
+    /// \param reader Callback that reads a slice, it is called concurrently for different slices
+    /// \param writer Callback that writes a plane, it is called concurrently for different planes
+    void Process(SliceReader reader, PlaneWriter writer);
+
+private:
+    StackReslicer(const StackReslicer &) = delete;
+    StackReslicer & operator=(const StackReslicer &) = delete;
+
+    struct Plane {
+        kipl::base::eImagePlanes plane;
+        size_t position;
+        size_t lineBytes;   ///< Bytes per line of the plane
+        size_t offset;      ///< Offset of the plane in a chunk line, i.e. the sum of the line bytes of previous planes
+    };
+
+    void scatterSlice(const char *slice, char *chunk, size_t z, size_t depth) const;
+    void writeChunk(const std::string &fname, const char *chunk, size_t depth, size_t chunkIndex) const;
+    void assemblePlanes(const std::string &fname, size_t chunkDepth, PlaneWriter &writer) const;
+    size_t readThreads() const;
+    size_t sliceBytes() const { return m_nWidth*m_nHeight*m_nBytesPerPixel; }
+    std::string temporaryFileName() const;
+
+    size_t m_nWidth;
+    size_t m_nHeight;
+    size_t m_nSlices;
+    size_t m_nBytesPerPixel;
+    size_t m_nMemoryBudget;
+    size_t m_nLineBytes;    ///< Bytes of all planes for one slice
+    std::string m_sTemporaryPath;
+    std::vector<Plane> m_Planes;
+};
+
+}}
+
+#endif // IO_STACKRESLICER_H
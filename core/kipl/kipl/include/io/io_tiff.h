@@ -10,6 +10,11 @@
 #include <cstdio>
 #include <cstring>
 #include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <limits>
+#include <algorithm>
 
 #include <tiffio.h>
 
@@ -18,6 +23,7 @@
 #include "../base/imageinfo.h"
 #include "../strings/filenames.h"
 #include "../base/kiplenums.h"
+#include "analyzefileext.h"
 
 
 namespace kipl { namespace io {
@@ -81,8 +87,42 @@ int WriteTIFF32(kipl::base::TImage<float,N> src,const char *fname)
 /// \brief Gets the dimensions of a tiff image without reading the image
 /// \param fname file name of the image file
 /// \param dims array with the dimensions
+/// \returns The number of frames in the file
 int KIPLSHARED_EXPORT GetTIFFDims(char const * const fname, size_t *dims);
 
+/// \brief Offsets of the image file directories of the frames in a TIFF or BigTIFF file
+struct KIPLSHARED_EXPORT TIFFFrameIndex
+{
+    std::vector<toff_t> offsets; ///< Directory offset of each frame
+    size_t dims[2];              ///< Size of the first frame
+};
+
+/// \brief Gets the frame index of a TIFF file.
+///
+/// The index is built by walking the directory chain once. It is cached and reused until the size or the
+/// modification time of the file changes. A cached index is only reused if the size of the first frame agrees
+/// with the file, this catches rewrites that the file system time stamp can't resolve.
+/// \param fname file name of the image file
+/// \returns The frame index
+/// \throws KiplException if the file can't be opened
+std::shared_ptr<const TIFFFrameIndex> KIPLSHARED_EXPORT GetTIFFFrameIndex(const std::string &fname);
+
+/// \brief Removes all frame indices from the cache
+void KIPLSHARED_EXPORT ClearTIFFFrameIndexCache();
+
+/// \brief Opens a TIFF file and moves to a frame using the cached frame index
+/// \param fname file name of the image file
+/// \param idx index of the frame, the index is only needed for idx>0
+/// \returns The open file, it must be closed using TIFFClose
+/// \throws KiplException if the file can't be opened or if the frame doesn't exist
+KIPLSHARED_EXPORT TIFF * OpenTIFFFrame(const std::string &fname, size_t idx=0L);
+
+/// \brief Decodes all tiles of the current frame of a tiled TIFF file
+/// \param image the tiff file positioned at the frame to read
+/// \param buffer receives the frame, it must hold TIFFScanlineSize(image)*height bytes
+/// \returns false if a tile couldn't be read
+bool KIPLSHARED_EXPORT ReadTIFFTiles(TIFF *image, unsigned char *buffer);
+
 /// \brief Parses a string to find slope and offset.
 ///
 /// This string could come the comment field in a tiff file created by the Octopus CT recontruction software.
@@ -200,6 +240,105 @@ int WriteTIFF(kipl::base::TImage<ImgType,N> src,const char *fname, ImgType lo, I
 	return WriteTIFF(img,fname);
 }
 
+/// \brief Layout and compression of the TIFF files written by WriteTIFF with options
+struct KIPLSHARED_EXPORT TIFFWriteOptions
+{
+    /// \brief Sets the default options, i.e. one uncompressed strip per frame
+    /// \param c compression scheme
+    TIFFWriteOptions(eTIFFCompression c=TIFFCompressionNone);
+
+    eTIFFCompression compression; ///< Compression scheme
+    int level;                    ///< Compression level of deflate (1-9) and zstd (1-22), -1 uses the codec default
+    bool predictor;               ///< Use the horizontal predictor for integers and the floating point predictor for floats
+    size_t rowsPerStrip;          ///< Rows per strip, 0 selects one strip per frame without compression and strips of about 256 kB with compression
+    size_t tileSize[2];           ///< Tile width and length, both must be multiples of 16. Strips are written if any of them is 0
+    bool bigTIFF;                 ///< Write a BigTIFF file, this is also done when the data exceeds 4 GB
+};
+
+/// \brief Writes frames to a TIFF file with the layout and compression given by the options.
+///
+/// The strips or tiles are compressed in parallel by libtiff's own encoders and written as raw data, the files are
+/// therefore readable by any TIFF reader that supports the codec.
+///	\param fname file name of the destination file
+///	\param data pointer to the first frame, the frames are stored consecutively
+///	\param dims width and height of the frames
+///	\param nFrames number of frames, more than one frame gives a multi-page file
+///	\param bitsPerSample number of bits per pixel
+///	\param sampleFormat TIFF sample format (SAMPLEFORMAT_UINT, SAMPLEFORMAT_INT or SAMPLEFORMAT_IEEEFP)
+///	\param info image information written to the tags of each frame
+///	\param options layout and compression
+/// \throws KiplException if the file can't be written or the codec isn't available in libtiff
+void KIPLSHARED_EXPORT WriteTIFFFrames(const char *fname, const void *data, const size_t *dims, size_t nFrames,
+                                        int bitsPerSample, int sampleFormat,
+                                        const kipl::base::ImageInfo &info,
+                                        const TIFFWriteOptions &options);
+
+/// \brief TIFF sample format of the pixel types supported by the compressing writer
+template <class T> struct TIFFSampleFormat;
+template <> struct TIFFSampleFormat<unsigned char>  { static const int value=SAMPLEFORMAT_UINT; };
+template <> struct TIFFSampleFormat<char>           { static const int value=SAMPLEFORMAT_INT; };
+template <> struct TIFFSampleFormat<unsigned short> { static const int value=SAMPLEFORMAT_UINT; };
+template <> struct TIFFSampleFormat<short>          { static const int value=SAMPLEFORMAT_INT; };
+template <> struct TIFFSampleFormat<unsigned int>   { static const int value=SAMPLEFORMAT_UINT; };
+template <> struct TIFFSampleFormat<int>            { static const int value=SAMPLEFORMAT_INT; };
+template <> struct TIFFSampleFormat<float>          { static const int value=SAMPLEFORMAT_IEEEFP; };
+template <> struct TIFFSampleFormat<double>         { static const int value=SAMPLEFORMAT_IEEEFP; };
+
+/// \brief Writes an image as TIFF with compression and a selectable strip or tile layout.
+///
+/// The pixels are stored in their own data type, i.e. float images are written as 32-bit floats. A volume is
+/// written as a multi-page file with one frame per slice.
+///	\param src the image to be stored
+///	\param fname file name of the destination file (including extension .tif)
+///	\param options layout and compression
+///
+///	\return Error code
+///	\retval 1 Successful
+/// \throws KiplException if the file can't be written
+template <class ImgType,size_t N>
+int WriteTIFF(kipl::base::TImage<ImgType,N> src,const char *fname, const TIFFWriteOptions &options)
+{
+    const size_t nSlices = N == 2 ? 1UL : src.Size(2);
+
+    WriteTIFFFrames(fname,src.GetDataPtr(),src.Dims(),nSlices,
+                    static_cast<int>(8*sizeof(ImgType)),TIFFSampleFormat<ImgType>::value,
+                    src.info,options);
+
+    return 1;
+}
+
+/// \brief Writes an image rescaled to 16 bits as TIFF with compression and a selectable strip or tile layout
+///	\param src the image to be stored
+///	\param fname file name of the destination file (including extension .tif)
+///	\param lo lower limit on the data dynamics
+///	\param hi upper limit on the data dynamics
+///	\param options layout and compression
+///
+///	\return Error code
+///	\retval 1 Successful
+template <class ImgType,size_t N>
+int WriteTIFF(kipl::base::TImage<ImgType,N> src,const char *fname, ImgType lo, ImgType hi, const TIFFWriteOptions &options)
+{
+    kipl::base::TImage<unsigned short,N> img;
+    try {
+        img=kipl::base::ImageCaster<unsigned short, ImgType, N>::cast(src,lo,hi);
+        if (src.info.sDescription.empty()) {
+            std::stringstream msg;
+
+            float slope = (static_cast<float>(hi)-static_cast<float>(lo))/std::numeric_limits<unsigned short>::max();
+
+            msg<<"slope = "<<scientific<<slope<<"\noffset = "<<scientific<<lo;
+            src.info.sDescription=msg.str();
+        }
+    }
+    catch (kipl::base::KiplException &E) {
+        throw kipl::base::KiplException(E.what(),__FILE__,__LINE__);
+    }
+    img.info=src.info;
+
+    return WriteTIFF(img,fname,options);
+}
+
 /// \brief Writes an uncompressed TIFF image from any image data type (grayscale)
 ///	\param src the image to be stored
 ///	\param fname file name of the destination file (including extension .tif)
@@ -275,18 +414,15 @@ int AppendTIFF(kipl::base::TImage<ImgType,N> src,const char *fname) {
     return 1;
 }
 
-/// \brief Reads the contents of a tiff file and stores the contents in the data type specified by the image
+/// \brief Reads the current frame of an open tiff file and stores the contents in the data type specified by the image
+///	\param image the tiff file positioned at the frame to read, it is not closed
 ///	\param src the image to be stored
-///	\param fname file name of the destination file
-///	
-///	\return Error code 	
-///	\retval 0 The writing failed
-///	\retval 1 Successful 
+///
+///	\return The number of bits per sample of the frame
 template <class ImgType>
-int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t idx=0L)
+int ReadTIFFFrame(TIFF *image, kipl::base::TImage<ImgType,2> &src)
 {
     std::stringstream msg;
-	TIFF *image;
 	uint16 photo, spp, fillorder,bps, sformat;
 	tsize_t stripSize, stripCount;
 	unsigned long imageOffset;
@@ -295,26 +431,6 @@ int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t idx=0L
 	unsigned char *buffer, tempbyte;
 	unsigned long bufferSize, count;
 
-	TIFFSetWarningHandler(0);
-	// Open the TIFF image
-    if((image = TIFFOpen(fname, "r")) == nullptr){
-		msg.str();
-		msg<<"ReadTIFF: Could not open image "<<fname;
-		throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-	}
-	
-    int framecnt=0;
-    while ((framecnt<static_cast<int>(idx)) && (image!=nullptr)){
-        TIFFReadDirectory(image);
-        framecnt++;
-    }
-
-    if(image == nullptr) {
-        msg.str("");
-        msg<<"ReadTIFF: Frame index exceeds the available frame in the file"<<fname;
-        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-    }
-
 	// Check that it is of a type that we support
 	if((TIFFGetField(image, TIFFTAG_BITSPERSAMPLE, &bps) == 0) ){
 		throw kipl::base::KiplException("ReadTIFF: Either undefined or unsupported number of bits per pixel",__FILE__,__LINE__);
@@ -327,12 +443,18 @@ int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t idx=0L
 		throw kipl::base::KiplException("ReadTIFF: Either undefined or unsupported number of samples per pixel",__FILE__,__LINE__);
 	}
 
+	int dimx,dimy;
+	// We need to set some values for basic tags before we can add any data
+	TIFFGetField(image, TIFFTAG_IMAGEWIDTH,&dimx);
+	TIFFGetField(image, TIFFTAG_IMAGELENGTH, &dimy);
+
 	// Read in the possibly multiple strips
+	const bool tiled = TIFFIsTiled(image)!=0;
 	stripSize = TIFFStripSize (image);
 	stripMax = TIFFNumberOfStrips (image);
 	imageOffset = 0;
 
-	bufferSize = TIFFNumberOfStrips (image) * stripSize;
+	bufferSize = tiled ? TIFFScanlineSize(image)*dimy : TIFFNumberOfStrips (image) * stripSize;
 	try {
         if((buffer = new unsigned char[bufferSize]) == nullptr){
 			msg.str("");
@@ -350,17 +472,18 @@ int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t idx=0L
 	}
 
 
-	int dimx,dimy;
-	// We need to set some values for basic tags before we can add any data
-	TIFFGetField(image, TIFFTAG_IMAGEWIDTH,&dimx);
-	TIFFGetField(image, TIFFTAG_IMAGELENGTH, &dimy);
+	if (tiled && !ReadTIFFTiles(image,buffer)) {
+		delete [] buffer;
+		throw kipl::base::KiplException("Read error on the input tiles",__FILE__,__LINE__);
+	}
 
-	for (stripCount = 0; stripCount < stripMax; stripCount++){
+	for (stripCount = 0; !tiled && (stripCount < stripMax); stripCount++){
 		if((result = TIFFReadEncodedStrip (image, stripCount,
 					      buffer + imageOffset,
 					      stripSize)) == -1){
 			msg.str("");
 			msg<<"Read error on input strip number "<<static_cast<size_t>(stripCount);
+			delete [] buffer;
 			throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
 		}
     	imageOffset += result;
@@ -431,7 +554,6 @@ int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t idx=0L
 			break;
 	}
 
-	TIFFClose(image);
 	size_t dims[]={static_cast<size_t>(dimx), static_cast<size_t>(dimy)};
 	src.Resize(dims);
 
@@ -479,21 +601,61 @@ int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t idx=0L
 
 /// \brief Reads the contents of a tiff file and stores the contents in the data type specified by the image
 ///	\param src the image to be stored
-///	\param fname file name of the destination file (including extension .bmp)
+///	\param fname file name of the destination file
+///	\param idx index of the frame in a multi-frame file, the frame is found using the cached frame index
 ///	
 ///	\return Error code 	
 ///	\retval 0 The writing failed
 ///	\retval 1 Successful 
 template <class ImgType>
-int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t const * const crop, size_t idx=0L)
+int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t idx=0L)
+{
+    TIFF *image=OpenTIFFFrame(fname,idx);
+
+    int bps=0;
+    try {
+        bps=ReadTIFFFrame(image,src);
+    }
+    catch (...) {
+        TIFFClose(image);
+        throw;
+    }
+    TIFFClose(image);
+
+    return bps;
+}
+
+/// \brief Reads a region of the current frame of an open tiff file
+///	\param image the tiff file positioned at the frame to read, it is not closed
+///	\param src the image to be stored
+///	\param crop region to read (x0,y0,x1,y1), the region is limited to the frame
+///
+///	\return The number of bits per sample of the frame
+template <class ImgType>
+int ReadTIFFFrame(TIFF *image, kipl::base::TImage<ImgType,2> &src, size_t const * const crop)
 {
     kipl::logging::Logger logger("ReadTIFF");
 
     if (crop==nullptr) {
-        return ReadTIFF(src,fname,idx);
+        return ReadTIFFFrame(image,src);
+	}
+
+	if (TIFFIsTiled(image)) {
+		// Tiles can't be read by scan lines, the frame is decoded completely and then cropped
+		kipl::base::TImage<ImgType,2> frame;
+		int bps=ReadTIFFFrame(image,frame);
+
+		size_t x0=std::min(frame.Size(0),crop[0]);
+		size_t y0=std::min(frame.Size(1),crop[1]);
+		size_t imgdims[2]={std::min(frame.Size(0),crop[2])-x0,std::min(frame.Size(1),crop[3])-y0};
+		src.Resize(imgdims);
+		src.info=frame.info;
+		for (size_t y=0; y<imgdims[1]; ++y)
+			std::copy_n(frame.GetLinePtr(y0+y)+x0,imgdims[0],src.GetLinePtr(y));
+
+		return bps;
 	}
 	std::stringstream msg;
-	TIFF *image;
 	uint16 photo, spp, fillorder,bps, sformat;
 	tsize_t stripSize;
 	unsigned long imageOffset;
@@ -502,25 +664,6 @@ int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t const
 	unsigned char *buffer, tempbyte;
 	unsigned long bufferSize, count;
 
-    TIFFSetWarningHandler(nullptr);
-	// Open the TIFF image
-    if((image = TIFFOpen(fname, "r")) == nullptr){
-        msg.str("");
-		msg<<"ReadTIFF: Could not open image "<<fname;
-		throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-	}
-    size_t framecnt=0;
-    while ((framecnt<idx) && (image!=nullptr)){
-        TIFFReadDirectory(image);
-        framecnt++;
-    }
-
-    if(image == nullptr){
-        msg.str("");
-        msg<<"ReadTIFF: Frame index exceeds the available frame in the file"<<fname;
-        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-    }
-
 	// Check that it is of a type that we support
 	if((TIFFGetField(image, TIFFTAG_BITSPERSAMPLE, &bps) == 0) ){
 		throw kipl::base::KiplException("ReadTIFF: Either undefined or unsupported number of bits per pixel",__FILE__,__LINE__);
@@ -567,14 +710,26 @@ int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t const
 		throw E;
 	}
 
+	// Compressed strips can only be decoded from the first row of the strip
+	uint16 compression=COMPRESSION_NONE;
+	uint32 rowsPerStrip=0;
+	TIFFGetField(image, TIFFTAG_COMPRESSION, &compression);
+	TIFFGetField(image, TIFFTAG_ROWSPERSTRIP, &rowsPerStrip);
+	int firstRow=adjcrop[1];
+	if ((compression!=COMPRESSION_NONE) && (rowsPerStrip!=0))
+		firstRow=static_cast<int>((adjcrop[1]/rowsPerStrip)*rowsPerStrip);
+
 	src.Resize(imgdims);
-	for (int row=adjcrop[1]; row<adjcrop[3]; row++) {
+	for (int row=firstRow; row<adjcrop[3]; row++) {
         if (TIFFReadScanline(image,static_cast<tdata_t>(buffer), row, 0)!=1) {
 			msg.str("");
 			msg<<"ReadTIFFLine: an error occurred during reading scan line "<<row;
-			TIFFClose(image);
+			delete [] buffer;
 			throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
 		}
+		if (row<adjcrop[1])
+			continue;
+
 		// Deal with photometric interpretations
 		if(TIFFGetField(image, TIFFTAG_PHOTOMETRIC, &photo) == 0){
 			throw kipl::base::KiplException("Image has an undefined photometric interpretation",__FILE__,__LINE__);
@@ -641,7 +796,6 @@ int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t const
 					pLine[i-adjcrop[0]]=buffer[i];
 				break;
 			case 4:
-				TIFFClose(image);
 				delete [] buffer;
 				throw kipl::base::KiplException("4-bit TIFF images are not supported in crop mode",__FILE__,__LINE__);
 
@@ -679,8 +833,6 @@ int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t const
 			break;
 	}
 
-	TIFFClose(image);
-		
 	delete [] buffer;
 
 	return bps;
@@ -689,6 +841,36 @@ int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t const
 /// \brief Reads the contents of a tiff file and stores the contents in the data type specified by the image
 ///	\param src the image to be stored
 ///	\param fname file name of the destination file (including extension .bmp)
+///	\param crop region to read (x0,y0,x1,y1), the full frame is read if crop is nullptr
+///	\param idx index of the frame in a multi-frame file, the frame is found using the cached frame index
+///	
+///	\return Error code 	
+///	\retval 0 The writing failed
+///	\retval 1 Successful 
+template <class ImgType>
+int ReadTIFF(kipl::base::TImage<ImgType,2> &src,const char *fname, size_t const * const crop, size_t idx=0L)
+{
+    TIFF *image=OpenTIFFFrame(fname,idx);
+
+    int bps=0;
+    try {
+        bps=ReadTIFFFrame(image,src,crop);
+    }
+    catch (...) {
+        TIFFClose(image);
+        throw;
+    }
+    TIFFClose(image);
+
+    return bps;
+}
+
+/// \brief Reads all frames of a multi-frame tiff file into a volume
+///	\param src the image to be stored
+///	\param fname file name of the destination file (including extension .bmp)
+///	\param crop region to read from each frame, the full frames are read if crop is nullptr
+///
+///	The file is opened once and the frames are found using the cached frame index.
 ///
 ///	\return Error code
 ///	\retval 0 The writing failed
@@ -697,35 +879,49 @@ template <class ImgType>
 int ReadTIFF(kipl::base::TImage<ImgType,3> &src,const char *fname, size_t const * const crop=nullptr)
 {
     std::ostringstream msg;
-    size_t dims[3];
-    int nframes=GetTIFFDims(fname,dims);
+    std::shared_ptr<const TIFFFrameIndex> index=GetTIFFFrameIndex(fname);
+    const size_t nframes=index->offsets.size();
 
-    dims[2]=static_cast<size_t>(nframes);
+    TIFF *image=OpenTIFFFrame(fname);
 
+    kipl::base::TImage<ImgType,2> img;
+    int res=0;
     try {
-        src.Resize(dims);
-    }
-    catch (kipl::base::KiplException &e) {
-        msg.str("");
-        msg<<"Failed to allocate 3D image for "<<fname<<"\n"<<e.what();
-        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-    }
-    catch (std::exception &e) {
-        msg.str("");
-        msg<<"Failed to allocate 3D image for "<<fname<<"\n"<<e.what();
-        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+        for (size_t i=0; i<nframes; ++i) {
+            if (TIFFSetSubDirectory(image,index->offsets[i])==0) {
+                msg.str("");
+                msg<<"ReadTIFF: Failed to read the directory of frame "<<i<<" in "<<fname;
+                throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+            }
+
+            res=ReadTIFFFrame(image,img,crop);
+
+            if (i==0) {
+                size_t dims[3]={img.Size(0),img.Size(1),nframes};
+                try {
+                    src.Resize(dims);
+                }
+                catch (std::exception &e) {
+                    msg.str("");
+                    msg<<"Failed to allocate 3D image for "<<fname<<"\n"<<e.what();
+                    throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+                }
+            }
+
+            if (img.Size()!=src.Size(0)*src.Size(1)) {
+                msg.str("");
+                msg<<"ReadTIFF: Frame "<<i<<" in "<<fname<<" has a different size than the first frame";
+                throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+            }
+
+            std::copy_n(img.GetDataPtr(),img.Size(),src.GetLinePtr(0,i));
+        }
     }
     catch (...) {
-        msg.str("");
-        msg<<"Failed to allocate 3D image for "<<fname<<" with an unhandled exception";
-        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-    }
-    kipl::base::TImage<float,2> img;
-    int res=0;
-    for (size_t i=0; i< static_cast<size_t>(nframes); ++i) {
-        res=ReadTIFF(img,fname,crop,i);
-        std::copy_n(img.GetDataPtr(),img.Size(),src.GetLinePtr(0,i));
+        TIFFClose(image);
+        throw;
     }
+    TIFFClose(image);
 
     return res;
 }
@@ -2,9 +2,11 @@
 #define VIVASEQ_H
 
 #include "../kipl_global.h"
+#include <memory>
 #include <string>
 
 #include "../base/timage.h"
+#include "io_mappedfile.h"
 namespace kipl { namespace io {
 
 class KIPLSHARED_EXPORT ViVaSEQHeader
@@ -55,6 +57,19 @@ int KIPLSHARED_EXPORT GetViVaSEQHeader(std::string fname, ViVaSEQHeader *header)
 
 int KIPLSHARED_EXPORT GetViVaSEQDims(std::string fname,size_t *dims);
 
+/// \brief Memory maps a SEQ file, the frames can be accessed as zero-copy views or read with the region of interest.
+/// \param fname File name of the SEQ file
+/// \param header Receives the file header if non-nullptr
+/// \returns A frame reader for the file
+std::unique_ptr<MappedFrameReader> KIPLSHARED_EXPORT OpenViVaSEQ(std::string fname, ViVaSEQHeader *header=nullptr);
+
+/// \brief Reads a range of frames from a SEQ file, the frames are read in parallel from the memory mapped file.
+/// \param fname File name of the SEQ file
+/// \param img Destination image
+/// \param roi Region of interest (x0,y0,x1,y1), the full frames are read if nullptr
+/// \param first_frame First frame to read, all frames are read if -1
+/// \param last_frame The frame after the last frame to read
+/// \param frame_step Frame increment
 int KIPLSHARED_EXPORT ReadViVaSEQ(std::string fname, kipl::base::TImage<float,3> &img, const size_t * const roi=nullptr, int first_frame=-1, int last_frame=0, int frame_step=1);
 
 int KIPLSHARED_EXPORT ReadViVaSEQ(std::string fname, kipl::base::TImage<float,2> &img, int idx, size_t const * const roi=nullptr);
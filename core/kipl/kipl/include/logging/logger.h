@@ -11,6 +11,7 @@
 #include <string>
 #include <list>
 #include <mutex>
+#include <atomic>
 
 namespace kipl {
 /// \brief This namespace collects classes related to the handling of log messages.
@@ -39,8 +40,14 @@ protected:
     std::ofstream fout;
 };
 
+class AsyncLogSink;
+
 /// \brief A basic logging class that can take log messages from different origins and write then to the same destination.
+///
+/// The messages are written by the calling thread unless the asynchronous mode is selected. In asynchronous mode the messages
+/// are queued in a lock-free buffer and a background thread writes them to the log target.
 class KIPLSHARED_EXPORT Logger {
+    friend class AsyncLogSink;
 public:
 
 	/// \brief Enum used to select the current minimum log level
@@ -64,7 +71,22 @@ public:
 
 	/// \brief Set the global log level
 	static void SetLogLevel(LogLevel level);
-    static kipl::logging::Logger::LogLevel GetLogLevel() { return CurrentLogLevel; }
+    static kipl::logging::Logger::LogLevel GetLogLevel() { return CurrentLogLevel.load(std::memory_order_relaxed); }
+
+    /// \brief Checks if messages of a level will be written. Use it to skip building messages that would be discarded.
+    /// \param level The log level of the message
+    static bool IsEnabled(LogLevel level) { return level<=CurrentLogLevel.load(std::memory_order_relaxed); }
+
+    /// \brief Selects if the messages are written by a background thread
+    /// \param async Starts the background writer if true, otherwise the queued messages are written and the writer is stopped.
+    /// \param capacity Number of messages that can be queued before the callers have to wait for the writer.
+    static void SetAsynchronous(bool async, size_t capacity=8192);
+
+    /// \returns True if the messages are written by the background thread
+    static bool IsAsynchronous();
+
+    /// \brief Waits until all queued messages are written. Error messages are always flushed before the log call returns.
+    static void Flush();
 	
 	/// \brief Log a message
 	/// \param severity The log level of the current log message
@@ -88,14 +110,17 @@ protected:
 	/// \param s The log level of the current log message
 	/// \param message A string containing the message
 	static void WriteMessage(LogLevel s, std::string message);
+
+    /// \brief Formats the message and writes it to the log targets
+    static void WriteToTargets(LogLevel s, const std::string &message);
 #ifdef MULTITARGETS
     /// \brief
     static std::list<LogWriter *> LogTargets;   //!< Refence to the global log target. Experimental approach to allow several log targets. It is still not stable
 #else
     static LogWriter * LogTarget;   //!< Refence to the global log target single log target case
 #endif
-    static LogLevel CurrentLogLevel; //!< The current global log level
-    static std::mutex m_LoggerMutex; ///< A mutex to protect against simultaneous writing from several threads.
+    static std::atomic<LogLevel> CurrentLogLevel; //!< The current global log level
+    static std::recursive_mutex m_LoggerMutex; ///< A mutex to protect against simultaneous writing from several threads.
 
     std::string sLogOrigin; //!< The name of the current log space. Every class that use a logger instance should tell what their name is to improve the quality of the message.
 };
@@ -1,24 +1,52 @@
 #ifndef CIRCULARHOUGHTRANSFORM_H
 #define CIRCULARHOUGHTRANSFORM_H
 
+#include <complex>
+#include <vector>
+
 #include "../kipl_global.h"
 #include "../base/timage.h"
 #include "../logging/logger.h"
 
 namespace kipl { namespace math {
 
+/// \brief Circular Hough transform by correlation with normalized ring kernels.
+///
+/// The rings are applied in the frequency domain. The spectrum of the mirror padded image is computed once per call
+/// and two radii share each inverse transform, the ring kernels are real and even and their responses are
+/// separated as the real and imaginary parts. The cost per radius is therefore independent of the radius.
 class KIPLSHARED_EXPORT CircularHoughTransform
 {
     kipl::logging::Logger logger;
 public:
     CircularHoughTransform();
 
-    kipl::base::TImage<float,2> operator()(kipl::base::TImage<float,2> img, float diameter, bool useDerivative=false);
+    /// \brief Computes the transform for a single radius
+    /// \param img The image to transform
+    /// \param radius The radius of the ring
+    /// \param useDerivative Transform the gradient magnitude instead of the image
+    /// \returns The transform map
+    kipl::base::TImage<float,2> operator()(kipl::base::TImage<float,2> img, float radius, bool useDerivative=false);
+
+    /// \brief Computes the transform for a range of radii and keeps the best radius of each pixel
+    /// \param img The image to transform
+    /// \param radii The radii to test
+    /// \param bestRadius Receives the radius with the greatest response at each pixel
+    /// \param useDerivative Transform the gradient magnitude instead of the image
+    /// \returns The greatest response of each pixel
+    kipl::base::TImage<float,2> operator()(kipl::base::TImage<float,2> img,
+                                           const std::vector<float> &radii,
+                                           kipl::base::TImage<float,2> &bestRadius,
+                                           bool useDerivative=false);
 private:
-    void buildKernel(float radius);
+    /// \brief Adds a normalized ring kernel centered at the origin of a periodic grid
+    /// \param radius The radius of the ring
+    /// \param dims The size of the grid
+    /// \param kernel The grid
+    /// \param imaginary Put the kernel in the imaginary part instead of the real part
+    void addRingKernel(float radius, const size_t *dims, std::complex<float> *kernel, bool imaginary);
     void absDerivative(bool useDerivative);
     kipl::base::TImage<float,2> m_Img;
-    kipl::base::TImage<float,2> ringKernel;
 };
 }}
 #endif // CIRCULARHOUGHTRANSFORM_H
@@ -0,0 +1,99 @@
+//<LICENCE>
+
+#ifndef VOLUMESTATISTICS_H
+#define VOLUMESTATISTICS_H
+
+#include "../kipl_global.h"
+
+#include <vector>
+#include <iostream>
+
+namespace kipl { namespace math {
+
+/// \brief Mergeable statistics and histogram of a large data set.
+///
+/// The statistics are accumulated chunk by chunk, e.g. per reconstructed slice block, and partial results from
+/// different threads, blocks or shards are combined with merge. The histogram has a fixed number of bins with a
+/// power of two bin width. The bins are aligned to multiples of the width, i.e. two histograms can always be merged
+/// exactly by combining pairs of bins until they have the same width. When new data falls outside the current
+/// range the bin width is doubled, at least a quarter of the bins covers the data range.
+class KIPLSHARED_EXPORT VolumeStatistics
+{
+public:
+    /// \brief Initializes empty statistics
+    /// \param nBins Number of histogram bins, it is rounded up to an even number of at least four
+    VolumeStatistics(size_t nBins=4096);
+
+    /// \brief Removes all data
+    void reset();
+
+    /// \brief Adds an array of values, non-finite values are ignored
+    /// \param data The values
+    /// \param N Number of values
+    void put(float const * const data, size_t N);
+
+    /// \brief Adds the data of other statistics
+    /// \param s The statistics to add
+    void merge(const VolumeStatistics &s);
+
+    /// \brief Adds the data of other statistics
+    /// \param s The statistics to add
+    VolumeStatistics & operator+=(const VolumeStatistics &s) { merge(s); return *this; }
+
+    /// \returns The number of values
+    size_t n() const { return m_nCount; }
+    /// \returns The smallest value
+    double Min() const;
+    /// \returns The greatest value
+    double Max() const;
+    /// \returns The mean value
+    double E() const;
+    /// \returns The variance
+    double V() const;
+    /// \returns The standard deviation
+    double s() const;
+
+    /// \brief Estimates a percentile from the histogram, the values are interpolated linearly in the bins.
+    /// \param p The percentile in the interval [0,100]
+    /// \returns The value below which p percent of the data is found
+    double Percentile(double p) const;
+
+    /// \brief Finds the interval that contains a percentage of the values, same definition as kipl::base::FindLimits.
+    /// \param percentage Percentage of the values inside the interval
+    /// \param lo Receives the lower bound
+    /// \param hi Receives the upper bound
+    void GrayInterval(float percentage, float &lo, float &hi) const;
+
+    /// \brief Resamples the histogram to bins spanning the interval [Min,Max]
+    /// \param axis Receives the bin centers, must be allocated with nBins elements
+    /// \param hist Receives the bin counts, must be allocated with nBins elements
+    /// \param nBins Number of bins
+    void GetHistogram(float *axis, size_t *hist, size_t nBins) const;
+
+    /// \returns The internal bin counts
+    const std::vector<size_t> & histogram() const { return m_Histogram; }
+    /// \returns The internal bin width
+    double binWidth() const;
+    /// \returns The lower bound of the first internal bin
+    double binStart() const;
+
+private:
+    void fitRange(double lo, double hi);
+    void coarsen();
+
+    size_t m_nCount;
+    double m_fMin;
+    double m_fMax;
+    double m_fMean;
+    double m_fM2;        ///< Sum of squared deviations from the mean
+
+    int m_nExponent;     ///< The bin width is 2^m_nExponent
+    long long m_nFirst;  ///< The first bin starts at m_nFirst*2^m_nExponent
+    std::vector<size_t> m_Histogram;
+};
+
+}}
+
+std::ostream KIPLSHARED_EXPORT & operator<<(std::ostream &s, const kipl::math::VolumeStatistics &stats);
+
+#endif // VOLUMESTATISTICS_H
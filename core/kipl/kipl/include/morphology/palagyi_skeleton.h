@@ -3,14 +3,18 @@
 #ifndef _PALAGYI_SKELETON_
 #define _PALAGYI_SKELETON_
 
-// implement thinning templates given by 
+// implement thinning templates given by
 // Palagyi and Kuba in "A Parallel 3D 12-Subiteration Thinning Algorithm", 1999
 //
+#include "../kipl_global.h"
+
+#include <cstring>
 #include <iostream>
 #include <vector>
-#include <deque>
+#include <sstream>
 
 #include "../base/timage.h"
+#include "../logging/logger.h"
 #include "morphology.h"
 #include "base3dskeleton.h"
 #include "label.h"
@@ -19,56 +23,70 @@ using namespace std;
 
 namespace kipl { namespace morphology {
 
+/// \brief Bit of a neighborhood position in the index of the deletability table
+/// \param p Linear position z*9+y*3+x in the 3x3x3 neighborhood, the center (13) has no bit
+inline int PalagyiTableBit(int p) { return p<13 ? p : p-1; }
+
+/// \brief Deletability table of the thinning templates for the UP_SOUTH direction.
+///
+/// The table has one bit for each of the 2^26 configurations of the 26-neighborhood of an object voxel. Bit
+/// PalagyiTableBit(p) of the index is set when position p is object. The table (8 MB) is built on the first call.
+/// \returns The table packed in 64-bit words
+KIPLSHARED_EXPORT const std::vector<unsigned long long> & PalagyiDeletableTable();
+
+/// \brief Directional thinning of a 3D binary image using the 12 subiterations by Palagyi and Kuba.
+///
+/// The templates are evaluated by a lookup in PalagyiDeletableTable, the neighborhood of the other directions
+/// is packed in the rotated order. The border voxels of a subiteration are tested in parallel, only object voxels
+/// that have a background face neighbor are visited, i.e. the list of active voxels follows the surface of the object.
 template<class ImgType>
 class PalagyiSkeleton: public kipl::morphology::Base3Dskeleton<ImgType> {
 private:
 	enum Direction {
-	UP_SOUTH = 0, 
+	UP_SOUTH = 0,
 	NORT_EAST,
-	DOWN_WEST, 
-	
+	DOWN_WEST,
+
 	SOUTH_EAST,
-	UP_WEST, 
-	DOWN_NORTH, 
-	
+	UP_WEST,
+	DOWN_NORTH,
+
 	SOUTH_WEST,
-	UP_NORTH, 
-	DOWN_EAST, 
-	
+	UP_NORTH,
+	DOWN_EAST,
+
 	NORT_WEST,
-	UP_EAST, 
+	UP_EAST,
 	DOWN_SOUTH,
-	
+
 	UP,
-	DOWN, 
-	EAST, 
-	WEST, 
-	NORTH, 
+	DOWN,
+	EAST,
+	WEST,
+	NORTH,
 	SOUTH
 	};
-	
+
 public:
 	PalagyiSkeleton();
 	~PalagyiSkeleton(){}
 	int process(kipl::base::TImage<ImgType,3> & img, bool Quiet=true);
 private:
-	bool MatchesATemplate(ImgType n[3][3][3]);
-	bool MatchesATemplate2(ImgType n[3][3][3]);
-	bool TransformNeighborhood(	ImgType n[3][3][3], 
-								char direction, 
-								ImgType USn[3][3][3]);
-								
-	bool markBoundaryInDirection(kipl::base::TImage<ImgType,3> &img,
-								 vector<long> &objectVoxels, 
-								 vector<long> &boundaryVoxels,
-			      				 char d1, char d2);
-			      				 
-	bool markBoundaryInDirection(kipl::base::TImage<ImgType,3> &img,
-								 vector<long> &objectVoxels, 
-								 vector<long> &boundaryVoxels,
-			      				 char direction);
-			      				 
-	int CleanObjectVector(kipl::base::TImage<ImgType,3> &img,vector<long> &objectVoxels);
+	/// \brief Rotates the neighborhood of a direction to the UP_SOUTH direction of the templates
+	bool TransformNeighborhood(	int n[3][3][3],
+								char direction,
+								int USn[3][3][3]);
+
+	/// \brief Finds the table bit of each neighborhood position for a direction
+	/// \param direction The thinning direction
+	/// \param bits Receives the bit of positions 0-26, the center is not used
+	void PackingOrder(char direction, int bits[27]);
+
+	/// \brief Removes the deletable border voxels of one subiteration
+	/// \returns The number of deleted voxels
+	size_t ThinDirection(kipl::base::TImage<ImgType,3> &img,
+						 std::vector<ptrdiff_t> &active,
+						 char direction);
 };
 
 template<class ImgType>
@@ -78,359 +96,204 @@ PalagyiSkeleton<ImgType>::PalagyiSkeleton()
 }
 
 template<class ImgType>
-int PalagyiSkeleton<ImgType>::process(kipl::base::TImage<ImgType,3> &img, bool Quiet) 
+int PalagyiSkeleton<ImgType>::process(kipl::base::TImage<ImgType,3> &img, bool Quiet)
 {
-  this->quiet=Quiet;
-  int L, M, N;
-  int sz, slsz, nidx;
-  long idx;
-  int nrDel;
-  int dir;
-  ImgType nb[3][3][3];
-  ImgType USn[3][3][3];
-
-  int nrPasses;
-  int maxnsp;
-  char ii, jj, kk;
-
-  unsigned int tmp, nrSubsets;
-  int len;
-
-  char spList[26][3];
-  char spListLen;
-  bool canBeDeleted = false;
-
-  L=img.Size(0);  M =img.Size(1); N = img.Size(2);
-  
-  sz = L*M*N;
-  slsz = L*M;
-
-  // set all object voxels to object
-	if (this->N26)
-		delete this->N26;
-
-	this->N26=new CNeighborhood(img.Dims(),3, conn26);
-  vector<long> objectVoxels, boundaryVoxels;
-  
-  ImgType *vol=img.GetDataPtr();
-  for(idx=0; idx < img.Size(); idx++) {
-    if(img[idx] != 0) {
-    	img[idx] = this->object;
-    	objectVoxels.push_back(idx);
-    }
-  }
-
-  nrDel = 1;
-  nrPasses = 1;
-  maxnsp = 0;
-
-  unsigned char firstBoundary[12]= {5 , 3, 4, 2, 5, 4, 2, 5, 4, 3, 5, 4};
-  unsigned char secondBoundary[12]=  { 2, 0, 1, 0, 1, 3, 1, 3, 0, 1, 0,2};
-
-  
-  deque<long> simpleVoxels, nonSimpleVoxels;
-  int endpoint;
-  vector<long>::iterator it;
-  
-  while(nrDel > 0) {
-	if (!this->quiet)
-    	cout<<"Pass "<<nrPasses<<"..."<<endl;
-    else
-    	cout<<"."<<flush;
-    nrDel = 0;
-    for(dir = 0; dir < 12; dir++) {
-		if (!this->quiet)
-			cout<<"\tDir "<<dir<<","<<flush;
-	
-		boundaryVoxels.clear();
- 		markBoundaryInDirection(img, objectVoxels, boundaryVoxels,firstBoundary[dir]);
-  		markBoundaryInDirection(img, objectVoxels, boundaryVoxels,secondBoundary[dir]);
-  		
-		// check each boundary point and remove it if itmacthes a template
-		if (!this->quiet)
-			cout<<" boundary size: "<<boundaryVoxels.size()<<" "<<flush;
-		while (!boundaryVoxels.empty()) {
-			idx=boundaryVoxels.back();
-			boundaryVoxels.pop_back();
-			if(img[idx] == this->border) {
-				// copy neighborhood into buffer
-				endpoint=Base3Dskeleton<ImgType>::CopyNeighborhoodInBuffer(img, idx, nb);
-				TransformNeighborhood(nb, dir, USn);
-
-				if(MatchesATemplate(USn)) {		  
-					// delete the point
-					// can be removed
-					img[idx] = this->simple;
-					simpleVoxels.push_back(idx);
-					//nrDel++;
-				}
-				else {
-				//	img[idx]= object;
-					nonSimpleVoxels.push_back(idx);
+	this->quiet=Quiet;
+	kipl::logging::Logger logger("PalagyiSkeleton");
+	std::ostringstream msg;
+
+	const ptrdiff_t sx  = img.Size(0);
+	const ptrdiff_t sy  = img.Size(1);
+	const ptrdiff_t sz  = img.Size(2);
+	const ptrdiff_t sxy = sx*sy;
+
+	// The table is built before the threads start
+	PalagyiDeletableTable();
+
+	// set all object voxels to object, the object voxels at the surface are queued
+	ImgType *vol=img.GetDataPtr();
+	const ptrdiff_t N=static_cast<ptrdiff_t>(img.Size());
+
+	#pragma omp parallel for
+	for (ptrdiff_t idx=0; idx<N; ++idx)
+		vol[idx] = vol[idx]!=0 ? this->object : this->background;
+
+	std::vector<ptrdiff_t> active;
+	#pragma omp parallel
+	{
+		std::vector<ptrdiff_t> localActive;
+
+		#pragma omp for
+		for (ptrdiff_t z=0; z<sz; ++z) {
+			for (ptrdiff_t y=0; y<sy; ++y) {
+				for (ptrdiff_t x=0; x<sx; ++x) {
+					const ptrdiff_t idx=z*sxy+y*sx+x;
+					if (vol[idx]==0)
+						continue;
+
+					if ((x==0) || (x==sx-1) || (y==0) || (y==sy-1) || (z==0) || (z==sz-1) ||
+						(vol[idx-1]==0) || (vol[idx+1]==0) || (vol[idx-sx]==0) || (vol[idx+sx]==0) ||
+						(vol[idx-sxy]==0) || (vol[idx+sxy]==0))
+						localActive.push_back(idx);
 				}
 			}
 		}
-			
-		nrDel=simpleVoxels.size();
-		// reset all object voxels to object
-		while (!simpleVoxels.empty()) {
-			idx=simpleVoxels.front();
-			simpleVoxels.pop_front();
-			img[idx]=this->background;
-		}
-		while (!nonSimpleVoxels.empty()) {
-			idx=nonSimpleVoxels.front();
-			nonSimpleVoxels.pop_front();
-			vol[idx]=this->object;
+
+		#pragma omp critical
+		{
+			active.insert(active.end(),localActive.begin(),localActive.end());
 		}
-		
-		if (!this->quiet)
-      		cout<<"done."<<endl;
-    }
-	if (!this->quiet)
-    	cout<<"Number of deleted voxels in pass "<<nrPasses<<": "<<nrDel<<endl;
-    	
-//    CleanObjectVector(img,objectVoxels);
-    nrPasses++;
-  }
-  cout<<endl;
-  
-  return 0;
-}
+	}
 
+	for (auto idx : active)
+		vol[idx]=this->queued;
 
-template<class ImgType>
-int PalagyiSkeleton<ImgType>::CleanObjectVector(kipl::base::TImage<ImgType,3> &img, vector<long> &objectVoxels)
-{
-	vector<long>::iterator it, toRemove;
-	vector<long> tmp;
-	for (it=objectVoxels.begin(); it!=objectVoxels.end(); it++) 
-		if (img[*it]==this->object) 
-			tmp.push_back(*it);
-			
-	objectVoxels=tmp;
-	
-	return 0;
-}
+	size_t nrDel=1;
+	int nrPasses=1;
+	while (nrDel > 0) {
+		nrDel=0;
+		for (char dir=0; dir < 12; dir++)
+			nrDel+=ThinDirection(img,active,dir);
 
-template<class ImgType>
-bool PalagyiSkeleton<ImgType>::MatchesATemplate(ImgType n[3][3][3]) {
-  // T1
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object))
-     &&
-     ((n[0][0][2] + n[1][0][2] + n[2][0][2] + 
-       n[0][1][2] + n[1][1][2] + n[2][1][2] + 
-       n[0][2][2] + n[1][2][2] + n[2][2][2]) == 0)
-     &&
-     ((n[0][0][0] + n[1][0][0] + n[2][0][0] + n[0][1][0] + n[2][1][0] + n[0][2][0] + n[1][2][0] + n[2][2][0] + 
-       n[0][0][1] + n[1][0][1] + n[2][0][1] + n[0][1][1] + n[2][1][1] + n[0][2][1] + n[1][2][1] + n[2][2][1]) > 0))
-  {
-    // it matches T1
-    return true;
-  }
-  
-  // T2
-  if(
-     ((n[1][1][1] == this->object) && (n[1][2][1] == this->object))
-     &&
-     (n[0][0][0] + n[1][0][0] + n[2][0][0] +
-      n[0][0][1] + n[1][0][1] + n[2][0][1] +
-      n[0][0][2] + n[1][0][2] + n[2][0][2] == 0)
-     && 
-     (n[0][1][0] + n[1][1][0] + n[2][1][0] + n[0][1][1] + n[2][1][1] + n[0][1][2] + n[1][1][2] + n[2][1][2] + 
-      n[0][2][0] + n[1][2][0] + n[2][2][0] + n[0][2][1] + n[2][2][1] + n[0][2][2] + n[1][2][2] + n[2][2][2] > 0))
-  {
-    // it matches T2
-    return true;
-  }
-
-  // T3
-  if(
-     ((n[1][1][1] == this->object) && (n[1][2][0] == this->object)) 
-     &&
-     ((n[0][0][0] + n[1][0][0] + n[2][0][0] + 
-       n[0][0][1] + n[1][0][1] + n[2][0][1] + 
-       n[0][0][2] + n[1][0][2] + n[2][0][2] + 
-       n[0][1][2] + n[1][1][2] + n[2][1][2] + 
-       n[0][2][2] + n[1][2][2] + n[2][2][2]) == 0)
-     &&
-     ((n[0][1][0] + n[0][2][0] + n[2][1][0] + n[2][2][0] +
-       n[0][1][1] + n[0][2][1] + n[2][1][1] + n[2][2][1]) > 0))
-  {
-    // it matches T3
-    return true;
-  }
-  
-  // T4
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) && 
-      (n[1][2][1] == this->object))
-     &&
-     ((n[1][0][1] + n[0][0][2] + n[1][0][2] + n[2][0][2] + n[1][1][2]) == 0)
-     &&
-     ((n[0][0][1] * n[0][1][2]) == 0)
-     &&
-     ((n[2][0][1] * n[2][1][2]) == 0))
-  {
-    // it matches T4
-    return true;
-  }
-  
-  // T5
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) && 
-      (n[1][2][1] == this->object) && (n[2][0][2] == this->object))
-     &&
-     ((n[1][0][1] + n[0][0][2] + n[1][0][2] + n[1][1][2]) == 0)
-     && 
-     ((n[0][0][1] * n[0][1][2]) == 0)
-     &&
-     ((n[2][0][1] + n[2][1][2]) == this->object))
-  {
-    // matches T5
-    return true;
-  }
-
-  // T6
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) && 
-      (n[1][2][1] == this->object) && (n[0][0][2] == this->object))
-     &&
-     ((n[1][0][1] + n[1][0][2] + n[2][0][2] + n[1][1][2]) == 0)
-     &&
-     ((n[0][0][1] + n[0][1][2]) == this->object)
-     &&
-     ((n[2][0][1] * n[2][1][2]) == 0))
-  {
-    // matches T6
-    return true;
-  }
+		msg.str("");
+		msg<<"Number of deleted voxels in pass "<<nrPasses<<": "<<nrDel<<", active voxels: "<<active.size();
+		if (!this->quiet)
+			logger(kipl::logging::Logger::LogMessage,msg.str());
 
-  // T7
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) &&
-      (n[1][2][1] == this->object) && (n[2][1][1] == this->object))
-     &&
-     ((n[1][0][1] + n[0][0][2] + n[1][0][2] + n[1][1][2]) == 0)
-     &&
-     ((n[0][0][1] * n[0][1][2]) == 0))
-  {
-    return true;
-  }
+		nrPasses++;
+	}
 
-  // T8
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) && 
-      (n[1][2][1] == this->object) && (n[0][1][1] == this->object))
-     &&
-     ((n[1][0][1] + n[1][0][2] + n[2][0][2] + n[1][1][2]) == 0)
-     &&
-     ((n[2][0][1] * n[2][1][2]) == 0))
-  {
-    return true;
-  }
+	for (auto idx : active)
+		vol[idx]=this->object;
 
-  // T9
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) &&
-      (n[1][2][1] == this->object) && (n[2][1][1] == this->object) &&
-      (n[0][0][2] == this->object))
-     &&
-     ((n[1][0][1] + n[1][0][2] + n[1][1][2]) == 0) 
-     &&
-     ((n[0][0][1] + n[0][1][2]) == this->object))
-  {
-    return true;
-  }
+	return 0;
+}
 
-  // T10
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) &&
-      (n[0][1][1] == this->object) && (n[1][2][1] == this->object) &&
-      (n[2][0][2] == this->object))
-     &&
-     ((n[1][0][1] + n[1][0][2] + n[1][1][2]) == 0) 
-     &&
-     ((n[2][0][1] + n[2][1][2]) == this->object))
-  {
-    return true;
-  }
+template<class ImgType>
+size_t PalagyiSkeleton<ImgType>::ThinDirection(kipl::base::TImage<ImgType,3> &img,
+											   std::vector<ptrdiff_t> &active,
+											   char direction)
+{
+	// Face neighbors of the directions, 0:+x, 1:-x, 2:-y, 3:+y, 4:-z, 5:+z
+	const char firstBoundary[12]  = {5, 3, 4, 2, 5, 4, 2, 5, 4, 3, 5, 4};
+	const char secondBoundary[12] = {2, 0, 1, 0, 1, 3, 1, 3, 0, 1, 0, 2};
+	const ptrdiff_t faceDx[6] = {1,-1, 0, 0, 0, 0};
+	const ptrdiff_t faceDy[6] = {0, 0,-1, 1, 0, 0};
+	const ptrdiff_t faceDz[6] = {0, 0, 0, 0,-1, 1};
+
+	const ptrdiff_t sx  = img.Size(0);
+	const ptrdiff_t sy  = img.Size(1);
+	const ptrdiff_t sz  = img.Size(2);
+	const ptrdiff_t sxy = sx*sy;
+
+	int bits[27];
+	PackingOrder(direction,bits);
+
+	ptrdiff_t offset[27];
+	for (int p=0; p<27; ++p)
+		offset[p]=(p/9-1)*sxy+((p/3)%3-1)*sx+(p%3-1);
+
+	const std::vector<unsigned long long> &table=PalagyiDeletableTable();
+	const int d[2]={firstBoundary[static_cast<int>(direction)],secondBoundary[static_cast<int>(direction)]};
+
+	ImgType *vol=img.GetDataPtr();
+	const ptrdiff_t nActive=static_cast<ptrdiff_t>(active.size());
+	std::vector<char> deletable(nActive,0);
+
+	// The neighborhoods are only read here, i.e. all voxels are tested on the image of the previous subiteration
+	#pragma omp parallel for schedule(dynamic,4096)
+	for (ptrdiff_t k=0; k<nActive; ++k) {
+		const ptrdiff_t idx=active[k];
+		const ptrdiff_t x=idx % sx;
+		const ptrdiff_t y=(idx / sx) % sy;
+		const ptrdiff_t z=idx / sxy;
+
+		bool border=false;
+		for (int i=0; i<2; ++i) {
+			const ptrdiff_t nx=x+faceDx[d[i]];
+			const ptrdiff_t ny=y+faceDy[d[i]];
+			const ptrdiff_t nz=z+faceDz[d[i]];
+
+			if ((nx<0) || (sx<=nx) || (ny<0) || (sy<=ny) || (nz<0) || (sz<=nz) ||
+				(vol[nz*sxy+ny*sx+nx]==this->background))
+				border=true;
+		}
 
-  // T11
-  if(
-     ((n[1][1][1] == this->object) && (n[2][1][0] == this->object) &&
-      (n[1][2][0] == this->object))
-     &&
-     ((n[0][0][0] + n[1][0][0] + 
-       n[0][0][1] + n[1][0][1] + 
-       n[0][0][2] + n[1][0][2] + n[2][0][2] +
-       n[0][1][2] + n[1][1][2] + n[2][1][2] +
-       n[0][2][2] + n[1][2][2] + n[2][2][2]) == 0))
-  {
-    return true;
-  }
+		if (!border)
+			continue;
 
-  // T12
-  if(
-     ((n[1][1][1] == this->object) && (n[0][1][0] == this->object) && 
-      (n[1][2][0] == this->object))
-     &&
-     ((n[1][0][0] + n[2][0][0] + 
-       n[1][0][1] + n[2][0][1] + 
-       n[0][0][2] + n[1][0][2] + n[2][0][2] +
-       n[0][1][2] + n[1][1][2] + n[2][1][2] +
-       n[0][2][2] + n[1][2][2] + n[2][2][2]) == 0))
-  {
-    return true;
-  }
+		unsigned int code=0;
+		if ((0<x) && (x<sx-1) && (0<y) && (y<sy-1) && (0<z) && (z<sz-1)) {
+			for (int p=0; p<27; ++p)
+				if ((p!=13) && (vol[idx+offset[p]]!=0))
+					code|=1u<<bits[p];
+		}
+		else {
+			// Voxels outside the image are background
+			for (int p=0; p<27; ++p) {
+				const ptrdiff_t nx=x+p%3-1;
+				const ptrdiff_t ny=y+(p/3)%3-1;
+				const ptrdiff_t nz=z+p/9-1;
+
+				if ((p!=13) && (0<=nx) && (nx<sx) && (0<=ny) && (ny<sy) && (0<=nz) && (nz<sz) &&
+					(vol[idx+offset[p]]!=0))
+					code|=1u<<bits[p];
+			}
+		}
 
-  // T13
-  if(
-     ((n[1][1][1] == this->object) && (n[1][2][0] == this->object) && 
-      (n[2][2][1] == this->object))
-     &&
-     ((n[0][0][0] + n[1][0][0] + n[2][0][0] + 
-       n[0][0][1] + n[1][0][1] + n[2][0][1] + 
-       n[0][0][2] + n[1][0][2] + n[2][0][2] + 
-       n[0][1][2] + n[1][1][2] + 
-       n[0][2][2] + n[1][2][2]) == 0))
-  {
-    return true;
-  }
+		deletable[k]=static_cast<char>((table[code>>6]>>(code & 63)) & 1);
+	}
 
-  // T14
-  if(
-     ((n[1][1][1] == this->object) && (n[1][2][0] == this->object) &&
-      (n[0][2][1] == this->object))
-     &&
-     ((n[0][0][0] + n[1][0][0] + n[2][0][0] + 
-       n[0][0][1] + n[1][0][1] + n[2][0][1] + 
-       n[0][0][2] + n[1][0][2] + n[2][0][2] + 
-       n[1][1][2] + n[2][1][2] + 
-       n[1][2][2] + n[2][2][2]) == 0))
-  {
-    return true;
-  }
+	// Delete the simple voxels, the remaining voxels stay at the surface
+	std::vector<ptrdiff_t> deleted;
+	ptrdiff_t nKeep=0;
+	for (ptrdiff_t k=0; k<nActive; ++k) {
+		if (deletable[k]) {
+			vol[active[k]]=this->background;
+			deleted.push_back(active[k]);
+		}
+		else
+			active[nKeep++]=active[k];
+	}
+	active.resize(nKeep);
+
+	// The object face neighbors of the deleted voxels are now at the surface
+	for (auto idx : deleted) {
+		const ptrdiff_t x=idx % sx;
+		const ptrdiff_t y=(idx / sx) % sy;
+		const ptrdiff_t z=idx / sxy;
+
+		for (int i=0; i<6; ++i) {
+			const ptrdiff_t nx=x+faceDx[i];
+			const ptrdiff_t ny=y+faceDy[i];
+			const ptrdiff_t nz=z+faceDz[i];
+
+			if ((0<=nx) && (nx<sx) && (0<=ny) && (ny<sy) && (0<=nz) && (nz<sz)) {
+				const ptrdiff_t pos=nz*sxy+ny*sx+nx;
+				if (vol[pos]==this->object) {
+					vol[pos]=this->queued;
+					active.push_back(pos);
+				}
+			}
+		}
+	}
 
-  return false;
+	return deleted.size();
 }
 
-
-
 // transform neighborhood from a different direction
 template<class ImgType>
-bool PalagyiSkeleton<ImgType>::TransformNeighborhood(ImgType n[3][3][3], 
-													 char direction, 
-													 ImgType USn[3][3][3]) 
+bool PalagyiSkeleton<ImgType>::TransformNeighborhood(int n[3][3][3],
+													 char direction,
+													 int USn[3][3][3])
 {
   int i, j, k,k2,j2;
-  ImgType tmp[3][3][3];
-  
+  int tmp[3][3][3];
+
   switch(direction) {
-  case 0:  //UP_SOUTH = 0, 
+  case 0:  //UP_SOUTH = 0,
     // just copy
-    memcpy(USn, n, 27*sizeof(unsigned char));
+    memcpy(USn, n, 27*sizeof(int));
     break;
   case 1:  //NORT_EAST,
     // 1
@@ -451,7 +314,7 @@ bool PalagyiSkeleton<ImgType>::TransformNeighborhood(ImgType n[3][3][3],
       }
     }
     break;
-  case 2: // DOWN_WEST, 
+  case 2: // DOWN_WEST,
     // 1
     for(k=0; k < 3; k++) {
       for(j=0; j < 3; j++) {
@@ -482,7 +345,7 @@ bool PalagyiSkeleton<ImgType>::TransformNeighborhood(ImgType n[3][3][3],
       }
     }
     break;
-  case 4: //UP_WEST, 
+  case 4: //UP_WEST,
     // 1
     for(k=0; k < 3; k++) {
       for(j=0; j < 3; j++) {
@@ -493,7 +356,7 @@ bool PalagyiSkeleton<ImgType>::TransformNeighborhood(ImgType n[3][3][3],
       }
     }
     break;
-  case 5: // DOWN_NORTH, 
+  case 5: // DOWN_NORTH,
     // 1
     for(k=0; k < 3; k++) {
       for(j=0; j < 3; j++) {
@@ -523,7 +386,7 @@ bool PalagyiSkeleton<ImgType>::TransformNeighborhood(ImgType n[3][3][3],
       }
     }
     break;
-  case 7: //UP_NORTH, 
+  case 7: //UP_NORTH,
     // 1
     for(k=0; k < 3; k++) {
       for(j=0; j < 3; j++) {
@@ -534,7 +397,7 @@ bool PalagyiSkeleton<ImgType>::TransformNeighborhood(ImgType n[3][3][3],
       }
     }
     break;
-  case 8: // DOWN_EAST, 
+  case 8: // DOWN_EAST,
      // 1
     for(k=0; k < 3; k++) {
       for(j=0; j < 3; j++) {
@@ -572,7 +435,7 @@ bool PalagyiSkeleton<ImgType>::TransformNeighborhood(ImgType n[3][3][3],
       }
     }
     break;
-  case 10: // UP_EAST, 
+  case 10: // UP_EAST,
     // 1
     for(k=0; k < 3; k++) {
       for(j=0; j < 3; j++) {
@@ -594,271 +457,26 @@ bool PalagyiSkeleton<ImgType>::TransformNeighborhood(ImgType n[3][3][3],
     }
     break;
   }
-  
-  return true; 
-}
-
-template<class ImgType>
-bool PalagyiSkeleton<ImgType>::MatchesATemplate2(ImgType n[3][3][3]) {
-  // T1
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object))
-     &&
-     ((n[0][0][2] | n[1][0][2] | n[2][0][2] | 
-       n[0][1][2] | n[1][1][2] | n[2][1][2] | 
-       n[0][2][2] | n[1][2][2] | n[2][2][2]) == 0)
-     &&
-     ((n[0][0][0] | n[1][0][0] | n[2][0][0] | n[0][1][0] | n[2][1][0] | n[0][2][0] | n[1][2][0] | n[2][2][0] | 
-       n[0][0][1] | n[1][0][1] | n[2][0][1] | n[0][1][1] | n[2][1][1] | n[0][2][1] | n[1][2][1] | n[2][2][1]) != 0))
-  {
-    // it matches T1
-    return true;
-  }
-  
-  // T2
-  if(
-     ((n[1][1][1] == this->object) && (n[1][2][1] == this->object))
-     &&
-     (n[0][0][0] | n[1][0][0] | n[2][0][0] |
-      n[0][0][1] | n[1][0][1] | n[2][0][1] |
-      n[0][0][2] | n[1][0][2] | n[2][0][2] == 0)
-     && 
-     (n[0][1][0] | n[1][1][0] | n[2][1][0] | n[0][1][1] | n[2][1][1] | n[0][1][2] | n[1][1][2] | n[2][1][2] | 
-      n[0][2][0] | n[1][2][0] | n[2][2][0] | n[0][2][1] | n[2][2][1] | n[0][2][2] | n[1][2][2] | n[2][2][2] > 0))
-  {
-    // it matches T2
-    return true;
-  }
-
-  // T3
-  if(
-     ((n[1][1][1] == this->object) && (n[1][2][0] == this->object)) 
-     &&
-     ((n[0][0][0] | n[1][0][0] | n[2][0][0] | 
-       n[0][0][1] | n[1][0][1] | n[2][0][1] | 
-       n[0][0][2] | n[1][0][2] | n[2][0][2] | 
-       n[0][1][2] | n[1][1][2] | n[2][1][2] | 
-       n[0][2][2] | n[1][2][2] | n[2][2][2]) == 0)
-     &&
-     ((n[0][1][0] | n[0][2][0] | n[2][1][0] | n[2][2][0] |
-       n[0][1][1] | n[0][2][1] | n[2][1][1] | n[2][2][1]) > 0))
-  {
-    // it matches T3
-    return true;
-  }
-  
-  // T4
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) && 
-      (n[1][2][1] == this->object))
-     &&
-     ((n[1][0][1] | n[0][0][2] | n[1][0][2] | n[2][0][2] | n[1][1][2]) == 0)
-     &&
-     ((n[0][0][1] & n[0][1][2]) == 0)
-     &&
-     ((n[2][0][1] & n[2][1][2]) == 0))
-  {
-    // it matches T4
-    return true;
-  }
-  
-  // T5
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) && 
-      (n[1][2][1] == this->object) && (n[2][0][2] == this->object))
-     &&
-     ((n[1][0][1] | n[0][0][2] | n[1][0][2] | n[1][1][2]) == 0)
-     && 
-     ((n[0][0][1] & n[0][1][2]) == 0)
-     &&
-     ((n[2][0][1]== this->object ^ n[2][1][2]==this->object) == this->object))
-  {
-    // matches T5
-    return true;
-  }
-
-  // T6
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) && 
-      (n[1][2][1] == this->object) && (n[0][0][2] == this->object))
-     &&
-     ((n[1][0][1] | n[1][0][2] | n[2][0][2] | n[1][1][2]) == 0)
-     &&
-     ((n[0][0][1]== this->object ^ n[0][1][2]== this->object) == this->object)
-     &&
-     ((n[2][0][1] & n[2][1][2]) == 0))
-  {
-    // matches T6
-    return true;
-  }
-
-  // T7
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) &&
-      (n[1][2][1] == this->object) && (n[2][1][1] == this->object))
-     &&
-     ((n[1][0][1] | n[0][0][2] | n[1][0][2] | n[1][1][2]) == 0)
-     &&
-     ((n[0][0][1] & n[0][1][2]) == 0))
-  {
-    return true;
-  }
-
-  // T8
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) && 
-      (n[1][2][1] == this->object) && (n[0][1][1] == this->object))
-     &&
-     ((n[1][0][1] | n[1][0][2] | n[2][0][2] | n[1][1][2]) == 0)
-     &&
-     ((n[2][0][1] & n[2][1][2]) == 0))
-  {
-    return true;
-  }
-
-  // T9
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) &&
-      (n[1][2][1] == this->object) && (n[2][1][1] == this->object) &&
-      (n[0][0][2] == this->object))
-     &&
-     ((n[1][0][1] | n[1][0][2] | n[1][1][2]) == 0) 
-     &&
-     ((n[0][0][1]== this->object ^ n[0][1][2]== this->object) == this->object))
-  {
-    return true;
-  }
-
-  // T10
-  if(
-     ((n[1][1][1] == this->object) && (n[1][1][0] == this->object) &&
-      (n[0][1][1] == this->object) && (n[1][2][1] == this->object) &&
-      (n[2][0][2] == this->object))
-     &&
-     ((n[1][0][1] | n[1][0][2] | n[1][1][2]) == 0) 
-     &&
-     ((n[2][0][1]== this->object ^ n[2][1][2]== this->object) == this->object))
-  {
-    return true;
-  }
-
-  // T11
-  if(
-     ((n[1][1][1] == this->object) && (n[2][1][0] == this->object) &&
-      (n[1][2][0] == this->object))
-     &&
-     ((n[0][0][0] | n[1][0][0] | 
-       n[0][0][1] | n[1][0][1] | 
-       n[0][0][2] | n[1][0][2] | n[2][0][2] |
-       n[0][1][2] | n[1][1][2] | n[2][1][2] |
-       n[0][2][2] | n[1][2][2] | n[2][2][2]) == 0))
-  {
-    return true;
-  }
-
-  // T12
-  if(
-     ((n[1][1][1] == this->object) && (n[0][1][0] == this->object) && 
-      (n[1][2][0] == this->object))
-     &&
-     ((n[1][0][0] | n[2][0][0] | 
-       n[1][0][1] | n[2][0][1] | 
-       n[0][0][2] | n[1][0][2] | n[2][0][2] |
-       n[0][1][2] | n[1][1][2] | n[2][1][2] |
-       n[0][2][2] | n[1][2][2] | n[2][2][2]) == 0))
-  {
-    return true;
-  }
 
-  // T13
-  if(
-     ((n[1][1][1] == this->object) && (n[1][2][0] == this->object) && 
-      (n[2][2][1] == this->object))
-     &&
-     ((n[0][0][0] | n[1][0][0] | n[2][0][0] | 
-       n[0][0][1] | n[1][0][1] | n[2][0][1] | 
-       n[0][0][2] | n[1][0][2] | n[2][0][2] | 
-       n[0][1][2] | n[1][1][2] | 
-       n[0][2][2] | n[1][2][2]) == 0))
-  {
-    return true;
-  }
-
-  // T14
-  if(
-     ((n[1][1][1] == this->object) && (n[1][2][0] == this->object) &&
-      (n[0][2][1] == this->object))
-     &&
-     ((n[0][0][0] | n[1][0][0] | n[2][0][0] | 
-       n[0][0][1] | n[1][0][1] | n[2][0][1] | 
-       n[0][0][2] | n[1][0][2] | n[2][0][2] | 
-       n[1][1][2] | n[2][1][2] | 
-       n[1][2][2] | n[2][2][2]) == 0))
-  {
-    return true;
-  }
-
-  return false;
+  return true;
 }
 
 template<class ImgType>
-bool PalagyiSkeleton<ImgType>::markBoundaryInDirection(kipl::base::TImage<ImgType,3> &img,
-								 vector<long> &objectVoxels, 
-								 vector<long> &boundaryVoxels,
-			      				 char direction)
+void PalagyiSkeleton<ImgType>::PackingOrder(char direction, int bits[27])
 {
-	vector<long>::iterator it;
-	long pos1;
-	ImgType val=0;
-	for (it=objectVoxels.begin(); it!=objectVoxels.end(); it++) {
-		pos1=this->N26->neighbor(*it,direction);
-		
-		val=img[*it];
-		if (val== this->object) {
-			if ((pos1<0)) {
-				img[*it]= this->border;
-				boundaryVoxels.push_back(*it);
-			}
-			else {
-				if ((img[pos1]==this->background)){
-					img[*it]=this->border;
-					boundaryVoxels.push_back(*it);
-				}
-			}
-		}
-	}
-		
-	return true;
-}
+	int n[3][3][3];
+	int USn[3][3][3];
 
-template<class ImgType>
-bool PalagyiSkeleton<ImgType>::markBoundaryInDirection(kipl::base::TImage<ImgType,3> &img,
-								 vector<long> &objectVoxels, 
-								 vector<long> &boundaryVoxels,
-			      				 char d1, char d2)
-{
-	vector<long>::iterator it;
-	long pos1, pos2;
-	ImgType val=0;
-	for (it=objectVoxels.begin(); it!=objectVoxels.end(); it++) {
-		pos1=this->N26->neighbor(*it,d1);
-		pos2=this->N26->neighbor(*it,d1);
-		val=img[*it];
-		if (val== this->object) {
-			if ((pos1<0) || (pos2<0)) {
-				img[*it]= this->border;
-				boundaryVoxels.push_back(*it);
-			}
-			else {
-				if ((img[pos1]== this->background) || (img[pos2]== this->background)){
-					img[*it]= this->border;
-					boundaryVoxels.push_back(*it);
-				}
-			}
-		}
+	// Each position is marked by its index and found at its rotated position
+	for (int p=0; p<27; ++p)
+		n[p/9][(p/3)%3][p%3]=p;
+
+	TransformNeighborhood(n,direction,USn);
+
+	for (int q=0; q<27; ++q) {
+		const int p=USn[q/9][(q/3)%3][q%3];
+		bits[p] = q==13 ? 0 : PalagyiTableBit(q);
 	}
-		
-	return true;
 }
 
 }}
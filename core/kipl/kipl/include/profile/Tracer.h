@@ -0,0 +1,114 @@
+//<LICENCE>
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include "../kipl_global.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../logging/logger.h"
+
+namespace kipl { namespace profile {
+
+/// \brief Process wide collector of timing spans and counters.
+///
+/// The tracer is disabled by default. All recording calls return immediately when the
+/// tracer is disabled, which keeps the instrumentation cost at a relaxed atomic load.
+/// The recorded events can be written as a Chrome trace (chrome://tracing, Perfetto)
+/// and summarized as a table with one row per span name and counter.
+class KIPLSHARED_EXPORT Tracer
+{
+public:
+    typedef std::chrono::high_resolution_clock::time_point TimePoint;
+
+    /// \brief Enables or disables the recording of events.
+    /// \param on The new state of the tracer.
+    static void enable(bool on=true);
+
+    /// \returns True if events are recorded.
+    static bool enabled() { return s_bEnabled.load(std::memory_order_relaxed); }
+
+    /// \brief Removes all recorded events and restarts the trace clock.
+    static void clear();
+
+    /// \brief Records a completed span.
+    /// \param name Name of the span, spans with the same name are grouped in the summary.
+    /// \param category Category string, e.g. io, preprocessing or backprojection.
+    /// \param start Time point when the span started.
+    /// \param stop Time point when the span ended.
+    static void addSpan(const std::string &name, const std::string &category, TimePoint start, TimePoint stop);
+
+    /// \brief Records a counter sample, e.g. bytes read or projections per second for a block.
+    /// \param name Name of the counter.
+    /// \param value The sample value.
+    static void addCounter(const std::string &name, double value);
+
+    /// \brief Writes the recorded events in the Chrome trace event JSON format.
+    /// \param fname Name of the destination file.
+    static void writeChromeTrace(const std::string &fname);
+
+    /// \brief Creates a table summarizing the recorded spans (count, total, mean, min, max) and counters (samples, sum, mean, min, max).
+    /// \returns The table as a string.
+    static std::string summary();
+
+private:
+    static std::atomic<bool> s_bEnabled;
+};
+
+/// \brief Scoped span that is recorded by the Tracer when it goes out of scope or is stopped.
+///
+/// The span does nothing, except a check of the tracer state, when the tracer is disabled.
+class KIPLSHARED_EXPORT TraceSpan
+{
+public:
+    /// \brief Starts a span.
+    /// \param name Name of the span.
+    /// \param category Category of the span.
+    TraceSpan(const std::string &name, const std::string &category="");
+
+    /// \brief Records the span if it wasn't stopped before.
+    ~TraceSpan();
+
+    /// \brief Stops and records the span.
+    /// \returns The duration of the span in seconds or zero if the tracer is disabled.
+    double stop();
+
+private:
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan & operator=(const TraceSpan &) = delete;
+
+    bool m_bActive;
+    std::string m_sName;
+    std::string m_sCategory;
+    Tracer::TimePoint m_Start;
+};
+
+/// \brief Controls the tracer from the command line arguments trace:file=<filename> and trace:summary=true.
+///
+/// The class is shared by the command line tools to give them the same trace options.
+class KIPLSHARED_EXPORT TraceArguments
+{
+    kipl::logging::Logger logger;
+public:
+    TraceArguments();
+
+    /// \brief Reads the trace arguments and enables a cleared tracer if any of them is given.
+    /// \param args The command line arguments.
+    /// \returns True if the tracer was enabled.
+    bool setup(const std::vector<std::string> &args);
+
+    /// \brief Disables the tracer, writes the trace file and prints the summary to std::cout as requested by the arguments.
+    void report();
+
+private:
+    std::string m_sTraceFile;
+    bool m_bSummary;
+};
+
+}}
+
+#endif // TRACER_H
@@ -6,6 +6,8 @@
 #include <sstream>
 #include <ios>
 #include <string>
+#include <vector>
+#include <algorithm>
 
 #include "../base/timage.h"
 #include "diff_filterbase.h"
@@ -68,18 +70,31 @@ template <typename T, size_t NDim>
 
         int Regularization() {return DiffusionBaseFilter<T,NDim>::Regularization(this->u,this->v);}
 
-		/// \brief Performs one AOS iteration 
+		/// \brief Performs one AOS iteration, the lines are solved in parallel
 		int AOSiteration();
 
-        /// \brief Solve a linear system of equations using Thomas algorithm for tri diagonal matrices
-        /// \param alpha Main diagonal data
-        /// \param beta Right diagonal data
-        /// \param gamma Left diagonal data
-        /// \param d Right hand side of equation system
-        /// \param uk Solution
-        /// \param N kernel size
-        /// \note the function is tested
-		int SolveThomas(float *alpha, float *beta, float *gamma, float *d, float *uk, int N);
+        /// Number of adjacent lines that are solved together in the strided directions
+        static const size_t nLanes=16;
+
+        /// \brief Solves the AOS system of one contiguous line using the Thomas algorithm
+        /// \param pG Diffusivity along the line
+        /// \param pF Right hand side of the equation system
+        /// \param pU Receives the solution
+        /// \param N length of the line
+        /// \param scratch working memory with 3N elements
+        void SolveLine(const float *pG, const float *pF, float *pU, size_t N, float *scratch);
+
+        /// \brief Solves the AOS systems of adjacent strided lines together, the lines are interleaved in memory.
+        /// The loops run over the lanes, i.e. the memory accesses are contiguous and the lanes are vectorized.
+        /// \param pG Diffusivity of the first line
+        /// \param pF Right hand side of the first line
+        /// \param pU Solution of the first line, it is updated as pU=scale*(pU+x)
+        /// \param stride distance between two elements of a line
+        /// \param N length of the lines
+        /// \param w number of lines, at most nLanes
+        /// \param scale weight of the sum of the previous value and the solution
+        /// \param scratch working memory with 3*N*nLanes elements
+        void SolveLines(const float *pG, const float *pF, float *pU, size_t stride, size_t N, size_t w, float scale, float *scratch);
 
         /// \brief get the line pointer in G
         /// \param i y-coordinate of the line
@@ -97,43 +112,14 @@ template <typename T, size_t NDim>
         ///\param s The function argument to to g(s)
 		float getG_LUT(float s);
 
-        /// \brief Allocates memory for the computational kernel
-        ///	\param N length of the 1D signal
-		int AllocateKernel(int N);
-
-		/// \brief Deallocates the kernel memory
-		int DeAllocateKernel();
-
 		float lambda;
         LambdaEstBase<T,NDim> *lambdaest;
-		
-		int NKernel;
-
-		float *p;
-		float *q;
-		float *d; /// Right hand side of the Equation system
-		float *a; /// Storage vector for the main diagonal of the equation system
-		float *b; /// Off-diagonal vectors of the equation system
-		float *x; /// Solution vector		
-		float *y; /// Vector containing the R solution of the LR decomposition
-		float *l; /// L part of the LR decomposition
-		float *m; /// Main diagonal of the LR decomposition
-
 	};
 
 template <typename T, size_t NDim>
 NonLinDiffusionFilter<T,NDim>::NonLinDiffusionFilter(kipl::interactors::InteractionBase *interactor):
   DiffusionBaseFilter<T,NDim>(1.0f,0.25f,10,interactor),
-  lambdaest(nullptr),
-  a(nullptr),
-  b(nullptr),
-  d(nullptr),
-  p(nullptr),
-  q(nullptr),
-  x(nullptr),
-  y(nullptr),
-  m(nullptr),
-  l(nullptr)
+  lambdaest(nullptr)
 {
 
 
@@ -143,16 +129,7 @@ template <typename T, size_t NDim>
 NonLinDiffusionFilter<T,NDim>::NonLinDiffusionFilter(float Sigma, float Tau, float Lambda, int It,kipl::interactors::InteractionBase *interactor):
 DiffusionBaseFilter<T,NDim>(Sigma,Tau,It,interactor),
     lambda(Lambda),
-    lambdaest(nullptr),
-    a(nullptr),
-    b(nullptr),
-    d(nullptr),
-    p(nullptr),
-    q(nullptr),
-    x(nullptr),
-    y(nullptr),
-    m(nullptr),
-    l(nullptr)
+    lambdaest(nullptr)
 {
 	this->sigma.clear();
 	this->sigma.push_back(Sigma);
@@ -212,66 +189,19 @@ DiffusionBaseFilter<T,NDim>(Sigma,Tau,It,interactor),
 //}
 
 template <typename T, size_t NDim>
-NonLinDiffusionFilter<T,NDim>::~NonLinDiffusionFilter()
-{
-	DeAllocateKernel();
-}
-
-
-template <typename T, size_t NDim>
-    int NonLinDiffusionFilter<T,NDim>::AllocateKernel(int N)
-{
-	if (N!=NKernel) {
-		DeAllocateKernel();
-
-		a=new float[N];
-		b=new float[N];
-		d=new float[N];
-		p=new float[N];
-		q=new float[N];
-		x=new float[N];
-		y=new float[N];
-		m=new float[N];		
-		l=new float[N];
-
-		NKernel=N;
-	}
-
-	return 1;
-}
+const size_t NonLinDiffusionFilter<T,NDim>::nLanes;
 
 template <typename T, size_t NDim>
-    int NonLinDiffusionFilter<T,NDim>::DeAllocateKernel()
+NonLinDiffusionFilter<T,NDim>::~NonLinDiffusionFilter()
 {
-
-    if (a!=nullptr) delete [] a;
-    if (b!=nullptr) delete [] b;
-    if (d!=nullptr) delete [] d;
-    if (p!=nullptr) delete [] p;
-    if (q!=nullptr) delete [] q;
-    if (x!=nullptr) delete [] x;
-    if (y!=nullptr) delete [] y;
-    if (m!=nullptr) delete [] m;
-    if (l!=nullptr) delete [] l;
-
-	return 1;
 }
 
 template <typename T, size_t NDim>
 int NonLinDiffusionFilter<T,NDim>::operator()(kipl::base::TImage<float,NDim> &img)
 {
 
-    switch (NDim) {
-    case 2:
-        AllocateKernel(max(max(img.Size(0),img.Size(1)),img.Size(2)));
-        break;
-    case 3:
-        AllocateKernel(max(max(img.Size(0),img.Size(1)),img.Size(2)));
-        break;
-    default:
-        kipl::base::KiplException("Chosen dimension is not supported by non-linear diffusion filter",__FILE__,__LINE__);
-        return 0;
-    }
+    if ((NDim!=2) && (NDim!=3))
+        throw kipl::base::KiplException("Chosen dimension is not supported by non-linear diffusion filter",__FILE__,__LINE__);
     this->u.Clone(img);
     img.FreeImage();
 
@@ -338,167 +268,167 @@ template <typename T, size_t NDim>
 	//f=u; //memorysaving precuation (MSP 041115)
 	this->v=this->u; // MSP 041115
     this->v.Clone(); // Use memcpy instead to save new/delete operations
-    this->u=static_cast<T>(0);
 
-	int sx=this->u.Size(0);
-	int sy=this->u.Size(1);
-	int sz=this->u.Size(2),sxy=sx*sy;
-	int i,j,k;
+	const size_t sx=this->u.Size(0);
+	const size_t sy=this->u.Size(1);
+	const size_t sz=NDim==3 ? this->u.Size(NDim-1) : 1;
+	const size_t sxy=sx*sy;
+	const size_t nMax=std::max(std::max(sx,sy),sz);
 
-	float *pG,*pF,*pU, *pX;
-	
-	for (k=0; k<sz; k++) {
-		// Operating on Rows
-		for (i=0; i<sy; i++) {
-			pG=getG(i,k);
-			//pF=f.GetLinePtr(i,k); // MSP 041115
-			pF=this->v.GetLinePtr(i,k);
-
-			for (j=0; j<sx-1; j++) {
-				q[j] = pG[j]+pG[j+1]; //(d(1:end-1,:)+d(2:end,:));
-				d[j]=pF[j]; // RHS of B u = d
-			}
-			d[j]=pF[j];
-			p[0] = q[0];
-			p[sx-1] = q[sx-2];
-
-			for (j=1; j<sx-1; j++) 
-				p[j]=q[j-1]+q[j]; //p(2:end-1,:) = ( q(1:end-1,:) + q(2:end,:) );
-
-			for (j=0; j<sx; j++) // Compute the main diagonal
-				a[j] = 1 + this->tau*p[j]; //(p is -1*p)
-
-			for (j=0; j<sx-1; j++) // Compute the left and right off-diagonals
-				b[j] = -this->tau*q[j];
+	// Each pass writes its own elements of u, the passes are separated by the barriers of the loops
+	#pragma omp parallel
+	{
+		std::vector<float> scratch(3*nMax*nLanes);
 
-			SolveThomas(a,b,b,d,x,sx);
+		// Operating on Rows
+		#pragma omp for schedule(static)
+		for (ptrdiff_t line=0; line<static_cast<ptrdiff_t>(sy*sz); ++line) {
+			const size_t i=line % sy;
+			const size_t k=line / sy;
 
-			pU=this->u.GetLinePtr(i,k);			// Insert the solution in u
-			pX=x;
-			for (int j=0; j<sx; j++) 
-				pU[j]=pX[j];
+			SolveLine(getG(i,k),this->v.GetLinePtr(i,k),this->u.GetLinePtr(i,k),sx,scratch.data());
 		}
 
+		// Operating on Columns, adjacent columns are solved together
+		const size_t nColBlocks=(sx+nLanes-1)/nLanes;
+		#pragma omp for schedule(static)
+		for (ptrdiff_t block=0; block<static_cast<ptrdiff_t>(nColBlocks*sz); ++block) {
+			const size_t x0=(block % nColBlocks)*nLanes;
+			const size_t k=block / nColBlocks;
+			const size_t offset=k*sxy+x0;
 
-		// Operating on Columns
-		
-		for (i=0; i<sx; i++) {
-			pG=this->g.GetLinePtr(0,k)+i;
-			//pF=f.getSliceptr(k)+i;
-			pF=this->v.GetLinePtr(0,k)+i;
-			for (j=0; j<sy-1; j++,pG+=sx, pF+=sx) {
-				q[j] = *pG+*(pG+sx); //(d(1:end-1,:)+d(2:end,:));
-				d[j] = *pF;
-			}
-			d[j]=*pF;
-
-			p[0] = q[0];
-			p[sy-1] = q[sy-2];
-
-			for (j=1; j<sy-1; j++) 
-				p[j]=q[j-1]+q[j]; //p(2:end-1,:) = ( q(1:end-1,:) + q(2:end,:) );
-
-
-			for (j=0; j<sy; j++)
-				a[j] = 1 + this->tau*p[j]; //(p is -1*p)
-
-			for (j=0; j<sy-1; j++)
-				b[j] = -this->tau*q[j];
-
-			SolveThomas(a,b,b,d,x,sy);
-
-			pU=this->u.GetLinePtr(0,k)+i;
-			pX=x;
-			if (NDim==2)
-				for (int j=0; j<sy; j++, pU+=sx,pX++) 
-					*pU=0.5f*(*pU+*pX);
-
-			if (NDim==3)
-				for (int j=0; j<sy; j++, pU+=sx,pX++) 
-					*pU=*pU+*pX;
-
+			SolveLines(this->g.GetDataPtr()+offset,this->v.GetDataPtr()+offset,this->u.GetDataPtr()+offset,
+			           sx,sy,std::min(nLanes,sx-x0),NDim==2 ? 0.5f : 1.0f,scratch.data());
 		}
-	}
-
-	// Operating on Pillars
-	if (NDim==3) {
-		float third=1/3.0f;
-		for (i=0; i<sxy; i++) {
-			pG=this->g.GetDataPtr()+i;
-			//pF=f.GetDataPtr()+i;
-			pF=this->v.GetDataPtr()+i;
-
-			for (j=0; j<sz-1; j++,pG+=sxy, pF+=sxy) {
-				q[j] = *pG+*(pG+sxy); //(d(1:end-1,:)+d(2:end,:));
-				d[j] = *pF;
-			}
-			d[j]=*pF;
-
-			p[0] = q[0];
-			p[sy-1] = q[sy-2];
-
-			for (j=1; j<sz-1; j++) 
-				p[j]=q[j-1]+q[j]; //p(2:end-1,:) = ( q(1:end-1,:) + q(2:end,:) );
-
 
-			for (j=0; j<sz; j++)
-				a[j] = 1 + this->tau*p[j]; //(p is -1*p)
-
-			for (j=0; j<sz-1; j++)
-				b[j] = -this->tau*q[j];
-
-			SolveThomas(a,b,b,d,x,sz);
-
-			pU=this->u.GetDataPtr()+i;
-			pX=x;
-			
-
-			for (int j=0; j<sz; j++, pU+=sxy,pX++) 
-				*pU=(*pU+*pX)*third;
+		// Operating on Pillars, adjacent pillars are solved together
+		if (NDim==3) {
+			const size_t nPillarBlocks=(sxy+nLanes-1)/nLanes;
+			#pragma omp for schedule(static)
+			for (ptrdiff_t block=0; block<static_cast<ptrdiff_t>(nPillarBlocks); ++block) {
+				const size_t offset=block*nLanes;
 
+				SolveLines(this->g.GetDataPtr()+offset,this->v.GetDataPtr()+offset,this->u.GetDataPtr()+offset,
+				           sxy,sz,std::min(nLanes,sxy-offset),1/3.0f,scratch.data());
+			}
 		}
 	}
 
 	return 1;
 }
 
-    template <typename T, size_t NDim>
-        int NonLinDiffusionFilter<T,NDim>::SolveThomas(float *alpha, float *beta, float *gamma, float *d, float *uk, int N)
-	{
-		int i;
-		m[0]=1/alpha[0];
-		for (i=0; i<N-1; i++) {
-			l[i]=gamma[i]*m[i];
-			m[i+1]=1/(alpha[i+1]-l[i]*beta[i]);
+template <typename T, size_t NDim>
+void NonLinDiffusionFilter<T,NDim>::SolveLine(const float *pG, const float *pF, float *pU, size_t N, float *scratch)
+{
+	// The system is B u = f with the main diagonal 1+tau*(q[j-1]+q[j]) and the off-diagonals -tau*q[j], q[j]=g[j]+g[j+1]
+	float *m=scratch;     // inverse of the main diagonal of the LR decomposition
+	float *y=scratch+N;   // forward substituted right hand side
+	float *b=scratch+2*N; // off-diagonal
+	const float tau=this->tau;
+
+	float qPrev=0.0f;
+	float bPrev=0.0f;
+	for (size_t j=0; j<N; ++j) {
+		const float q=j<N-1 ? pG[j]+pG[j+1] : 0.0f;
+		const float a=1+tau*(qPrev+q);
+
+		if (j==0) {
+			m[j]=1/a;
+			y[j]=pF[j];
+		}
+		else {
+			const float l=bPrev*m[j-1];
+			m[j]=1/(a-l*bPrev);
+			y[j]=pF[j]-l*y[j-1];
 		}
 
-		y[0]=d[0];
-		for (i=1; i<N; i++) 
-			y[i]=d[i]-l[i-1]*y[i-1];
+		b[j]=-tau*q;
+		bPrev=b[j];
+		qPrev=q;
+	}
 
-		uk[N-1]=y[N-1]*m[N-1];
+	pU[N-1]=y[N-1]*m[N-1];
+	for (size_t j=N-1; 0<j; --j)
+		pU[j-1]=(y[j-1]-b[j-1]*pU[j])*m[j-1];
+}
 
-		for (i=N-2; i>=0; i--)
-			uk[i]=(y[i]-beta[i]*uk[i+1])*m[i];
+template <typename T, size_t NDim>
+void NonLinDiffusionFilter<T,NDim>::SolveLines(const float *pG, const float *pF, float *pU, size_t stride, size_t N, size_t w, float scale, float *scratch)
+{
+	// Same recursion as SolveLine with one lane per line, the element j of lane s is found at j*stride+s
+	float *m=scratch;
+	float *y=scratch+N*nLanes;
+	float *b=scratch+2*N*nLanes;
+	const float tau=this->tau;
+
+	float q[nLanes];
+	float qPrev[nLanes];
+	float x[nLanes];
+
+	std::fill_n(qPrev,nLanes,0.0f);
+	std::fill_n(q,nLanes,0.0f);
+
+	for (size_t j=0; j<N; ++j) {
+		const float *g0=pG+j*stride;
+		const float *f0=pF+j*stride;
+		float *mj=m+j*nLanes;
+		float *yj=y+j*nLanes;
+		float *bj=b+j*nLanes;
+
+		if (j<N-1) {
+			#pragma omp simd
+			for (size_t s=0; s<w; ++s)
+				q[s]=g0[s]+g0[s+stride];
+		}
+		else
+			std::fill_n(q,nLanes,0.0f);
+
+		if (j==0) {
+			#pragma omp simd
+			for (size_t s=0; s<w; ++s) {
+				mj[s]=1/(1+tau*(qPrev[s]+q[s]));
+				yj[s]=f0[s];
+			}
+		}
+		else {
+			const float *mPrev=mj-nLanes;
+			const float *yPrev=yj-nLanes;
+			const float *bPrev=bj-nLanes;
+			#pragma omp simd
+			for (size_t s=0; s<w; ++s) {
+				const float l=bPrev[s]*mPrev[s];
+				mj[s]=1/(1+tau*(qPrev[s]+q[s])-l*bPrev[s]);
+				yj[s]=f0[s]-l*yPrev[s];
+			}
+		}
 
-/*
-		m[0]=alpha[0];
-		for (i=0; i<N-1; i++) {
-			l[i]=gamma[i]/m[i];
-			m[i+1]=alpha[i+1]-l[i]*beta[i];
+		#pragma omp simd
+		for (size_t s=0; s<w; ++s) {
+			bj[s]=-tau*q[s];
+			qPrev[s]=q[s];
 		}
+	}
 
-		y[0]=d[0];
-		for (i=1; i<N; i++) 
-			y[i]=d[i]-l[i-1]*y[i-1];
+	float *u0=pU+(N-1)*stride;
+	#pragma omp simd
+	for (size_t s=0; s<w; ++s) {
+		x[s]=y[(N-1)*nLanes+s]*m[(N-1)*nLanes+s];
+		u0[s]=scale*(u0[s]+x[s]);
+	}
 
-		uk[N-1]=y[N-1]/m[N-1];
+	for (size_t j=N-1; 0<j; --j) {
+		const float *mj=m+(j-1)*nLanes;
+		const float *yj=y+(j-1)*nLanes;
+		const float *bj=b+(j-1)*nLanes;
+		float *uj=pU+(j-1)*stride;
 
-		for (i=N-2; i>=0; i--)
-			uk[i]=(y[i]-beta[i]*uk[i+1])/m[i];
-*/
-		return 1;
+		#pragma omp simd
+		for (size_t s=0; s<w; ++s) {
+			x[s]=(yj[s]-bj[s]*x[s])*mj[s];
+			uj[s]=scale*(uj[s]+x[s]);
+		}
 	}
+}
 
 template <typename T, size_t NDim>
         int NonLinDiffusionFilter<T,NDim>::Diffusivity()
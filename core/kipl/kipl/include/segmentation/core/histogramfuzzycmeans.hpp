@@ -0,0 +1,382 @@
+//<LICENCE>
+
+#ifndef SEGMENTATIONHISTOGRAMFUZZYCMEANS_HPP
+#define SEGMENTATIONHISTOGRAMFUZZYCMEANS_HPP
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <sstream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../../base/timage.h"
+#include "../../base/KiplException.h"
+#include "../../math/image_statistics.h"
+#include "../../logging/logger.h"
+
+namespace kipl { namespace segmentation {
+
+template<class ImgType, class SegType ,size_t NDim>
+HistogramFuzzyCMeans<ImgType,SegType,NDim>::HistogramFuzzyCMeans() :
+    kipl::segmentation::SegmentationBase<ImgType,SegType,NDim>("HistogramFuzzyCMeans"),
+    maxIterations(250),
+    haveCenters(false),
+    centers(2,0.0f),
+    fuzziness(1.5f),
+    m_fSigma(0.0f),
+    m_nBins(65536),
+    m_nIterations(0),
+    m_fBinStart(0.0),
+    m_fBinScale(1.0)
+{
+    this->nClasses=2;
+}
+
+template<class ImgType, class SegType ,size_t NDim>
+HistogramFuzzyCMeans<ImgType,SegType,NDim>::~HistogramFuzzyCMeans()
+{
+}
+
+template<class ImgType, class SegType ,size_t NDim>
+int HistogramFuzzyCMeans<ImgType,SegType,NDim>::set(int NClasses, float fuz, int maxIt, float sigma)
+{
+    if (NClasses<1)
+        throw kipl::base::KiplException("HistogramFuzzyCMeans needs at least one class",__FILE__,__LINE__);
+
+    if (fuz<=1.0f)
+        throw kipl::base::KiplException("HistogramFuzzyCMeans: the fuzziness must be greater than one",__FILE__,__LINE__);
+
+    if (sigma<0.0f)
+        throw kipl::base::KiplException("HistogramFuzzyCMeans: the kernel width must not be negative",__FILE__,__LINE__);
+
+    this->nClasses=NClasses;
+    centers.assign(NClasses,0.0f);
+    haveCenters=false;
+
+    fuzziness=fuz;
+    maxIterations=maxIt;
+    m_fSigma=sigma;
+
+    return 0;
+}
+
+template<class ImgType, class SegType ,size_t NDim>
+void HistogramFuzzyCMeans<ImgType,SegType,NDim>::setBins(size_t nBins)
+{
+    if (nBins<2)
+        throw kipl::base::KiplException("HistogramFuzzyCMeans needs at least two bins",__FILE__,__LINE__);
+
+    m_nBins=nBins;
+}
+
+template<class ImgType, class SegType ,size_t NDim>
+int HistogramFuzzyCMeans<ImgType,SegType,NDim>::setCenters(float const * const cVec)
+{
+    std::copy(cVec,cVec+this->nClasses,centers.begin());
+    haveCenters=true;
+
+    return 0;
+}
+
+template<class ImgType, class SegType ,size_t NDim>
+void HistogramFuzzyCMeans<ImgType,SegType,NDim>::setParameters(std::map<std::string,std::string> parameters)
+{
+    int   nc    = this->nClasses;
+    float fuz   = fuzziness;
+    int   maxIt = maxIterations;
+    float sigma = m_fSigma;
+
+    if (parameters.count("nclasses"))
+        nc=std::atoi(parameters["nclasses"].c_str());
+    if (parameters.count("fuzziness"))
+        fuz=static_cast<float>(std::atof(parameters["fuzziness"].c_str()));
+    if (parameters.count("maxiterations"))
+        maxIt=std::atoi(parameters["maxiterations"].c_str());
+    if (parameters.count("sigma"))
+        sigma=static_cast<float>(std::atof(parameters["sigma"].c_str()));
+
+    set(nc,fuz,maxIt,sigma);
+}
+
+template<class ImgType, class SegType ,size_t NDim>
+size_t HistogramFuzzyCMeans<ImgType,SegType,NDim>::binIndex(ImgType x) const
+{
+    const double pos=(static_cast<double>(x)-m_fBinStart)*m_fBinScale;
+
+    // Also catches NaN
+    if (!(0.0<pos))
+        return 0;
+
+    return pos<static_cast<double>(m_nBins-1) ? static_cast<size_t>(pos) : m_nBins-1;
+}
+
+template<class ImgType, class SegType ,size_t NDim>
+void HistogramFuzzyCMeans<ImgType,SegType,NDim>::buildHistogram(const kipl::base::TImage<ImgType,NDim> &img)
+{
+    ImgType imgmin=static_cast<ImgType>(0);
+    ImgType imgmax=static_cast<ImgType>(0);
+    kipl::math::minmax(img.GetDataPtr(),img.Size(),&imgmin,&imgmax);
+
+    const double range=static_cast<double>(imgmax)-static_cast<double>(imgmin);
+    m_fBinStart=static_cast<double>(imgmin);
+
+    if (std::numeric_limits<ImgType>::is_integer && (range<static_cast<double>(m_nBins)))
+        m_fBinScale=1.0; // One bin per gray level
+    else if (0.0<range)
+        m_fBinScale=m_nBins/range;
+    else
+        m_fBinScale=0.0;
+
+    std::vector<double> binSum(m_nBins,0.0);
+    m_BinCount.assign(m_nBins,0);
+
+    ImgType const * const pImg=img.GetDataPtr();
+    const ptrdiff_t N=static_cast<ptrdiff_t>(img.Size());
+
+    #pragma omp parallel
+    {
+        std::vector<size_t> count(m_nBins,0);
+        std::vector<double> sum(m_nBins,0.0);
+
+        #pragma omp for
+        for (ptrdiff_t i=0; i<N; ++i) {
+            const size_t b=binIndex(pImg[i]);
+            ++count[b];
+            sum[b]+=static_cast<double>(pImg[i]);
+        }
+
+        #pragma omp critical
+        {
+            for (size_t b=0; b<m_nBins; ++b) {
+                m_BinCount[b]+=count[b];
+                binSum[b]+=sum[b];
+            }
+        }
+    }
+
+    m_BinValue.resize(m_nBins);
+    m_Occupied.clear();
+    for (size_t b=0; b<m_nBins; ++b) {
+        if (m_BinCount[b]!=0) {
+            m_BinValue[b]=binSum[b]/m_BinCount[b];
+            m_Occupied.push_back(b);
+        }
+        else if (m_fBinScale==1.0)
+            m_BinValue[b]=m_fBinStart+b;
+        else
+            m_BinValue[b]=m_fBinScale!=0.0 ? m_fBinStart+(b+0.5)/m_fBinScale : m_fBinStart;
+    }
+}
+
+template<class ImgType, class SegType ,size_t NDim>
+void HistogramFuzzyCMeans<ImgType,SegType,NDim>::initCenters()
+{
+    const int NC=this->nClasses;
+    size_t total=0;
+    for (auto b : m_Occupied)
+        total+=m_BinCount[b];
+
+    // The centers start at the quantiles (c+0.5)/NC of the gray levels
+    size_t cumsum=0;
+    int c=0;
+    for (auto b : m_Occupied) {
+        cumsum+=m_BinCount[b];
+        while ((c<NC) && ((c+0.5)*total<=static_cast<double>(cumsum)*NC)) {
+            centers[c]=static_cast<float>(m_BinValue[b]);
+            ++c;
+        }
+    }
+
+    for ( ; c<NC; ++c)
+        centers[c]=static_cast<float>(m_BinValue[m_Occupied.back()]);
+}
+
+template<class ImgType, class SegType ,size_t NDim>
+void HistogramFuzzyCMeans<ImgType,SegType,NDim>::computeMembership(double x, float *u) const
+{
+    const int NC=this->nClasses;
+    const bool bKernel=0.0f<m_fSigma;
+    // FCM uses (1/|x-v|^2)^(1/(m-1)), the kernel version (1/(1-K(x,v)))^(1/(m-1))
+    const double mpower=(bKernel ? -1.0 : -2.0)/(fuzziness-1.0);
+    const double sigma2=static_cast<double>(m_fSigma)*m_fSigma;
+
+    // The distances are kept in u until the memberships are known
+    int nZero=0;
+    float dmin=std::numeric_limits<float>::max();
+    for (int c=0; c<NC; ++c) {
+        const double diff=x-centers[c];
+        u[c]=static_cast<float>(bKernel ? 1.0-std::exp(-diff*diff/sigma2) : std::fabs(diff));
+
+        dmin=std::min(dmin,u[c]);
+        if (u[c]<=0.0f)
+            ++nZero;
+    }
+
+    if (nZero!=0) {
+        // The gray level coincides with one or more centers
+        for (int c=0; c<NC; ++c)
+            u[c] = u[c]<=0.0f ? 1.0f/nZero : 0.0f;
+
+        return;
+    }
+
+    // Relative to the nearest center to avoid overflow for small distances
+    double sum=0.0;
+    for (int c=0; c<NC; ++c) {
+        u[c]=static_cast<float>(std::pow(static_cast<double>(u[c])/dmin,mpower));
+        sum+=u[c];
+    }
+
+    for (int c=0; c<NC; ++c)
+        u[c]=static_cast<float>(u[c]/sum);
+}
+
+template<class ImgType, class SegType ,size_t NDim>
+int HistogramFuzzyCMeans<ImgType,SegType,NDim>::operator()(kipl::base::TImage<ImgType,NDim> & img, kipl::base::TImage<SegType,NDim> &seg)
+{
+    const kipl::base::TImage<ImgType,NDim> &cimg=img;
+
+    return operator()(cimg,seg);
+}
+
+template<class ImgType, class SegType ,size_t NDim>
+int HistogramFuzzyCMeans<ImgType,SegType,NDim>::operator()(const kipl::base::TImage<ImgType,NDim> & img, kipl::base::TImage<SegType,NDim> &seg)
+{
+    std::ostringstream msg;
+    const int NC=this->nClasses;
+
+    if (img.Size()==0)
+        throw kipl::base::KiplException("HistogramFuzzyCMeans: the image is empty",__FILE__,__LINE__);
+
+    buildHistogram(img);
+
+    if (!haveCenters)
+        initCenters();
+
+    const bool bKernel=0.0f<m_fSigma;
+    const double sigma2=static_cast<double>(m_fSigma)*m_fSigma;
+    const ptrdiff_t nOccupied=static_cast<ptrdiff_t>(m_Occupied.size());
+    std::vector<float> U(nOccupied*NC,0.0f);
+    std::vector<double> sum(NC), uxSum(NC);
+
+    double change=0.0;
+    int r=0;
+    for (r=0; r<maxIterations; ++r) {
+        // Update the memberships, each bin is a single gray level
+        change=0.0;
+        #pragma omp parallel
+        {
+            std::vector<float> u(NC);
+            double localChange=0.0;
+
+            #pragma omp for
+            for (ptrdiff_t k=0; k<nOccupied; ++k) {
+                float *pU=U.data()+k*NC;
+                computeMembership(m_BinValue[m_Occupied[k]],u.data());
+
+                for (int c=0; c<NC; ++c) {
+                    localChange=std::max(localChange,static_cast<double>(std::fabs(u[c]-pU[c])));
+                    pU[c]=u[c];
+                }
+            }
+
+            #pragma omp critical
+            {
+                change=std::max(change,localChange);
+            }
+        }
+
+        // Update the centers, the bins are weighted by their voxel count
+        std::fill(sum.begin(),sum.end(),0.0);
+        std::fill(uxSum.begin(),uxSum.end(),0.0);
+        for (ptrdiff_t k=0; k<nOccupied; ++k) {
+            const size_t b=m_Occupied[k];
+            const double x=m_BinValue[b];
+            const float *pU=U.data()+k*NC;
+
+            for (int c=0; c<NC; ++c) {
+                double w=m_BinCount[b]*std::pow(static_cast<double>(pU[c]),static_cast<double>(fuzziness));
+                if (bKernel) {
+                    const double diff=x-centers[c];
+                    w*=std::exp(-diff*diff/sigma2);
+                }
+                sum[c]+=w;
+                uxSum[c]+=w*x;
+            }
+        }
+
+        for (int c=0; c<NC; ++c)
+            if (sum[c]!=0.0)
+                centers[c]=static_cast<float>(uxSum[c]/sum[c]);
+
+        std::sort(centers.begin(),centers.end());
+
+        if (change<1e-5)
+            break;
+    }
+    m_nIterations=r;
+
+    msg<<r<<"("<<maxIterations<<") iterations on "<<nOccupied<<" gray levels, centers=";
+    for (int c=0; c<NC; ++c)
+        msg<<" "<<centers[c];
+    this->logger(kipl::logging::Logger::LogVerbose,msg.str());
+
+    // Tables for all bins
+    m_Membership.resize(m_nBins*NC);
+    m_Label.resize(m_nBins);
+    const ptrdiff_t nBins=static_cast<ptrdiff_t>(m_nBins);
+    #pragma omp parallel for
+    for (ptrdiff_t b=0; b<nBins; ++b) {
+        float *pU=m_Membership.data()+b*NC;
+        computeMembership(m_BinValue[b],pU);
+
+        int label=0;
+        for (int c=1; c<NC; ++c)
+            if (pU[label]<pU[c])
+                label=c;
+
+        m_Label[b]=static_cast<SegType>(label);
+    }
+
+    seg.Resize(img.Dims());
+    ImgType const * const pImg=img.GetDataPtr();
+    SegType *pSeg=seg.GetDataPtr();
+    SegType const * const pLabel=m_Label.data();
+    const ptrdiff_t N=static_cast<ptrdiff_t>(img.Size());
+
+    #pragma omp parallel for
+    for (ptrdiff_t i=0; i<N; ++i)
+        pSeg[i]=pLabel[binIndex(pImg[i])];
+
+    return 0;
+}
+
+template<class ImgType, class SegType ,size_t NDim>
+void HistogramFuzzyCMeans<ImgType,SegType,NDim>::membership(const kipl::base::TImage<ImgType,NDim> & img, int c, kipl::base::TImage<float,NDim> &u) const
+{
+    if (m_Label.empty())
+        throw kipl::base::KiplException("HistogramFuzzyCMeans: the memberships are requested before the segmentation",__FILE__,__LINE__);
+
+    if ((c<0) || (this->nClasses<=c))
+        throw kipl::base::KiplException("HistogramFuzzyCMeans: the class index is out of range",__FILE__,__LINE__);
+
+    u.Resize(img.Dims());
+    ImgType const * const pImg=img.GetDataPtr();
+    float *pU=u.GetDataPtr();
+    float const * const pMembership=m_Membership.data()+c;
+    const size_t NC=static_cast<size_t>(this->nClasses);
+    const ptrdiff_t N=static_cast<ptrdiff_t>(img.Size());
+
+    #pragma omp parallel for
+    for (ptrdiff_t i=0; i<N; ++i)
+        pU[i]=pMembership[binIndex(pImg[i])*NC];
+}
+
+}}
+
+#endif
@@ -0,0 +1,131 @@
+//<LICENCE>
+
+#ifndef SEGMENTATIONHISTOGRAMFUZZYCMEANS_H
+#define SEGMENTATIONHISTOGRAMFUZZYCMEANS_H
+
+#include <cstddef>
+#include <vector>
+#include <map>
+#include <string>
+
+#include "../base/timage.h"
+#include "../logging/logger.h"
+
+#include "segmentationbase.h"
+
+namespace kipl { namespace segmentation {
+
+/// \brief Fuzzy C-means and kernel fuzzy C-means classification of the gray levels of an N-dimensional image.
+///
+/// The memberships of a voxel only depend on its gray level. The iterations are therefore done on a weighted histogram
+/// with a fine binning, i.e. the cost of an iteration doesn't depend on the image size and no membership image is
+/// stored. Integer images with less gray levels than bins get one bin per gray level and the result is the same as
+/// for a voxel wise iteration. Each bin is represented by the mean gray level of its voxels. The labels and memberships
+/// of the full image are finally found by a table lookup.
+///
+/// The classes are ordered by increasing center value.
+/// @author Anders Kaestner
+template<class ImgType, class SegType , size_t NDim>
+class HistogramFuzzyCMeans : public SegmentationBase<ImgType,SegType,NDim>
+{
+public:
+    HistogramFuzzyCMeans();
+
+    ~HistogramFuzzyCMeans();
+
+    /// \brief Setting processing parameters
+    ///	\param NClasses Number of classes to find
+    ///	\param fuz Fuzziness parameter, must be greater than one
+    ///	\param maxIt Maximal number of iterations to find the solution
+    /// \param sigma Width of the Gaussian kernel exp(-(x-v)^2/sigma^2), the Euclidean distance is used when sigma is zero
+    int set(int NClasses, float fuz=1.5f, int maxIt=250, float sigma=0.0f);
+
+    /// \brief Sets the number of histogram bins, the default is 65536
+    /// \param nBins Number of bins
+    void setBins(size_t nBins);
+
+    /// \brief Set an initial guess of the center values
+    ///	\param cVec A vector containing nClasses guesses, otherwise the guess is taken from quantiles of the histogram
+    int setCenters(float const * const cVec);
+
+    /// Removes the initial center guess
+    int clearCenters() { haveCenters=false; return 0; }
+
+    /// \returns The centers found by the last segmentation
+    float const * getCenters() const { return centers.data(); }
+
+    /// \returns The number of iterations used by the last segmentation
+    int iterations() const { return m_nIterations; }
+
+    /// \brief Segments an image
+    ///	\param img Image to be segmented
+    ///	\param seg Segmented image, the label is the class with the greatest membership
+    int operator()(const kipl::base::TImage<ImgType,NDim> & img, kipl::base::TImage<SegType,NDim> &seg);
+
+    /// \brief Segments an image
+    ///	\param img Image to be segmented
+    ///	\param seg Segmented image
+    virtual int operator()(kipl::base::TImage<ImgType,NDim> & img, kipl::base::TImage<SegType,NDim> &seg);
+
+    /// \brief Computes the membership image of one class using the classification of the last segmentation
+    /// \param img Image to look up, normally the segmented image
+    /// \param c Index of the class
+    /// \param u Membership image
+    void membership(const kipl::base::TImage<ImgType,NDim> & img, int c, kipl::base::TImage<float,NDim> &u) const;
+
+    /// \brief Set the parameters for the segmentation
+    /// \param parameters Uses the keys nclasses, fuzziness, maxiterations, and sigma if they exist
+    virtual void setParameters(std::map<std::string,std::string> parameters);
+
+protected:
+    /// \brief Builds the histogram and the compact list of the occupied bins
+    /// \param img The image to classify
+    void buildHistogram(const kipl::base::TImage<ImgType,NDim> &img);
+
+    /// \brief Guesses the initial centers from quantiles of the histogram
+    void initCenters();
+
+    /// \brief Computes the memberships of a gray level for the current centers
+    /// \param x The gray level
+    /// \param u Receives nClasses memberships
+    void computeMembership(double x, float *u) const;
+
+    /// \brief Finds the bin of a gray level
+    size_t binIndex(ImgType x) const;
+
+    /// Limits the iteration process
+    int maxIterations;
+    /// indicates that a initial guess has been provided
+    bool haveCenters;
+    /// The class centers
+    std::vector<float> centers;
+    /// Fuzziness coefficient
+    float fuzziness;
+    /// Width of the Gaussian kernel, zero selects the Euclidean distance
+    float m_fSigma;
+    /// Number of histogram bins
+    size_t m_nBins;
+    /// Number of iterations used by the last segmentation
+    int m_nIterations;
+
+    /// Lower bound of the first bin
+    double m_fBinStart;
+    /// Number of bins per gray level unit
+    double m_fBinScale;
+    /// Mean gray level of each bin, the bin center for empty bins
+    std::vector<double> m_BinValue;
+    /// Number of voxels in each bin
+    std::vector<size_t> m_BinCount;
+    /// Indices of the occupied bins
+    std::vector<size_t> m_Occupied;
+    /// Membership table, the memberships of bin b start at b*nClasses
+    std::vector<float> m_Membership;
+    /// Label table
+    std::vector<SegType> m_Label;
+};
+
+}}
+
+#include "core/histogramfuzzycmeans.hpp"
+
+#endif
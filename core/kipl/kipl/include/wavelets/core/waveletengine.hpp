@@ -0,0 +1,621 @@
+//<LICENCE>
+
+#ifndef WAVELETENGINE_HPP_
+#define WAVELETENGINE_HPP_
+
+#include <cmath>
+#include <algorithm>
+#include <vector>
+
+#include "../../base/KiplException.h"
+
+namespace kipl { namespace wavelets {
+
+template <typename T>
+WaveletEngine<T>::WaveletEngine(const WaveletKernel<T> &kernel, kipl::base::ePadType pad) :
+    m_nBegin(kernel.begin()),
+    m_nSize(kernel.size()),
+    m_ePad(pad),
+    m_eLifting(NoLifting),
+    m_tH(kernel.transH()+kernel.begin(),kernel.transH()+kernel.end()+1),
+    m_tG(kernel.transG()+kernel.begin(),kernel.transG()+kernel.end()+1),
+    m_sH(kernel.synthH()+kernel.begin(),kernel.synthH()+kernel.end()+1),
+    m_sG(kernel.synthG()+kernel.begin(),kernel.synthG()+kernel.end()+1)
+{
+    std::fill_n(m_fLift,6,T(0));
+
+    // The lifting steps are derived for the sign convention of kernels starting at index 0
+    if (m_nBegin!=0)
+        return;
+
+    if ((m_nSize==2) && (m_sH[0]==m_sH[1])) {
+        // d=e-o, s=o+d/2, the low pass is the scaled mean and the high pass the scaled difference
+        m_fLift[0] = m_sH[0]+m_sH[1];
+        m_fLift[1] = m_sH[1];
+        m_eLifting = LiftingHaar;
+    }
+
+    if (m_nSize==4) {
+        // Factorization of the polyphase matrix of the even samples e and the odd samples o:
+        // o1[k]=o[k]+a*e[k], e2[k]=e[k]+b0*o1[k]+b1*o1[k-1], lo[k]=c*e2[k], hi[k]=g0*e2[k]+g1*o1[k-1]
+        const double h0=m_sH[0], h1=m_sH[1], h2=m_sH[2], h3=m_sH[3];
+        const double a  = h0/h1;
+        const double c  = h2-a*h3;
+        const double b0 = h3/c;
+        const double b1 = h1/c;
+        const double g0 = h1+a*h0;
+        const double r  = h3+a*h2;       // vanishes for orthogonal kernels
+        const double g1 = -h2-b0*r-b1*g0;
+        const double tolerance=1e-5;
+
+        if ((std::fabs(r)<tolerance) && (std::fabs(h0+b0*g0)<tolerance) && (std::fabs(b1*r)<tolerance)) {
+            m_fLift[0] = static_cast<T>(a);
+            m_fLift[1] = static_cast<T>(b0);
+            m_fLift[2] = static_cast<T>(b1);
+            m_fLift[3] = static_cast<T>(c);
+            m_fLift[4] = static_cast<T>(g0);
+            m_fLift[5] = static_cast<T>(g1);
+            m_eLifting = LiftingD4;
+        }
+    }
+}
+
+template <typename T>
+size_t WaveletEngine<T>::TransformSize(size_t n) const
+{
+    return (n+m_nSize-1+(n & 1))/2;
+}
+
+template <typename T>
+void WaveletEngine<T>::Analysis(const kipl::base::TImage<T,2> &img, WaveletQuad<T> &q)
+{
+    const size_t nx=img.Size(0);
+    const size_t ny=img.Size(1);
+
+    checkSize(nx);
+    checkSize(ny);
+
+    const size_t dims[2]={TransformSize(nx),TransformSize(ny)};
+    q.a=kipl::base::TImage<T,2>(dims);
+    q.h=kipl::base::TImage<T,2>(dims);
+    q.v=kipl::base::TImage<T,2>(dims);
+    q.d=kipl::base::TImage<T,2>(dims);
+
+    // Both bands of the rows in one pass
+    const size_t tdims[2]={dims[0],ny};
+    kipl::base::TImage<T,2> lo(tdims);
+    kipl::base::TImage<T,2> hi(tdims);
+    analyseRows(img.GetDataPtr(),nx,ny,lo.GetDataPtr(),hi.GetDataPtr());
+
+    // All four subbands from the columns of the row bands
+    PaddedLines pLo, pHi;
+    padLines(lo.GetDataPtr(),dims[0],ny,dims[0],false,pLo);
+    padLines(hi.GetDataPtr(),dims[0],ny,dims[0],false,pHi);
+
+    std::vector<AnalysisJob> jobs;
+    AnalysisJob jobLo={pLo.center(m_nSize), q.a.GetDataPtr(), q.h.GetDataPtr(), dims[0]};
+    AnalysisJob jobHi={pHi.center(m_nSize), q.v.GetDataPtr(), q.d.GetDataPtr(), dims[0]};
+    jobs.push_back(jobLo);
+    jobs.push_back(jobHi);
+
+    analyseColumns(jobs,dims[1],dims[0]);
+}
+
+template <typename T>
+void WaveletEngine<T>::Synthesis(const WaveletQuad<T> &q, kipl::base::TImage<T,2> &img)
+{
+    const size_t w0=q.a.Size(0);
+    const size_t w1=q.a.Size(1);
+    const size_t dx=img.Size(0);
+    const size_t dy=img.Size(1);
+
+    if ((q.h.Size()!=q.a.Size()) || (q.v.Size()!=q.a.Size()) || (q.d.Size()!=q.a.Size()))
+        throw kipl::base::KiplException("The wavelet subbands have different sizes",__FILE__,__LINE__);
+
+    if ((2*w0<dx) || (2*w1<dy))
+        throw kipl::base::KiplException("The synthesized image is larger than twice the subbands",__FILE__,__LINE__);
+
+    checkSize(2*w0);
+    checkSize(2*w1);
+
+    // The columns are combined first, the intermediate images have the width of the subbands
+    const size_t sdims[2]={w0,dy};
+    kipl::base::TImage<T,2> s0(sdims);
+    kipl::base::TImage<T,2> s1(sdims);
+
+    PaddedLines pa, ph, pv, pd;
+    padLines(q.a.GetDataPtr(),w0,w1,w0,true,pa);
+    padLines(q.h.GetDataPtr(),w0,w1,w0,true,ph);
+    padLines(q.v.GetDataPtr(),w0,w1,w0,true,pv);
+    padLines(q.d.GetDataPtr(),w0,w1,w0,true,pd);
+
+    std::vector<SynthesisJob> jobs;
+    SynthesisJob jobLo={pa.center(m_nSize), ph.center(m_nSize), s0.GetDataPtr(), w0};
+    SynthesisJob jobHi={pv.center(m_nSize), pd.center(m_nSize), s1.GetDataPtr(), w0};
+    jobs.push_back(jobLo);
+    jobs.push_back(jobHi);
+
+    synthesizeColumns(jobs,dy,w0);
+
+    synthesizeRows(s0.GetDataPtr(),s1.GetDataPtr(),w0,dy,img.GetDataPtr(),dx);
+}
+
+template <typename T>
+void WaveletEngine<T>::Analysis(const kipl::base::TImage<T,3> &img, kipl::base::TImage<T,3> *bands)
+{
+    const size_t nx=img.Size(0);
+    const size_t ny=img.Size(1);
+    const size_t nz=img.Size(2);
+
+    checkSize(nx);
+    checkSize(ny);
+    checkSize(nz);
+
+    const size_t dims[3]={TransformSize(nx),TransformSize(ny),TransformSize(nz)};
+    const size_t plane=dims[0]*dims[1];
+
+    // x: two bands
+    const size_t xdims[3]={dims[0],ny,nz};
+    kipl::base::TImage<T,3> lo(xdims);
+    kipl::base::TImage<T,3> hi(xdims);
+    analyseRows(img.GetDataPtr(),nx,ny*nz,lo.GetDataPtr(),hi.GetDataPtr());
+
+    // y: four bands, the lines of each slice are filtered separately
+    const size_t ydims[3]={dims[0],dims[1],nz};
+    kipl::base::TImage<T,3> xy[4];
+    for (int i=0; i<4; ++i)
+        xy[i]=kipl::base::TImage<T,3>(ydims);
+
+    std::vector<PaddedLines> pxy(2*nz);
+    std::vector<AnalysisJob> jobs;
+    for (size_t z=0; z<nz; ++z) {
+        padLines(lo.GetLinePtr(0,z),dims[0],ny,dims[0],false,pxy[2*z]);
+        padLines(hi.GetLinePtr(0,z),dims[0],ny,dims[0],false,pxy[2*z+1]);
+
+        AnalysisJob jobLo={pxy[2*z].center(m_nSize),   xy[0].GetLinePtr(0,z), xy[2].GetLinePtr(0,z), dims[0]};
+        AnalysisJob jobHi={pxy[2*z+1].center(m_nSize), xy[1].GetLinePtr(0,z), xy[3].GetLinePtr(0,z), dims[0]};
+        jobs.push_back(jobLo);
+        jobs.push_back(jobHi);
+    }
+
+    analyseColumns(jobs,dims[1],dims[0]);
+    pxy.clear();
+    lo=kipl::base::TImage<T,3>();
+    hi=kipl::base::TImage<T,3>();
+
+    // z: eight bands, the slices are filtered as lines of plane size
+    for (int i=0; i<8; ++i)
+        bands[i]=kipl::base::TImage<T,3>(dims);
+
+    PaddedLines pz[4];
+    jobs.clear();
+    for (int i=0; i<4; ++i) {
+        padLines(xy[i].GetDataPtr(),plane,nz,plane,false,pz[i]);
+
+        AnalysisJob job={pz[i].center(m_nSize), bands[i].GetDataPtr(), bands[i+4].GetDataPtr(), plane};
+        jobs.push_back(job);
+    }
+
+    analyseColumns(jobs,dims[2],plane);
+}
+
+template <typename T>
+void WaveletEngine<T>::Synthesis(kipl::base::TImage<T,3> const *bands, kipl::base::TImage<T,3> &img)
+{
+    const size_t w0=bands[0].Size(0);
+    const size_t w1=bands[0].Size(1);
+    const size_t w2=bands[0].Size(2);
+    const size_t dx=img.Size(0);
+    const size_t dy=img.Size(1);
+    const size_t dz=img.Size(2);
+    const size_t plane=w0*w1;
+
+    for (int i=1; i<8; ++i) {
+        if (bands[i].Size()!=bands[0].Size())
+            throw kipl::base::KiplException("The wavelet subbands have different sizes",__FILE__,__LINE__);
+    }
+
+    if ((2*w0<dx) || (2*w1<dy) || (2*w2<dz))
+        throw kipl::base::KiplException("The synthesized volume is larger than twice the subbands",__FILE__,__LINE__);
+
+    checkSize(2*w0);
+    checkSize(2*w1);
+    checkSize(2*w2);
+
+    // z: four intermediate bands with the size of the subbands in the slices
+    const size_t zdims[3]={w0,w1,dz};
+    kipl::base::TImage<T,3> sz[4];
+    PaddedLines pz[8];
+    std::vector<SynthesisJob> jobs;
+
+    for (int i=0; i<4; ++i) {
+        sz[i]=kipl::base::TImage<T,3>(zdims);
+        padLines(bands[i].GetDataPtr(),plane,w2,plane,true,pz[i]);
+        padLines(bands[i+4].GetDataPtr(),plane,w2,plane,true,pz[i+4]);
+
+        SynthesisJob job={pz[i].center(m_nSize), pz[i+4].center(m_nSize), sz[i].GetDataPtr(), plane};
+        jobs.push_back(job);
+    }
+
+    synthesizeColumns(jobs,dz,plane);
+
+    // y: two intermediate bands
+    const size_t ydims[3]={w0,dy,dz};
+    kipl::base::TImage<T,3> sy[2];
+    std::vector<PaddedLines> py(4*dz);
+    jobs.clear();
+
+    for (int i=0; i<2; ++i) {
+        sy[i]=kipl::base::TImage<T,3>(ydims);
+        for (size_t z=0; z<dz; ++z) {
+            PaddedLines &pLo=py[4*z+2*i];
+            PaddedLines &pHi=py[4*z+2*i+1];
+            padLines(sz[i].GetLinePtr(0,z),w0,w1,w0,true,pLo);
+            padLines(sz[i+2].GetLinePtr(0,z),w0,w1,w0,true,pHi);
+
+            SynthesisJob job={pLo.center(m_nSize), pHi.center(m_nSize), sy[i].GetLinePtr(0,z), w0};
+            jobs.push_back(job);
+        }
+    }
+
+    synthesizeColumns(jobs,dy,w0);
+
+    // x: the lines of the volume
+    synthesizeRows(sy[0].GetDataPtr(),sy[1].GetDataPtr(),w0,dy*dz,img.GetDataPtr(),dx);
+}
+
+template <typename T>
+void WaveletEngine<T>::checkSize(size_t n) const
+{
+    if (n<static_cast<size_t>(m_nSize))
+        throw kipl::base::KiplException("Image smaller than wavelet kernel size",__FILE__,__LINE__);
+
+    if ((m_ePad==kipl::base::PadSP1) && (n<4))
+        throw kipl::base::KiplException("The SP1 padding needs at least four pixels",__FILE__,__LINE__);
+}
+
+template <typename T>
+void WaveletEngine<T>::padIndex(size_t n, bool upsampled, std::vector<ptrdiff_t> &idx) const
+{
+    // Same padding as WaveletTransform::pad_*, -1 marks a zero or an extrapolated (SP1) position
+    const ptrdiff_t L=m_nSize;
+    const ptrdiff_t N=static_cast<ptrdiff_t>(upsampled ? 2*n : n);
+
+    idx.assign(N+2*L,-1);
+    for (ptrdiff_t p=0; p<N; ++p)
+        idx[p+L]=p;
+
+    switch (m_ePad) {
+    case kipl::base::PadPeriodic :
+        for (ptrdiff_t i=0; i<L; ++i) {
+            idx[i]=N-L+i;
+            idx[N+L-1+i]=i;
+        }
+        break;
+    case kipl::base::PadZero :
+    case kipl::base::PadSP1 :
+        break;
+    case kipl::base::PadSP0 :
+        for (ptrdiff_t i=0; i<L; ++i) {
+            idx[i]=0;
+            idx[N+L+i]=N-1;
+        }
+        break;
+    case kipl::base::PadMirror :
+    default :
+        for (ptrdiff_t i=0; i<L; ++i) {
+            idx[i]=L-i-1;
+            idx[N+L+i]=N-1-i;
+        }
+        break;
+    }
+
+    // The upsampled signal has zeros at the odd positions
+    if (upsampled) {
+        for (auto &i : idx)
+            i = ((i<0) || (i & 1)) ? -1 : i/2;
+    }
+}
+
+template <typename T>
+void WaveletEngine<T>::padLine(const T *src, bool upsampled, const std::vector<ptrdiff_t> &idx, T *buffer) const
+{
+    const ptrdiff_t L=m_nSize;
+    const ptrdiff_t N=static_cast<ptrdiff_t>(idx.size())-2*L;
+
+    for (size_t i=0; i<idx.size(); ++i)
+        buffer[i] = idx[i]<0 ? T(0) : src[idx[i]];
+
+    if (m_ePad==kipl::base::PadSP1) {
+        auto value=[=](ptrdiff_t j) { return upsampled ? ((j & 1) ? T(0) : src[j/2]) : src[j]; };
+
+        const double k0=std::min((value(1)-value(0))/2.0,(value(3)-value(2))/2.0);
+        const double k1=std::min((value(N-1)-value(N-2))/2.0,(value(N-3)-value(N-4))/2.0);
+
+        for (ptrdiff_t i=0; i<L; ++i) {
+            buffer[i]     = value(0)+static_cast<T>(k0*(i-1-L));
+            buffer[L+N+i] = value(N-1)+static_cast<T>(k1*(i+1));
+        }
+    }
+}
+
+template <typename T>
+void WaveletEngine<T>::padLines(const T *first, size_t stride, size_t n, size_t width, bool upsampled, PaddedLines &padded) const
+{
+    const ptrdiff_t L=m_nSize;
+
+    std::vector<ptrdiff_t> idx;
+    padIndex(n,upsampled,idx);
+    const ptrdiff_t N=static_cast<ptrdiff_t>(idx.size())-2*L;
+
+    padded.lines.assign(idx.size(),nullptr);
+    padded.rows.clear();
+
+    if (m_ePad==kipl::base::PadSP1) {
+        // The extrapolated lines are stored, L lines before and L lines after the signal
+        padded.rows.resize(2*L*width);
+
+        for (size_t x=0; x<width; ++x) {
+            auto value=[=](ptrdiff_t j) { return upsampled ? ((j & 1) ? T(0) : first[(j/2)*stride+x]) : first[j*stride+x]; };
+
+            const double k0=std::min((value(1)-value(0))/2.0,(value(3)-value(2))/2.0);
+            const double k1=std::min((value(N-1)-value(N-2))/2.0,(value(N-3)-value(N-4))/2.0);
+
+            for (ptrdiff_t i=0; i<L; ++i) {
+                padded.rows[i*width+x]     = value(0)+static_cast<T>(k0*(i-1-L));
+                padded.rows[(L+i)*width+x] = value(N-1)+static_cast<T>(k1*(i+1));
+            }
+        }
+
+        for (ptrdiff_t i=0; i<L; ++i) {
+            padded.lines[i]     = padded.rows.data()+i*width;
+            padded.lines[L+N+i] = padded.rows.data()+(L+i)*width;
+        }
+    }
+    else if (!upsampled) {
+        // The analysis reads zero lines from a buffer, the synthesis skips them
+        padded.rows.assign(width,T(0));
+    }
+
+    for (size_t i=0; i<idx.size(); ++i) {
+        if (0<=idx[i])
+            padded.lines[i]=first+idx[i]*stride;
+        else if ((padded.lines[i]==nullptr) && !upsampled)
+            padded.lines[i]=padded.rows.data();
+    }
+}
+
+template <typename T>
+void WaveletEngine<T>::analyseRows(const T *src, size_t n, size_t nLines, T *lo, T *hi) const
+{
+    const size_t m=TransformSize(n);
+    const ptrdiff_t N=static_cast<ptrdiff_t>(nLines);
+
+    std::vector<ptrdiff_t> idx;
+    padIndex(n,false,idx);
+
+    #pragma omp parallel
+    {
+        std::vector<T> buffer(idx.size());
+
+        #pragma omp for schedule(static)
+        for (ptrdiff_t i=0; i<N; ++i) {
+            padLine(src+i*n,false,idx,buffer.data());
+            analyseLine(buffer.data()+m_nSize,m,lo+i*m,hi+i*m);
+        }
+    }
+}
+
+template <typename T>
+void WaveletEngine<T>::analyseLine(const T *pp, size_t m, T *lo, T *hi) const
+{
+    // Output k is the sum of H[j]*pp[2k-j+1], same as WaveletTransform::transform
+    const ptrdiff_t M=static_cast<ptrdiff_t>(m);
+
+    switch (m_eLifting) {
+    case LiftingHaar : {
+        const T half=static_cast<T>(0.5);
+        for (ptrdiff_t k=0; k<M; ++k) {
+            const T d=pp[2*k]-pp[2*k+1];
+            const T s=pp[2*k+1]+half*d;
+            lo[k]=m_fLift[0]*s;
+            hi[k]=m_fLift[1]*d;
+        }
+        break;
+    }
+    case LiftingD4 : {
+        const T a=m_fLift[0], b0=m_fLift[1], b1=m_fLift[2], c=m_fLift[3], g0=m_fLift[4], g1=m_fLift[5];
+        T o1p=pp[-1]+a*pp[-2];
+        for (ptrdiff_t k=0; k<M; ++k) {
+            const T e  = pp[2*k];
+            const T o1 = pp[2*k+1]+a*e;
+            const T e2 = e+b0*o1+b1*o1p;
+            lo[k]=c*e2;
+            hi[k]=g0*e2+g1*o1p;
+            o1p=o1;
+        }
+        break;
+    }
+    default : {
+        const T *pH=m_tH.data();
+        const T *pG=m_tG.data();
+        for (ptrdiff_t k=0; k<M; ++k) {
+            const T *p=pp+2*k+1-m_nBegin;
+            T sl=0;
+            T sh=0;
+            for (int j=0; j<m_nSize; ++j) {
+                sl+=pH[j]*p[-j];
+                sh+=pG[j]*p[-j];
+            }
+            lo[k]=sl;
+            hi[k]=sh;
+        }
+    }
+    }
+}
+
+template <typename T>
+void WaveletEngine<T>::analyseColumns(const std::vector<AnalysisJob> &jobs, size_t m, size_t width) const
+{
+    const size_t nBlocks=(width+BlockWidth-1)/BlockWidth;
+    const size_t nJobTasks=m*nBlocks;
+    const ptrdiff_t nTasks=static_cast<ptrdiff_t>(jobs.size()*nJobTasks);
+
+    #pragma omp parallel for schedule(static)
+    for (ptrdiff_t t=0; t<nTasks; ++t) {
+        const AnalysisJob &job=jobs[t/nJobTasks];
+        const size_t k  = (t%nJobTasks)/nBlocks;
+        const size_t x0 = ((t%nJobTasks)%nBlocks)*BlockWidth;
+        const size_t x1 = std::min(x0+static_cast<size_t>(BlockWidth),width);
+
+        analyseBlock(job.src,k,x0,x1,job.lo+k*job.stride,job.hi+k*job.stride);
+    }
+}
+
+template <typename T>
+void WaveletEngine<T>::analyseBlock(const T * const *pp, size_t k, size_t x0, size_t x1, T *lo, T *hi) const
+{
+    const ptrdiff_t k2=2*static_cast<ptrdiff_t>(k);
+
+    switch (m_eLifting) {
+    case LiftingHaar : {
+        const T half=static_cast<T>(0.5);
+        const T *e=pp[k2];
+        const T *o=pp[k2+1];
+        #pragma omp simd
+        for (size_t x=x0; x<x1; ++x) {
+            const T d=e[x]-o[x];
+            const T s=o[x]+half*d;
+            lo[x]=m_fLift[0]*s;
+            hi[x]=m_fLift[1]*d;
+        }
+        break;
+    }
+    case LiftingD4 : {
+        const T a=m_fLift[0], b0=m_fLift[1], b1=m_fLift[2], c=m_fLift[3], g0=m_fLift[4], g1=m_fLift[5];
+        const T *ep=pp[k2-2];
+        const T *op=pp[k2-1];
+        const T *e=pp[k2];
+        const T *o=pp[k2+1];
+        #pragma omp simd
+        for (size_t x=x0; x<x1; ++x) {
+            const T o1p = op[x]+a*ep[x];
+            const T o1  = o[x]+a*e[x];
+            const T e2  = e[x]+b0*o1+b1*o1p;
+            lo[x]=c*e2;
+            hi[x]=g0*e2+g1*o1p;
+        }
+        break;
+    }
+    default :
+        std::fill(lo+x0,lo+x1,T(0));
+        std::fill(hi+x0,hi+x1,T(0));
+        for (int j=0; j<m_nSize; ++j) {
+            const T *line=pp[k2+1-m_nBegin-j];
+            const T h=m_tH[j];
+            const T g=m_tG[j];
+            #pragma omp simd
+            for (size_t x=x0; x<x1; ++x) {
+                lo[x]+=h*line[x];
+                hi[x]+=g*line[x];
+            }
+        }
+    }
+}
+
+template <typename T>
+void WaveletEngine<T>::synthesizeRows(const T *lo, const T *hi, size_t w, size_t nLines, T *dst, size_t nOut) const
+{
+    const ptrdiff_t N=static_cast<ptrdiff_t>(nLines);
+
+    std::vector<ptrdiff_t> idx;
+    padIndex(w,true,idx);
+
+    #pragma omp parallel
+    {
+        std::vector<T> bufLo(idx.size());
+        std::vector<T> bufHi(idx.size());
+
+        #pragma omp for schedule(static)
+        for (ptrdiff_t i=0; i<N; ++i) {
+            padLine(lo+i*w,true,idx,bufLo.data());
+            padLine(hi+i*w,true,idx,bufHi.data());
+            synthesizeLine(bufLo.data()+m_nSize,bufHi.data()+m_nSize,2*w,nOut,dst+i*nOut);
+        }
+    }
+}
+
+template <typename T>
+void WaveletEngine<T>::synthesizeLine(const T *ppLo, const T *ppHi, size_t n, size_t nOut, T *dst) const
+{
+    // Output k is the sum of H[m]*pp[k+L-2-m] on the upsampled signal, same as WaveletTransform::upsconv
+    const ptrdiff_t N=static_cast<ptrdiff_t>(n);
+    const ptrdiff_t c=m_nSize-2;
+    const ptrdiff_t e=m_nBegin+m_nSize-1;
+    const T *pH=m_sH.data()-m_nBegin;
+    const T *pG=m_sG.data()-m_nBegin;
+
+    for (ptrdiff_t k=0; k<static_cast<ptrdiff_t>(nOut); ++k) {
+        const ptrdiff_t p0=k+c;
+        ptrdiff_t m0=m_nBegin;
+        ptrdiff_t step=1;
+
+        // Inside the signal only the even positions are non-zero
+        if ((e<=p0) && (p0-m_nBegin<N)) {
+            m0=m_nBegin+((p0-m_nBegin) & 1);
+            step=2;
+        }
+
+        T sum=0;
+        for (ptrdiff_t m=m0; m<=e; m+=step)
+            sum+=pH[m]*ppLo[p0-m]+pG[m]*ppHi[p0-m];
+
+        dst[k]=sum;
+    }
+}
+
+template <typename T>
+void WaveletEngine<T>::synthesizeColumns(const std::vector<SynthesisJob> &jobs, size_t nOut, size_t width) const
+{
+    const size_t nBlocks=(width+BlockWidth-1)/BlockWidth;
+    const size_t nJobTasks=nOut*nBlocks;
+    const ptrdiff_t nTasks=static_cast<ptrdiff_t>(jobs.size()*nJobTasks);
+
+    #pragma omp parallel for schedule(static)
+    for (ptrdiff_t t=0; t<nTasks; ++t) {
+        const SynthesisJob &job=jobs[t/nJobTasks];
+        const size_t k  = (t%nJobTasks)/nBlocks;
+        const size_t x0 = ((t%nJobTasks)%nBlocks)*BlockWidth;
+        const size_t x1 = std::min(x0+static_cast<size_t>(BlockWidth),width);
+
+        synthesizeBlock(job.lo,job.hi,k,x0,x1,job.dst+k*job.stride);
+    }
+}
+
+template <typename T>
+void WaveletEngine<T>::synthesizeBlock(const T * const *ppLo, const T * const *ppHi, size_t k, size_t x0, size_t x1, T *dst) const
+{
+    const ptrdiff_t p0=static_cast<ptrdiff_t>(k)+m_nSize-2;
+
+    std::fill(dst+x0,dst+x1,T(0));
+
+    for (int i=0; i<m_nSize; ++i) {
+        const ptrdiff_t p=p0-m_nBegin-i;
+        const T *lo=ppLo[p];
+        const T *hi=ppHi[p];
+
+        // Both bands have the same zero lines of the upsampling
+        if (lo==nullptr)
+            continue;
+
+        const T h=m_sH[i];
+        const T g=m_sG[i];
+        #pragma omp simd
+        for (size_t x=x0; x<x1; ++x)
+            dst[x]+=h*lo[x]+g*hi[x];
+    }
+}
+
+}}
+
+#endif /* WAVELETENGINE_HPP_ */
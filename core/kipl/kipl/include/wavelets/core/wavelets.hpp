@@ -476,13 +476,10 @@ WaveletQuad<T> WaveletTransform<T>::transform(WaveletQuad<T> &q)
     if ((q.a.Size(0)<static_cast<size_t>(kernel.size()) || (q.a.Size(1)<static_cast<size_t>(kernel.size()))))
 		throw kipl::base::KiplException("Image smaller than wavelet kernel size",__FILE__,__LINE__);
 
-	size_t dims[2]={(q.a.Size(0)+kernel.size()-1+(q.a.Size(0) & 1))/2, (q.a.Size(1)+kernel.size()-1+(q.a.Size(1) & 1))/2};
-	WaveletQuad<T> result(dims);
-
-	transform(q.a, result.a, kernel.transH(), kernel.transH(), kernel.begin(), kernel.end());
-	transform(q.a, result.h, kernel.transH(), kernel.transG(), kernel.begin(), kernel.end());
-	transform(q.a, result.v, kernel.transG(), kernel.transH(), kernel.begin(), kernel.end());
-	transform(q.a, result.d, kernel.transG(), kernel.transG(), kernel.begin(), kernel.end());
+	// All four subbands are computed in one pass
+	WaveletQuad<T> result;
+	WaveletEngine<T> engine(kernel,padtype);
+	engine.Analysis(q.a,result);
 
 	return result;
 }
@@ -617,13 +614,9 @@ kipl::base::TImage<T,2> WaveletTransform<T>::synthesize()
 		previous=current;
 	}
 
-	size_t dims[]={data.begin()->a.Size(0)*2, data.begin()->a.Size(1)*2};
-	kipl::base::TImage<T,2> img(dims);
-	synthesize(*previous,img);
+	// Only the pixels of the original image are synthesized
 	kipl::base::TImage<T,2> result(n_dims);
-
-    for (size_t y=0; y<n_dims[1]; y++)
-		memcpy(result.GetLinePtr(y),img.GetLinePtr(y),sizeof(T)*n_dims[0]);
+	synthesize(*previous,result);
 
 	return result;
 }
@@ -631,17 +624,8 @@ kipl::base::TImage<T,2> WaveletTransform<T>::synthesize()
 template <typename T>
 void WaveletTransform<T>::synthesize(WaveletQuad<T> &src, kipl::base::TImage<T,2> &dst)
 {
-	kipl::base::TImage<T> img(dst.Dims());
-	dst=static_cast<T>(0);
-
-	upsconv(src.a,dst,kernel.synthH(),kernel.synthH());
-
-	upsconv(src.h,img,kernel.synthH(),kernel.synthG());
-	dst+=img;
-	upsconv(src.v,img,kernel.synthG(),kernel.synthH());
-	dst+=img;
-	upsconv(src.d,img,kernel.synthG(),kernel.synthG());
-	dst+=img;
+	WaveletEngine<T> engine(kernel,padtype);
+	engine.Synthesis(src,dst);
 }
 
 // Padding methods of the lines to be filtered
@@ -5,6 +5,7 @@
 
 #include <iostream>
 #include <list>
+#include <vector>
 
 #include "../base/timage.h"
 #include "../logging/logger.h"
@@ -60,6 +61,113 @@ template <typename T>
 		kipl::base::TImage<T,2> d;
 	};
 
+	/// \brief Computes one level of the wavelet transform and its synthesis for 2D and 3D images.
+	///
+	/// The padding and the size of the coefficient images are the same as for WaveletTransform. All subbands are
+	/// computed in one pass, each line is split into its low and high pass band at once. The vertical directions are
+	/// filtered in blocks of columns directly on the lines of the image, i.e. without copying the columns. The kernels
+	/// with two and four taps (daub1 and daub2) are computed with the lifting scheme. Lines and blocks are processed in parallel.
+	///
+	/// The synthesis of the analysis reconstructs the image exactly with zero padding. With the other paddings the
+	/// reconstruction is exact at least one kernel length away from the edges.
+	///
+	/// The 3D subbands are indexed by the filter used along each axis, bit 0 is set for the high pass along x,
+	/// bit 1 for the high pass along y, and bit 2 for the high pass along z. In 2D, a=0, v=1, h=2, and d=3.
+	template <typename T>
+	class WaveletEngine
+	{
+	public:
+		/// \brief Prepares the filters
+		/// \param kernel The wavelet kernel
+		/// \param pad The padding used at the image edges
+		WaveletEngine(const WaveletKernel<T> &kernel, kipl::base::ePadType pad=kipl::base::PadMirror);
+
+		/// \param n Length of the signal
+		/// \returns The number of coefficients in each band
+		size_t TransformSize(size_t n) const;
+
+		/// \returns true if the analysis is computed by lifting steps
+		bool Lifting() const {return m_eLifting!=NoLifting;}
+
+		/// \brief Computes the four subbands of an image
+		/// \param img The image to transform
+		/// \param q Receives newly allocated subbands
+		void Analysis(const kipl::base::TImage<T,2> &img, WaveletQuad<T> &q);
+
+		/// \brief Reconstructs an image from its subbands
+		/// \param q The subbands
+		/// \param img Receives the image, it must be allocated with at most twice the size of the subbands
+		void Synthesis(const WaveletQuad<T> &q, kipl::base::TImage<T,2> &img);
+
+		/// \brief Computes the eight subbands of a volume
+		/// \param img The volume to transform
+		/// \param bands Array of eight images that receives newly allocated subbands
+		void Analysis(const kipl::base::TImage<T,3> &img, kipl::base::TImage<T,3> *bands);
+
+		/// \brief Reconstructs a volume from its subbands
+		/// \param bands Array of eight subbands
+		/// \param img Receives the volume, it must be allocated with at most twice the size of the subbands
+		void Synthesis(kipl::base::TImage<T,3> const *bands, kipl::base::TImage<T,3> &img);
+
+	protected:
+		enum eLifting {
+			NoLifting,
+			LiftingHaar,
+			LiftingD4
+		};
+
+		/// Width of the column blocks of the vertical passes
+		enum {BlockWidth=256};
+
+		/// Padded set of lines, the entry of position p is found at index p+m_nSize
+		struct PaddedLines {
+			std::vector<const T *> lines;
+			std::vector<T> rows;     ///< Storage for lines that don't exist in the image
+			const T * const * center(size_t L) const {return lines.data()+L;}
+		};
+
+		/// One output band pair of a vertical analysis pass, line k of the output is found at k*stride
+		struct AnalysisJob {
+			const T * const *src;
+			T *lo;
+			T *hi;
+			size_t stride;
+		};
+
+		/// One output of a vertical synthesis pass, line k of the output is found at k*stride
+		struct SynthesisJob {
+			const T * const *lo;
+			const T * const *hi;
+			T *dst;
+			size_t stride;
+		};
+
+		void checkSize(size_t n) const;
+		void padIndex(size_t n, bool upsampled, std::vector<ptrdiff_t> &idx) const;
+		void padLine(const T *src, bool upsampled, const std::vector<ptrdiff_t> &idx, T *buffer) const;
+		void padLines(const T *first, size_t stride, size_t n, size_t width, bool upsampled, PaddedLines &padded) const;
+
+		void analyseRows(const T *src, size_t n, size_t nLines, T *lo, T *hi) const;
+		void analyseLine(const T *pp, size_t m, T *lo, T *hi) const;
+		void analyseColumns(const std::vector<AnalysisJob> &jobs, size_t m, size_t width) const;
+		void analyseBlock(const T * const *pp, size_t k, size_t x0, size_t x1, T *lo, T *hi) const;
+
+		void synthesizeRows(const T *lo, const T *hi, size_t w, size_t nLines, T *dst, size_t nOut) const;
+		void synthesizeLine(const T *ppLo, const T *ppHi, size_t n, size_t nOut, T *dst) const;
+		void synthesizeColumns(const std::vector<SynthesisJob> &jobs, size_t nOut, size_t width) const;
+		void synthesizeBlock(const T * const *ppLo, const T * const *ppHi, size_t k, size_t x0, size_t x1, T *dst) const;
+
+		int m_nBegin;
+		int m_nSize;
+		kipl::base::ePadType m_ePad;
+		eLifting m_eLifting;
+		std::vector<T> m_tH;   ///< Analysis low pass, tap i belongs to index m_nBegin+i
+		std::vector<T> m_tG;   ///< Analysis high pass
+		std::vector<T> m_sH;   ///< Synthesis low pass
+		std::vector<T> m_sG;   ///< Synthesis high pass
+		T m_fLift[6];          ///< Coefficients of the lifting steps
+	};
+
 	template <typename T>
 	class WaveletTransform
 	{
@@ -112,5 +220,6 @@ template <typename T>
 std::ostream & operator<<(std::ostream & s, const kipl::wavelets::WaveletTransform<T> &wt);
 
 #include "core/wavelets.hpp"
+#include "core/waveletengine.hpp"
 
 #endif
@@ -50,6 +50,15 @@ win32:CONFIG(release, debug|release): LIBS += -llibtiff -lcfitsio -lzlib_a -llib
 else:win32:CONFIG(debug, debug|release): LIBS += -llibtiff -lcfitsio -lzlib_a -llibfftw3-3 -llibfftw3f-3 -lIphlpapi
 else:unix: LIBS +=  -lm -lz -ltiff -lfftw3 -lfftw3f -lcfitsio -larmadillo -llapack -lblas
 
+# Multi-threaded transforms are used when the threaded FFTW library is available
+unix:!macx {
+    exists(/usr/lib/x86_64-linux-gnu/libfftw3f_threads*)|exists(/usr/lib/libfftw3f_threads*) {
+        message("-lfftw3f_threads exists")
+        DEFINES += HAVE_FFTW_THREADS
+        LIBS += -lfftw3f_threads
+    }
+}
+
 DEFINES += KIPL_LIBRARY
 
 SOURCES += \
@@ -63,10 +72,13 @@ SOURCES += \
     ../src/math/GaussianNoise.cpp \
     ../src/logging/logger.cpp \
     ../src/io/io_tiff.cpp \
+    ../src/io/io_multiframetiff.cpp \
     ../src/io/io_stack.cpp \
     ../src/io/core/matlabio.cpp \
     ../src/io/core/io_fits.cpp \
     ../src/io/io_vivaseq.cpp \
+    ../src/io/io_mappedfile.cpp \
+    ../src/io/io_stackreslicer.cpp \
     ../src/generators/Sine2D.cpp \
     ../src/generators/SignalGenerator.cpp \
     ../src/generators/SequenceImage.cpp \
@@ -75,6 +87,7 @@ SOURCES += \
     ../src/fft/zeropadding.cpp \
     ../src/fft/fftbasef.cpp \
     ../src/fft/fftbase.cpp \
+    ../src/fft/fftplancache.cpp \
     ../src/base/KiplException.cpp \
     ../src/base/index2coord.cpp \
     ../src/base/imagesamplers.cpp \
@@ -96,6 +109,7 @@ SOURCES += \
     ../src/scalespace/filterenums.cpp \
     ../src/profile/Timer.cpp \
     ../src/profile/MicroTimer.cpp \
+    ../src/profile/Tracer.cpp \
     ../src/octree/octree.cpp \
     ../src/morphology/morphology.cpp \
     ../src/morphology/morphdist.cpp \
@@ -104,6 +118,7 @@ SOURCES += \
     ../src/pca/pca.cpp \
     ../src/math/covariance.cpp \
     ../src/morphology/skeleton.cpp \
+    ../src/morphology/palagyi_skeleton.cpp \
     ../src/io/DirAnalyzer.cpp \
     ../src/math/linfit.cpp \
     ../src/generators/spotgenerator.cpp \
@@ -118,6 +133,7 @@ SOURCES += \
     ../src/io/io_png.cpp \
     ../src/math/tcenterofgravity.cpp \
     ../src/math/statistics.cpp \
+    ../src/math/volumestatistics.cpp \
     ../src/math/circularhoughtransform.cpp \
     ../src/base/roi.cpp \
     ../src/math/findpeaks.cpp \
@@ -166,6 +182,7 @@ HEADERS +=\
     ../include/drawing/core/drawing.hpp \
     ../include/fft/zeropadding.h \
     ../include/fft/fftbase.h \
+    ../include/fft/fftplancache.h \
     ../include/fft/core/zeropadding.hpp \
     ../include/filters/convolutionkernels.h \
     ../include/filters/structureelements.h \
@@ -185,6 +202,7 @@ HEADERS +=\
     ../include/generators/NoiseImage.h \
     ../include/io/io_vtk.h \
     ../include/io/io_tiff.h \
+    ../include/io/io_multiframetiff.h \
     ../include/io/io_stack.h \
     ../include/io/io_matlab.h \
     ../include/io/io_fits.h \
@@ -209,6 +227,7 @@ HEADERS +=\
     ../include/morphology/base3dskeleton.h \
     ../include/math/sums.h \
     ../include/math/statistics.h \
+    ../include/math/volumestatistics.h \
     ../include/math/numfunc.h \
     ../include/math/nonlinfit.h \
     ../include/math/median.h \
@@ -239,10 +258,12 @@ HEADERS +=\
     ../include/segmentation/mapupdater.h \
     ../include/segmentation/kernelfuzzykmeans.h \
     ../include/segmentation/fuzzykmeans.h \
+    ../include/segmentation/histogramfuzzycmeans.h \
     ../include/segmentation/core/multiresseg.hpp \
     ../include/segmentation/core/mapupdater.hpp \
     ../include/segmentation/core/kernelfuzzykmeans.hpp \
     ../include/segmentation/core/fuzzykmeans.hpp \
+    ../include/segmentation/core/histogramfuzzycmeans.hpp \
     ../include/segmentation/core/ClassGrowing.hpp \
     ../include/segmentation/ClassGrowing.h \
     ../include/segmentation/bigunupdater.h \
@@ -284,10 +305,12 @@ HEADERS +=\
     ../include/queuefilter/absgradworker.h \
     ../include/profile/Timer.h \
     ../include/profile/MicroTimer.h \
+    ../include/profile/Tracer.h \
     ../include/porespace/poresize.h \
     ../include/porespace/core/poresize.hpp \
     ../include/wavelets/wavelets.h \
     ../include/wavelets/core/wavelets.hpp \
+    ../include/wavelets/core/waveletengine.hpp \
     ../include/visualization/GNUPlot.h \
     ../include/utilities/SystemInformation.h \
     ../include/utilities/nodelocker.h \
@@ -323,12 +346,16 @@ HEADERS +=\
     ../include/filters/stddevfilter.h \
     ../include/interactors/interactionbase.h \
     ../include/containers/ringbuffer.h \
+    ../include/containers/mpscringbuffer.h \
     ../include/segmentation/multivariateclassifyerbase.h \
     ../include/morphology/pixeliterator.h \
     ../include/segmentation/gradientguidedthreshold.h \
     ../include/segmentation/core/gradientguidedthreshold.hpp \
     ../include/morphology/morphgeo2.h \
     ../include/io/io_vivaseq.h \
+    ../include/io/io_mappedfile.h \
+    ../include/io/core/io_mappedfile.hpp \
+    ../include/io/io_stackreslicer.h \
     ../include/io/io_png.h \
     ../include/math/tcenterofgravity.h \
     ../include/math/core/tcenterofgravity.hpp \
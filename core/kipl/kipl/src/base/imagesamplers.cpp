@@ -1,6 +1,9 @@
 //<LICENCE>
 
+#include <sstream>
+
 #include "../../include/base/imagesamplers.h"
+#include "../../include/base/KiplException.h"
 
 namespace kipl { namespace base {
 
@@ -11,5 +14,22 @@ void BinDimensions(size_t const * const origdims, size_t const * const nbin,size
 //	}
 }
 
+void BinAndOrientDims(size_t const * const dims, size_t bin, kipl::base::eImageRotate rotate, size_t *resdims)
+{
+	const size_t b = bin<1 ? 1 : bin;
+	const size_t bw=dims[0]/b;
+	const size_t bh=dims[1]/b;
+
+	if ((bw==0) || (bh==0)) {
+		std::ostringstream msg;
+		msg<<"Binning "<<dims[0]<<"x"<<dims[1]<<" pixels by "<<b<<" results in a zero-size image";
+		throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+	}
+
+	const bool transpose = (rotate==kipl::base::ImageRotate90) || (rotate==kipl::base::ImageRotate270);
+	resdims[0] = transpose ? bh : bw;
+	resdims[1] = transpose ? bw : bh;
+}
+
 }
 }
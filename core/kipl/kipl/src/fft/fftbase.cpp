@@ -164,12 +164,12 @@ int FFTBase::operator() (double *inRdata,  complex<double> *outCdata)
 						FFTW_ESTIMATE);
 				break;
 			case 2:
-				r2cPlan=fftw_plan_dft_r2c_2d(dims[0],dims[1],
+				r2cPlan=fftw_plan_dft_r2c_2d(dims[1],dims[0],
 						rBuffer,reinterpret_cast<fftw_complex*>(cBufferA),
 						FFTW_ESTIMATE);
 				break;
 			case 3:
-				r2cPlan=fftw_plan_dft_r2c_3d(dims[0],dims[1], dims[2],
+				r2cPlan=fftw_plan_dft_r2c_3d(dims[2],dims[1], dims[0],
 						rBuffer, reinterpret_cast<fftw_complex*>(cBufferA),
 						FFTW_ESTIMATE);
 				break;
@@ -209,12 +209,12 @@ int FFTBase::operator() ( complex<double> *inCdata, double *outRdata)
 						FFTW_ESTIMATE);
 				break;
 			case 2:
-				c2rPlan=fftw_plan_dft_c2r_2d(dims[0],dims[1],
+				c2rPlan=fftw_plan_dft_c2r_2d(dims[1],dims[0],
 						reinterpret_cast<fftw_complex*>(cBufferA),rBuffer,
 						FFTW_ESTIMATE);
 				break;
 			case 3:
-				c2rPlan=fftw_plan_dft_c2r_3d(dims[0],dims[1], dims[2],
+				c2rPlan=fftw_plan_dft_c2r_3d(dims[2],dims[1], dims[0],
 						reinterpret_cast<fftw_complex*>(cBufferA),rBuffer, 
 						FFTW_ESTIMATE);
 				break;
@@ -6,10 +6,13 @@
 #include <iostream>
 #include <cmath>
 #include <algorithm>
+#include <iterator>
+#include <vector>
 
 #include <fftw3.h>
 
 #include "../../include/fft/fftbase.h"
+#include "../../include/fft/fftplancache.h"
 #include "../../include/base/KiplException.h"
 
 namespace kipl { namespace math { namespace fft {
@@ -47,106 +50,66 @@ FFTBaseFloat::FFTBaseFloat(size_t const * const Dims, size_t const NDim) :
 
 FFTBaseFloat::~FFTBaseFloat()
 {
-	if (r2cPlan)
-		fftwf_destroy_plan(r2cPlan);	
-		
-	if (c2cPlan)
-		fftwf_destroy_plan(c2cPlan);
-		
-	if (c2rPlan)
-		fftwf_destroy_plan(c2rPlan);
-			
-	if (c2cPlanI)
-		fftwf_destroy_plan(c2cPlanI);
-				
+	// The plans are owned by the plan cache
 	if (cBufferA)
-		delete [] cBufferA;
+		fftwf_free(cBufferA);
 		
 	if (cBufferB)
-		delete [] cBufferB;
+		fftwf_free(cBufferB);
 		
 	if (rBuffer)
-		delete [] rBuffer;
+		fftwf_free(rBuffer);
 }
 
-int FFTBaseFloat::operator() ( complex<float> *inCdata,  complex<float> *outCdata, int sign)
+std::vector<int> FFTBaseFloat::planDims() const
+{
+	// FFTW wants the slowest varying axis first
+	return std::vector<int>(std::reverse_iterator<const int *>(dims+ndim),
+							std::reverse_iterator<const int *>(dims));
+}
+
+void FFTBaseFloat::allocateBuffers(bool complexB, bool real)
 {
 	if (!cBufferA)
-		cBufferA=new  complex<float>[Ndata];
-	
-	if (!cBufferB)
-		cBufferB=new  complex<float>[Ndata];
+		cBufferA=reinterpret_cast<complex<float> *>(fftwf_malloc(sizeof(fftwf_complex)*Ndata));
+
+	if (complexB && !cBufferB)
+		cBufferB=reinterpret_cast<complex<float> *>(fftwf_malloc(sizeof(fftwf_complex)*Ndata));
 
-//    std::fill_n(cBufferA,0,Ndata);
-//    std::fill_n(cBufferB,0,Ndata);
+	if (real && !rBuffer)
+		rBuffer=reinterpret_cast<float *>(fftwf_malloc(sizeof(float)*2*Ndata));
+
+	if (!cBufferA || (complexB && !cBufferB) || (real && !rBuffer))
+		throw kipl::base::KiplException("Failed to allocate the FFT buffers",__FILE__,__LINE__);
+}
+
+int FFTBaseFloat::operator() ( complex<float> *inCdata,  complex<float> *outCdata, int sign)
+{
+	const int N=static_cast<int>(Ndata);
+
+	allocateBuffers(true,false);
 
 	if (sign<0) {
 		if (!have_c2cPlan) {
-			switch (ndim) {
-				case 1:
-					c2cPlan=fftwf_plan_dft_1d(dims[0],
-                           reinterpret_cast<fftwf_complex*>(cBufferA), 
-							reinterpret_cast<fftwf_complex*>(cBufferB),-1,
-							FFTW_ESTIMATE);
-					break;
-				case 2:
-					c2cPlan=fftwf_plan_dft_2d(dims[1],dims[0],
-                           reinterpret_cast<fftwf_complex*>(cBufferA), 
-							reinterpret_cast<fftwf_complex*>(cBufferB),-1,
-							FFTW_ESTIMATE);
-					break;
-				case 3:
-					c2cPlan=fftwf_plan_dft_3d(dims[2],dims[1], dims[0],
-                           reinterpret_cast<fftwf_complex*>(cBufferA), 
-							reinterpret_cast<fftwf_complex*>(cBufferB),-1,
-							FFTW_ESTIMATE);
-					break;
-				default:
-					cerr<<"ndim="<<ndim<<" is not supported"<<endl;
-					return -1;
-			}
-							
+			c2cPlan=FFTPlanCache::instance().plan(FFTForwardC2C,planDims(),1,1,N,1,N,false,true);
 			have_c2cPlan=true;
 		}
 	
 		memcpy(cBufferA,inCdata,sizeof( complex<float>)*Ndata);
-		fftwf_execute(c2cPlan);
+		fftwf_execute_dft(c2cPlan,
+						  reinterpret_cast<fftwf_complex*>(cBufferA),
+						  reinterpret_cast<fftwf_complex*>(cBufferB));
 	}
 	else {
 		if (!have_c2cPlanI) {
-			ostringstream str;
-			switch (ndim) {
-				case 1:
-					c2cPlanI=fftwf_plan_dft_1d(dims[0],
-                            reinterpret_cast<fftwf_complex*>(cBufferA),
-							reinterpret_cast<fftwf_complex*>(cBufferB),1,
-							FFTW_ESTIMATE);
-					break;
-				case 2:
-					c2cPlanI=fftwf_plan_dft_2d(dims[1],dims[0],
-                           reinterpret_cast<fftwf_complex*>(cBufferA), 
-							reinterpret_cast<fftwf_complex*>(cBufferB),1,
-							FFTW_ESTIMATE);
-					break;
-				case 3:
-					c2cPlanI=fftwf_plan_dft_3d(dims[2],dims[1], dims[0],
-                           reinterpret_cast<fftwf_complex*>(cBufferA), 
-							reinterpret_cast<fftwf_complex*>(cBufferB),1,
-							FFTW_ESTIMATE);
-					break;
-				default:
-					str.str("");
-					str<<"ndim="<<ndim<<" is not supported";
-					logger(kipl::logging::Logger::LogError,str.str());
-					return -1;
-					
-			}
-							
+			c2cPlanI=FFTPlanCache::instance().plan(FFTBackwardC2C,planDims(),1,1,N,1,N,false,true);
 			have_c2cPlanI=true;
 		}
 			
 		memcpy(cBufferA,inCdata,sizeof( complex<float>)*Ndata);
-		fftwf_execute(c2cPlanI);
+		fftwf_execute_dft(c2cPlanI,
+						  reinterpret_cast<fftwf_complex*>(cBufferA),
+						  reinterpret_cast<fftwf_complex*>(cBufferB));
 	}
 
 	memcpy(outCdata,cBufferB,sizeof( complex<float>)*Ndata);
@@ -156,46 +119,18 @@ int FFTBaseFloat::operator() ( complex<float> *inCdata,  complex<float> *outCdat
 
 int FFTBaseFloat::operator() (float *inRdata,  complex<float> *outCdata)
 {
-	if (!cBufferA)
-		cBufferA=new  complex<float>[Ndata];
-	
-	if (!rBuffer)
-		rBuffer=new float[2*Ndata];
+	const int N=static_cast<int>(Ndata);
 
-    std::fill_n(cBufferA,0,Ndata);
-    std::fill_n(rBuffer,0,2*Ndata);
+	allocateBuffers(false,true);
 		
 	if (!have_r2cPlan) {
-		ostringstream str;
-		switch (ndim) {
-			case 1:
-				r2cPlan=fftwf_plan_dft_r2c_1d(dims[0],
-						rBuffer,reinterpret_cast<fftwf_complex*>(cBufferA),
-						FFTW_ESTIMATE);
-				break;
-			case 2:
-				r2cPlan=fftwf_plan_dft_r2c_2d(dims[0],dims[1],
-						rBuffer,reinterpret_cast<fftwf_complex*>(cBufferA),
-						FFTW_ESTIMATE);
-				break;
-			case 3:
-				r2cPlan=fftwf_plan_dft_r2c_3d(dims[0],dims[1], dims[2],
-						rBuffer, reinterpret_cast<fftwf_complex*>(cBufferA),
-						FFTW_ESTIMATE);
-				break;
-			default:
-				str.str("");
-				str<<"ndim="<<ndim<<" is not supported";
-				logger(kipl::logging::Logger::LogError,str.str());
-				return -1;
-		}
-	
+		r2cPlan=FFTPlanCache::instance().plan(FFTForwardR2C,planDims(),1,1,N,1,N,false,true);
 		have_r2cPlan=true;
 	}
 	
 	memcpy(rBuffer,inRdata,sizeof(float)*Ndata);		
 	
-	fftwf_execute(r2cPlan);
+	fftwf_execute_dft_r2c(r2cPlan,rBuffer,reinterpret_cast<fftwf_complex*>(cBufferA));
 
 	memcpy(outCdata,cBufferA,sizeof( complex<float>)*Ndata);
 
@@ -205,46 +140,17 @@ int FFTBaseFloat::operator() (float *inRdata,  complex<float> *outCdata)
 
 int FFTBaseFloat::operator() ( complex<float> *inCdata, float *outRdata)
 {
-	if (!cBufferA)
-		//cBufferA=reinterpret_cast<complex<float> *>(fftw_malloc(sizeof(fftwf_complex) * Ndata));
-		cBufferA=new  complex<float>[Ndata];
-	
-	if (!rBuffer)
-		rBuffer=new float[2*Ndata];
+	const int N=static_cast<int>(Ndata);
 
-    std::fill_n(cBufferA,0,Ndata);
-    std::fill_n(rBuffer,0,2*Ndata);
+	allocateBuffers(false,true);
 
 	if (!have_c2rPlan) {
-		ostringstream str;
-		switch (ndim) {
-			case 1:
-				c2rPlan=fftwf_plan_dft_c2r_1d(dims[0],
-						reinterpret_cast<fftwf_complex*>(cBufferA),rBuffer,
-						FFTW_ESTIMATE);
-				break;
-			case 2:
-				c2rPlan=fftwf_plan_dft_c2r_2d(dims[0],dims[1],
-						reinterpret_cast<fftwf_complex*>(cBufferA),rBuffer,
-						FFTW_ESTIMATE);
-				break;
-			case 3:
-				c2rPlan=fftwf_plan_dft_c2r_3d(dims[0],dims[1], dims[2],
-						reinterpret_cast<fftwf_complex*>(cBufferA),rBuffer, 
-						FFTW_ESTIMATE);
-				break;
-			default:
-				str.str("");
-				str<<"ndim="<<ndim<<" is not supported";
-				logger(kipl::logging::Logger::LogError,str.str());
-				return -1;
-		}
-		
+		c2rPlan=FFTPlanCache::instance().plan(FFTBackwardC2R,planDims(),1,1,N,1,N,false,true);
 		have_c2rPlan=true;
 	}
 	
 	memcpy(cBufferA,inCdata,sizeof(complex<float>)*Ndata);
-	fftwf_execute(c2rPlan);
+	fftwf_execute_dft_c2r(c2rPlan,reinterpret_cast<fftwf_complex*>(cBufferA),rBuffer);
 
 	memcpy(outRdata,rBuffer,sizeof(float)*Ndata);
 
@@ -0,0 +1,330 @@
+//<LICENCE>
+
+#include <sstream>
+#include <complex>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+
+#include <fftw3.h>
+
+#include "../../include/fft/fftplancache.h"
+#include "../../include/base/KiplException.h"
+
+namespace kipl { namespace math { namespace fft {
+
+namespace {
+
+/// \brief Number of elements spanned by a batch of strided arrays
+size_t batchExtent(const std::vector<int> &embed, int howmany, int stride, int dist)
+{
+    const size_t N=std::accumulate(embed.begin(),embed.end(),size_t(1),std::multiplies<size_t>());
+
+    return static_cast<size_t>(howmany-1)*dist+(N-1)*stride+1;
+}
+
+}
+
+FFTPlanCache & FFTPlanCache::instance()
+{
+    // The initialization of a local static is thread safe
+    static FFTPlanCache cache;
+
+    return cache;
+}
+
+FFTPlanCache::FFTPlanCache() :
+    logger("kipl::math::fft::FFTPlanCache"),
+    m_ePlanning(FFTPlanEstimate),
+    m_nThreads(1)
+{
+#ifdef HAVE_FFTW_THREADS
+    fftwf_init_threads();
+#endif
+}
+
+FFTPlanCache::~FFTPlanCache()
+{
+    clear();
+}
+
+fftwf_plan FFTPlanCache::plan(eFFTKind kind, const std::vector<int> &n, int howmany,
+                              int istride, int idist, int ostride, int odist,
+                              bool inPlace, bool aligned)
+{
+    std::ostringstream msg;
+
+    if (n.empty() || (3<n.size()))
+        throw kipl::base::KiplException("The plan cache supports transforms of rank 1-3",__FILE__,__LINE__);
+
+    std::vector<int> key={static_cast<int>(kind),static_cast<int>(n.size())};
+    key.insert(key.end(),n.begin(),n.end());
+    key.insert(key.end(),{howmany,istride,idist,ostride,odist,inPlace,aligned});
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    key.insert(key.end(),{m_nThreads,static_cast<int>(m_ePlanning)});
+
+    auto it=m_Plans.find(key);
+    if (it!=m_Plans.end())
+        return it->second;
+
+    // The half complex arrays have n/2+1 elements along the fastest axis and in place real arrays are padded
+    std::vector<int> realEmbed(n);
+    std::vector<int> complexEmbed(n);
+    if (kind==FFTForwardR2C || kind==FFTBackwardC2R) {
+        complexEmbed.back() = n.back()/2+1;
+        if (inPlace)
+            realEmbed.back() = 2*complexEmbed.back();
+    }
+
+    const bool inIsReal  = kind==FFTForwardR2C;
+    const bool outIsReal = kind==FFTBackwardC2R;
+    std::vector<int> inEmbed  = inIsReal  ? realEmbed : complexEmbed;
+    std::vector<int> outEmbed = outIsReal ? realEmbed : complexEmbed;
+
+    if (kind==FFTForwardC2C || kind==FFTBackwardC2C) {
+        inEmbed  = n;
+        outEmbed = n;
+    }
+
+    const size_t inBytes  = batchExtent(inEmbed,howmany,istride,idist)*(inIsReal ? sizeof(float) : sizeof(fftwf_complex));
+    const size_t outBytes = batchExtent(outEmbed,howmany,ostride,odist)*(outIsReal ? sizeof(float) : sizeof(fftwf_complex));
+
+    // The plan is made on scratch buffers since the measuring planners overwrite the arrays
+    void *inBuffer  = fftwf_malloc(inPlace ? std::max(inBytes,outBytes) : inBytes);
+    void *outBuffer = inPlace ? inBuffer : fftwf_malloc(outBytes);
+
+    if ((inBuffer==nullptr) || (outBuffer==nullptr)) {
+        fftwf_free(inBuffer);
+        if (!inPlace)
+            fftwf_free(outBuffer);
+        throw kipl::base::KiplException("Failed to allocate the FFT planning buffers",__FILE__,__LINE__);
+    }
+
+    unsigned int flags=FFTW_ESTIMATE;
+    switch (m_ePlanning) {
+        case FFTPlanEstimate : flags=FFTW_ESTIMATE; break;
+        case FFTPlanMeasure  : flags=FFTW_MEASURE;  break;
+        case FFTPlanPatient  : flags=FFTW_PATIENT;  break;
+    }
+
+    if (!aligned)
+        flags |= FFTW_UNALIGNED;
+
+#ifdef HAVE_FFTW_THREADS
+    fftwf_plan_with_nthreads(m_nThreads);
+#endif
+
+    const int rank=static_cast<int>(n.size());
+    fftwf_plan p=nullptr;
+
+    switch (kind) {
+        case FFTForwardC2C :
+        case FFTBackwardC2C :
+            p=fftwf_plan_many_dft(rank,n.data(),howmany,
+                                  reinterpret_cast<fftwf_complex *>(inBuffer),inEmbed.data(),istride,idist,
+                                  reinterpret_cast<fftwf_complex *>(outBuffer),outEmbed.data(),ostride,odist,
+                                  kind==FFTForwardC2C ? FFTW_FORWARD : FFTW_BACKWARD, flags);
+            break;
+        case FFTForwardR2C :
+            p=fftwf_plan_many_dft_r2c(rank,n.data(),howmany,
+                                      reinterpret_cast<float *>(inBuffer),inEmbed.data(),istride,idist,
+                                      reinterpret_cast<fftwf_complex *>(outBuffer),outEmbed.data(),ostride,odist,
+                                      flags);
+            break;
+        case FFTBackwardC2R :
+            p=fftwf_plan_many_dft_c2r(rank,n.data(),howmany,
+                                      reinterpret_cast<fftwf_complex *>(inBuffer),inEmbed.data(),istride,idist,
+                                      reinterpret_cast<float *>(outBuffer),outEmbed.data(),ostride,odist,
+                                      flags);
+            break;
+    }
+
+    fftwf_free(inBuffer);
+    if (!inPlace)
+        fftwf_free(outBuffer);
+
+    if (p==nullptr) {
+        msg<<"FFTW could not create a plan for the transform layout (rank="<<rank<<", howmany="<<howmany
+           <<", istride="<<istride<<", idist="<<idist<<", ostride="<<ostride<<", odist="<<odist<<")";
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    m_Plans[key]=p;
+
+    if ((m_ePlanning!=FFTPlanEstimate) && !m_sWisdomFile.empty())
+        fftwf_export_wisdom_to_filename(m_sWisdomFile.c_str());
+
+    return p;
+}
+
+void FFTPlanCache::setPlanning(eFFTPlanning planning)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_ePlanning=planning;
+}
+
+eFFTPlanning FFTPlanCache::planning()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_ePlanning;
+}
+
+bool FFTPlanCache::setThreads(int nThreads)
+{
+#ifdef HAVE_FFTW_THREADS
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_nThreads=std::max(1,nThreads);
+
+    return true;
+#else
+    if (1<nThreads)
+        logger.warning("The library was built without FFTW threads, the transforms are single threaded.");
+
+    return false;
+#endif
+}
+
+int FFTPlanCache::threads()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_nThreads;
+}
+
+bool FFTPlanCache::loadWisdom(const std::string &fname)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return fftwf_import_wisdom_from_filename(fname.c_str())!=0;
+}
+
+bool FFTPlanCache::saveWisdom(const std::string &fname)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    return fftwf_export_wisdom_to_filename(fname.c_str())!=0;
+}
+
+void FFTPlanCache::setWisdomFile(const std::string &fname)
+{
+    std::ostringstream msg;
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    m_sWisdomFile=fname;
+
+    if (!m_sWisdomFile.empty()) {
+        if (fftwf_import_wisdom_from_filename(m_sWisdomFile.c_str())!=0)
+            msg<<"Loaded FFTW wisdom from "<<m_sWisdomFile;
+        else
+            msg<<"No FFTW wisdom loaded from "<<m_sWisdomFile;
+
+        logger.verbose(msg.str());
+    }
+}
+
+size_t FFTPlanCache::size()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Plans.size();
+}
+
+void FFTPlanCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    for (auto &item : m_Plans)
+        fftwf_destroy_plan(item.second);
+
+    m_Plans.clear();
+}
+
+bool FFTPlanCache::isAligned(const void *p)
+{
+    return fftwf_alignment_of(reinterpret_cast<float *>(const_cast<void *>(p)))==0;
+}
+
+FFTBatchFloat::FFTBatchFloat(size_t const * const Dims, size_t NDim, size_t howmany,
+                             size_t realStride, size_t realDist,
+                             size_t complexStride, size_t complexDist) :
+    n(Dims,Dims+NDim),
+    howmany(static_cast<int>(howmany)),
+    realStride(static_cast<int>(realStride)),
+    realDist(static_cast<int>(realDist)),
+    complexStride(static_cast<int>(complexStride)),
+    complexDist(static_cast<int>(complexDist))
+{
+    if ((NDim<1) || (3<NDim))
+        throw kipl::base::KiplException("FFTBatchFloat supports transforms of rank 1-3",__FILE__,__LINE__);
+
+    // FFTW wants the slowest varying axis first
+    std::reverse(n.begin(),n.end());
+}
+
+fftwf_plan FFTBatchFloat::getPlan(eFFTKind kind, const void *in, const void *out) const
+{
+    const bool inPlace = in==out;
+    const bool realKind = (kind==FFTForwardR2C) || (kind==FFTBackwardC2R);
+
+    int realLength = std::accumulate(n.begin(),n.end()-1,1,std::multiplies<int>());
+    int complexLength = realLength;
+
+    if (realKind) {
+        complexLength *= n.back()/2+1;
+        realLength    *= inPlace ? 2*(n.back()/2+1) : n.back();
+    }
+    else {
+        complexLength *= n.back();
+        realLength    *= n.back();
+    }
+
+    const int rDist = realDist==0    ? realStride*realLength       : realDist;
+    const int cDist = complexDist==0 ? complexStride*complexLength : complexDist;
+
+    const bool aligned = FFTPlanCache::isAligned(in) && FFTPlanCache::isAligned(out);
+
+    if ((kind==FFTForwardR2C) || (kind==FFTForwardC2C))
+        return FFTPlanCache::instance().plan(kind,n,howmany,realStride,rDist,complexStride,cDist,inPlace,aligned);
+
+    return FFTPlanCache::instance().plan(kind,n,howmany,complexStride,cDist,realStride,rDist,inPlace,aligned);
+}
+
+void FFTBatchFloat::forward(float *in, std::complex<float> *out)
+{
+    fftwf_execute_dft_r2c(getPlan(FFTForwardR2C,in,out),
+                          in,
+                          reinterpret_cast<fftwf_complex *>(out));
+}
+
+void FFTBatchFloat::inverse(std::complex<float> *in, float *out)
+{
+    fftwf_execute_dft_c2r(getPlan(FFTBackwardC2R,in,out),
+                          reinterpret_cast<fftwf_complex *>(in),
+                          out);
+}
+
+void FFTBatchFloat::forward(std::complex<float> *in, std::complex<float> *out)
+{
+    fftwf_execute_dft(getPlan(FFTForwardC2C,in,out),
+                      reinterpret_cast<fftwf_complex *>(in),
+                      reinterpret_cast<fftwf_complex *>(out));
+}
+
+void FFTBatchFloat::inverse(std::complex<float> *in, std::complex<float> *out)
+{
+    fftwf_execute_dft(getPlan(FFTBackwardC2C,in,out),
+                      reinterpret_cast<fftwf_complex *>(in),
+                      reinterpret_cast<fftwf_complex *>(out));
+}
+
+size_t FFTBatchFloat::batchSize() const
+{
+    return static_cast<size_t>(howmany);
+}
+
+size_t FFTBatchFloat::halfComplexSize() const
+{
+    return std::accumulate(n.begin(),n.end()-1,size_t(1),std::multiplies<size_t>())*(n.back()/2+1);
+}
+
+}}}
@@ -146,3 +146,32 @@ else if (str=="PNG16bits")              ft=kipl::io::PNG16bits;
 else throw kipl::base::KiplException("Unknow matrix file type string",__FILE__,__LINE__);
 
 }
+
+std::ostream & operator<<(std::ostream &s, const kipl::io::eTIFFCompression &c)
+{
+    s<<enum2string(c);
+
+    return s;
+}
+
+std::string enum2string(const kipl::io::eTIFFCompression &c)
+{
+std::string s;
+switch (c) {
+case kipl::io::TIFFCompressionNone    : s="TIFFCompressionNone";    break;
+case kipl::io::TIFFCompressionDeflate : s="TIFFCompressionDeflate"; break;
+case kipl::io::TIFFCompressionLZW     : s="TIFFCompressionLZW";     break;
+case kipl::io::TIFFCompressionZSTD    : s="TIFFCompressionZSTD";    break;
+}
+
+return s;
+}
+
+void string2enum(const std::string &str, kipl::io::eTIFFCompression &c)
+{
+if      (str=="TIFFCompressionNone")    c=kipl::io::TIFFCompressionNone;
+else if (str=="TIFFCompressionDeflate") c=kipl::io::TIFFCompressionDeflate;
+else if (str=="TIFFCompressionLZW")     c=kipl::io::TIFFCompressionLZW;
+else if (str=="TIFFCompressionZSTD")    c=kipl::io::TIFFCompressionZSTD;
+else throw kipl::base::KiplException("Unknown TIFF compression string",__FILE__,__LINE__);
+}
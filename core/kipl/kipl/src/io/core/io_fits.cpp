@@ -1,12 +1,18 @@
 //<LICENCE>
 
 #include <exception>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <string>
 #include <stdint.h>
+#include <sys/stat.h>
 
 #include <fitsio.h>
 
 #include "../../../include/base/KiplException.h"
+#include "../../../include/io/io_fits.h"
 
 namespace kipl { namespace io {
 int KIPLSHARED_EXPORT FITSDataType(unsigned char x) 	{ (void)x; return     TBYTE; }
@@ -32,45 +38,214 @@ int KIPLSHARED_EXPORT FITSPixelSize(float x)            { (void)x; return    FLO
 int KIPLSHARED_EXPORT FITSPixelSize(double x)           { (void)x; return   DOUBLE_IMG; }    // 64-bit double precision floating point
 
 
+namespace {
+
+/// \brief An open fits file, the mutex serializes the reads through the handle
+struct FITSHandle {
+    FITSHandle() : fptr(nullptr) {}
+    ~FITSHandle()
+    {
+        int status=0;
+        if (fptr!=nullptr)
+            fits_close_file(fptr,&status);
+    }
+
+    std::mutex mutex;
+    fitsfile *fptr;
+};
+
+struct FITSCacheEntry {
+    long long size;
+    long long mtime; //< Modification time in nanoseconds
+    FITSLayout layout;
+    std::shared_ptr<FITSHandle> handle; //< Open file of the entry, nullptr when it has been closed
+    size_t lastUse;
+};
+
+std::mutex FITSCacheMutex;
+std::map<std::string,FITSCacheEntry> FITSCache;
+const size_t FITSCacheCapacity=16384;
+const size_t FITSOpenFileCapacity=16;
+size_t FITSUseCount=0;
+
+bool FITSFileStamp(char const * const filename, long long &size, long long &mtime)
+{
+    struct stat info;
+    if (stat(filename,&info)!=0)
+        return false;
+
+    // The modification time is kept in nanoseconds where the platform provides it,
+    // a file rewritten within the same second with the same size is otherwise not detected
+    size  = static_cast<long long>(info.st_size);
+#if defined(_WIN32)
+    mtime = static_cast<long long>(info.st_mtime)*1000000000LL;
+#elif defined(__APPLE__)
+    mtime = static_cast<long long>(info.st_mtimespec.tv_sec)*1000000000LL + static_cast<long long>(info.st_mtimespec.tv_nsec);
+#else
+    mtime = static_cast<long long>(info.st_mtim.tv_sec)*1000000000LL + static_cast<long long>(info.st_mtim.tv_nsec);
+#endif
+
+    return true;
+}
+
+void ThrowFITSError(fitsfile *fptr, int status, char const * const filename, char const * const file, int line)
+{
+    char err_text[512];
+
+    fits_get_errstatus(status, err_text);
+    if (fptr!=nullptr) {
+        int close_status=0;
+        fits_close_file(fptr,&close_status);
+    }
+
+    std::ostringstream msg;
+    msg<<"ReadFITS: "<<err_text<<" ("<<filename<<")";
+    throw kipl::base::KiplException(msg.str(),file,line);
+}
+
+/// \brief Opens a fits file at its first image HDU and gets the layout from the parsed header
+std::shared_ptr<FITSHandle> OpenFITSFile(char const * const filename, FITSLayout &layout)
+{
+    std::shared_ptr<FITSHandle> handle=std::make_shared<FITSHandle>();
+    int status=0;
+
+    fits_open_image(&handle->fptr, filename, READONLY, &status);
+    if (status!=0) {
+        handle->fptr=nullptr;
+        std::ostringstream msg;
+        msg<<"Failed to open '"<<filename<<"' as a fits image";
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    long naxes[8]={0,0,0,0,0,0,0,0};
+
+    // The handle closes the file if an error is thrown
+    fits_get_img_param(handle->fptr, 8, &layout.bitpix, &layout.naxis, naxes, &status);
+    if (status!=0)
+        ThrowFITSError(nullptr,status,filename,__FILE__,__LINE__);
+
+    const int compressed=fits_is_compressed_image(handle->fptr,&status);
+    if (status!=0)
+        ThrowFITSError(nullptr,status,filename,__FILE__,__LINE__);
+
+    layout.compressed = compressed!=0;
+    for (int i=0; i<8; i++)
+        layout.dims[i]=static_cast<size_t>(naxes[i]);
+
+    return handle;
+}
+
+/// \brief Gets an open handle and the layout of a fits file.
+///
+/// The header is parsed once per file version. The handle is kept open with the cached layout, so the
+/// layout query and the following reads of a file share one parse, and further crops of the file don't
+/// parse the header at all. Only the most recently used files are kept open.
+std::shared_ptr<FITSHandle> AcquireFITSFile(char const * const filename, FITSLayout &layout)
+{
+    long long size=0;
+    long long mtime=0;
+    const bool bStamp=FITSFileStamp(filename,size,mtime);
+
+    if (bStamp) {
+        std::lock_guard<std::mutex> lock(FITSCacheMutex);
+        auto it=FITSCache.find(filename);
+        if ((it!=FITSCache.end()) && (it->second.size==size) && (it->second.mtime==mtime) && it->second.handle) {
+            it->second.lastUse=++FITSUseCount;
+            layout=it->second.layout;
+            return it->second.handle;
+        }
+    }
+
+    // The header is parsed outside the lock, the readers of different files don't wait for each other
+    std::shared_ptr<FITSHandle> handle=OpenFITSFile(filename,layout);
+
+    if (bStamp) {
+        std::lock_guard<std::mutex> lock(FITSCacheMutex);
+        if ((FITSCacheCapacity<=FITSCache.size()) && (FITSCache.count(filename)==0))
+            FITSCache.clear();
+
+        FITSCacheEntry &entry=FITSCache[filename];
+        entry.size    = size;
+        entry.mtime   = mtime;
+        entry.layout  = layout;
+        entry.handle  = handle;
+        entry.lastUse = ++FITSUseCount;
+
+        // Closes the least recently used files, a handle that is in use is closed when its reader releases it
+        size_t nOpen=0;
+        for (auto &item : FITSCache)
+            nOpen += item.second.handle ? 1 : 0;
+
+        for ( ; FITSOpenFileCapacity<nOpen; --nOpen) {
+            auto oldest=FITSCache.end();
+            for (auto it=FITSCache.begin(); it!=FITSCache.end(); ++it)
+                if (it->second.handle && ((oldest==FITSCache.end()) || (it->second.lastUse<oldest->second.lastUse)))
+                    oldest=it;
+
+            oldest->second.handle.reset();
+        }
+    }
+
+    return handle;
+}
+
+}
+
+FITSLayout KIPLSHARED_EXPORT GetFITSLayout(char const * const filename)
+{
+    long long size=0;
+    long long mtime=0;
+
+    if (FITSFileStamp(filename,size,mtime)) {
+        std::lock_guard<std::mutex> lock(FITSCacheMutex);
+        auto it=FITSCache.find(filename);
+        if ((it!=FITSCache.end()) && (it->second.size==size) && (it->second.mtime==mtime))
+            return it->second.layout;
+    }
+
+    FITSLayout layout;
+    AcquireFITSFile(filename,layout);
+
+    return layout;
+}
+
+void KIPLSHARED_EXPORT ClearFITSLayoutCache()
+{
+    std::lock_guard<std::mutex> lock(FITSCacheMutex);
+    FITSCache.clear();
+}
+
+void KIPLSHARED_EXPORT ReleaseFITSFile(char const * const filename)
+{
+    std::lock_guard<std::mutex> lock(FITSCacheMutex);
+    FITSCache.erase(filename);
+}
+
 int KIPLSHARED_EXPORT GetFITSDims(char const * const filename,size_t * dims)
 {
-	fitsfile *fptr;
-	int status=0;
-	std::ostringstream msg;
-	fits_open_image(&fptr, filename, READONLY, &status);
-	if (status!=0) {
-		msg<<"Failed to open '"<<filename<<"' in GetFITSDims";
-		throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-	}
-	int bitpix=0;
-	int naxis;
-    long naxes[8];
-
-	try {
-        fits_get_img_param(fptr, 8,  &bitpix, &naxis, naxes, &status);
-	}
-	catch (std::exception &e) {
-		fits_close_file(fptr,&status);
-		throw kipl::base::KiplException(e.what(), __FILE__, __LINE__);
-	}
-	catch (...) {
-		fits_close_file(fptr,&status);
-		throw kipl::base::KiplException("Unknown exception",__FILE__,__LINE__);
-	}
-	if (status!=0) {
-		char err_text[512];
-
-		fits_get_errstatus(status, err_text);
-		std::stringstream msg;
-		fits_close_file(fptr,&status);
-		msg<<"ReadFITS: "<<err_text<<" ("<<filename<<")";
-		throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-	}
-
-	for (int i=0; i<naxis; i++)
-		dims[i]=naxes[i];
-
-	fits_close_file(fptr, &status);
-    return naxis;
+    FITSLayout layout=GetFITSLayout(filename);
+
+    for (int i=0; i<layout.naxis; i++)
+        dims[i]=layout.dims[i];
+
+    return layout.naxis;
+}
+
+void KIPLSHARED_EXPORT ReadFITSSubset(char const * const filename, int datatype, int naxis, long *first, long *last, void *data)
+{
+    if (8<naxis)
+        ThrowFITSError(nullptr,BAD_NAXIS,filename,__FILE__,__LINE__);
+
+    FITSLayout layout;
+    std::shared_ptr<FITSHandle> handle=AcquireFITSFile(filename,layout);
+
+    long inc[8]={1,1,1,1,1,1,1,1};
+    int anynul=0;
+    int status=0;
+
+    std::lock_guard<std::mutex> lock(handle->mutex);
+    // For tile compressed images CFITSIO only decompresses the tiles that intersect the region
+    if (fits_read_subset(handle->fptr, datatype, first, last, inc, nullptr, data, &anynul, &status))
+        ThrowFITSError(nullptr,status,filename,__FILE__,__LINE__);
 }
 }}
@@ -0,0 +1,196 @@
+//<LICENCE>
+
+#include <algorithm>
+#include <sstream>
+
+#ifdef _MSC_VER
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../../include/io/io_mappedfile.h"
+#include "../../include/base/KiplException.h"
+
+namespace kipl { namespace io {
+
+#ifdef _MSC_VER
+MappedFile::MappedFile(const std::string &fname) :
+    m_sFileName(fname),
+    m_pData(nullptr),
+    m_nSize(0),
+    m_hFile(INVALID_HANDLE_VALUE),
+    m_hMapping(nullptr)
+{
+    std::ostringstream msg;
+
+    m_hFile=CreateFileA(fname.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,FILE_FLAG_SEQUENTIAL_SCAN,nullptr);
+    if (m_hFile==INVALID_HANDLE_VALUE) {
+        msg<<"MappedFile: Failed to open "<<fname;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    LARGE_INTEGER size;
+    GetFileSizeEx(m_hFile,&size);
+    m_nSize=static_cast<size_t>(size.QuadPart);
+
+    if (m_nSize!=0) {
+        m_hMapping=CreateFileMappingA(m_hFile,nullptr,PAGE_READONLY,0,0,nullptr);
+        if (m_hMapping!=nullptr)
+            m_pData=static_cast<const char *>(MapViewOfFile(m_hMapping,FILE_MAP_READ,0,0,0));
+
+        if (m_pData==nullptr) {
+            if (m_hMapping!=nullptr)
+                CloseHandle(m_hMapping);
+            CloseHandle(m_hFile);
+            msg<<"MappedFile: Failed to map "<<fname;
+            throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+        }
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_pData!=nullptr)
+        UnmapViewOfFile(m_pData);
+    if (m_hMapping!=nullptr)
+        CloseHandle(m_hMapping);
+    if (m_hFile!=INVALID_HANDLE_VALUE)
+        CloseHandle(m_hFile);
+}
+#else
+MappedFile::MappedFile(const std::string &fname) :
+    m_sFileName(fname),
+    m_pData(nullptr),
+    m_nSize(0),
+    m_nFile(-1)
+{
+    std::ostringstream msg;
+
+    m_nFile=open(fname.c_str(),O_RDONLY);
+    if (m_nFile<0) {
+        msg<<"MappedFile: Failed to open "<<fname;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    struct stat info;
+    if (fstat(m_nFile,&info)!=0) {
+        close(m_nFile);
+        msg<<"MappedFile: Failed to get the size of "<<fname;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+    m_nSize=static_cast<size_t>(info.st_size);
+
+    if (m_nSize!=0) {
+        void *ptr=mmap(nullptr,m_nSize,PROT_READ,MAP_SHARED,m_nFile,0);
+        if (ptr==MAP_FAILED) {
+            close(m_nFile);
+            msg<<"MappedFile: Failed to map "<<fname;
+            throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+        }
+        m_pData=static_cast<const char *>(ptr);
+        madvise(ptr,m_nSize,MADV_SEQUENTIAL);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_pData!=nullptr)
+        munmap(const_cast<char *>(m_pData),m_nSize);
+    if (0<=m_nFile)
+        close(m_nFile);
+}
+#endif
+
+MappedFrameReader::MappedFrameReader(const std::string &fname,
+                                     size_t width,
+                                     size_t height,
+                                     size_t offset,
+                                     size_t lineStride,
+                                     size_t frameStride,
+                                     kipl::base::eDataType dt,
+                                     kipl::base::eEndians endian) :
+    m_File(fname),
+    m_nWidth(width),
+    m_nHeight(height),
+    m_nOffset(offset),
+    m_nLineStride(lineStride),
+    m_nFrameStride(frameStride),
+    m_nFrames(0),
+    m_DataType(dt),
+    m_bSwap(false)
+{
+    std::ostringstream msg;
+
+    if ((width==0) || (height==0) || (frameStride==0))
+        throw kipl::base::KiplException("MappedFrameReader: the frame size must be greater than zero",__FILE__,__LINE__);
+
+    size_t nLineBytes=0;
+    switch (dt) {
+    case kipl::base::UInt4   : nLineBytes=(width+1)/2;   break;
+    case kipl::base::UInt8   : nLineBytes=width;         break;
+    case kipl::base::UInt12  : nLineBytes=3*((width+1)/2); break;
+    case kipl::base::UInt16  : nLineBytes=2*width;       break;
+    case kipl::base::Float32 : nLineBytes=4*width;       break;
+    }
+
+    if ((lineStride<nLineBytes) || (frameStride<(height-1)*lineStride+nLineBytes)) {
+        msg<<"MappedFrameReader: the strides of "<<fname<<" are too small for "<<width<<"x"<<height<<" pixels of type "<<dt;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    // The last frame only needs to extend to the end of its last line
+    const size_t nFrameBytes=(height-1)*lineStride+nLineBytes;
+    if (offset+nFrameBytes<=m_File.size())
+        m_nFrames=(m_File.size()-offset-nFrameBytes)/frameStride+1;
+
+    if (m_nFrames==0) {
+        msg<<"MappedFrameReader: "<<fname<<" doesn't contain a complete frame";
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    const uint16_t probe=1;
+    const bool bLittleEndianHost=*reinterpret_cast<const unsigned char *>(&probe)==1;
+    m_bSwap = bLittleEndianHost==(endian==kipl::base::BigEndian);
+}
+
+const char * MappedFrameReader::framePtr(size_t idx) const
+{
+    if (m_nFrames<=idx) {
+        std::ostringstream msg;
+        msg<<"MappedFrameReader: frame "<<idx<<" is out of range, "<<m_File.fileName()<<" has "<<m_nFrames<<" frames";
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    return m_File.data()+m_nOffset+idx*m_nFrameStride;
+}
+
+const char * MappedFrameReader::linePtr(size_t idx, size_t line) const
+{
+    return framePtr(idx)+line*m_nLineStride;
+}
+
+void MappedFrameReader::checkROI(size_t const * const roi, size_t *bounds) const
+{
+    if (roi==nullptr) {
+        bounds[0]=0;
+        bounds[1]=0;
+        bounds[2]=m_nWidth;
+        bounds[3]=m_nHeight;
+        return;
+    }
+
+    if ((roi[2]<=roi[0]) || (roi[3]<=roi[1]) || (m_nWidth<roi[2]) || (m_nHeight<roi[3])) {
+        std::ostringstream msg;
+        msg<<"MappedFrameReader: the roi ["<<roi[0]<<", "<<roi[1]<<", "<<roi[2]<<", "<<roi[3]
+           <<"] doesn't fit in the frame ("<<m_nWidth<<"x"<<m_nHeight<<")";
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    std::copy_n(roi,4,bounds);
+}
+
+}}
@@ -0,0 +1,86 @@
+//<LICENCE>
+
+#include <sstream>
+
+#include <tiffio.h>
+
+#include "../../include/io/io_multiframetiff.h"
+#include "../../include/base/KiplException.h"
+
+namespace kipl { namespace io {
+
+MultiFrameTIFF::MultiFrameTIFF(const std::string &fname) :
+    m_sFileName(fname),
+    m_Index(GetTIFFFrameIndex(fname))
+{
+    // The first handle also verifies that the file can be opened for reading
+    m_Handles.push_back(OpenTIFFFrame(m_sFileName));
+}
+
+MultiFrameTIFF::~MultiFrameTIFF()
+{
+    for (auto image : m_Handles)
+        TIFFClose(image);
+}
+
+size_t MultiFrameTIFF::frames() const
+{
+    return m_Index->offsets.size();
+}
+
+const size_t * MultiFrameTIFF::dims() const
+{
+    return m_Index->dims;
+}
+
+const std::string & MultiFrameTIFF::fileName() const
+{
+    return m_sFileName;
+}
+
+TIFF * MultiFrameTIFF::acquire(size_t idx)
+{
+    std::ostringstream msg;
+
+    if (frames()<=idx) {
+        msg<<"MultiFrameTIFF: Frame index "<<idx<<" exceeds the "<<frames()<<" available frames in the file "<<m_sFileName;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    TIFF *image=nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_Handles.empty()) {
+            image=m_Handles.back();
+            m_Handles.pop_back();
+        }
+    }
+
+    if (image==nullptr) {
+        if ((image = TIFFOpen(m_sFileName.c_str(), "r")) == nullptr) {
+            msg<<"MultiFrameTIFF: Could not open "<<m_sFileName;
+            throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+        }
+    }
+
+    if (TIFFSetSubDirectory(image,m_Index->offsets[idx])==0) {
+        TIFFClose(image);
+        msg<<"MultiFrameTIFF: Failed to read the directory of frame "<<idx<<" in "<<m_sFileName;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    return image;
+}
+
+void MultiFrameTIFF::release(TIFF *image, bool reuse)
+{
+    if (reuse) {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Handles.push_back(image);
+    }
+    else {
+        TIFFClose(image);
+    }
+}
+
+}}
@@ -134,4 +134,41 @@ int KIPLSHARED_EXPORT GetNexusDims(const char *fname, size_t *dims){
 
 }
 
+void KIPLSHARED_EXPORT OpenNexusSignal(NeXus::File &file, size_t *dims)
+{
+    file.openGroup("entry", "NXentry");
+    map<string, string> entries = file.getEntries();
+
+    for (map<string,string>::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+        if (it->second!="NXdata")
+            continue;
+
+        file.openGroup(it->first, it->second);
+        map<string, string> entries_data = file.getEntries();
+
+        for (map<string,string>::const_iterator it_data = entries_data.begin(); it_data != entries_data.end(); ++it_data) {
+            file.openData(it_data->first);
+            vector<NeXus::AttrInfo> attr_infos = file.getAttrInfos();
+
+            for (vector<NeXus::AttrInfo>::const_iterator it_att = attr_infos.begin(); it_att != attr_infos.end(); ++it_att) {
+                if (it_att->name=="signal") {
+                    NeXus::Info info=file.getInfo();
+                    if (info.dims.size()!=3)
+                        throw kipl::base::KiplException("OpenNexusSignal: the signal data set is not a stack of frames",__FILE__,__LINE__);
+
+                    dims[0]=static_cast<size_t>(info.dims[2]);
+                    dims[1]=static_cast<size_t>(info.dims[1]);
+                    dims[2]=static_cast<size_t>(info.dims[0]);
+
+                    return;
+                }
+            }
+            file.closeData();
+        }
+        file.closeGroup();
+    }
+
+    throw kipl::base::KiplException("OpenNexusSignal: the file has no signal data set",__FILE__,__LINE__);
+}
+
 }}
@@ -0,0 +1,343 @@
+//<LICENCE>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../../include/io/io_stackreslicer.h"
+#include "../../include/base/KiplException.h"
+
+namespace kipl { namespace io {
+
+namespace {
+
+/// Number of slice lines handled together when the columns are gathered for the YZ planes
+const size_t nLineBlock = 64;
+
+int maxThreads()
+{
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+template <typename T>
+void gatherColumn(const char *slice, size_t width, size_t x, size_t y0, size_t y1, char *dst)
+{
+    const T *pSrc = reinterpret_cast<const T *>(slice)+x;
+    T *pDst = reinterpret_cast<T *>(dst);
+
+    for (size_t y=y0; y<y1; ++y)
+        pDst[y-y0] = pSrc[y*width];
+}
+
+void gatherColumn(const char *slice, size_t width, size_t x, size_t y0, size_t y1, char *dst, size_t bytesPerPixel)
+{
+    switch (bytesPerPixel) {
+    case 1 : gatherColumn<unsigned char>(slice,width,x,y0,y1,dst); break;
+    case 2 : gatherColumn<unsigned short>(slice,width,x,y0,y1,dst); break;
+    case 4 : gatherColumn<unsigned int>(slice,width,x,y0,y1,dst); break;
+    case 8 : gatherColumn<unsigned long long>(slice,width,x,y0,y1,dst); break;
+    default :
+        for (size_t y=y0; y<y1; ++y)
+            std::memcpy(dst+(y-y0)*bytesPerPixel,slice+(y*width+x)*bytesPerPixel,bytesPerPixel);
+    }
+}
+
+/// Removes the temporary file also when the processing fails
+class TemporaryFile
+{
+public:
+    TemporaryFile(const std::string &fname) : m_sFileName(fname) {}
+    ~TemporaryFile() { if (!m_sFileName.empty()) std::remove(m_sFileName.c_str()); }
+private:
+    std::string m_sFileName;
+};
+
+}
+
+StackReslicer::StackReslicer(size_t width, size_t height, size_t slices, size_t bytesPerPixel) :
+    m_nWidth(width),
+    m_nHeight(height),
+    m_nSlices(slices),
+    m_nBytesPerPixel(bytesPerPixel),
+    m_nMemoryBudget(size_t(1)<<30),
+    m_nLineBytes(0)
+{
+    if ((width==0) || (height==0) || (slices==0) || (bytesPerPixel==0))
+        throw kipl::base::KiplException("StackReslicer: the stack must not be empty",__FILE__,__LINE__);
+
+#ifdef _MSC_VER
+    const char *tmp=std::getenv("TEMP");
+    m_sTemporaryPath = tmp!=nullptr ? tmp : ".";
+#else
+    const char *tmp=std::getenv("TMPDIR");
+    m_sTemporaryPath = tmp!=nullptr ? tmp : "/tmp";
+#endif
+}
+
+StackReslicer::~StackReslicer()
+{
+}
+
+void StackReslicer::AddPlanes(kipl::base::eImagePlanes plane, size_t first, size_t last)
+{
+    std::ostringstream msg;
+
+    size_t nLimit=0;
+    size_t nLineBytes=0;
+    switch (plane) {
+    case kipl::base::ImagePlaneXY :
+        throw kipl::base::KiplException("StackReslicer: XY planes are not resliced",__FILE__,__LINE__);
+    case kipl::base::ImagePlaneXZ :
+        nLimit     = m_nHeight;
+        nLineBytes = m_nWidth*m_nBytesPerPixel;
+        break;
+    case kipl::base::ImagePlaneYZ :
+        nLimit     = m_nWidth;
+        nLineBytes = m_nHeight*m_nBytesPerPixel;
+        break;
+    }
+
+    if ((last<first) || (nLimit<=last)) {
+        msg<<"StackReslicer: the plane range "<<first<<"-"<<last<<" is outside the slices ("<<m_nWidth<<"x"<<m_nHeight<<")";
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    for (size_t pos=first; pos<=last; ++pos) {
+        Plane p;
+        p.plane     = plane;
+        p.position  = pos;
+        p.lineBytes = nLineBytes;
+        p.offset    = m_nLineBytes;
+        m_Planes.push_back(p);
+
+        m_nLineBytes += nLineBytes;
+    }
+}
+
+void StackReslicer::SetMemoryBudget(size_t bytes)
+{
+    m_nMemoryBudget=bytes;
+}
+
+void StackReslicer::SetTemporaryPath(const std::string &path)
+{
+    m_sTemporaryPath=path;
+}
+
+size_t StackReslicer::ChunkDepth() const
+{
+    if (m_nLineBytes==0)
+        return m_nSlices;
+
+    // Each reading thread needs a slice buffer, the rest of the budget holds the chunk
+    const size_t nSliceMemory = readThreads()*sliceBytes();
+    const size_t nChunkMemory = nSliceMemory<m_nMemoryBudget ? m_nMemoryBudget-nSliceMemory : 0;
+
+    return std::max(size_t(1),std::min(m_nSlices,nChunkMemory/m_nLineBytes));
+}
+
+size_t StackReslicer::readThreads() const
+{
+    // The slice buffers may use at most half of the budget
+    return std::max(size_t(1),std::min(static_cast<size_t>(maxThreads()),m_nMemoryBudget/(2*sliceBytes())));
+}
+
+void StackReslicer::Process(SliceReader reader, PlaneWriter writer)
+{
+    std::ostringstream msg;
+
+    if (m_Planes.empty())
+        throw kipl::base::KiplException("StackReslicer: no planes are selected",__FILE__,__LINE__);
+
+    const size_t nDepth   = ChunkDepth();
+    const size_t nChunks  = (m_nSlices+nDepth-1)/nDepth;
+    const bool   bSpill   = 1<nChunks;
+    const int    nThreads = static_cast<int>(readThreads());
+
+    std::vector<char> chunk(nDepth*m_nLineBytes);
+
+    const std::string fname = bSpill ? temporaryFileName() : std::string();
+    TemporaryFile guard(fname);
+
+    for (size_t c=0; c<nChunks; ++c) {
+        const size_t z0 = c*nDepth;
+        const ptrdiff_t nLocal = static_cast<ptrdiff_t>(std::min(nDepth,m_nSlices-z0));
+
+        bool bFailed=false;
+        std::string sError;
+
+        #pragma omp parallel num_threads(nThreads)
+        {
+            std::vector<char> slice(sliceBytes());
+
+            #pragma omp for schedule(dynamic)
+            for (ptrdiff_t i=0; i<nLocal; ++i) {
+                try {
+                    reader(z0+i,slice.data());
+                    scatterSlice(slice.data(),chunk.data(),i,nLocal);
+                }
+                catch (std::exception &e) {
+                    #pragma omp critical
+                    {
+                        bFailed=true;
+                        sError=e.what();
+                    }
+                }
+            }
+        }
+
+        if (bFailed) {
+            msg<<"StackReslicer: failed to read slice in the range "<<z0<<"-"<<z0+nLocal-1<<"\n"<<sError;
+            throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+        }
+
+        if (bSpill)
+            writeChunk(fname,chunk.data(),nLocal,c);
+    }
+
+    if (bSpill) {
+        chunk.clear();
+        chunk.shrink_to_fit();
+        assemblePlanes(fname,nDepth,writer);
+        return;
+    }
+
+    // All planes are in memory, the plane blocks of the chunk are the complete planes
+    bool bFailed=false;
+    std::string sError;
+    const ptrdiff_t nPlanes=static_cast<ptrdiff_t>(m_Planes.size());
+
+    #pragma omp parallel for schedule(dynamic)
+    for (ptrdiff_t i=0; i<nPlanes; ++i) {
+        const Plane &p=m_Planes[i];
+        try {
+            writer(p.plane,p.position,chunk.data()+p.offset*m_nSlices,p.lineBytes/m_nBytesPerPixel,m_nSlices);
+        }
+        catch (std::exception &e) {
+            #pragma omp critical
+            {
+                bFailed=true;
+                sError=e.what();
+            }
+        }
+    }
+
+    if (bFailed) {
+        msg<<"StackReslicer: failed to write a plane\n"<<sError;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+}
+
+void StackReslicer::scatterSlice(const char *slice, char *chunk, size_t z, size_t depth) const
+{
+    // The chunk holds one block per plane with depth lines
+    for (const auto &p : m_Planes) {
+        if (p.plane==kipl::base::ImagePlaneXZ)
+            std::memcpy(chunk+p.offset*depth+z*p.lineBytes,slice+p.position*p.lineBytes,p.lineBytes);
+    }
+
+    // The columns are gathered for a block of lines at a time to keep the lines in the cache for all YZ planes
+    for (size_t y0=0; y0<m_nHeight; y0+=nLineBlock) {
+        const size_t y1=std::min(m_nHeight,y0+nLineBlock);
+
+        for (const auto &p : m_Planes) {
+            if (p.plane==kipl::base::ImagePlaneYZ)
+                gatherColumn(slice,m_nWidth,p.position,y0,y1,
+                             chunk+p.offset*depth+z*p.lineBytes+y0*m_nBytesPerPixel,
+                             m_nBytesPerPixel);
+        }
+    }
+}
+
+void StackReslicer::writeChunk(const std::string &fname, const char *chunk, size_t depth, size_t chunkIndex) const
+{
+    // All chunks but the last have the full depth, i.e. the chunks are appended in order
+    std::ofstream file(fname.c_str(), std::ios::binary | (chunkIndex==0 ? std::ios::trunc : std::ios::app));
+
+    if (!file.good() || !file.write(chunk,depth*m_nLineBytes)) {
+        std::ostringstream msg;
+        msg<<"StackReslicer: failed to write to the temporary file "<<fname;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+}
+
+void StackReslicer::assemblePlanes(const std::string &fname, size_t chunkDepth, PlaneWriter &writer) const
+{
+    size_t nMaxPlaneBytes=0;
+    for (const auto &p : m_Planes)
+        nMaxPlaneBytes=std::max(nMaxPlaneBytes,p.lineBytes*m_nSlices);
+
+    const int nThreads = static_cast<int>(std::max(size_t(1),std::min(static_cast<size_t>(maxThreads()),m_nMemoryBudget/nMaxPlaneBytes)));
+    const size_t nChunks = (m_nSlices+chunkDepth-1)/chunkDepth;
+    const ptrdiff_t nPlanes = static_cast<ptrdiff_t>(m_Planes.size());
+
+    bool bFailed=false;
+    std::string sError;
+
+    #pragma omp parallel num_threads(nThreads)
+    {
+        std::ifstream file(fname.c_str(), std::ios::binary);
+        std::vector<char> buffer(nMaxPlaneBytes);
+
+        #pragma omp for schedule(dynamic)
+        for (ptrdiff_t i=0; i<nPlanes; ++i) {
+            const Plane &p=m_Planes[i];
+            try {
+                // Each chunk contributes a contiguous block of lines to the plane
+                for (size_t c=0; c<nChunks; ++c) {
+                    const size_t z0=c*chunkDepth;
+                    const size_t depth=std::min(chunkDepth,m_nSlices-z0);
+                    const std::streamoff pos=static_cast<std::streamoff>(z0*m_nLineBytes+p.offset*depth);
+
+                    file.seekg(pos);
+                    if (!file.read(buffer.data()+z0*p.lineBytes,depth*p.lineBytes))
+                        throw kipl::base::KiplException("StackReslicer: failed to read from the temporary file",__FILE__,__LINE__);
+                }
+
+                writer(p.plane,p.position,buffer.data(),p.lineBytes/m_nBytesPerPixel,m_nSlices);
+            }
+            catch (std::exception &e) {
+                file.clear();
+                #pragma omp critical
+                {
+                    bFailed=true;
+                    sError=e.what();
+                }
+            }
+        }
+    }
+
+    if (bFailed) {
+        std::ostringstream msg;
+        msg<<"StackReslicer: failed to write a plane\n"<<sError;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+}
+
+std::string StackReslicer::temporaryFileName() const
+{
+    std::ostringstream fname;
+
+    fname<<m_sTemporaryPath;
+    if (!m_sTemporaryPath.empty() && (m_sTemporaryPath.back()!='/') && (m_sTemporaryPath.back()!='\\'))
+        fname<<"/";
+
+    fname<<"kipl_reslice_"<<std::chrono::steady_clock::now().time_since_epoch().count()
+         <<"_"<<reinterpret_cast<size_t>(this)<<".tmp";
+
+    return fname.str();
+}
+
+}}
@@ -2,11 +2,20 @@
 
 
 #include <iostream>
+#include <map>
+#include <mutex>
+#include <sys/stat.h>
+#include <algorithm>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <tiffio.h>
 
 #include "../../include/base/timage.h"
 #include "../../include/base/KiplException.h"
+#include "../../include/io/io_tiff.h"
 
 namespace kipl { namespace io {
 
@@ -27,36 +36,619 @@ bool KIPLSHARED_EXPORT GetSlopeOffset(std::string msg, float &slope, float &offs
 	return true;
 }
 
-int KIPLSHARED_EXPORT GetTIFFDims(char const * const fname,size_t *dims)
+namespace {
+
+/// \brief A cached frame index and the file state it was built for
+struct TIFFFrameIndexEntry
+{
+    std::shared_ptr<const TIFFFrameIndex> index;
+    long long fileSize;
+    long long modificationTime;
+    size_t lastUse;
+};
+
+const size_t cnMaxCachedFrameIndices=64;
+
+std::mutex frameIndexMutex;
+std::map<std::string,TIFFFrameIndexEntry> frameIndexCache;
+size_t frameIndexUseCount=0;
+
+bool getFileState(const std::string &fname, long long &size, long long &mtime)
+{
+    struct stat info;
+
+    if (stat(fname.c_str(),&info)!=0)
+        return false;
+
+    // The modification time is kept in nanoseconds where the platform provides it,
+    // a file rewritten within the same second with the same size is otherwise not detected
+    size  = static_cast<long long>(info.st_size);
+#if defined(_WIN32)
+    mtime = static_cast<long long>(info.st_mtime)*1000000000LL;
+#elif defined(__APPLE__)
+    mtime = static_cast<long long>(info.st_mtimespec.tv_sec)*1000000000LL + static_cast<long long>(info.st_mtimespec.tv_nsec);
+#else
+    mtime = static_cast<long long>(info.st_mtim.tv_sec)*1000000000LL + static_cast<long long>(info.st_mtim.tv_nsec);
+#endif
+
+    return true;
+}
+
+/// \brief Checks a cached index against the first frame of an open file
+/// \param image The file positioned at its first frame
+/// \param index The cached index
+/// \returns true if the size of the first frame agrees with the index
+bool sameFirstFrame(TIFF *image, const TIFFFrameIndex &index)
+{
+    uint32 nWidth=0;
+    uint32 nLength=0;
+    TIFFGetField(image, TIFFTAG_IMAGEWIDTH,  &nWidth);
+    TIFFGetField(image, TIFFTAG_IMAGELENGTH, &nLength);
+
+    return (index.dims[0]==static_cast<size_t>(nWidth)) && (index.dims[1]==static_cast<size_t>(nLength));
+}
+
+std::shared_ptr<TIFFFrameIndex> buildFrameIndex(const std::string &fname)
 {
-	TIFF *image;
-	//TIFFErrorHandler warn = TIFFSetWarningHandler(0);
-	// Open the TIFF image
-    if((image = TIFFOpen(fname, "r")) == nullptr){
+    TIFF *image;
+
+    TIFFSetWarningHandler(nullptr);
+    if((image = TIFFOpen(fname.c_str(), "r")) == nullptr){
         std::stringstream msg;
         msg.str("");
         msg<<"GetTIFFDims: Could not open "<<fname;
         throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
-	}
-	// We need to set some values for basic tags before we can add any data
-	int nWidth=0;
-	int nLength=0;
-	TIFFGetField(image, TIFFTAG_IMAGEWIDTH,&nWidth);
-	TIFFGetField(image, TIFFTAG_IMAGELENGTH, &nLength);
-	
-	dims[0]=static_cast<size_t>(nWidth);
-	dims[1]=static_cast<size_t>(nLength);
-    int frames=0;
+    }
+
+    std::shared_ptr<TIFFFrameIndex> index=std::make_shared<TIFFFrameIndex>();
+
+    int nWidth=0;
+    int nLength=0;
+    TIFFGetField(image, TIFFTAG_IMAGEWIDTH,&nWidth);
+    TIFFGetField(image, TIFFTAG_IMAGELENGTH, &nLength);
+
+    index->dims[0]=static_cast<size_t>(nWidth);
+    index->dims[1]=static_cast<size_t>(nLength);
+
     do {
-            frames++;
+        index->offsets.push_back(TIFFCurrentDirOffset(image));
     } while (TIFFReadDirectory(image));
-	TIFFClose(image);
 
-    return frames;
+    TIFFClose(image);
+
+    return index;
+}
+
+/// \brief Looks up the frame index of a file and builds it if the cached entry is missing or stale
+/// \param fname file name of the image file
+/// \param image The file positioned at its first frame, used to verify a cached entry
+std::shared_ptr<const TIFFFrameIndex> lookupFrameIndex(const std::string &fname, TIFF *image)
+{
+    long long fileSize=-1;
+    long long modificationTime=-1;
+    const bool haveState=getFileState(fname,fileSize,modificationTime);
+
+    if (haveState) {
+        std::shared_ptr<const TIFFFrameIndex> cached;
+        {
+            std::lock_guard<std::mutex> lock(frameIndexMutex);
+
+            auto it=frameIndexCache.find(fname);
+            if ((it!=frameIndexCache.end()) &&
+                    (it->second.fileSize==fileSize) &&
+                    (it->second.modificationTime==modificationTime)) {
+                it->second.lastUse=++frameIndexUseCount;
+                cached=it->second.index;
+            }
+        }
+
+        // The file stamp can't tell apart rewrites within the time resolution of the file system
+        if (cached && sameFirstFrame(image,*cached))
+            return cached;
+    }
+
+    // The directory chain is walked without holding the lock
+    std::shared_ptr<const TIFFFrameIndex> index=buildFrameIndex(fname);
+
+    if (haveState) {
+        std::lock_guard<std::mutex> lock(frameIndexMutex);
+
+        if ((cnMaxCachedFrameIndices<=frameIndexCache.size()) && (frameIndexCache.count(fname)==0)) {
+            auto oldest=frameIndexCache.begin();
+            for (auto it=frameIndexCache.begin(); it!=frameIndexCache.end(); ++it)
+                if (it->second.lastUse<oldest->second.lastUse)
+                    oldest=it;
+
+            frameIndexCache.erase(oldest);
+        }
+
+        frameIndexCache[fname]=TIFFFrameIndexEntry{index,fileSize,modificationTime,++frameIndexUseCount};
+    }
+
+    return index;
+}
+
+}
+
+std::shared_ptr<const TIFFFrameIndex> KIPLSHARED_EXPORT GetTIFFFrameIndex(const std::string &fname)
+{
+    TIFF *image;
+
+    TIFFSetWarningHandler(nullptr);
+    if((image = TIFFOpen(fname.c_str(), "r")) == nullptr){
+        std::stringstream msg;
+        msg<<"GetTIFFDims: Could not open "<<fname;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    std::shared_ptr<const TIFFFrameIndex> index;
+    try {
+        index=lookupFrameIndex(fname,image);
+    }
+    catch (...) {
+        TIFFClose(image);
+        throw;
+    }
+
+    TIFFClose(image);
+
+    return index;
+}
+
+void KIPLSHARED_EXPORT ClearTIFFFrameIndexCache()
+{
+    std::lock_guard<std::mutex> lock(frameIndexMutex);
+
+    frameIndexCache.clear();
+}
+
+KIPLSHARED_EXPORT TIFF * OpenTIFFFrame(const std::string &fname, size_t idx)
+{
+    std::stringstream msg;
+    TIFF *image;
+
+    TIFFSetWarningHandler(nullptr);
+    if((image = TIFFOpen(fname.c_str(), "r")) == nullptr){
+        msg.str("");
+        msg<<"ReadTIFF: Could not open image "<<fname;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    if (idx==0)
+        return image;
+
+    std::shared_ptr<const TIFFFrameIndex> index;
+    try {
+        index=lookupFrameIndex(fname,image);
+    }
+    catch (...) {
+        TIFFClose(image);
+        throw;
+    }
+
+    if (index->offsets.size()<=idx) {
+        TIFFClose(image);
+        msg.str("");
+        msg<<"ReadTIFF: Frame index "<<idx<<" exceeds the "<<index->offsets.size()<<" available frames in the file "<<fname;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    if (TIFFSetSubDirectory(image,index->offsets[idx])==0) {
+        TIFFClose(image);
+        msg.str("");
+        msg<<"ReadTIFF: Failed to read the directory of frame "<<idx<<" in "<<fname;
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    return image;
+}
+
+bool KIPLSHARED_EXPORT ReadTIFFTiles(TIFF *image, unsigned char *buffer)
+{
+    uint32 width=0, length=0, tileWidth=0, tileLength=0;
+
+    TIFFGetField(image, TIFFTAG_IMAGEWIDTH,  &width);
+    TIFFGetField(image, TIFFTAG_IMAGELENGTH, &length);
+    TIFFGetField(image, TIFFTAG_TILEWIDTH,   &tileWidth);
+    TIFFGetField(image, TIFFTAG_TILELENGTH,  &tileLength);
+
+    if ((tileWidth==0) || (tileLength==0))
+        return false;
+
+    const size_t pixelBytes=static_cast<size_t>(TIFFScanlineSize(image))/width;
+    std::vector<unsigned char> tile(static_cast<size_t>(TIFFTileSize(image)));
+
+    for (uint32 y=0; y<length; y+=tileLength) {
+        for (uint32 x=0; x<width; x+=tileWidth) {
+            if (TIFFReadTile(image,tile.data(),x,y,0,0)==-1)
+                return false;
+
+            const size_t rows=std::min(tileLength,length-y);
+            const size_t cols=std::min(tileWidth,width-x);
+            for (size_t row=0; row<rows; ++row)
+                std::copy_n(tile.data()+row*tileWidth*pixelBytes,
+                            cols*pixelBytes,
+                            buffer+((y+row)*static_cast<size_t>(width)+x)*pixelBytes);
+        }
+    }
+
+    return true;
+}
+
+int KIPLSHARED_EXPORT GetTIFFDims(char const * const fname,size_t *dims)
+{
+    std::shared_ptr<const TIFFFrameIndex> index=GetTIFFFrameIndex(fname);
+
+    dims[0]=index->dims[0];
+    dims[1]=index->dims[1];
+
+    return static_cast<int>(index->offsets.size());
+}
+
+TIFFWriteOptions::TIFFWriteOptions(eTIFFCompression c) :
+    compression(c),
+    level(-1),
+    predictor(true),
+    rowsPerStrip(0),
+    bigTIFF(false)
+{
+    tileSize[0]=0;
+    tileSize[1]=0;
+}
+
+namespace {
+
+// Compression tags that are missing in the libtiff 3 headers
+#ifndef COMPRESSION_ZSTD
+#define COMPRESSION_ZSTD 50000
+#endif
+#ifndef TIFFTAG_ZSTD_LEVEL
+#define TIFFTAG_ZSTD_LEVEL 65564
+#endif
+
+const size_t cnCompressedStripBytes=262144;
+const unsigned long long cnBigTIFFLimit=0xF0000000ULL;
+
+/// \brief Geometry of the strips or tiles of a frame
+struct TIFFChunkLayout
+{
+    size_t width;       ///< Frame width
+    size_t length;      ///< Frame height
+    size_t pixelBytes;  ///< Bytes per pixel
+    bool tiled;         ///< Tiles instead of strips
+    size_t chunkWidth;  ///< Width of a strip or tile
+    size_t chunkRows;   ///< Rows of a strip or tile
+    size_t across;      ///< Chunks per row of chunks
+    size_t down;        ///< Rows of chunks
+
+    size_t count() const { return across*down; }
+};
+
+/// \brief Growing memory file used to run the libtiff encoders on single chunks
+struct TIFFMemoryFile
+{
+    std::vector<unsigned char> data;
+    size_t pos;
+};
+
+tsize_t memoryRead(thandle_t h, tdata_t buf, tsize_t size)
+{
+    TIFFMemoryFile *file=reinterpret_cast<TIFFMemoryFile *>(h);
+
+    size_t n=std::min(static_cast<size_t>(size),file->data.size()-std::min(file->pos,file->data.size()));
+    std::copy_n(file->data.data()+file->pos,n,reinterpret_cast<unsigned char *>(buf));
+    file->pos+=n;
+
+    return static_cast<tsize_t>(n);
+}
+
+tsize_t memoryWrite(thandle_t h, tdata_t buf, tsize_t size)
+{
+    TIFFMemoryFile *file=reinterpret_cast<TIFFMemoryFile *>(h);
+
+    if (file->data.size()<file->pos+static_cast<size_t>(size))
+        file->data.resize(file->pos+static_cast<size_t>(size));
+
+    std::copy_n(reinterpret_cast<unsigned char *>(buf),static_cast<size_t>(size),file->data.data()+file->pos);
+    file->pos+=static_cast<size_t>(size);
+
+    return size;
+}
+
+toff_t memorySeek(thandle_t h, toff_t offset, int whence)
+{
+    TIFFMemoryFile *file=reinterpret_cast<TIFFMemoryFile *>(h);
+
+    switch (whence) {
+        case SEEK_SET : file->pos=static_cast<size_t>(offset); break;
+        case SEEK_CUR : file->pos+=static_cast<size_t>(offset); break;
+        case SEEK_END : file->pos=file->data.size()+static_cast<size_t>(offset); break;
+    }
+
+    return static_cast<toff_t>(file->pos);
 }
 
+int memoryClose(thandle_t)
+{
+    return 0;
+}
+
+toff_t memorySize(thandle_t h)
+{
+    return static_cast<toff_t>(reinterpret_cast<TIFFMemoryFile *>(h)->data.size());
+}
+
+int memoryMap(thandle_t, tdata_t *, toff_t *)
+{
+    return 0;
+}
+
+void memoryUnmap(thandle_t, tdata_t, toff_t)
+{
+}
+
+uint16 compressionScheme(eTIFFCompression compression)
+{
+    switch (compression) {
+        case TIFFCompressionNone    : return COMPRESSION_NONE;
+        case TIFFCompressionDeflate : return COMPRESSION_ADOBE_DEFLATE;
+        case TIFFCompressionLZW     : return COMPRESSION_LZW;
+        case TIFFCompressionZSTD    : return COMPRESSION_ZSTD;
+    }
+
+    return COMPRESSION_NONE;
+}
+
+/// \brief Sets the tags describing the samples and the compression of a frame
+void setSampleTags(TIFF *image, size_t width, size_t length, int bitsPerSample, int sampleFormat,
+                   const TIFFWriteOptions &options)
+{
+    TIFFSetField(image, TIFFTAG_IMAGEWIDTH,      static_cast<uint32>(width));
+    TIFFSetField(image, TIFFTAG_IMAGELENGTH,     static_cast<uint32>(length));
+    TIFFSetField(image, TIFFTAG_BITSPERSAMPLE,   static_cast<uint16>(bitsPerSample));
+    TIFFSetField(image, TIFFTAG_SAMPLEFORMAT,    static_cast<uint16>(sampleFormat));
+    TIFFSetField(image, TIFFTAG_SAMPLESPERPIXEL, 1);
+    TIFFSetField(image, TIFFTAG_PHOTOMETRIC,     PHOTOMETRIC_MINISBLACK);
+    TIFFSetField(image, TIFFTAG_FILLORDER,       FILLORDER_MSB2LSB);
+    TIFFSetField(image, TIFFTAG_PLANARCONFIG,    PLANARCONFIG_CONTIG);
+    TIFFSetField(image, TIFFTAG_COMPRESSION,     compressionScheme(options.compression));
+
+    if ((options.compression!=TIFFCompressionNone) && options.predictor)
+        TIFFSetField(image, TIFFTAG_PREDICTOR,
+                     sampleFormat==SAMPLEFORMAT_IEEEFP ? PREDICTOR_FLOATINGPOINT : PREDICTOR_HORIZONTAL);
+}
+
+/// \brief Compresses one strip or tile with the libtiff encoder of the selected scheme
+/// \param chunk the pixels of the chunk, it is modified by the predictor
+/// \param layout the chunk geometry
+/// \param rows number of rows in the chunk
+/// \returns The encoded chunk
+std::vector<unsigned char> encodeChunk(std::vector<unsigned char> &chunk, const TIFFChunkLayout &layout, size_t rows,
+                                       int bitsPerSample, int sampleFormat, const TIFFWriteOptions &options)
+{
+    TIFFMemoryFile file;
+    file.pos=0;
 
+    TIFF *image=TIFFClientOpen("chunk","wm",reinterpret_cast<thandle_t>(&file),
+                               memoryRead,memoryWrite,memorySeek,memoryClose,memorySize,memoryMap,memoryUnmap);
 
+    if (image==nullptr)
+        throw kipl::base::KiplException("WriteTIFF: Could not create the compression buffer",__FILE__,__LINE__);
 
+    // A strip and a tile of the same size have the same encoding, the predictor works on rows of chunkWidth pixels
+    setSampleTags(image,layout.chunkWidth,rows,bitsPerSample,sampleFormat,options);
+    TIFFSetField(image, TIFFTAG_ROWSPERSTRIP, static_cast<uint32>(rows));
+
+    if (0<options.level) {
+        if (options.compression==TIFFCompressionDeflate)
+            TIFFSetField(image, TIFFTAG_ZIPQUALITY, options.level);
+        if (options.compression==TIFFCompressionZSTD)
+            TIFFSetField(image, TIFFTAG_ZSTD_LEVEL, options.level);
+    }
+
+    std::vector<unsigned char> encoded;
+    if (TIFFWriteEncodedStrip(image,0,chunk.data(),static_cast<tsize_t>(chunk.size()))!=-1) {
+        toff_t *offsets=nullptr;
+        toff_t *byteCounts=nullptr;
+
+        if (TIFFGetField(image,TIFFTAG_STRIPOFFSETS,&offsets) && TIFFGetField(image,TIFFTAG_STRIPBYTECOUNTS,&byteCounts))
+            encoded.assign(file.data.begin()+static_cast<ptrdiff_t>(offsets[0]),
+                           file.data.begin()+static_cast<ptrdiff_t>(offsets[0]+byteCounts[0]));
+    }
+
+    // The chunk is extracted from the memory file, there is no need to write the directory
+    TIFFCleanup(image);
+
+    if (encoded.empty())
+        throw kipl::base::KiplException("WriteTIFF: Failed to compress a strip",__FILE__,__LINE__);
+
+    return encoded;
+}
+
+/// \brief Copies a strip or tile from a frame, the tiles are zero padded at the borders
+/// \returns Number of rows in the chunk
+size_t extractChunk(const unsigned char *frame, const TIFFChunkLayout &layout, size_t idx, std::vector<unsigned char> &chunk)
+{
+    const size_t x0=(idx % layout.across)*layout.chunkWidth;
+    const size_t y0=(idx / layout.across)*layout.chunkRows;
+    const size_t rows=layout.tiled ? layout.chunkRows : std::min(layout.chunkRows,layout.length-y0);
+    const size_t validRows=std::min(rows,layout.length-y0);
+    const size_t validWidth=std::min(layout.chunkWidth,layout.width-x0);
+    const size_t rowBytes=layout.chunkWidth*layout.pixelBytes;
+
+    chunk.assign(rows*rowBytes,0);
+
+    for (size_t y=0; y<validRows; ++y)
+        std::copy_n(frame+((y0+y)*layout.width+x0)*layout.pixelBytes,
+                    validWidth*layout.pixelBytes,
+                    chunk.data()+y*rowBytes);
+
+    return rows;
+}
+
+}
+
+void KIPLSHARED_EXPORT WriteTIFFFrames(const char *fname, const void *data, const size_t *dims, size_t nFrames,
+                                       int bitsPerSample, int sampleFormat,
+                                       const kipl::base::ImageInfo &info,
+                                       const TIFFWriteOptions &options)
+{
+    std::ostringstream msg;
+
+    const uint16 scheme=compressionScheme(options.compression);
+    if ((options.compression!=TIFFCompressionNone) && (TIFFIsCODECConfigured(scheme)==0)) {
+        msg<<"WriteTIFF: The TIFF library doesn't support the compression "<<enum2string(options.compression);
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    TIFFChunkLayout layout;
+    layout.width      = dims[0];
+    layout.length     = dims[1];
+    layout.pixelBytes = static_cast<size_t>(bitsPerSample/8);
+    layout.tiled      = (options.tileSize[0]!=0) && (options.tileSize[1]!=0);
+
+    if (layout.tiled) {
+        if ((options.tileSize[0] % 16 !=0) || (options.tileSize[1] % 16 != 0)) {
+            msg<<"WriteTIFF: The tile size "<<options.tileSize[0]<<"x"<<options.tileSize[1]<<" is not a multiple of 16";
+            throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+        }
+        layout.chunkWidth = options.tileSize[0];
+        layout.chunkRows  = options.tileSize[1];
+    }
+    else {
+        layout.chunkWidth = layout.width;
+        if (options.rowsPerStrip!=0)
+            layout.chunkRows = std::min(options.rowsPerStrip,layout.length);
+        else if (options.compression==TIFFCompressionNone)
+            layout.chunkRows = layout.length;
+        else
+            layout.chunkRows = std::max(size_t(1),std::min(layout.length,cnCompressedStripBytes/(layout.width*layout.pixelBytes)));
+    }
+
+    layout.across = (layout.width+layout.chunkWidth-1)/layout.chunkWidth;
+    layout.down   = (layout.length+layout.chunkRows-1)/layout.chunkRows;
+
+    const size_t frameBytes=layout.width*layout.length*layout.pixelBytes;
+    const bool bigTIFF = options.bigTIFF || (cnBigTIFFLimit<static_cast<unsigned long long>(frameBytes)*nFrames);
+
+    TIFF *image;
+    if ((image = TIFFOpen(fname, bigTIFF ? "w8" : "w")) == nullptr) {
+        msg<<"WriteTIFF: Could not open "<<fname<<" for writing";
+        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+    }
+
+    kipl::base::ImageInfo frameInfo(info);
+    const unsigned char *pData=reinterpret_cast<const unsigned char *>(data);
+
+    // The frames are compressed in batches to bound the memory, all chunks of a batch are compressed in parallel
+    const size_t nChunks=layout.count();
+    size_t nBatchFrames=1;
+#ifdef _OPENMP
+    nBatchFrames=std::max(size_t(1),static_cast<size_t>(omp_get_max_threads())/nChunks);
+#endif
+    std::vector<std::vector<unsigned char> > encoded;
+
+    try {
+        for (size_t first=0; first<nFrames; first+=nBatchFrames) {
+            const size_t nBatch=std::min(nBatchFrames,nFrames-first);
+
+            if (options.compression!=TIFFCompressionNone) {
+                encoded.resize(nBatch*nChunks);
+                const ptrdiff_t nTasks=static_cast<ptrdiff_t>(nBatch*nChunks);
+                std::string errorMessage;
+
+                #pragma omp parallel
+                {
+                    std::vector<unsigned char> chunk;
+
+                    #pragma omp for schedule(dynamic)
+                    for (ptrdiff_t task=0; task<nTasks; ++task) {
+                        try {
+                            const size_t frame=first+task/nChunks;
+                            const size_t rows=extractChunk(pData+frame*frameBytes,layout,task % nChunks,chunk);
+                            encoded[task]=encodeChunk(chunk,layout,rows,bitsPerSample,sampleFormat,options);
+                        }
+                        catch (kipl::base::KiplException &e) {
+                            #pragma omp critical(WriteTIFFError)
+                            {
+                                errorMessage=e.what();
+                            }
+                        }
+                        catch (std::exception &e) {
+                            #pragma omp critical(WriteTIFFError)
+                            {
+                                errorMessage=e.what();
+                            }
+                        }
+                    }
+                }
+
+                if (!errorMessage.empty())
+                    throw kipl::base::KiplException(errorMessage,__FILE__,__LINE__);
+            }
+
+            for (size_t i=0; i<nBatch; ++i) {
+                setSampleTags(image,layout.width,layout.length,bitsPerSample,sampleFormat,options);
+                if (layout.tiled) {
+                    TIFFSetField(image, TIFFTAG_TILEWIDTH,  static_cast<uint32>(layout.chunkWidth));
+                    TIFFSetField(image, TIFFTAG_TILELENGTH, static_cast<uint32>(layout.chunkRows));
+                }
+                else
+                    TIFFSetField(image, TIFFTAG_ROWSPERSTRIP, static_cast<uint32>(layout.chunkRows));
+
+                TIFFSetField(image, TIFFTAG_RESOLUTIONUNIT, RESUNIT_CENTIMETER);
+                TIFFSetField(image, TIFFTAG_XRESOLUTION,    frameInfo.GetDPCMX());
+                TIFFSetField(image, TIFFTAG_YRESOLUTION,    frameInfo.GetDPCMY());
+
+                if (!frameInfo.sCopyright.empty())
+                    TIFFSetField(image, TIFFTAG_COPYRIGHT,  frameInfo.sCopyright.c_str());
+                if (!frameInfo.sArtist.empty())
+                    TIFFSetField(image, TIFFTAG_ARTIST,     frameInfo.sArtist.c_str());
+                if (!frameInfo.sSoftware.empty())
+                    TIFFSetField(image, TIFFTAG_SOFTWARE,   frameInfo.sSoftware.c_str());
+                if (!frameInfo.sDescription.empty())
+                    TIFFSetField(image, TIFFTAG_IMAGEDESCRIPTION, frameInfo.sDescription.c_str());
+
+                const unsigned char *pFrame=pData+(first+i)*frameBytes;
+                std::vector<unsigned char> chunk;
+
+                for (size_t c=0; c<nChunks; ++c) {
+                    tsize_t written=0;
+                    tsize_t expected=0;
+
+                    if (options.compression==TIFFCompressionNone) {
+                        extractChunk(pFrame,layout,c,chunk);
+                        expected=static_cast<tsize_t>(chunk.size());
+                        written = layout.tiled ? TIFFWriteRawTile(image,static_cast<ttile_t>(c),chunk.data(),expected)
+                                               : TIFFWriteRawStrip(image,static_cast<tstrip_t>(c),chunk.data(),expected);
+                    }
+                    else {
+                        std::vector<unsigned char> &buffer=encoded[i*nChunks+c];
+                        expected=static_cast<tsize_t>(buffer.size());
+                        written = layout.tiled ? TIFFWriteRawTile(image,static_cast<ttile_t>(c),buffer.data(),expected)
+                                               : TIFFWriteRawStrip(image,static_cast<tstrip_t>(c),buffer.data(),expected);
+                        std::vector<unsigned char>().swap(buffer);
+                    }
+
+                    if (written!=expected) {
+                        msg<<"WriteTIFF: Failed to write frame "<<first+i<<" of "<<fname;
+                        throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+                    }
+                }
+
+                if (TIFFWriteDirectory(image)==0) {
+                    msg<<"WriteTIFF: Failed to write the directory of frame "<<first+i<<" of "<<fname;
+                    throw kipl::base::KiplException(msg.str(),__FILE__,__LINE__);
+                }
+            }
+        }
+    }
+    catch (...) {
+        TIFFClose(image);
+        throw;
+    }
+
+    TIFFClose(image);
+}
 
 }}
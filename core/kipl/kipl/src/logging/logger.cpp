@@ -4,22 +4,140 @@
 #include <list>
 #include <iostream>
 #include <ctime>
+#include <chrono>
+#include <condition_variable>
+#include <thread>
 
 #include "../../include/kipl_global.h"
 #include "../../include/logging/logger.h"
 #include "../../include/base/KiplException.h"
+#include "../../include/containers/mpscringbuffer.h"
 
 namespace kipl { namespace logging {
 using namespace std;
 //std::ostream * Logger::LogTargets=& std::cout;
-Logger::LogLevel Logger::CurrentLogLevel=Logger::LogMessage;
+std::atomic<Logger::LogLevel> Logger::CurrentLogLevel(Logger::LogMessage);
 LogWriter ConsoleLogger;
 #ifdef MULTITARGETS
 #else
 LogWriter * Logger::LogTarget = &ConsoleLogger;
 #endif
 
-std::mutex Logger::m_LoggerMutex;
+std::recursive_mutex Logger::m_LoggerMutex;
+
+/// \brief Background writer for the asynchronous logging mode
+class AsyncLogSink
+{
+public:
+    struct Item {
+        Logger::LogLevel level;
+        std::string message;
+    };
+
+    AsyncLogSink(size_t capacity) :
+        m_Buffer(capacity),
+        m_nWritten(0),
+        m_WriterId(std::thread::id()),
+        m_bStop(false)
+    {
+        m_Thread=std::thread(&AsyncLogSink::Run,this);
+    }
+
+    /// \brief Writes the remaining messages and stops the writer thread
+    ~AsyncLogSink()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_WakeMutex);
+            m_bStop=true;
+        }
+        m_Wakeup.notify_one();
+        m_Thread.join();
+    }
+
+    void Push(Item &item)
+    {
+        // A full buffer makes the producers wait, messages are never dropped
+        while (!m_Buffer.Push(item)) {
+            // The writer can't wait for itself, e.g. when a log target logs a message
+            if (IsWriterThread()) {
+                Drain();
+            }
+            else {
+                m_Wakeup.notify_one();
+                std::this_thread::yield();
+            }
+        }
+        m_Wakeup.notify_one();
+    }
+
+    void Flush()
+    {
+        // A flush from a log target runs on the writer thread, the queue is written inline instead of waiting for the writer
+        if (IsWriterThread()) {
+            Drain();
+            return;
+        }
+
+        const size_t target=m_Buffer.Pushed();
+
+        while (m_nWritten.load(std::memory_order_acquire)<target) {
+            m_Wakeup.notify_one();
+            std::this_thread::yield();
+        }
+    }
+
+private:
+    bool IsWriterThread() const
+    {
+        return std::this_thread::get_id()==m_WriterId.load(std::memory_order_relaxed);
+    }
+
+    /// \brief Writes the queued messages, only called on the writer thread since the buffer has a single consumer
+    void Drain()
+    {
+        Item item;
+
+        while (m_Buffer.Pop(item)) {
+            Logger::WriteToTargets(item.level,item.message);
+            m_nWritten.fetch_add(1,std::memory_order_release);
+        }
+    }
+
+    void Run()
+    {
+        m_WriterId.store(std::this_thread::get_id());
+
+        for (;;) {
+            Drain();
+
+            std::unique_lock<std::mutex> lock(m_WakeMutex);
+            if (m_bStop && (m_Buffer.Popped()==m_Buffer.Pushed()))
+                break;
+
+            // The timeout covers a notification that arrives between the last pop and the wait
+            m_Wakeup.wait_for(lock,std::chrono::milliseconds(20));
+        }
+    }
+
+    kipl::containers::MPSCRingBuffer<Item> m_Buffer;
+    std::atomic<size_t> m_nWritten;
+    std::atomic<std::thread::id> m_WriterId;
+    bool m_bStop;
+    std::mutex m_WakeMutex;
+    std::condition_variable m_Wakeup;
+    std::thread m_Thread;
+};
+
+namespace {
+std::atomic<AsyncLogSink *> AsyncSink(nullptr); ///< The active sink, nullptr in synchronous mode
+std::atomic<int> ActiveProducers(0);           ///< Number of threads that are about to push to the sink
+std::mutex SinkMutex;                          ///< Serializes starting and stopping the sink
+
+/// Stops the sink at program exit, i.e. before the console writer is destroyed
+struct AsyncSinkShutdown {
+    ~AsyncSinkShutdown() { Logger::SetAsynchronous(false); }
+} SinkShutdown;
+}
 
 size_t LogWriter::Write(std::string str){
 	std::cout<<str;
@@ -59,6 +177,7 @@ Logger::Logger(std::string str, std::ostream & UNUSED(s))
 
 size_t Logger::AddLogTarget(LogWriter & lw)
 {
+    std::lock_guard<std::recursive_mutex> lock(m_LoggerMutex);
 #ifdef MULTITARGET
     if (((*(Logger::LogTargets.begin())) == &ConsoleLogger) && (Logger::LogTargets.size()==1))
         Logger::LogTargets.clear();
@@ -75,13 +194,47 @@ void Logger::SetLogLevel(LogLevel level)
 	Logger::CurrentLogLevel=level;
 }
 
+void Logger::SetAsynchronous(bool async, size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(SinkMutex);
+
+    AsyncLogSink *sink=AsyncSink.load();
+    if (async==(sink!=nullptr))
+        return;
+
+    if (async) {
+        AsyncSink.store(new AsyncLogSink(capacity));
+    }
+    else {
+        // New messages are written directly, the sink is deleted when the last producer has pushed its message
+        AsyncSink.store(nullptr);
+        while (ActiveProducers.load()!=0)
+            std::this_thread::yield();
+
+        delete sink;
+    }
+}
+
+bool Logger::IsAsynchronous()
+{
+    return AsyncSink.load()!=nullptr;
+}
+
+void Logger::Flush()
+{
+    ++ActiveProducers;
+    AsyncLogSink *sink=AsyncSink.load();
+    if (sink!=nullptr)
+        sink->Flush();
+    --ActiveProducers;
+}
+
 void Logger::operator()(LogLevel severity, std::string message)
 {	
-	std::ostringstream ostr;
-	ostr<<sLogOrigin<<": "<<message;
-	
-	WriteMessage(severity, ostr.str());
-	
+    if (!IsEnabled(severity))
+        return;
+
+    WriteMessage(severity, sLogOrigin+": "+message);
 }
 
 /// \brief Log a message
@@ -89,7 +242,8 @@ void Logger::operator()(LogLevel severity, std::string message)
 /// \param message A string containing the message
 void Logger::operator()(LogLevel severity, std::stringstream & message)
 {
-    operator ()(severity,message.str());
+    if (IsEnabled(severity))
+        operator ()(severity,message.str());
 }
 
 void Logger::error(const std::string message)
@@ -120,20 +274,40 @@ void Logger::debug(const std::string message)
 
 void Logger::WriteMessage(LogLevel s, std::string message)
 {
-    std::lock_guard<std::mutex> lock(m_LoggerMutex);
+    if (!IsEnabled(s))
+        return;
+
+    ++ActiveProducers;
+    AsyncLogSink *sink=AsyncSink.load();
+    if (sink!=nullptr) {
+        AsyncLogSink::Item item={s,std::move(message)};
+        sink->Push(item);
+
+        // Errors are often followed by an exception that terminates the program
+        if (s==LogError)
+            sink->Flush();
+    }
+    --ActiveProducers;
+
+    if (sink==nullptr)
+        WriteToTargets(s,message);
+}
+
+void Logger::WriteToTargets(LogLevel s, const std::string &message)
+{
+    stringstream msg;
+    msg<<"["<<s<<"] "<<message<<std::endl;
 
-	if (s<=CurrentLogLevel) {
-		stringstream msg;
-		msg<<"["<<s<<"] "<<message<<std::endl;
+    // The mutex is recursive since a log target may flush the asynchronous queue, which writes to the targets again
+    std::lock_guard<std::recursive_mutex> lock(m_LoggerMutex);
 #ifdef MULTITARGET
-        std::list<kipl::logging::LogWriter *>::iterator it;
-        for (it=Logger::LogTargets.begin(); it!=Logger::LogTargets.end(); it++) {
-            (*it)->Write(msg.str());
-        }
+    std::list<kipl::logging::LogWriter *>::iterator it;
+    for (it=Logger::LogTargets.begin(); it!=Logger::LogTargets.end(); it++) {
+        (*it)->Write(msg.str());
+    }
 #else
-        Logger::LogTarget->Write(msg.str());
+    Logger::LogTarget->Write(msg.str());
 #endif
-	}
 }
 	
 }}
@@ -2,15 +2,55 @@
 #include <cmath>
 #include <sstream>
 #include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cstddef>
 
 #include "../../include/math/circularhoughtransform.h"
 #include "../../include/drawing/drawing.h"
 #include "../../include/filters/filter.h"
 #include "../../include/math/sums.h"
 #include "../../include/io/io_tiff.h"
+#include "../../include/fft/fftbase.h"
+#include "../../include/base/KiplException.h"
 
 namespace kipl { namespace math {
 
+namespace {
+
+/// \brief Maps an index outside [0,n) into the image by mirroring about the edge pixels
+ptrdiff_t mirrorIndex(ptrdiff_t i, ptrdiff_t n)
+{
+    if (n<2)
+        return 0;
+
+    const ptrdiff_t period=2*(n-1);
+
+    i%=period;
+    if (i<0)
+        i+=period;
+
+    return i<n ? i : period-i;
+}
+
+/// \brief Finds the smallest transform length not less than n with only small prime factors
+size_t fftFriendlySize(size_t n)
+{
+    const size_t factors[4]={2,3,5,7};
+
+    for ( ; ; ++n) {
+        size_t m=n;
+        for (size_t f : factors)
+            while (m%f==0)
+                m/=f;
+
+        if (m==1)
+            return n;
+    }
+}
+
+}
+
 CircularHoughTransform::CircularHoughTransform() :
     logger("CircularHoughTransform")
 {
@@ -19,45 +59,133 @@ CircularHoughTransform::CircularHoughTransform() :
 
 kipl::base::TImage<float,2> CircularHoughTransform::operator()(kipl::base::TImage<float,2> img, float radius, bool useDerivative)
 {
+    std::vector<float> radii(1,radius);
+    kipl::base::TImage<float,2> bestRadius;
+
+    return (*this)(img,radii,bestRadius,useDerivative);
+}
+
+kipl::base::TImage<float,2> CircularHoughTransform::operator()(kipl::base::TImage<float,2> img,
+                                                               const std::vector<float> &radii,
+                                                               kipl::base::TImage<float,2> &bestRadius,
+                                                               bool useDerivative)
+{
+    if (radii.empty())
+        throw kipl::base::KiplException("No radii were given to the circular Hough transform",__FILE__,__LINE__);
+
+    if (*std::min_element(radii.begin(),radii.end())<=0.0f)
+        throw kipl::base::KiplException("The circular Hough transform radii must be positive",__FILE__,__LINE__);
+
     m_Img.Clone(img);
     absDerivative(useDerivative);
 
-    buildKernel(radius);
+    // The padding covers the widest ring kernel, the periodic wrap of the correlation only touches the padding
+    const ptrdiff_t pad = static_cast<ptrdiff_t>(ceil(*std::max_element(radii.begin(),radii.end())+1));
+    const ptrdiff_t nx  = static_cast<ptrdiff_t>(m_Img.Size(0));
+    const ptrdiff_t ny  = static_cast<ptrdiff_t>(m_Img.Size(1));
 
-    kipl::filters::TFilter<float,2> cht(ringKernel.GetDataPtr(),ringKernel.Dims());
+    size_t fftDims[2]={fftFriendlySize(nx+2*pad), fftFriendlySize(ny+2*pad)};
+    const ptrdiff_t px = static_cast<ptrdiff_t>(fftDims[0]);
+    const ptrdiff_t py = static_cast<ptrdiff_t>(fftDims[1]);
+    const ptrdiff_t N  = px*py;
 
-    kipl::base::TImage<float,2> chtmap=cht(m_Img,kipl::filters::FilterBase::EdgeMirror);
+    std::ostringstream msg;
+    msg<<"Transforming "<<radii.size()<<" radii on a "<<px<<"x"<<py<<" grid";
+    logger(logger.LogMessage,msg.str());
 
-    return chtmap;
-}
+    std::vector<std::complex<float> > spectrum(N);
+    std::vector<std::complex<float> > buffer(N);
 
-void CircularHoughTransform::buildKernel(float radius)
-{
-    int N=ceil(radius+1)*2+1;
-    int C=N/2;
-    size_t dims[2]={static_cast<size_t>(N),static_cast<size_t>(N)};
+    #pragma omp parallel for
+    for (ptrdiff_t y=0; y<py; ++y) {
+        const float *pLine = m_Img.GetLinePtr(mirrorIndex(y-pad,ny));
+        std::complex<float> *pPadded = buffer.data()+y*px;
 
-    ringKernel.Resize(dims);
+        for (ptrdiff_t x=0; x<px; ++x)
+            pPadded[x]=pLine[mirrorIndex(x-pad,nx)];
+    }
 
-    int i=0;
-    float sum=0.0f;
+    kipl::math::fft::FFTBaseFloat fft(fftDims,2);
+    fft(buffer.data(),spectrum.data(),-1);
+
+    kipl::base::TImage<float,2> chtmap(m_Img.Dims());
+    bestRadius.Resize(m_Img.Dims());
+    std::fill_n(chtmap.GetDataPtr(),chtmap.Size(),-std::numeric_limits<float>::max());
+    std::fill_n(bestRadius.GetDataPtr(),bestRadius.Size(),0.0f);
+
+    const float scale=1.0f/static_cast<float>(N);
+
+    for (size_t i=0; i<radii.size(); i+=2) {
+        const bool havePair = i+1<radii.size();
+
+        std::fill(buffer.begin(),buffer.end(),std::complex<float>(0.0f,0.0f));
+        addRingKernel(radii[i],fftDims,buffer.data(),false);
+        if (havePair)
+            addRingKernel(radii[i+1],fftDims,buffer.data(),true);
+
+        // Both kernels are real and even, their spectra are real and the responses are the real and imaginary parts
+        fft(buffer.data(),buffer.data(),-1);
+
+        #pragma omp parallel for
+        for (ptrdiff_t j=0; j<N; ++j)
+            buffer[j]*=spectrum[j];
+
+        fft(buffer.data(),buffer.data(),1);
+
+        #pragma omp parallel for
+        for (ptrdiff_t y=0; y<ny; ++y) {
+            const std::complex<float> *pResponse = buffer.data()+(y+pad)*px+pad;
+            float *pMap  = chtmap.GetLinePtr(y);
+            float *pBest = bestRadius.GetLinePtr(y);
+
+            for (ptrdiff_t x=0; x<nx; ++x) {
+                const float a=pResponse[x].real()*scale;
+                if (pMap[x]<a) {
+                    pMap[x]  = a;
+                    pBest[x] = radii[i];
+                }
+
+                if (havePair) {
+                    const float b=pResponse[x].imag()*scale;
+                    if (pMap[x]<b) {
+                        pMap[x]  = b;
+                        pBest[x] = radii[i+1];
+                    }
+                }
+            }
+        }
+    }
 
-    for (int y=0; y<N; ++y) {
-        float y2=(y-C)*(y-C);
+    return chtmap;
+}
 
-        for (int x=0; x<N; ++x, ++i) {
-            ringKernel[i]=abs(sqrt((x-C)*(x-C)+y2)-radius)<0.5f;
-            sum+=ringKernel[i];
+void CircularHoughTransform::addRingKernel(float radius, const size_t *dims, std::complex<float> *kernel, bool imaginary)
+{
+    const int C=static_cast<int>(ceil(radius+1));
+    const ptrdiff_t px=static_cast<ptrdiff_t>(dims[0]);
+    const ptrdiff_t py=static_cast<ptrdiff_t>(dims[1]);
+
+    std::vector<ptrdiff_t> ring;
+    for (int y=-C; y<=C; ++y) {
+        for (int x=-C; x<=C; ++x) {
+            if (fabs(sqrt(static_cast<float>(x*x+y*y))-radius)<0.5f)
+                ring.push_back(((y+py)%py)*px+(x+px)%px);
         }
     }
 
-    for (size_t i=0; i<ringKernel.Size(); ++i)
-        ringKernel[i]/=sum;
+    const float w=1.0f/static_cast<float>(ring.size());
+
+    for (auto idx : ring) {
+        if (imaginary)
+            kernel[idx].imag(w);
+        else
+            kernel[idx].real(w);
+    }
 
     std::ostringstream msg;
 
-    msg<<"Kernel info: "<<ringKernel;
-    logger(logger.LogMessage,msg.str());
+    msg<<"Ring kernel r="<<radius<<" with "<<ring.size()<<" pixels";
+    logger(logger.LogVerbose,msg.str());
 }
 
 void CircularHoughTransform::absDerivative(bool useDerivative)
@@ -0,0 +1,306 @@
+//<LICENCE>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "../../include/math/volumestatistics.h"
+
+namespace kipl { namespace math {
+
+namespace {
+
+/// Floor division by two, also for negative bin indices
+inline long long halfIndex(long long g)
+{
+    return 0<=g ? g/2 : -((1-g)/2);
+}
+
+inline long long binIndex(double x, double scale)
+{
+    return static_cast<long long>(std::floor(x*scale));
+}
+
+}
+
+VolumeStatistics::VolumeStatistics(size_t nBins) :
+    m_Histogram(std::max(static_cast<size_t>(4),nBins+(nBins & 1)),0)
+{
+    reset();
+}
+
+void VolumeStatistics::reset()
+{
+    m_nCount    = 0;
+    m_fMin      = std::numeric_limits<double>::max();
+    m_fMax      = -std::numeric_limits<double>::max();
+    m_fMean     = 0.0;
+    m_fM2       = 0.0;
+    m_nExponent = 0;
+    m_nFirst    = 0;
+    std::fill(m_Histogram.begin(),m_Histogram.end(),0);
+}
+
+void VolumeStatistics::put(float const * const data, size_t N)
+{
+    // The chunks stay in the L1 cache between the min/max pass and the binning pass
+    const size_t nChunk=4096;
+    const size_t nBins=m_Histogram.size();
+
+    for (size_t start=0; start<N; start+=nChunk) {
+        float const * const pChunk=data+start;
+        const size_t nLength=std::min(nChunk,N-start);
+
+        size_t cnt=0;
+        double sum=0.0;
+        float cmin=std::numeric_limits<float>::max();
+        float cmax=-std::numeric_limits<float>::max();
+
+        for (size_t i=0; i<nLength; i++) {
+            const float x=pChunk[i];
+            if (std::isfinite(x)) {
+                cmin=std::min(cmin,x);
+                cmax=std::max(cmax,x);
+                sum+=x;
+                cnt++;
+            }
+        }
+
+        if (cnt==0)
+            continue;
+
+        fitRange(cmin,cmax);
+
+        const double scale=std::ldexp(1.0,-m_nExponent);
+        const double cmean=sum/cnt;
+        double m2=0.0;
+        size_t *pHist=m_Histogram.data();
+
+        for (size_t i=0; i<nLength; i++) {
+            const float x=pChunk[i];
+            if (std::isfinite(x)) {
+                const double d=x-cmean;
+                m2+=d*d;
+                const long long idx=binIndex(x,scale)-m_nFirst;
+                pHist[std::min(static_cast<size_t>(std::max(idx,0LL)),nBins-1)]++;
+            }
+        }
+
+        const double n=static_cast<double>(m_nCount+cnt);
+        const double delta=cmean-m_fMean;
+        m_fMean += delta*cnt/n;
+        m_fM2   += m2+delta*delta*(static_cast<double>(m_nCount)*cnt/n);
+        m_nCount+=cnt;
+        m_fMin=std::min(m_fMin,static_cast<double>(cmin));
+        m_fMax=std::max(m_fMax,static_cast<double>(cmax));
+    }
+}
+
+void VolumeStatistics::merge(const VolumeStatistics &s)
+{
+    if (s.m_nCount==0)
+        return;
+
+    VolumeStatistics other(s);
+
+    // Bring both histograms to the same bin width and a common range
+    if (m_nCount==0)
+        fitRange(s.m_fMin,s.m_fMax);
+
+    while (m_nExponent<other.m_nExponent)
+        coarsen();
+
+    if (m_nCount!=0)
+        fitRange(other.m_fMin,other.m_fMax);
+
+    while (other.m_nExponent<m_nExponent)
+        other.coarsen();
+
+    const size_t nBins=m_Histogram.size();
+    for (size_t i=0; i<other.m_Histogram.size(); i++) {
+        if (other.m_Histogram[i]!=0) {
+            const long long idx=other.m_nFirst+static_cast<long long>(i)-m_nFirst;
+            m_Histogram[std::min(static_cast<size_t>(std::max(idx,0LL)),nBins-1)]+=other.m_Histogram[i];
+        }
+    }
+
+    const double n=static_cast<double>(m_nCount+s.m_nCount);
+    const double delta=s.m_fMean-m_fMean;
+    m_fMean += delta*s.m_nCount/n;
+    m_fM2   += s.m_fM2+delta*delta*(static_cast<double>(m_nCount)*s.m_nCount/n);
+    m_nCount+=s.m_nCount;
+    m_fMin=std::min(m_fMin,s.m_fMin);
+    m_fMax=std::max(m_fMax,s.m_fMax);
+}
+
+double VolumeStatistics::Min() const
+{
+    return m_nCount==0 ? 0.0 : m_fMin;
+}
+
+double VolumeStatistics::Max() const
+{
+    return m_nCount==0 ? 0.0 : m_fMax;
+}
+
+double VolumeStatistics::E() const
+{
+    return m_fMean;
+}
+
+double VolumeStatistics::V() const
+{
+    return m_nCount==0 ? 0.0 : m_fM2/m_nCount;
+}
+
+double VolumeStatistics::s() const
+{
+    return std::sqrt(V());
+}
+
+double VolumeStatistics::Percentile(double p) const
+{
+    if (m_nCount==0)
+        return 0.0;
+
+    const double target=std::min(std::max(p,0.0),100.0)*m_nCount/100.0;
+    const double w=binWidth();
+
+    double cumulated=0.0;
+    for (size_t i=0; i<m_Histogram.size(); i++) {
+        const double cnt=static_cast<double>(m_Histogram[i]);
+        if ((cnt!=0.0) && (target<=cumulated+cnt)) {
+            const double value=(m_nFirst+static_cast<double>(i)+(target-cumulated)/cnt)*w;
+            return std::min(std::max(value,m_fMin),m_fMax);
+        }
+        cumulated+=cnt;
+    }
+
+    return m_fMax;
+}
+
+void VolumeStatistics::GrayInterval(float percentage, float &lo, float &hi) const
+{
+    const double fraction=(100.0-percentage)/200.0;
+
+    lo=static_cast<float>(Percentile(100.0*fraction));
+    hi=static_cast<float>(Percentile(100.0*(1.0-fraction)));
+}
+
+void VolumeStatistics::GetHistogram(float *axis, size_t *hist, size_t nBins) const
+{
+    std::fill_n(hist,nBins,0);
+
+    const double lo=Min();
+    const double step=(Max()-lo)/nBins;
+
+    for (size_t i=0; i<nBins; i++)
+        axis[i]=static_cast<float>(lo+(i+0.5)*step);
+
+    if (m_nCount==0)
+        return;
+
+    const double w=binWidth();
+    for (size_t i=0; i<m_Histogram.size(); i++) {
+        if (m_Histogram[i]==0)
+            continue;
+
+        size_t idx=0;
+        if (0.0<step) {
+            const double center=std::min(std::max((m_nFirst+i+0.5)*w,m_fMin),m_fMax);
+            idx=std::min(nBins-1,static_cast<size_t>((center-lo)/step));
+        }
+        hist[idx]+=m_Histogram[i];
+    }
+}
+
+double VolumeStatistics::binWidth() const
+{
+    return std::ldexp(1.0,m_nExponent);
+}
+
+double VolumeStatistics::binStart() const
+{
+    return m_nFirst*binWidth();
+}
+
+void VolumeStatistics::fitRange(double lo, double hi)
+{
+    const long long nBins=static_cast<long long>(m_Histogram.size());
+    // Keeps the bin indices far from the integer limits
+    const double fMaxIndex=std::ldexp(1.0,52);
+    const double fMagnitude=std::max(std::fabs(lo),std::fabs(hi));
+
+    if (m_nCount==0) {
+        const double span=hi-lo;
+        if (0.0<span)
+            m_nExponent=std::ilogb(span/(nBins-2))+1;
+        else
+            m_nExponent=std::ilogb(std::max(fMagnitude,1e-30))-24;
+
+        while ((fMaxIndex<std::ldexp(fMagnitude,-m_nExponent)) ||
+               (nBins<=binIndex(hi,std::ldexp(1.0,-m_nExponent))-binIndex(lo,std::ldexp(1.0,-m_nExponent))))
+            m_nExponent++;
+
+        m_nFirst=binIndex(lo,std::ldexp(1.0,-m_nExponent));
+        std::fill(m_Histogram.begin(),m_Histogram.end(),0);
+        return;
+    }
+
+    for (;;) {
+        const double scale=std::ldexp(1.0,-m_nExponent);
+        if (fMaxIndex<fMagnitude*scale) {
+            coarsen();
+            continue;
+        }
+
+        const long long klo=binIndex(lo,scale);
+        const long long khi=binIndex(hi,scale);
+
+        if ((m_nFirst<=klo) && (khi<m_nFirst+nBins))
+            return;
+
+        // The occupied bins may allow to move the window without changing the bin width
+        const long long ulo=std::min(klo,binIndex(m_fMin,scale));
+        const long long uhi=std::max(khi,binIndex(m_fMax,scale));
+
+        if (uhi-ulo<nBins) {
+            const long long first = klo<m_nFirst ? ulo : uhi-nBins+1;
+            std::vector<size_t> shifted(m_Histogram.size(),0);
+            for (long long i=0; i<nBins; i++) {
+                if (m_Histogram[i]!=0)
+                    shifted[m_nFirst+i-first]=m_Histogram[i];
+            }
+            m_Histogram.swap(shifted);
+            m_nFirst=first;
+            return;
+        }
+
+        coarsen();
+    }
+}
+
+void VolumeStatistics::coarsen()
+{
+    const long long first=halfIndex(m_nFirst);
+    std::vector<size_t> coarse(m_Histogram.size(),0);
+
+    for (size_t i=0; i<m_Histogram.size(); i++)
+        coarse[halfIndex(m_nFirst+static_cast<long long>(i))-first]+=m_Histogram[i];
+
+    m_Histogram.swap(coarse);
+    m_nFirst=first;
+    m_nExponent++;
+}
+
+}}
+
+std::ostream & operator<<(std::ostream &s, const kipl::math::VolumeStatistics &stats)
+{
+    s<<"n="<<stats.n()<<std::endl;
+    s<<"min="<<stats.Min()<<", max="<<stats.Max()<<std::endl;
+    s<<"E="<<stats.E()<<std::endl;
+    s<<"s="<<stats.s()<<std::endl;
+
+    return s;
+}
@@ -0,0 +1,155 @@
+//<LICENCE>
+
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+#include "../../include/morphology/palagyi_skeleton.h"
+
+namespace kipl { namespace morphology {
+
+namespace {
+
+/// \brief Builds a mask from neighborhood positions n[i][j][k] given as strings "ijk"
+unsigned int templateMask(std::initializer_list<const char *> positions)
+{
+    unsigned int mask=0;
+    for (auto pos : positions)
+        mask|=1u<<PalagyiTableBit(9*(pos[0]-'0')+3*(pos[1]-'0')+(pos[2]-'0'));
+
+    return mask;
+}
+
+/// \brief A thinning template for the UP_SOUTH direction, the center voxel is always object
+struct ThinningTemplate {
+    unsigned int ones;       ///< Voxels that must be object
+    unsigned int zeros;      ///< Voxels that must be background
+    unsigned int any;        ///< At least one of these voxels must be object, ignored if empty
+    unsigned int notBoth[2]; ///< Pairs of voxels that must not both be object
+    unsigned int exactlyOne; ///< Pair of voxels of which exactly one must be object
+
+    bool matches(unsigned int x) const
+    {
+        if (((x & ones)!=ones) || ((x & zeros)!=0))
+            return false;
+
+        if ((any!=0) && ((x & any)==0))
+            return false;
+
+        for (auto pair : notBoth)
+            if ((pair!=0) && ((x & pair)==pair))
+                return false;
+
+        if ((exactlyOne!=0) && (((x & exactlyOne)==0) || ((x & exactlyOne)==exactlyOne)))
+            return false;
+
+        return true;
+    }
+};
+
+/// The templates T1-T14 of Palagyi and Kuba, as they were matched voxel by voxel before
+std::vector<ThinningTemplate> thinningTemplates()
+{
+    std::vector<ThinningTemplate> t(14,ThinningTemplate{0,0,0,{0,0},0});
+
+    // T1
+    t[0].ones  = templateMask({"110"});
+    t[0].zeros = templateMask({"002","102","202","012","112","212","022","122","222"});
+    t[0].any   = templateMask({"000","100","200","010","210","020","120","220",
+                               "001","101","201","011","211","021","121","221"});
+    // T2
+    t[1].ones  = templateMask({"121"});
+    t[1].zeros = templateMask({"000","100","200","001","101","201","002","102","202"});
+    t[1].any   = templateMask({"010","110","210","011","211","012","112","212",
+                               "020","120","220","021","221","022","122","222"});
+    // T3
+    t[2].ones  = templateMask({"120"});
+    t[2].zeros = templateMask({"000","100","200","001","101","201","002","102","202",
+                               "012","112","212","022","122","222"});
+    t[2].any   = templateMask({"010","020","210","220","011","021","211","221"});
+    // T4
+    t[3].ones       = templateMask({"110","121"});
+    t[3].zeros      = templateMask({"101","002","102","202","112"});
+    t[3].notBoth[0] = templateMask({"001","012"});
+    t[3].notBoth[1] = templateMask({"201","212"});
+    // T5
+    t[4].ones       = templateMask({"110","121","202"});
+    t[4].zeros      = templateMask({"101","002","102","112"});
+    t[4].notBoth[0] = templateMask({"001","012"});
+    t[4].exactlyOne = templateMask({"201","212"});
+    // T6
+    t[5].ones       = templateMask({"110","121","002"});
+    t[5].zeros      = templateMask({"101","102","202","112"});
+    t[5].exactlyOne = templateMask({"001","012"});
+    t[5].notBoth[0] = templateMask({"201","212"});
+    // T7
+    t[6].ones       = templateMask({"110","121","211"});
+    t[6].zeros      = templateMask({"101","002","102","112"});
+    t[6].notBoth[0] = templateMask({"001","012"});
+    // T8
+    t[7].ones       = templateMask({"110","121","011"});
+    t[7].zeros      = templateMask({"101","102","202","112"});
+    t[7].notBoth[0] = templateMask({"201","212"});
+    // T9
+    t[8].ones       = templateMask({"110","121","211","002"});
+    t[8].zeros      = templateMask({"101","102","112"});
+    t[8].exactlyOne = templateMask({"001","012"});
+    // T10
+    t[9].ones       = templateMask({"110","011","121","202"});
+    t[9].zeros      = templateMask({"101","102","112"});
+    t[9].exactlyOne = templateMask({"201","212"});
+    // T11
+    t[10].ones  = templateMask({"210","120"});
+    t[10].zeros = templateMask({"000","100","001","101","002","102","202",
+                                "012","112","212","022","122","222"});
+    // T12
+    t[11].ones  = templateMask({"010","120"});
+    t[11].zeros = templateMask({"100","200","101","201","002","102","202",
+                                "012","112","212","022","122","222"});
+    // T13
+    t[12].ones  = templateMask({"120","221"});
+    t[12].zeros = templateMask({"000","100","200","001","101","201","002","102","202",
+                                "012","112","022","122"});
+    // T14
+    t[13].ones  = templateMask({"120","021"});
+    t[13].zeros = templateMask({"000","100","200","001","101","201","002","102","202",
+                                "112","212","122","222"});
+
+    return t;
+}
+
+std::vector<unsigned long long> buildDeletableTable()
+{
+    const std::vector<ThinningTemplate> templates=thinningTemplates();
+    const ptrdiff_t nWords=static_cast<ptrdiff_t>((1u<<26)/64);
+    std::vector<unsigned long long> table(nWords,0ULL);
+
+    #pragma omp parallel for
+    for (ptrdiff_t w=0; w<nWords; ++w) {
+        unsigned long long word=0ULL;
+        for (unsigned int b=0; b<64; ++b) {
+            const unsigned int x=static_cast<unsigned int>(w*64+b);
+            for (const auto &t : templates) {
+                if (t.matches(x)) {
+                    word|=1ULL<<b;
+                    break;
+                }
+            }
+        }
+        table[w]=word;
+    }
+
+    return table;
+}
+
+}
+
+const std::vector<unsigned long long> & PalagyiDeletableTable()
+{
+    // Built once on first use, the initialization of a local static is thread safe
+    static const std::vector<unsigned long long> table=buildDeletableTable();
+
+    return table;
+}
+
+}}
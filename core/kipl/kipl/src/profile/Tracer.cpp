@@ -0,0 +1,345 @@
+//<LICENCE>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include "../../include/profile/Tracer.h"
+#include "../../include/base/KiplException.h"
+
+namespace kipl { namespace profile {
+
+namespace {
+
+struct TraceEvent
+{
+    std::string name;
+    std::string category;
+    char   phase;    ///< 'X' for complete spans and 'C' for counters as in the chrome trace format
+    double ts;       ///< Start time in microseconds since the trace clock start
+    double duration; ///< Span duration in microseconds
+    double value;    ///< Counter value
+    int    tid;
+};
+
+struct TraceStorage
+{
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    std::map<std::thread::id,int> threads;
+    Tracer::TimePoint origin = std::chrono::high_resolution_clock::now();
+
+    int threadIndex()
+    {
+        auto it=threads.find(std::this_thread::get_id());
+        if (it!=threads.end())
+            return it->second;
+
+        int idx=static_cast<int>(threads.size());
+        threads[std::this_thread::get_id()]=idx;
+
+        return idx;
+    }
+};
+
+TraceStorage & storage()
+{
+    static TraceStorage s;
+
+    return s;
+}
+
+std::string escapeJSON(const std::string &str)
+{
+    std::ostringstream s;
+    for (const char &c : str)
+    {
+        switch (c)
+        {
+        case '"'  : s<<"\\\""; break;
+        case '\\' : s<<"\\\\"; break;
+        case '\n' : s<<"\\n";  break;
+        case '\t' : s<<"\\t";  break;
+        default:
+            if (static_cast<unsigned char>(c)<0x20)
+                s<<"\\u"<<std::hex<<std::setw(4)<<std::setfill('0')<<static_cast<int>(c)<<std::dec;
+            else
+                s<<c;
+        }
+    }
+
+    return s.str();
+}
+
+struct Statistics
+{
+    size_t cnt = 0;
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+
+    void add(double x)
+    {
+        ++cnt;
+        sum += x;
+        min  = std::min(min,x);
+        max  = std::max(max,x);
+    }
+};
+
+}
+
+std::atomic<bool> Tracer::s_bEnabled(false);
+
+void Tracer::enable(bool on)
+{
+    TraceStorage &s=storage();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    if (on && s.events.empty())
+        s.origin=std::chrono::high_resolution_clock::now();
+
+    s_bEnabled.store(on);
+}
+
+void Tracer::clear()
+{
+    TraceStorage &s=storage();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    s.events.clear();
+    s.threads.clear();
+    s.origin=std::chrono::high_resolution_clock::now();
+}
+
+void Tracer::addSpan(const std::string &name, const std::string &category, TimePoint start, TimePoint stop)
+{
+    if (!enabled())
+        return;
+
+    TraceStorage &s=storage();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    TraceEvent e;
+    e.name     = name;
+    e.category = category;
+    e.phase    = 'X';
+    e.ts       = std::chrono::duration<double,std::micro>(start-s.origin).count();
+    e.duration = std::chrono::duration<double,std::micro>(stop-start).count();
+    e.value    = 0.0;
+    e.tid      = s.threadIndex();
+
+    s.events.push_back(e);
+}
+
+void Tracer::addCounter(const std::string &name, double value)
+{
+    if (!enabled())
+        return;
+
+    TimePoint now=std::chrono::high_resolution_clock::now();
+    TraceStorage &s=storage();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    TraceEvent e;
+    e.name     = name;
+    e.phase    = 'C';
+    e.ts       = std::chrono::duration<double,std::micro>(now-s.origin).count();
+    e.duration = 0.0;
+    e.value    = value;
+    e.tid      = s.threadIndex();
+
+    s.events.push_back(e);
+}
+
+void Tracer::writeChromeTrace(const std::string &fname)
+{
+    std::ofstream file(fname.c_str());
+
+    if (!file.is_open())
+        throw kipl::base::KiplException("Could not open the trace file "+fname,__FILE__,__LINE__);
+
+    TraceStorage &s=storage();
+    std::lock_guard<std::mutex> lock(s.mutex);
+
+    file<<"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file<<std::fixed<<std::setprecision(3);
+    bool first=true;
+    for (const auto &e : s.events)
+    {
+        if (!first)
+            file<<",\n";
+        first=false;
+
+        file<<"{\"name\":\""<<escapeJSON(e.name)<<"\",\"ph\":\""<<e.phase<<"\",\"pid\":1,\"tid\":"<<e.tid
+            <<",\"ts\":"<<e.ts;
+
+        if (e.phase=='X')
+            file<<",\"dur\":"<<e.duration<<",\"cat\":\""<<escapeJSON(e.category)<<"\"}";
+        else
+            file<<",\"args\":{\"value\":"<<e.value<<"}}";
+    }
+    file<<"\n]}\n";
+}
+
+std::string Tracer::summary()
+{
+    std::map<std::string,Statistics> spans;
+    std::map<std::string,Statistics> counters;
+    std::vector<std::string> spanOrder;
+    std::vector<std::string> counterOrder;
+
+    {
+        TraceStorage &s=storage();
+        std::lock_guard<std::mutex> lock(s.mutex);
+
+        for (const auto &e : s.events)
+        {
+            if (e.phase=='X')
+            {
+                if (spans.find(e.name)==spans.end())
+                    spanOrder.push_back(e.name);
+                spans[e.name].add(e.duration*1e-3);
+            }
+            else
+            {
+                if (counters.find(e.name)==counters.end())
+                    counterOrder.push_back(e.name);
+                counters[e.name].add(e.value);
+            }
+        }
+    }
+
+    size_t width=24;
+    for (const auto &name : spanOrder)
+        width=std::max(width,name.size()+2);
+    for (const auto &name : counterOrder)
+        width=std::max(width,name.size()+2);
+
+    std::ostringstream s;
+    s<<std::fixed<<std::setprecision(2);
+
+    s<<std::left<<std::setw(width)<<"Span"<<std::right
+     <<std::setw(8)<<"count"
+     <<std::setw(14)<<"total [ms]"
+     <<std::setw(14)<<"mean [ms]"
+     <<std::setw(14)<<"min [ms]"
+     <<std::setw(14)<<"max [ms]"<<"\n";
+
+    for (const auto &name : spanOrder)
+    {
+        const Statistics &st=spans[name];
+        s<<std::left<<std::setw(width)<<name<<std::right
+         <<std::setw(8)<<st.cnt
+         <<std::setw(14)<<st.sum
+         <<std::setw(14)<<st.sum/st.cnt
+         <<std::setw(14)<<st.min
+         <<std::setw(14)<<st.max<<"\n";
+    }
+
+    if (!counterOrder.empty())
+    {
+        s<<"\n"<<std::left<<std::setw(width)<<"Counter"<<std::right
+         <<std::setw(8)<<"samples"
+         <<std::setw(14)<<"sum"
+         <<std::setw(14)<<"mean"
+         <<std::setw(14)<<"min"
+         <<std::setw(14)<<"max"<<"\n";
+
+        s<<std::setprecision(4)<<std::scientific;
+        for (const auto &name : counterOrder)
+        {
+            const Statistics &st=counters[name];
+            s<<std::left<<std::setw(width)<<name<<std::right
+             <<std::setw(8)<<st.cnt
+             <<std::setw(14)<<st.sum
+             <<std::setw(14)<<st.sum/st.cnt
+             <<std::setw(14)<<st.min
+             <<std::setw(14)<<st.max<<"\n";
+        }
+    }
+
+    return s.str();
+}
+
+TraceSpan::TraceSpan(const std::string &name, const std::string &category) :
+    m_bActive(Tracer::enabled())
+{
+    if (m_bActive)
+    {
+        m_sName     = name;
+        m_sCategory = category;
+        m_Start     = std::chrono::high_resolution_clock::now();
+    }
+}
+
+TraceSpan::~TraceSpan()
+{
+    stop();
+}
+
+double TraceSpan::stop()
+{
+    if (!m_bActive)
+        return 0.0;
+
+    m_bActive=false;
+    Tracer::TimePoint now=std::chrono::high_resolution_clock::now();
+    Tracer::addSpan(m_sName,m_sCategory,m_Start,now);
+
+    return std::chrono::duration<double>(now-m_Start).count();
+}
+
+TraceArguments::TraceArguments() :
+    logger("TraceArguments"),
+    m_bSummary(false)
+{
+}
+
+bool TraceArguments::setup(const std::vector<std::string> &args)
+{
+    const std::string fileArg("trace:file=");
+
+    for (const auto &arg : args)
+    {
+        if (arg.find(fileArg)==0)
+            m_sTraceFile=arg.substr(fileArg.size());
+
+        if (arg=="trace:summary=true")
+            m_bSummary=true;
+    }
+
+    if (m_sTraceFile.empty() && !m_bSummary)
+        return false;
+
+    Tracer::clear();
+    Tracer::enable(true);
+
+    return true;
+}
+
+void TraceArguments::report()
+{
+    if (!Tracer::enabled())
+        return;
+
+    Tracer::enable(false);
+
+    if (!m_sTraceFile.empty())
+    {
+        logger.message("Writing performance trace to "+m_sTraceFile);
+        Tracer::writeChromeTrace(m_sTraceFile);
+    }
+
+    if (m_bSummary)
+        std::cout<<Tracer::summary()<<std::endl;
+}
+
+}}
@@ -18,6 +18,7 @@ SUBDIRS += \
     ../kipl/UnitTests/tkiplmorphologytest \
     ../kipl/UnitTests/tKIPLStrings \
     ../kipl/UnitTests/tKIPLTimers \
+    ../kipl/UnitTests/tKIPLLogging \
     ../kipl/UnitTests/tLinFit \
     ../kipl/UnitTests/tMorphology \
     ../kipl/UnitTests/tNoiseImage \
@@ -71,3 +71,23 @@ void ImageWriter::write(kipl::base::TImage<float,2> &img, std::string fname)
         throw ReaderException(msg.str(),__FILE__,__LINE__);
     }
 }
+
+void ImageWriter::write(kipl::base::TImage<float,2> &img, std::string fname, const kipl::io::TIFFWriteOptions &options)
+{
+    if (kipl::io::GetFileExtensionType(fname)!=kipl::io::ExtensionTIFF) {
+        write(img,fname);
+        return;
+    }
+
+    std::ostringstream msg;
+    try {
+        kipl::io::WriteTIFF(img,fname.c_str(),options);
+        msg<<"Wrote image "<<img<<" as "<<fname<<" using WriteTIFF with "<<options.compression;
+        logger(logger.LogDebug,msg.str());
+    }
+    catch (kipl::base::KiplException &e) {
+        msg.str("");
+        msg<<"ImageWriter failed to save the image (KiplException):"<<std::endl<<e.what();
+        throw ReaderException(msg.str(),__FILE__,__LINE__);
+    }
+}
@@ -7,6 +7,7 @@
 
 #include <base/timage.h>
 #include <logging/logger.h>
+#include <io/io_tiff.h>
 #include "readerconfig_global.h"
 
 class READERCONFIGSHARED_EXPORT ImageWriter
@@ -18,6 +19,12 @@ public:
     ~ImageWriter();
 
     void write(kipl::base::TImage<float,2> &img, std::string fname);
+
+    /// \brief Writes an image, TIFF files are written as 32-bit floats with the given compression and layout
+    /// \param img the image to write
+    /// \param fname destination file name, the extension selects the file format
+    /// \param options compression and layout of TIFF files, it is ignored for other formats
+    void write(kipl::base::TImage<float,2> &img, std::string fname, const kipl::io::TIFFWriteOptions &options);
 };
 
 #endif // IMAGEWRITER_H
@@ -7,6 +7,7 @@
 #include <strings/filenames.h>
 #include <io/io_stack.h>
 #include <base/KiplException.h>
+#include <profile/Tracer.h>
 
 #include "../include/KiplEngine.h"
 #include "../include/KiplFrameworkException.h"
@@ -81,7 +82,16 @@ int KiplEngine::Run(kipl::base::TImage<float,3> * img)
             cnt++;
             if (!(m_bCancel=updateStatus(cnt/fNumberOfModules)))
             {
+                kipl::profile::TraceSpan moduleSpan(module->GetModule()->ModuleName(),"processing");
                 module->GetModule()->Process(m_ResultImage,parameters);
+                double moduleTime=moduleSpan.stop();
+
+                if (kipl::profile::Tracer::enabled() && (0.0<moduleTime))
+                {
+                    kipl::profile::Tracer::addCounter("Voxels/s",m_ResultImage.Size()/moduleTime);
+                    kipl::profile::Tracer::addCounter("Buffer memory [bytes]",
+                                                      static_cast<double>((m_ResultImage.Size()+m_InputImage->Size())*sizeof(float)));
+                }
             }
             else
                 break;
@@ -180,6 +190,7 @@ bool KiplEngine::SaveImage(KiplProcessConfig::cOutImageInformation * info)
 		logger(kipl::logging::Logger::LogMessage,msg.str());
 
 		// Todo Rescaling must be fixed
+        kipl::profile::TraceSpan saveSpan("Save image","io");
 		kipl::io::WriteImageStack(m_ResultImage,
 				fname,
 				minval,maxval,
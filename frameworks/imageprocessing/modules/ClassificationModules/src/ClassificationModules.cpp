@@ -13,8 +13,8 @@
 
 #include "BasicThreshold.h"
 #include "DoubleThreshold.h"
-//#include "FuzzyCMeans.h"
-//#include "KernelFuzzyCMeans.h"
+#include "FuzzyCMeans.h"
+#include "KernelFuzzyCMeans.h"
 #include "RemoveBackground.h"
 
 #include "../include/KiplProcessModuleBase.h"
@@ -38,11 +38,11 @@ void * GetModule(const char * application, const char * name, void *vinteractor)
 		if (sName=="DoubleThreshold")
             return new DoubleThreshold (interactor);
 
-//		if (sName=="FuzzyCMeans")
-//			return new FuzzyCMeans;
+		if (sName=="FuzzyCMeans")
+            return new FuzzyCMeans (interactor);
 
-//		if (sName=="KernelFuzzyCMeans")
-//			return new KernelFuzzyCMeans;
+		if (sName=="KernelFuzzyCMeans")
+            return new KernelFuzzyCMeans (interactor);
 
 //		if (sName=="RemoveBackground")
 //			return new RemoveBackground;
@@ -81,11 +81,11 @@ int GetModuleList(const char * application, void *listptr)
     DoubleThreshold dt;
 	modulelist->operator []("DoubleThreshold")=dt.GetParameters();
 
-//	FuzzyCMeans fcm;
-//	modulelist->operator []("FuzzyCMeans")=fcm.GetParameters();
+	FuzzyCMeans fcm;
+	modulelist->operator []("FuzzyCMeans")=fcm.GetParameters();
 
-//	KernelFuzzyCMeans kfcm;
-//	modulelist->operator []("KernelFuzzyCMeans")=kfcm.GetParameters();
+	KernelFuzzyCMeans kfcm;
+	modulelist->operator []("KernelFuzzyCMeans")=kfcm.GetParameters();
 
 //	RemoveBackground rb;
 //	modulelist->operator []("RemoveBackground")=rb.GetParameters();
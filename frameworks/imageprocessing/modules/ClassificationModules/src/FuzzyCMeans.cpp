@@ -6,7 +6,7 @@
  */
 //#include "stdafx.h"
 #include "FuzzyCMeans.h"
-#include <segmentation/fuzzykmeans.h>
+#include <segmentation/histogramfuzzycmeans.h>
 #include <strings/miscstring.h>
 
 #ifdef _OPENMP
@@ -14,14 +14,11 @@
 #endif
 #include <ParameterHandling.h>
 
-FuzzyCMeans::FuzzyCMeans() :
-KiplProcessModuleBase("FuzzyCMeans"),
+FuzzyCMeans::FuzzyCMeans(kipl::interactors::InteractionBase *interactor) :
+KiplProcessModuleBase("FuzzyCMeans", false, interactor),
 	m_nNClasses(3),
 	m_fFuzziness(1.5f),
-	m_nMaxIt(250), 
-	m_bParallel(false),
-	m_bSaveIterations(false),
-	m_sIterationFileName("cmeans_####.tif")
+	m_nMaxIt(250)
 {
 
 }
@@ -31,14 +28,11 @@ FuzzyCMeans::~FuzzyCMeans() {
 }
 
 
-int FuzzyCMeans::Configure(std::map<std::string, std::string> parameters)
+int FuzzyCMeans::Configure(KiplProcessConfig m_Config, std::map<std::string, std::string> parameters)
 {
-	m_nNClasses  = GetFloatParameter(parameters,"nclasses");
+	m_nNClasses  = GetIntParameter(parameters,"nclasses");
 	m_fFuzziness = GetFloatParameter(parameters,"fuzziness");
-	m_nMaxIt     = GetFloatParameter(parameters,"maxiterations");
-	m_bParallel  = kipl::strings::string2bool(GetStringParameter(parameters,"parallel"));
-	m_bSaveIterations = kipl::strings::string2bool(GetStringParameter(parameters,"saveiterations"));
-	m_sIterationFileName = GetStringParameter(parameters,"iterationsfilename");
+	m_nMaxIt     = GetIntParameter(parameters,"maxiterations");
 
 	return 0;
 }
@@ -50,23 +44,17 @@ std::map<std::string, std::string> FuzzyCMeans::GetParameters()
 	parameters["nclasses"]       = kipl::strings::value2string(m_nNClasses);
 	parameters["fuzziness"]      = kipl::strings::value2string(m_fFuzziness);
 	parameters["maxiterations"]  = kipl::strings::value2string(m_nMaxIt);
-	parameters["parallel"]       = kipl::strings::bool2string(m_bParallel);
-	parameters["saveiterations"] = kipl::strings::bool2string(m_bSaveIterations);
-	parameters["iterationsfilename"] = m_sIterationFileName;
 
 	return parameters;
 }
 
 int FuzzyCMeans::ProcessCore(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff)
 {
-    kipl::segmentation::FuzzyKMeans<float,float,3> segmenter;
+    kipl::segmentation::HistogramFuzzyCMeans<float,float,3> segmenter;
 
-	segmenter.set(m_nNClasses, m_fFuzziness, m_nMaxIt,m_bSaveIterations,m_sIterationFileName);
+	segmenter.set(m_nNClasses, m_fFuzziness, m_nMaxIt);
 	kipl::base::TImage<float,3> tmp;
-	if (!m_bParallel) 
-		segmenter(img,tmp);
-	else
-		segmenter.parallel(img,tmp);
+	segmenter(img,tmp);
 
 	img=tmp;
 
@@ -10,13 +10,17 @@
 
 #include "ClassificationModules_global.h"
 #include <KiplProcessModuleBase.h>
+#include <KiplProcessConfig.h>
 
+/// \brief Fuzzy C-means classification of the gray levels, the classes are labelled 0..nclasses-1 by increasing center.
+///
+/// The iterations are done on a histogram of the gray levels and the labels are found by a lookup.
 class CLASSIFICATIONMODULES_EXPORT FuzzyCMeans: public KiplProcessModuleBase {
 public:
-	FuzzyCMeans();
+    FuzzyCMeans(kipl::interactors::InteractionBase *interactor=nullptr);
 	virtual ~FuzzyCMeans();
 	
-	virtual int Configure(std::map<std::string, std::string> parameters);
+    virtual int Configure(KiplProcessConfig m_Config, std::map<std::string, std::string> parameters);
 	virtual std::map<std::string, std::string> GetParameters();
 protected:
 	virtual int ProcessCore(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff);
@@ -24,10 +28,6 @@ protected:
 	int m_nNClasses;
 	float m_fFuzziness;
 	int m_nMaxIt;
-	bool m_bParallel;
-	bool m_bSaveIterations;
-	std::string m_sIterationFileName;
-
 };
 
 #endif /* DATASCALER_H_ */
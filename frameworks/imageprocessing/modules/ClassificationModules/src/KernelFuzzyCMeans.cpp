@@ -6,7 +6,7 @@
  */
 //#include "stdafx.h"
 #include "KernelFuzzyCMeans.h"
-#include <segmentation/kernelfuzzykmeans.h>
+#include <segmentation/histogramfuzzycmeans.h>
 #include <strings/miscstring.h>
 
 #ifdef _OPENMP
@@ -14,13 +14,12 @@
 #endif
 #include <ParameterHandling.h>
 
-KernelFuzzyCMeans::KernelFuzzyCMeans() :
-KiplProcessModuleBase("KernelFuzzyCMeans"),
+KernelFuzzyCMeans::KernelFuzzyCMeans(kipl::interactors::InteractionBase *interactor) :
+KiplProcessModuleBase("KernelFuzzyCMeans", false, interactor),
 	m_nNClasses(3),
 	m_fFuzziness(1.5f),
 	m_fSigma(2.0f),
-	m_nMaxIt(250),
-	m_bParallel(false)
+	m_nMaxIt(250)
 {
 
 }
@@ -29,13 +28,12 @@ KernelFuzzyCMeans::~KernelFuzzyCMeans() {
 }
 
 
-int KernelFuzzyCMeans::Configure(std::map<std::string, std::string> parameters)
+int KernelFuzzyCMeans::Configure(KiplProcessConfig m_Config, std::map<std::string, std::string> parameters)
 {
-	m_nNClasses  = GetFloatParameter(parameters,"nclasses");
+	m_nNClasses  = GetIntParameter(parameters,"nclasses");
 	m_fFuzziness = GetFloatParameter(parameters,"fuzziness");
 	m_fSigma     = GetFloatParameter(parameters,"sigma");
 	m_nMaxIt     = GetIntParameter(parameters,"maxiterations");
-	m_bParallel  = kipl::strings::string2bool(GetStringParameter(parameters,"parallel"));
 
 	return 0;
 }
@@ -48,26 +46,18 @@ std::map<std::string, std::string> KernelFuzzyCMeans::GetParameters()
 	parameters["fuzziness"]     = kipl::strings::value2string(m_fFuzziness);
 	parameters["sigma"]         = kipl::strings::value2string(m_fSigma);
 	parameters["maxiterations"] = kipl::strings::value2string(m_nMaxIt);
-	parameters["parallel"]	    = kipl::strings::bool2string(m_bParallel);
 	return parameters;
 }
 
 int KernelFuzzyCMeans::ProcessCore(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff)
 {
-//todo fix missing virtuals
-//    akipl::segmentation::KernelFuzzyKMeans<float,unsigned char,3> segmenter;
+    kipl::segmentation::HistogramFuzzyCMeans<float,float,3> segmenter;
 
-//	segmenter.set(m_nNClasses, m_fFuzziness, m_nMaxIt);
-//	kipl::base::TImage<unsigned char,3> seg;
-//	if (!m_bParallel)
-//		segmenter(img,seg);
-//	else
-//		segmenter.parallel(img,seg);
+	segmenter.set(m_nNClasses, m_fFuzziness, m_nMaxIt, m_fSigma);
+	kipl::base::TImage<float,3> tmp;
+	segmenter(img,tmp);
 
-//	float *pImg=img.GetDataPtr();
-//	unsigned char *pSeg=seg.GetDataPtr();
-//	for (size_t i=0; i<img.Size(); i++)
-//		pImg[i]=static_cast<float>(pSeg[i]);
+	img=tmp;
 
 	return 0;
 }
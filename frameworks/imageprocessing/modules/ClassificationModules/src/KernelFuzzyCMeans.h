@@ -10,13 +10,15 @@
 
 #include "ClassificationModules_global.h"
 #include <KiplProcessModuleBase.h>
+#include <KiplProcessConfig.h>
 
+/// \brief Kernel fuzzy C-means classification of the gray levels using a Gaussian kernel of width sigma.
 class CLASSIFICATIONMODULES_EXPORT KernelFuzzyCMeans: public KiplProcessModuleBase {
 public:
-	KernelFuzzyCMeans();
+    KernelFuzzyCMeans(kipl::interactors::InteractionBase *interactor=nullptr);
 	virtual ~KernelFuzzyCMeans();
 	
-	virtual int Configure(std::map<std::string, std::string> parameters);
+    virtual int Configure(KiplProcessConfig m_Config, std::map<std::string, std::string> parameters);
 	virtual std::map<std::string, std::string> GetParameters();
 protected:
 	virtual int ProcessCore(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff);
@@ -25,7 +27,6 @@ protected:
 	float m_fFuzziness;
 	float m_fSigma;
 	int m_nMaxIt;
-	bool m_bParallel;
 };
 
 #endif // KernelFuzzyCMeans_H_ 
@@ -195,9 +195,6 @@ size_t FdkReconBase::Process(kipl::base::TImage<float,2> proj, float angle, floa
 #endif
     nProjCounter++;
     if (bLastProjection || (nProjectionBufferSize<=(nProjCounter))) {
-        if (nProjectionBufferSize<=nProjCounter)
-            nProjCounter--;
-
         msg.str("");
         msg<<"Counter="<<nProjCounter<<", buffer size="<<nProjectionBufferSize<<" last "<<(bLastProjection ? "True" : "False");
         logger(logger.LogMessage,msg.str());
@@ -291,86 +288,30 @@ void FdkReconBase::GetMatrixDims(size_t *dims)
 }
 
 void FdkReconBase::GetHistogram(float *axis, size_t *hist,size_t nBins) {
-
-
-    float matrixMin=Min();
-    float matrixMax=Max();
+    kipl::math::VolumeStatistics stats;
+    GetStatistics(stats);
 
     ostringstream msg;
-    msg<<"Preparing histogram; #bins: "<<nBins<<", Min: "<<matrixMin<<", Max: "<<matrixMax;
+    msg<<"Preparing histogram; #bins: "<<nBins<<", Min: "<<stats.Min()<<", Max: "<<stats.Max();
     logger(kipl::logging::Logger::LogMessage,msg.str());
 
-    memset(axis,0,sizeof(float)*nBins);
-    memset(hist,0,sizeof(size_t)*nBins);
-    float scale=(matrixMax-matrixMin)/(nBins+1);
-    float invScale=1.0f/scale;
-    size_t index=0;
-    for (size_t z=0; z<volume.Size(2); z++) {
-        for (size_t y=0; y<volume.Size(1); y++) {
-            float *pLine=volume.GetLinePtr(y,z);
-            for (size_t x=0; x<volume.Size(0); x++) {
-                index=static_cast<size_t>(invScale*(pLine[x]-matrixMin));
-                if (pLine[x]<matrixMin)
-                    index=0;
-                else if (nBins<=index)
-                    index=nBins-1;
-                hist[index]++;
-            }
-        }
-    }
-
-    axis[0]=matrixMin+scale/2.0f;
-    for (size_t i=1; i<nBins; i++)
-        axis[i]=axis[i-1]+scale;
-
+    stats.GetHistogram(axis,hist,nBins);
 }
 
 float FdkReconBase::Min()
 {
-    float minval=std::numeric_limits<float>::max();
-
-
-//    if (MatrixAlignment==FdkReconBase::MatrixXYZ) {
-//        logger(kipl::logging::Logger::LogWarning,"Min is not implemented for MatrixXYZ");
-//        throw ReconException("Min is not implemented for MatrixXYZ",__FILE__,__LINE__);
-//    }
-//    else {
-    // should be computed on mask not to have too many values of the background.. but I haven't computed the mask yet..
-        for (size_t z=0; z<volume.Size(2); z++) {
-            for (size_t y=0; y<volume.Size(1); y++) {
-                float *pLine=volume.GetLinePtr(y,z);
-                minval=min(minval,*min_element(pLine,pLine+volume.Size(0)));
-            }
-        }
-//    }
-//        float *pLine = volume.GetDataPtr();
-//        minval = min(minval, *min(pLine, pLine+volume.Size(0)*volume.Size(1)*volume.Size(2)));
-
-
-    return minval;
+    kipl::math::VolumeStatistics stats;
+    GetStatistics(stats);
+
+    return static_cast<float>(stats.Min());
 }
 
 float FdkReconBase::Max()
 {
-    float maxval=-std::numeric_limits<float>::max();
-
-//    if (MatrixAlignment==FdkReconBase::MatrixXYZ) {
-//        logger(kipl::logging::Logger::LogWarning,"Max is not implemented for MatrixXYZ");
-//        throw ReconException("Max is not implemented for MatrixXYZ",__FILE__,__LINE__);
-//    }
-//    else {
-        for (size_t z=0; z<volume.Size(2); z++) {
-            for (size_t y=0; y<volume.Size(1); y++) {
-                float *pLine=volume.GetLinePtr(y,z);
-                maxval=max(maxval,*max_element(pLine,pLine+volume.Size(0)));
-            }
-        }
-//    }
-
-    //    float *pLine = volume.GetDataPtr();
-    //    maxval = max_element(volume.GetDataPtr(), volume.GetDataPtr()+volume.Size(0)*volume.Size(1)*volume.Size(2));
-
-    return maxval;
+    kipl::math::VolumeStatistics stats;
+    GetStatistics(stats);
+
+    return static_cast<float>(stats.Max());
 }
 
 size_t FdkReconBase::ComputeGeometryMatrices(float *matrices){
@@ -1,17 +1,29 @@
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+#include <ReconException.h>
+#include <linearforwardprojector.h>
+#include <linearbackprojector.h>
+#include <strings/miscstring.h>
+
 #include "iterativereconbase.h"
 
 IterativeReconBase::IterativeReconBase(std::string application, std::string name, eMatrixAlignment alignment, kipl::interactors::InteractionBase *interactor) :
     BackProjectorModuleBase(application,name,alignment,interactor),
-    m_fp(nullptr),
-    m_bp(nullptr),
-    m_nIterations(10)
+    m_fp(new LinearForwardProjector),
+    m_bp(new LinearBackProjector),
+    m_nIterations(10),
+    m_nSliceBlock(32)
 {
 
 }
 
 IterativeReconBase::~IterativeReconBase()
 {
-
+    delete m_fp;
+    delete m_bp;
 }
 
 /// Sets up the back-projector with new parameters
@@ -19,6 +31,18 @@ IterativeReconBase::~IterativeReconBase()
 /// \param parameters Additional set of configuration parameters
 int IterativeReconBase::Configure(ReconConfig config, std::map<std::string, std::string> parameters)
 {
+    mConfig=config;
+
+    if (mConfig.ProjectionInfo.beamgeometry!=ReconConfig::cProjections::BeamGeometry_Parallel)
+        throw ReconException(m_sModuleName+" only supports parallel beam geometry",__FILE__,__LINE__);
+
+    if (mConfig.ProjectionInfo.bCorrectTilt)
+        logger(kipl::logging::Logger::LogWarning,"Tilt correction is not supported by the iterative reconstruction, the axis is assumed to be vertical.");
+
+    m_nIterations = GetIntParameter(parameters,"iterations");
+    m_nSliceBlock = GetIntParameter(parameters,"SliceBlock");
+    if (m_nIterations<1)
+        throw ReconException("The number of iterations must be at least one",__FILE__,__LINE__);
 
     return 0;
 }
@@ -36,6 +60,9 @@ std::map<std::string, std::string> IterativeReconBase::GetParameters()
 {
    std::map<std::string, std::string> params;
 
+   params["iterations"]=kipl::strings::value2string(m_nIterations);
+   params["SliceBlock"]=kipl::strings::value2string(m_nSliceBlock);
+
    return params;
 }
 
@@ -43,16 +70,35 @@ std::map<std::string, std::string> IterativeReconBase::GetParameters()
 /// \param roi A four-entry array of ROI coordinates (x0,y0,x1,y1)
 void IterativeReconBase::SetROI(size_t *roi)
 {
+    ClearAll();
+
+    mConfig.ProjectionInfo.roi[0]=roi[0];
+    mConfig.ProjectionInfo.roi[1]=roi[1];
+    mConfig.ProjectionInfo.roi[2]=roi[2];
+    mConfig.ProjectionInfo.roi[3]=roi[3];
+
+    const size_t SizeU = roi[2]-roi[0];
+    const size_t SizeV = mConfig.ProjectionInfo.imagetype==ReconConfig::cProjections::ImageType_Proj_RepeatSinogram ? roi[3] : roi[3]-roi[1];
+
+    MatrixDims[0]=SizeU;
+    MatrixDims[1]=SizeU;
+    MatrixDims[2]=SizeV;
 
+    volume.Resize(MatrixDims);
+    volume=0.0f;
+
+    std::ostringstream msg;
+    msg<<"Setting up "<<m_sModuleName<<" with ROI=["<<roi[0]<<", "<<roi[1]<<", "<<roi[2]<<", "<<roi[3]<<"], matrix dimensions "<<volume;
+    logger(kipl::logging::Logger::LogVerbose,msg.str());
+
+    BuildCircleMask();
 }
 
-/// Add one projection to the back-projection stack
-/// \param proj The projection
-/// \param angle Acquisition angle
-/// \param weight Intensity scaling factor for interpolation when the angles are non-uniformly distributed
-/// \param bLastProjection termination signal. When true the back-projeciton is finalized.
+/// Single projections are not supported by iterative methods, all projections must be available.
 size_t IterativeReconBase::Process(kipl::base::TImage<float,2> proj, float angle, float weight, bool bLastProjection)
 {
+    throw ReconException(m_sModuleName+" needs all projections of a block, single projections can't be processed",__FILE__,__LINE__);
+
     return 0L;
 }
 
@@ -61,6 +107,106 @@ size_t IterativeReconBase::Process(kipl::base::TImage<float,2> proj, float angle
 /// \param parameters A list of parameters, the list shall contain at least the parameters angles and weights each containing a space separated list with as many values as projections
 size_t IterativeReconBase::Process(kipl::base::TImage<float,3> proj, std::map<std::string, std::string> parameters)
 {
+    if (volume.Size()==0)
+        throw ReconException("The target matrix is not allocated.",__FILE__,__LINE__);
 
-    return 0L;
+    const size_t nU    = proj.Size(0);
+    const size_t nV    = proj.Size(1);
+    const size_t nProj = proj.Size(2);
+
+    if ((nU!=volume.Size(0)) || (nV!=volume.Size(2))) {
+        std::ostringstream msg;
+        msg<<"The projection block "<<proj<<" doesn't match the matrix "<<volume;
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+
+    std::vector<float> angles(nProj);
+    GetFloatParameterVector(parameters,"angles",angles.data(),static_cast<int>(nProj));
+
+    const float dirWeight = 2.0f*(mConfig.ProjectionInfo.eDirection-0.5f);
+    for (auto &angle : angles)
+        angle *= dirWeight;
+
+    // Rearrange the projections to one sinogram per slice
+    size_t sinoDims[3]={nU, nProj, nV};
+    kipl::base::TImage<float,3> sinograms(sinoDims);
+
+    for (size_t i=0; i<nProj; ++i)
+        for (size_t z=0; z<nV; ++z)
+            memcpy(sinograms.GetLinePtr(i,z),proj.GetLinePtr(z,i),nU*sizeof(float));
+
+    timer.Tic();
+    size_t nIterations=reconstruct(sinograms,angles);
+    timer.Toc();
+
+    // Same attenuation unit as the filtered back-projection
+    const float fResolution = mConfig.ProjectionInfo.fResolution[0];
+    if (0.0f<fResolution)
+        volume *= 1.0f/(fResolution*0.1f);
+
+    applyMask();
+
+    std::ostringstream msg;
+    msg<<m_sModuleName<<" completed "<<nIterations<<" iterations on "<<nV<<" slices in "<<timer.elapsedTime(kipl::profile::Timer::seconds)<<"s";
+    logger(kipl::logging::Logger::LogMessage,msg.str());
+
+    return nIterations;
+}
+
+void IterativeReconBase::applyMask()
+{
+    const size_t sx=volume.Size(0);
+
+    for (size_t z=0; z<volume.Size(2); ++z) {
+        for (size_t y=0; y<mask.size(); ++y) {
+            float *pLine=volume.GetLinePtr(y,z);
+
+            if (mask[y].second<=mask[y].first) {
+                std::fill(pLine,pLine+sx,0.0f);
+                continue;
+            }
+
+            std::fill(pLine,pLine+mask[y].first,0.0f);
+            std::fill(pLine+std::min(mask[y].second+1,sx),pLine+sx,0.0f);
+        }
+    }
+}
+
+void IterativeReconBase::GetHistogram(float *x, size_t *y, size_t N)
+{
+    memset(x,0,sizeof(float)*N);
+    memset(y,0,sizeof(size_t)*N);
+
+    float matrixMin=std::numeric_limits<float>::max();
+    float matrixMax=std::numeric_limits<float>::lowest();
+
+    for (size_t z=0; z<volume.Size(2); ++z) {
+        for (size_t row=0; row<mask.size(); ++row) {
+            float *pLine=volume.GetLinePtr(row,z);
+            for (size_t col=mask[row].first; col<mask[row].second; ++col) {
+                matrixMin=std::min(matrixMin,pLine[col]);
+                matrixMax=std::max(matrixMax,pLine[col]);
+            }
+        }
+    }
+
+    if (matrixMax<matrixMin)
+        return;
+
+    const float scale    = (matrixMax-matrixMin)/(N+1);
+    const float invScale = 0.0f<scale ? 1.0f/scale : 0.0f;
+
+    for (size_t z=0; z<volume.Size(2); ++z) {
+        for (size_t row=0; row<mask.size(); ++row) {
+            float *pLine=volume.GetLinePtr(row,z);
+            for (size_t col=mask[row].first; col<mask[row].second; ++col) {
+                size_t index=static_cast<size_t>(invScale*(pLine[col]-matrixMin));
+                y[std::min(index,N-1)]++;
+            }
+        }
+    }
+
+    x[0]=matrixMin+scale/2.0f;
+    for (size_t i=1; i<N; ++i)
+        x[i]=x[i-1]+scale;
 }
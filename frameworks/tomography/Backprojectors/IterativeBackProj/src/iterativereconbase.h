@@ -1,11 +1,17 @@
 #ifndef ITERATIVERECONBASE_H
 #define ITERATIVERECONBASE_H
 
+#include <vector>
+
 #include <BackProjectorModuleBase.h>
 #include <ParameterHandling.h>
 #include <forwardprojectorbase.h>
 #include <backprojectorbase.h>
 
+/// \brief Base class for iterative reconstruction methods using a matched pair of forward and back-projectors.
+///
+/// The reconstruction is done for a complete block of slices at once. The projections of the block are
+/// rearranged to sinograms and passed to the reconstruct method, which is implemented by the derived class.
 class IterativeReconBase : public BackProjectorModuleBase
 {
 public:
@@ -20,11 +26,8 @@ public:
     /// Initializing the reconstructor
     virtual int Initialize();
 
-    /// Add one projection to the back-projection stack
-    /// \param proj The projection
-    /// \param angle Acquisition angle
-    /// \param weight Intensity scaling factor for interpolation when the angles are non-uniformly distributed
-    /// \param bLastProjection termination signal. When true the back-projeciton is finalized.
+    /// Single projections are not supported by iterative methods, all projections must be available.
+    /// \throws ReconException
     virtual size_t Process(kipl::base::TImage<float,2> proj, float angle, float weight, bool bLastProjection);
 
     /// Starts the back-projection process of projections stored as a 3D volume.
@@ -41,13 +44,27 @@ public:
     /// \param roi A four-entry array of ROI coordinates (x0,y0,x1,y1)
     virtual void SetROI(size_t *roi);
 
+    /// Get the histogram of the reconstructed matrix inside the reconstruction mask.
+    /// \param x the bin values of the x axis
+    /// \param y the histogram bins
+    /// \param N number of bins
+    virtual void GetHistogram(float *x, size_t *y, size_t N);
+
 protected:
-    virtual size_t reconstruct(kipl::base::TImage<float,3> proj,std::list<float> & angles) = 0;
+    /// Reconstructs the slices of a block into the volume.
+    /// \param sinograms The sinograms, one sinogram (detector x angles) per xy-plane
+    /// \param angles The projection angles in degrees
+    /// \returns The number of completed iterations
+    virtual size_t reconstruct(kipl::base::TImage<float,3> &sinograms, std::vector<float> & angles) = 0;
+
+    /// Sets the voxels outside the reconstruction mask to zero
+    void applyMask();
 
     ForwardProjectorBase *m_fp;
     BackProjectorBase    *m_bp;
 
     int   m_nIterations;
+    int   m_nSliceBlock; ///< Number of slices reconstructed together, used by the engine to split the volume into blocks
 };
 
 #endif // ITERATIVERECONBASE_H
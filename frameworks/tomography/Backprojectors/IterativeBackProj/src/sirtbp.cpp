@@ -1,11 +1,21 @@
 
-#include <interactors/interactionbase.h>
-#include "sirtbp.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
 
+#include <interactors/interactionbase.h>
+#include <strings/miscstring.h>
+#include <ReconException.h>
 
+#include "sirtbp.h"
 
 SIRTbp::SIRTbp(kipl::interactors::InteractionBase *interactor) :
-    IterativeReconBase("muhrec","SIRTbp",BackProjectorModuleBase::MatrixXYZ,interactor)
+    IterativeReconBase("muhrec","SIRTbp",BackProjectorModuleBase::MatrixXYZ,interactor),
+    m_fAlpha(1.0f),
+    m_nSubsets(1),
+    m_bPositivity(true),
+    m_fCachedCenter(0.0f),
+    m_nCachedSize(0)
 {
 
 }
@@ -15,81 +25,142 @@ SIRTbp::~SIRTbp()
 
 }
 
-/// Add one projection to the back-projection stack
-/// \param proj The projection
-/// \param angle Acquisition angle
-/// \param weight Intensity scaling factor for interpolation when the angles are non-uniformly distributed
-/// \param bLastProjection termination signal. When true the back-projeciton is finalized.
-size_t SIRTbp::Process(kipl::base::TImage<float,2> proj, float angle, float weight, bool bLastProjection)
+size_t SIRTbp::reconstruct(kipl::base::TImage<float,3> &sinograms, std::vector<float> &angles)
 {
+    std::ostringstream msg;
 
-    return 0L;
-}
+    const size_t N       = sinograms.Size(0);
+    const size_t nSlices = sinograms.Size(2);
+    const float  center  = mConfig.ProjectionInfo.fCenter;
 
-/// Starts the back-projection process of projections stored as a 3D volume.
-/// \param proj The projection data
-/// \param parameters A list of parameters, the list shall contain at least the parameters angles and weights each containing a space separated list with as many values as projections
-size_t SIRTbp::Process(kipl::base::TImage<float,3> proj, std::map<std::string, std::string> parameters)
-{
-//    //    forwproj2D  - forward projector
-//    //    backproj2D - backprojector
-//    //    x - initial guess
-//    //    b - projection data (sinogram)
-
-//    // Matalab initialization code
-//    //    [nsino1, nsino2] = size(b);
-//    //    N = size(x,1);
-//    //    if (N == 1)
-//    //        disp('Initialize image!');
-//    //    end
-//    //    row_sum = forwproj2D(ones(N,N), theta, nsino2);
-//    //    column_sum = backproj2D(ones(nsino1, nsino2), theta, N);
-//    //    R = zeros(nsino1, nsino2);
-//    //    C = zeros(N,N);
-
-//    //    roi1 = find(row_sum(:) > 0);
-//    //    roi2 = find(column_sum(column_sum(:) > 0));
-
-//    //    R(roi1) = 1./row_sum(roi1);
-//    //    C(roi2) = 1./column_sum(roi2);
-
-//    size_t dims[3]={proj.Size(0), proj.Size(0), proj.Size(2)};
-//    volume.Resize(dims);
-//    kipl::base::TImage<float,2> x(dims);
-//    kipl::base::TImage<float,2> bp(dims);
-//    kipl::base::TImage<float,2> r(dims); // todo fix dimensions
-//    kipl::base::TImage<float,2> res; // todo fix dimensions
-//    kipl::base::TImage<float,2> sino; // todo fix dimensions
-//    for (int i=0; i<m_nIterations; i++) {
-//        // Matlab iteration code
-//        //         r =  forwproj2D(x, theta, nsino2); % forward proj
-//        //         res = (b-r);
-//        //         res = res.*R;
-//        //         bp = backproj2D(res, theta, N);
-//        //         bp = bp.*C;
-//        //         x = x + bp;
-//        //         %x(x<0)=0;
-//        m_fp->project(x,theta,r);
-//        res = sino - r;
-//        res *=R;
-//        m_bp->backproject(res,dims[0]/2.0f,theta,bp);
-//        bp*=C;
-//        x+=bp;
-//    }
-
-    return 0L;
+    prepareGeometry(angles,center,N);
+
+    // Split the measured sinograms into the subsets
+    const size_t nSubsets=m_SubsetAngles.size();
+    std::vector<kipl::base::TImage<float,3> > measured(nSubsets);
+    for (size_t s=0; s<nSubsets; ++s) {
+        size_t dims[3]={N, m_SubsetIndex[s].size(), nSlices};
+        measured[s].Resize(dims);
+
+        for (size_t z=0; z<nSlices; ++z)
+            for (size_t j=0; j<m_SubsetIndex[s].size(); ++j)
+                memcpy(measured[s].GetLinePtr(j,z),sinograms.GetLinePtr(m_SubsetIndex[s][j],z),N*sizeof(float));
+    }
+
+    volume=0.0f;
+
+    kipl::base::TImage<float,3> residual;
+    kipl::base::TImage<float,3> correction;
+    const ptrdiff_t nSlicesP = static_cast<ptrdiff_t>(nSlices);
+    const size_t    sxy      = N*N;
+
+    size_t iteration=0;
+    for (iteration=0; iteration<static_cast<size_t>(m_nIterations); ++iteration) {
+        msg.str("");
+        msg<<"Iteration "<<iteration+1<<" of "<<m_nIterations;
+        if (UpdateStatus(static_cast<float>(iteration)/m_nIterations,msg.str()))
+            break;
+
+        for (size_t s=0; s<nSubsets; ++s) {
+            m_fp->project(volume,m_SubsetAngles[s],center,residual);
+
+            const size_t nBins   = residual.Size(0)*residual.Size(1);
+            const float *pInvRow = m_InvRowSum[s].GetDataPtr();
+
+            #pragma omp parallel for
+            for (ptrdiff_t z=0; z<nSlicesP; ++z) {
+                float *pRes        = residual.GetLinePtr(0,z);
+                const float *pMeas = measured[s].GetLinePtr(0,z);
+
+                for (size_t i=0; i<nBins; ++i)
+                    pRes[i]=(pMeas[i]-pRes[i])*pInvRow[i];
+            }
+
+            m_bp->backproject(residual,center,m_SubsetAngles[s],correction);
+
+            const float *pInvCol = m_InvColSum[s].GetDataPtr();
+
+            #pragma omp parallel for
+            for (ptrdiff_t z=0; z<nSlicesP; ++z) {
+                float *pVol        = volume.GetLinePtr(0,z);
+                const float *pCorr = correction.GetLinePtr(0,z);
+
+                for (size_t i=0; i<sxy; ++i)
+                    pVol[i]+=m_fAlpha*pInvCol[i]*pCorr[i];
+
+                if (m_bPositivity)
+                    for (size_t i=0; i<sxy; ++i)
+                        pVol[i]=std::max(pVol[i],0.0f);
+            }
+        }
+    }
+
+    return iteration;
 }
 
-size_t SIRTbp::reconstruct(kipl::base::TImage<float,3> proj,std::list<float> & angles)
+void SIRTbp::prepareGeometry(const std::vector<float> &angles, float center, size_t size)
 {
-    return 0L;
+    const size_t nSubsets=std::max(static_cast<size_t>(1),std::min(static_cast<size_t>(m_nSubsets),angles.size()));
+
+    if ((angles==m_CachedAngles) && (center==m_fCachedCenter) && (size==m_nCachedSize) && (m_SubsetAngles.size()==nSubsets))
+        return;
+
+    std::ostringstream msg;
+    msg<<"Computing row and column sums for "<<angles.size()<<" angles in "<<nSubsets<<" subset"<<(nSubsets==1 ? "" : "s");
+    logger(kipl::logging::Logger::LogMessage,msg.str());
+
+    m_SubsetIndex.assign(nSubsets,std::vector<size_t>());
+    m_SubsetAngles.assign(nSubsets,std::vector<float>());
+    m_InvRowSum.assign(nSubsets,kipl::base::TImage<float,3>());
+    m_InvColSum.assign(nSubsets,kipl::base::TImage<float,3>());
+
+    // Interleaved subsets give each subset a good angular coverage
+    for (size_t i=0; i<angles.size(); ++i) {
+        m_SubsetIndex[i % nSubsets].push_back(i);
+        m_SubsetAngles[i % nSubsets].push_back(angles[i]);
+    }
+
+    size_t dims[3]={size, size, 1};
+    kipl::base::TImage<float,3> ones(dims);
+    ones=1.0f;
+
+    for (size_t s=0; s<nSubsets; ++s) {
+        m_fp->project(ones,m_SubsetAngles[s],center,m_InvRowSum[s]);
+
+        float *pRow=m_InvRowSum[s].GetDataPtr();
+        for (size_t i=0; i<m_InvRowSum[s].Size(); ++i)
+            pRow[i] = 0.0f<pRow[i] ? 1.0f/pRow[i] : 0.0f;
+
+        kipl::base::TImage<float,3> sino(m_InvRowSum[s].Dims());
+        sino=1.0f;
+        m_bp->backproject(sino,center,m_SubsetAngles[s],m_InvColSum[s]);
+
+        float *pCol=m_InvColSum[s].GetDataPtr();
+        for (size_t i=0; i<m_InvColSum[s].Size(); ++i)
+            pCol[i] = 0.0f<pCol[i] ? 1.0f/pCol[i] : 0.0f;
+    }
+
+    m_CachedAngles  = angles;
+    m_fCachedCenter = center;
+    m_nCachedSize   = size;
 }
+
 /// Sets up the back-projector with new parameters
 /// \param config Reconstruction parameter set
 /// \param parameters Additional set of configuration parameters
 int SIRTbp::Configure(ReconConfig config, std::map<std::string, std::string> parameters)
 {
-    mConfig=config;
+    IterativeReconBase::Configure(config,parameters);
+
+    m_fAlpha      = GetFloatParameter(parameters,"relaxation");
+    m_nSubsets    = GetIntParameter(parameters,"subsets");
+    m_bPositivity = kipl::strings::string2bool(GetStringParameter(parameters,"positivity"));
+
+    if (m_nSubsets<1)
+        throw ReconException("The number of subsets must be at least one",__FILE__,__LINE__);
+
+    m_CachedAngles.clear();
+    m_SubsetAngles.clear();
 
     return 0;
 }
@@ -110,22 +181,9 @@ std::map<std::string, std::string> SIRTbp::GetParameters()
 
     parameters=IterativeReconBase::GetParameters();
 
+    parameters["relaxation"] = kipl::strings::value2string(m_fAlpha);
+    parameters["subsets"]    = kipl::strings::value2string(m_nSubsets);
+    parameters["positivity"] = kipl::strings::bool2string(m_bPositivity);
 
     return parameters;
 }
-
-/// Sets the region of interest on the projections.
-/// \param roi A four-entry array of ROI coordinates (x0,y0,x1,y1)
-void SIRTbp::SetROI(size_t *roi)
-{
-    IterativeReconBase::SetROI(roi);
-}
-
-/// Get the histogram of the reconstructed matrix. This should be calculated in the masked region only to avoid unnescessary zero counts.
-/// \param x the bin values of the x axis
-/// \param y the histogram bins
-/// \param N number of bins
-void SIRTbp::GetHistogram(float *x, size_t *y, size_t N)
-{
-
-}
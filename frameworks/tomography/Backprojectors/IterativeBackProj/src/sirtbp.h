@@ -1,28 +1,23 @@
 #ifndef SIRTBP_H
 #define SIRTBP_H
 
+#include <vector>
+
 #include "iterativebackproj_global.h"
 #include "iterativereconbase.h"
 #include <ParameterHandling.h>
 
+/// \brief Simultaneous iterative reconstruction technique (SIRT) with an ordered subset (SART) mode.
+///
+/// The update of an iteration is x = x + relaxation * C A^T R (b - A x), where R and C are the inverse row and column sums of the projection operator A.
+/// With more than one subset, the angles are split into interleaved subsets and the volume is updated after each subset.
+/// The row and column sums only depend on the geometry and are kept until the angles, center or block width change.
 class SIRTbp : public IterativeReconBase
 {
 public:
     SIRTbp(kipl::interactors::InteractionBase *interactor=nullptr);
     ~SIRTbp();
 
-    /// Add one projection to the back-projection stack
-    /// \param proj The projection
-    /// \param angle Acquisition angle
-    /// \param weight Intensity scaling factor for interpolation when the angles are non-uniformly distributed
-    /// \param bLastProjection termination signal. When true the back-projeciton is finalized.
-    virtual size_t Process(kipl::base::TImage<float,2> proj, float angle, float weight, bool bLastProjection);
-
-    /// Starts the back-projection process of projections stored as a 3D volume.
-    /// \param proj The projection data
-    /// \param parameters A list of parameters, the list shall contain at least the parameters angles and weights each containing a space separated list with as many values as projections
-    virtual size_t Process(kipl::base::TImage<float,3> proj, std::map<std::string, std::string> parameters);
-
     /// Sets up the back-projector with new parameters
     /// \param config Reconstruction parameter set
     /// \param parameters Additional set of configuration parameters
@@ -35,19 +30,26 @@ public:
     /// \returns The parameter list
     virtual std::map<std::string, std::string> GetParameters();
 
-    /// Sets the region of interest on the projections.
-    /// \param roi A four-entry array of ROI coordinates (x0,y0,x1,y1)
-    virtual void SetROI(size_t *roi);
-
-    /// Get the histogram of the reconstructed matrix. This should be calculated in the masked region only to avoid unnescessary zero counts.
-    /// \param x the bin values of the x axis
-    /// \param y the histogram bins
-    /// \param N number of bins
-    virtual void GetHistogram(float *x, size_t *y, size_t N);
-
 protected:
-    virtual size_t reconstruct(kipl::base::TImage<float,3> proj,std::list<float> & angles);
-    float m_fAlpha;
+    virtual size_t reconstruct(kipl::base::TImage<float,3> &sinograms, std::vector<float> & angles);
+
+    /// Computes the subsets and the inverse row and column sums if the geometry changed since the previous block.
+    /// \param angles The projection angles
+    /// \param center The position of the rotation axis
+    /// \param size The number of detector bins
+    void prepareGeometry(const std::vector<float> &angles, float center, size_t size);
+
+    float m_fAlpha;     ///< Relaxation factor
+    int   m_nSubsets;   ///< Number of ordered subsets, one subset gives SIRT
+    bool  m_bPositivity;///< Clamp the solution to non-negative values after each update
+
+    std::vector<float> m_CachedAngles;
+    float  m_fCachedCenter;
+    size_t m_nCachedSize;
+    std::vector<std::vector<size_t> > m_SubsetIndex;
+    std::vector<std::vector<float> >  m_SubsetAngles;
+    std::vector<kipl::base::TImage<float,3> > m_InvRowSum;
+    std::vector<kipl::base::TImage<float,3> > m_InvColSum;
 };
 
 #endif // SIRTBP_H
@@ -49,6 +49,21 @@ protected:
     virtual void ClearAll();
 
 	virtual void BackProject()=0;
+
+	/// \brief Copies a weighted projection into a slot of the back-projection buffer, transposed for the MatrixZXY alignment.
+	/// \param pSrc The projection data
+	/// \param dims The projection dimensions
+	/// \param weight The projection weight
+	/// \param pDest The buffer slot of the projection
+	void TransposeProjection(float const * pSrc, size_t const * dims, float weight, float *pDest);
+	/// \brief Provides the number of projections back-projected per batch by the block path, tuning it during the first batches.
+	/// \param nBytesPerProjection The buffer size of one projection
+	size_t BlockBatchSize(size_t nBytesPerProjection);
+	/// \brief Registers the time of a block batch and selects the next batch size to try
+	/// \param nBatch The number of projections in the batch
+	/// \param fSeconds The processing time of the batch
+	void TuneBlockBatchSize(size_t nBatch, double fSeconds);
+
 	std::vector<std::pair<ProjectionInfo, kipl::base::TImage<float, 2> > > ProjectionList;
 	kipl::base::TImage<float,3> projections;
 	size_t nProjCounter; //!< Counts the projections in the buffer
@@ -66,6 +81,10 @@ protected:
 
 	size_t nProjectionBufferSize;
 	size_t nSliceBlock;
+	size_t nBlockBatchSize;   //!< Batch size of the block back-projection, 0 until the batch size is tuned
+	size_t nBatchCandidate;   //!< Batch size currently being timed
+	size_t nBestBatchSize;    //!< Fastest batch size measured so far
+	double fBestBatchTime;    //!< Time per projection of the fastest batch size
 	size_t nSubVolume[2];
 	float fRotation;
 
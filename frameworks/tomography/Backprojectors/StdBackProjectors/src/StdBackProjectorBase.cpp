@@ -8,12 +8,15 @@
 #include <sstream>
 #include <fstream>
 #include <limits>
+#include <vector>
+#include <algorithm>
 
 #include <ParameterHandling.h>
 
 #include <strings/miscstring.h>
 #include <base/tpermuteimage.h>
 #include <math/mathconstants.h>
+#include <profile/Timer.h>
 
 #define USE_PROJ_PADDING
 
@@ -27,6 +30,10 @@ MatrixCenterX(0),
 ProjCenter(0.0f),
 nProjectionBufferSize(16),
 nSliceBlock(32),
+nBlockBatchSize(0),
+nBatchCandidate(0),
+nBestBatchSize(0),
+fBestBatchTime(0.0),
 fRotation(0.0f),
 filter(nullptr)
 {
@@ -106,12 +113,11 @@ size_t StdBackProjectorBase::Process(kipl::base::TImage<float,2> proj, float ang
 #endif
     nProjCounter++;
     if (bLastProjection || (nProjectionBufferSize<=(nProjCounter))) {
-        if (nProjectionBufferSize<=nProjCounter)
-            nProjCounter--;
-
-        msg.str("");
-        msg<<"Counter="<<nProjCounter<<", buffer size="<<nProjectionBufferSize<<" last "<<(bLastProjection ? "True" : "False");
-        logger(logger.LogDebug,msg.str());
+        if (logger.IsEnabled(logger.LogDebug)) {
+            msg.str("");
+            msg<<"Counter="<<nProjCounter<<", buffer size="<<nProjectionBufferSize<<" last "<<(bLastProjection ? "True" : "False");
+            logger(logger.LogDebug,msg.str());
+        }
 		this->BackProject();
 		nProjCounter=0;
 	}
@@ -120,37 +126,167 @@ size_t StdBackProjectorBase::Process(kipl::base::TImage<float,2> proj, float ang
 	return nProjCounter;
 }
 
-size_t StdBackProjectorBase::Process(kipl::base::TImage<float,3> projections, std::map<std::string, std::string> parameters)
+size_t StdBackProjectorBase::Process(kipl::base::TImage<float,3> proj, std::map<std::string, std::string> parameters)
 {
 	if (volume.Size()==0)
 		throw ReconException("The target matrix is not allocated.",__FILE__,__LINE__);
 
-	kipl::base::TImage<float,2> img(projections.Dims());
+	const bool bTransposed=MatrixAlignment==MatrixZXY;
+	if ((proj.Size(0)!=projections.Size(bTransposed ? 1 : 0)) || (projections.Size(bTransposed ? 0 : 1)<proj.Size(1)))
+		throw ReconException("The projection block doesn't match the ROI of the back-projector.",__FILE__,__LINE__);
 
-	size_t nProj=projections.Size(2);
+	const size_t nProj=proj.Size(2);
 	// Extract the projection parameters
-	float *weights=new float[nProj+16];
-	GetFloatParameterVector(parameters,"weights",weights,nProj);
+	std::vector<float> weights(nProj+16,0.0f);
+	GetFloatParameterVector(parameters,"weights",weights.data(),nProj);
 
+	std::vector<float> angles(nProj+16,0.0f);
+	GetFloatParameterVector(parameters,"angles",angles.data(),nProj);
 
-	float *angles=new float[nProj+16];
-	GetFloatParameterVector(parameters,"angles",angles,nProj);
+	// The geometry tables are computed once for the whole block
+	ProjCenter=mConfig.ProjectionInfo.fCenter;
+	const float dirWeight = 2.0f*(mConfig.ProjectionInfo.eDirection-0.5f);
+	std::vector<float> blockSin(nProj), blockCos(nProj), blockStartU(nProj);
+	for (size_t i=0; i<nProj; i++) {
+		blockSin[i]    = sin(dirWeight*angles[i]*fPi/180.0f);
+		blockCos[i]    = cos(dirWeight*angles[i]*fPi/180.0f);
+		blockStartU[i] = MatrixCenterX*(blockSin[i]-blockCos[i])+ProjCenter;
+	}
 
-	// Process the projections
-	float *pImg=img.GetDataPtr();
-    float *pProj=nullptr;
-	size_t i=0;
-	for (i=0; (i<nProj) && (!UpdateStatus(static_cast<float>(i)/nProj, "Back-projecting")); i++) {
-		pProj=projections.GetLinePtr(0,i);
-		memcpy(pImg,pProj,sizeof(float)*img.Size());
-		Process(img,angles[i],weights[i],i==(nProj-1));
+	// Without projection filter the projections are transposed directly from the block into the back-projection buffer.
+	// The filter keeps its work buffers in the instance, each thread filters with its own copy of the settings.
+	const bool bFilter = filter.filterType()!=ImagingAlgorithms::ProjectionFilterNone;
+	const std::map<std::string, std::string> filterParameters=filter.parameters();
+
+	size_t bufferDims[3]={projections.Size(0), projections.Size(1), projections.Size(2)};
+	const size_t nBytesPerProjection=bufferDims[0]*bufferDims[1]*sizeof(float);
+
+	kipl::profile::Timer timer;
+	for (size_t first=0; (first<nProj) && (!UpdateStatus(static_cast<float>(first)/nProj, "Back-projecting")); ) {
+		const size_t nBatch=std::min(nProj-first,BlockBatchSize(nBytesPerProjection));
+
+		timer.Tic();
+		if (projections.Size(2)<nBatch) {
+			bufferDims[2]=nBatch;
+			projections.Resize(bufferDims);
+			projections=0.0f;
+		}
+
+		if (bFilter) {
+			#pragma omp parallel
+			{
+				ImagingAlgorithms::ProjectionFilter threadFilter;
+				threadFilter.setParameters(filterParameters);
+				kipl::base::TImage<float,2> filtered(proj.Dims());
+
+				#pragma omp for
+				for (ptrdiff_t i=0; i<static_cast<ptrdiff_t>(nBatch); i++) {
+					std::copy_n(proj.GetLinePtr(0,first+i),filtered.Size(),filtered.GetDataPtr());
+					threadFilter.process(filtered);
+					TransposeProjection(filtered.GetDataPtr(),filtered.Dims(),weights[first+i],projections.GetLinePtr(0,i));
+				}
+			}
+		}
+		else {
+			#pragma omp parallel for
+			for (ptrdiff_t i=0; i<static_cast<ptrdiff_t>(nBatch); i++) {
+				TransposeProjection(proj.GetLinePtr(0,first+i),proj.Dims(),weights[first+i],projections.GetLinePtr(0,i));
+			}
+		}
+
+		std::copy_n(weights.begin()+first,     nBatch, fWeights);
+		std::copy_n(blockSin.begin()+first,    nBatch, fSin);
+		std::copy_n(blockCos.begin()+first,    nBatch, fCos);
+		std::copy_n(blockStartU.begin()+first, nBatch, fStartU);
+
+		nProjCounter=nBatch;
+		this->BackProject();
+		nProjCounter=0;
+
+		timer.Toc();
+		TuneBlockBatchSize(nBatch,timer.elapsedTime(kipl::profile::Timer::seconds));
+		first+=nBatch;
 	}
 
-	delete [] weights;
-	delete [] angles;
 	return 0;
 }
 
+void StdBackProjectorBase::TransposeProjection(float const * pSrc, size_t const * dims, float weight, float *pDest)
+{
+	const size_t nStride=projections.Size(0);
+
+	if (MatrixAlignment==MatrixZXY) {
+		// Tiles of 32x32 pixels keep both the source rows and the destination columns in the cache
+		const size_t nTile=32;
+		for (size_t v0=0; v0<dims[1]; v0+=nTile) {
+			const size_t v1=std::min(dims[1],v0+nTile);
+			for (size_t u0=0; u0<dims[0]; u0+=nTile) {
+				const size_t u1=std::min(dims[0],u0+nTile);
+				for (size_t v=v0; v<v1; v++) {
+					float const * pRow=pSrc+v*dims[0];
+					for (size_t u=u0; u<u1; u++)
+						pDest[u*nStride+v]=weight*pRow[u];
+				}
+			}
+		}
+	}
+	else {
+		for (size_t v=0; v<dims[1]; v++) {
+			float const * pRow=pSrc+v*dims[0];
+			float *pLine=pDest+v*nStride;
+			for (size_t u=0; u<dims[0]; u++)
+				pLine[u]=weight*pRow[u];
+		}
+	}
+}
+
+size_t StdBackProjectorBase::BlockBatchSize(size_t nBytesPerProjection)
+{
+	if (nBlockBatchSize!=0)
+		return nBlockBatchSize;
+
+	// The batch is limited by the geometry tables and a buffer budget of 1 GB
+	const size_t nMaxBatch=std::min(static_cast<size_t>(1024),
+									std::max(nProjectionBufferSize,(static_cast<size_t>(1)<<30)/nBytesPerProjection));
+
+	if (nBatchCandidate==0)
+		nBatchCandidate=std::min(nMaxBatch,std::max(nProjectionBufferSize,static_cast<size_t>(16)));
+
+	if ((nMaxBatch<nBatchCandidate) && (nBestBatchSize!=0)) {
+		nBlockBatchSize=std::min(nBestBatchSize,nMaxBatch);
+
+		std::ostringstream msg;
+		msg<<"Block back-projection uses batches of "<<nBlockBatchSize<<" projections";
+		logger(kipl::logging::Logger::LogMessage,msg.str());
+
+		return nBlockBatchSize;
+	}
+
+	return std::min(nBatchCandidate,nMaxBatch);
+}
+
+void StdBackProjectorBase::TuneBlockBatchSize(size_t nBatch, double fSeconds)
+{
+	// Partial batches at the end of a block aren't representative
+	if ((nBlockBatchSize!=0) || (nBatch!=nBatchCandidate))
+		return;
+
+	const double fTimePerProjection=fSeconds/nBatch;
+
+	if ((nBestBatchSize==0) || (fTimePerProjection<0.95*fBestBatchTime)) {
+		nBestBatchSize = nBatch;
+		fBestBatchTime = fTimePerProjection;
+		nBatchCandidate*=2;
+	}
+	else {
+		nBlockBatchSize=nBestBatchSize;
+
+		std::ostringstream msg;
+		msg<<"Block back-projection uses batches of "<<nBlockBatchSize<<" projections";
+		logger(kipl::logging::Logger::LogMessage,msg.str());
+	}
+}
+
 void StdBackProjectorBase::SetROI(size_t *roi)
 {
 	ClearAll();
@@ -251,75 +387,30 @@ void StdBackProjectorBase::ChangeMaskValue(float x)
 
 void StdBackProjectorBase::GetHistogram(float *axis, size_t *hist,size_t nBins)
 {
-	float matrixMin=Min();
-	float matrixMax=Max();
-	ostringstream msg;
+	kipl::math::VolumeStatistics stats;
+	GetStatistics(stats);
 
-	msg<<"Preparing histogram; #bins: "<<nBins<<", Min: "<<matrixMin<<", Max: "<<matrixMax;
+	ostringstream msg;
+	msg<<"Preparing histogram; #bins: "<<nBins<<", Min: "<<stats.Min()<<", Max: "<<stats.Max();
 	logger(kipl::logging::Logger::LogMessage,msg.str());
 
-	memset(axis,0,sizeof(float)*nBins);
-	memset(hist,0,sizeof(size_t)*nBins);
-	float scale=(matrixMax-matrixMin)/(nBins+1);
-	float invScale=1.0f/scale;
-	size_t index=0;
-	for (size_t y=0; y<mask.size(); y++) {
-		for (size_t x=mask[y].first; x<mask[y].second; x++) {
-			float *pLine=volume.GetLinePtr(x,y);
-			for (size_t z=0; z<volume.Size(0); z++) { 
-				index=static_cast<size_t>(invScale*(pLine[z]-matrixMin));
-                if (pLine[z]<matrixMin)
-					index=0;
-				else if (nBins<=index)
-					index=nBins-1;
-				hist[index]++;
-			}
-		}
-	}
-
-	axis[0]=matrixMin+scale/2.0f;
-	for (size_t i=1; i<nBins; i++)
-		axis[i]=axis[i-1]+scale;
+	stats.GetHistogram(axis,hist,nBins);
 }
 
 float StdBackProjectorBase::Min()
 {
-	float minval=std::numeric_limits<float>::max();
-	
-    if (MatrixAlignment==StdBackProjectorBase::MatrixXYZ) {
-        logger(kipl::logging::Logger::LogWarning,"Min is not implemented for MatrixXYZ");
-        throw ReconException("Min is not implemented for MatrixXYZ",__FILE__,__LINE__);
-    }
-    else {
-		for (size_t y=0; y<mask.size(); y++) {
-			for (size_t x=mask[y].first; x<mask[y].second; x++) {
-				float *pLine=volume.GetLinePtr(x,y);
-				minval=min(minval,*min(pLine,pLine+volume.Size(0)));
-			}
-        }
-    }
+	kipl::math::VolumeStatistics stats;
+	GetStatistics(stats);
 
-	return minval;
+	return static_cast<float>(stats.Min());
 }
 
 float StdBackProjectorBase::Max()
 {
-	float maxval=-std::numeric_limits<float>::max();
-	
-    if (MatrixAlignment==StdBackProjectorBase::MatrixXYZ) {
-        logger(kipl::logging::Logger::LogWarning,"Max is not implemented for MatrixXYZ");
-        throw ReconException("Max is not implemented for MatrixXYZ",__FILE__,__LINE__);
-    }
-    else {
-		for (size_t y=0; y<mask.size(); y++) {
-			for (size_t x=mask[y].first; x<mask[y].second; x++) {
-				float *pLine=volume.GetLinePtr(x,y);
-				maxval=max(maxval,*min(pLine,pLine+volume.Size(0)));
-			}
-        }
-    }
-	
-	return maxval;
+	kipl::math::VolumeStatistics stats;
+	GetStatistics(stats);
+
+	return static_cast<float>(stats.Max());
 }
 
 int StdBackProjectorBase::Configure(ReconConfig config, std::map<std::string, std::string> parameters)
@@ -330,6 +421,12 @@ int StdBackProjectorBase::Configure(ReconConfig config, std::map<std::string, st
     nSliceBlock           = GetIntParameter(parameters,"SliceBlock");
 	GetUIntParameterVector(parameters,"SubVolume",nSubVolume,2);
     filter.setParameters(parameters);
+
+	// The block batch size is tuned again for the new configuration
+	nBlockBatchSize = 0;
+	nBatchCandidate = 0;
+	nBestBatchSize  = 0;
+	fBestBatchTime  = 0.0;
 	
 	return 0;
 }
@@ -105,8 +105,6 @@ size_t VectorBackProjectorBase::Process(kipl::base::TImage<float,2> proj, float
 #endif
 	nProjCounter++;
 	if (bLastProjection || (nProjectionBufferSize<=nProjCounter)) {
-		if (nProjectionBufferSize<=nProjCounter)
-			nProjCounter--;
 		this->BackProject();
 		nProjCounter=0;
 	}
@@ -55,7 +55,9 @@ SOURCES += reconalgorithms.cpp \
     basicbackprojector.cpp \
     nnforwardprojector.cpp \
     reconalgorithmexception.cpp \
-    linearforwardprojector.cpp
+    linearforwardprojector.cpp \
+    linearbackprojector.cpp \
+    parallelbeamgeometry.cpp
 
 HEADERS += reconalgorithms.h\
         reconalgorithms_global.h \
@@ -65,7 +67,9 @@ HEADERS += reconalgorithms.h\
     basicbackprojector.h \
     nnforwardprojector.h \
     reconalgorithmexception.h \
-    linearforwardprojector.h
+    linearforwardprojector.h \
+    linearbackprojector.h \
+    parallelbeamgeometry.h
 
 unix {
     target.path = /usr/lib
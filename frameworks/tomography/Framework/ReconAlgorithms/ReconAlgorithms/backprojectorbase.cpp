@@ -1,4 +1,5 @@
 #include "backprojectorbase.h"
+#include "reconalgorithmexception.h"
 
 BackProjectorBase::BackProjectorBase(std::string name) :
     logger(name),
@@ -12,6 +13,13 @@ BackProjectorBase::~BackProjectorBase()
 
 }
 
+int BackProjectorBase::backproject(kipl::base::TImage<float,3> &proj, float center, const std::vector<float> &angles, kipl::base::TImage<float,3> &slices)
+{
+    throw ReconAlgorithmException(m_sName+" does not support back-projection of sinogram stacks",__FILE__,__LINE__);
+
+    return 0;
+}
+
 int BackProjectorBase::buildMask(float center, size_t *dims)
 {
 
@@ -6,6 +6,7 @@
 #include "reconalgorithms_global.h"
 #include <string>
 #include <list>
+#include <vector>
 
 #include <logging/logger.h>
 #include <base/timage.h>
@@ -23,6 +24,14 @@ public:
     virtual int backproject(kipl::base::TImage<float,2> &proj, float center, std::list<float> & angles, kipl::base::TImage<float,2> &slice) = 0;
     virtual int backproject(kipl::base::TImage<float,3> &proj, float center, std::list<float> & angles, kipl::base::TImage<float,3> &slices) = 0;
 
+    /// \brief Back-projects a stack of sinograms.
+    /// \param proj The sinograms, one sinogram (detector x angles) per xy-plane.
+    /// \param center The position of the rotation axis on the detector.
+    /// \param angles The projection angles in degrees.
+    /// \param slices The back-projected slices, one slice per xy-plane.
+    /// \returns The number of back-projected angles.
+    virtual int backproject(kipl::base::TImage<float,3> &proj, float center, const std::vector<float> &angles, kipl::base::TImage<float,3> &slices);
+
     /// \brief Set the pixel size in mm
     /// \param size The new pixel size
     void setPixelSize(float size) {m_PixelSize=size;}
@@ -7,6 +7,17 @@ ForwardProjectorBase::ForwardProjectorBase(std::string name) :
 {
 }
 
+ForwardProjectorBase::~ForwardProjectorBase()
+{
+}
+
+int ForwardProjectorBase::project(kipl::base::TImage<float,3> &slices, const std::vector<float> &angles, float center, kipl::base::TImage<float,3> &proj)
+{
+    throw ReconAlgorithmException(m_sName+" does not support projection with a rotation center",__FILE__,__LINE__);
+
+    return 0;
+}
+
 int ForwardProjectorBase::buildMask(const size_t *dims)
 {
     if (dims[0]!=dims[1])
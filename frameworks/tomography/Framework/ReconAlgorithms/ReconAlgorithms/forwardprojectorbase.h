@@ -4,6 +4,7 @@
 #include "reconalgorithms_global.h"
 #include <string>
 #include <list>
+#include <vector>
 
 #include <logging/logger.h>
 #include <base/timage.h>
@@ -16,10 +17,19 @@ protected:
 
 public:
     ForwardProjectorBase(std::string name = "ForwardProjectorBase");
+    virtual ~ForwardProjectorBase();
 
     virtual int project(kipl::base::TImage<float,2> &slice, std::list<float> & angles, kipl::base::TImage<float,2> &proj) = 0;
     virtual int project(kipl::base::TImage<float,3> &slice, std::list<float> & angles, kipl::base::TImage<float,3> &proj) = 0;
 
+    /// \brief Projects a stack of slices with the rotation axis at a given detector position.
+    /// \param slices The slices, one slice per xy-plane.
+    /// \param angles The projection angles in degrees.
+    /// \param center The position of the rotation axis on the detector.
+    /// \param proj The sinograms, one sinogram (detector x angles) per xy-plane.
+    /// \returns The number of projected angles.
+    virtual int project(kipl::base::TImage<float,3> &slices, const std::vector<float> &angles, float center, kipl::base::TImage<float,3> &proj);
+
     void setPixelSize(float size) { m_PixelSize=size; }
 protected:
     int buildMask(const size_t *dims);
@@ -0,0 +1,67 @@
+#include <cstring>
+
+#include "linearbackprojector.h"
+#include "parallelbeamgeometry.h"
+#include "reconalgorithmexception.h"
+
+LinearBackProjector::LinearBackProjector() :
+    BackProjectorBase("LinearBackProjector")
+{
+
+}
+
+LinearBackProjector::~LinearBackProjector()
+{
+
+}
+
+int LinearBackProjector::backproject(kipl::base::TImage<float,2> &proj, float center, std::list<float> & angles, kipl::base::TImage<float,2> &slice)
+{
+    size_t dims[3]={proj.Size(0), proj.Size(1), 1};
+    kipl::base::TImage<float,3> sino(dims);
+    memcpy(sino.GetDataPtr(),proj.GetDataPtr(),proj.Size()*sizeof(float));
+
+    kipl::base::TImage<float,3> slices;
+    std::vector<float> angleVec(angles.begin(),angles.end());
+    backproject(sino,center,angleVec,slices);
+
+    size_t sliceDims[2]={slices.Size(0), slices.Size(1)};
+    slice.Resize(sliceDims);
+    memcpy(slice.GetDataPtr(),slices.GetDataPtr(),slice.Size()*sizeof(float));
+
+    return static_cast<int>(angles.size());
+}
+
+int LinearBackProjector::backproject(kipl::base::TImage<float,3> &proj, float center, std::list<float> & angles, kipl::base::TImage<float,3> &slices)
+{
+    std::vector<float> angleVec(angles.begin(),angles.end());
+
+    return backproject(proj,center,angleVec,slices);
+}
+
+int LinearBackProjector::backproject(kipl::base::TImage<float,3> &proj, float center, const std::vector<float> &angles, kipl::base::TImage<float,3> &slices)
+{
+    if (proj.Size(1)!=angles.size())
+        throw ReconAlgorithmException("The number of sinogram lines does not match the number of angles",__FILE__,__LINE__);
+
+    const size_t N=proj.Size(0);
+    size_t dims[3]={N, N, proj.Size(2)};
+    slices.Resize(dims);
+    slices=0.0f;
+
+    ParallelBeamGeometry geometry(angles,center,N,N);
+
+    // Each slice row is owned by one thread, no synchronization is needed
+    const ptrdiff_t nRows=static_cast<ptrdiff_t>(N);
+    const ptrdiff_t nLines=nRows*static_cast<ptrdiff_t>(proj.Size(2));
+
+    #pragma omp parallel for
+    for (ptrdiff_t line=0; line<nLines; ++line) {
+        const size_t z=line/nRows;
+        const size_t y=line%nRows;
+
+        geometry.backprojectRow(y,proj.GetLinePtr(0,z),slices.GetLinePtr(y,z));
+    }
+
+    return static_cast<int>(angles.size());
+}
@@ -0,0 +1,28 @@
+#ifndef LINEARBACKPROJECTOR_H
+#define LINEARBACKPROJECTOR_H
+
+#include "reconalgorithms_global.h"
+#include "backprojectorbase.h"
+
+/// \brief Back-projector matched to the LinearForwardProjector, i.e. it computes the transpose of the linear projection operator.
+///
+/// The matched pair is needed by the algebraic reconstruction methods. The back-projection is pixel driven and the rows of the slices are processed in parallel.
+class RECONALGORITHMSSHARED_EXPORT LinearBackProjector : public BackProjectorBase
+{
+public:
+    LinearBackProjector();
+    ~LinearBackProjector();
+
+    virtual int backproject(kipl::base::TImage<float,2> &proj, float center, std::list<float> & angles, kipl::base::TImage<float,2> &slice);
+    virtual int backproject(kipl::base::TImage<float,3> &proj, float center, std::list<float> & angles, kipl::base::TImage<float,3> &slices);
+
+    /// \brief Back-projects a stack of sinograms.
+    /// \param proj The sinograms, one sinogram (detector x angles) per xy-plane.
+    /// \param center The position of the rotation axis on the detector.
+    /// \param angles The projection angles in degrees.
+    /// \param slices The back-projected slices, the slice width equals the number of detector bins.
+    /// \returns The number of back-projected angles.
+    virtual int backproject(kipl::base::TImage<float,3> &proj, float center, const std::vector<float> &angles, kipl::base::TImage<float,3> &slices);
+};
+
+#endif // LINEARBACKPROJECTOR_H
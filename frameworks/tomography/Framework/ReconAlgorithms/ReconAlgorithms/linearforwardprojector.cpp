@@ -1,8 +1,11 @@
 #include "linearforwardprojector.h"
+#include "parallelbeamgeometry.h"
+#include <cstring>
 #include <math/mathconstants.h>
 #include <reconalgorithmexception.h>
 
-LinearForwardProjector::LinearForwardProjector()
+LinearForwardProjector::LinearForwardProjector() :
+    ForwardProjectorBase("LinearForwardProjector")
 {
 
 }
@@ -145,7 +148,47 @@ int LinearForwardProjector::project(kipl::base::TImage<float,2> &slice, std::lis
 
 int LinearForwardProjector::project(kipl::base::TImage<float,3> &slice, std::list<float> & angles, kipl::base::TImage<float,3> &proj)
 {
-    throw ReconAlgorithmException("Linear forward projection for multiple slices is not implemented",__FILE__,__LINE__);
+    size_t dims[3]={slice.Size(0), angles.size(), slice.Size(2)};
+    proj.Resize(dims);
 
-    return 0;
+    const ptrdiff_t nSlices=static_cast<ptrdiff_t>(slice.Size(2));
+
+    #pragma omp parallel for
+    for (ptrdiff_t z=0; z<nSlices; ++z) {
+        kipl::base::TImage<float,2> img(slice.Dims());
+        kipl::base::TImage<float,2> sino;
+
+        memcpy(img.GetDataPtr(),slice.GetLinePtr(0,z),img.Size()*sizeof(float));
+        project(img,angles,sino);
+        memcpy(proj.GetLinePtr(0,z),sino.GetDataPtr(),sino.Size()*sizeof(float));
+    }
+
+    return static_cast<int>(angles.size());
+}
+
+int LinearForwardProjector::project(kipl::base::TImage<float,3> &slices, const std::vector<float> &angles, float center, kipl::base::TImage<float,3> &proj)
+{
+    if (slices.Size(0)!=slices.Size(1))
+        throw ReconAlgorithmException("Input slice does not have same number of rows as columns",__FILE__,__LINE__);
+
+    const size_t N=slices.Size(0);
+    size_t dims[3]={N, angles.size(), slices.Size(2)};
+    proj.Resize(dims);
+    proj=0.0f;
+
+    ParallelBeamGeometry geometry(angles,center,N,N);
+
+    // Each sinogram line is owned by one thread, no synchronization is needed
+    const ptrdiff_t nAngles=static_cast<ptrdiff_t>(angles.size());
+    const ptrdiff_t nLines=nAngles*static_cast<ptrdiff_t>(slices.Size(2));
+
+    #pragma omp parallel for
+    for (ptrdiff_t line=0; line<nLines; ++line) {
+        const size_t z=line/nAngles;
+        const size_t t=line%nAngles;
+
+        geometry.projectLine(t,slices.GetLinePtr(0,z),proj.GetLinePtr(t,z));
+    }
+
+    return static_cast<int>(nAngles);
 }
@@ -12,6 +12,14 @@ public:
 
     virtual int project(kipl::base::TImage<float,2> &slice, std::list<float> & angles, kipl::base::TImage<float,2> &proj);
     virtual int project(kipl::base::TImage<float,3> &slice, std::list<float> & angles, kipl::base::TImage<float,3> &proj);
+
+    /// \brief Projects a stack of slices using the footprint of Joseph's method. The sinograms are computed in parallel.
+    /// \param slices The slices, one slice per xy-plane.
+    /// \param angles The projection angles in degrees.
+    /// \param center The position of the rotation axis on the detector.
+    /// \param proj The sinograms, one sinogram (detector x angles) per xy-plane. The detector has as many bins as the slice width.
+    /// \returns The number of projected angles.
+    virtual int project(kipl::base::TImage<float,3> &slices, const std::vector<float> &angles, float center, kipl::base::TImage<float,3> &proj);
 };
 
 #endif // LINEARFORWARDPROJECTOR_H
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cmath>
+
+#include <math/mathconstants.h>
+
+#include "parallelbeamgeometry.h"
+#include "reconalgorithmexception.h"
+
+ParallelBeamGeometry::ParallelBeamGeometry(const std::vector<float> &angles, float center, size_t size, size_t bins) :
+    m_a(angles.size()),
+    m_b(angles.size()),
+    m_invS(angles.size()),
+    m_fCenter(center),
+    m_fMatrixCenter(static_cast<float>(size/2)),
+    m_nSize(size),
+    m_nBins(bins)
+{
+    if ((size==0) || (bins==0))
+        throw ReconAlgorithmException("The projection geometry needs a non-empty slice and detector",__FILE__,__LINE__);
+
+    for (size_t i=0; i<angles.size(); ++i) {
+        const float theta=angles[i]*fPi/180.0f;
+        m_a[i]    = -sin(theta);
+        m_b[i]    =  cos(theta);
+        m_invS[i] = 1.0f/std::max(fabs(m_a[i]),fabs(m_b[i]));
+    }
+}
+
+void ParallelBeamGeometry::projectLine(size_t idx, const float *slice, float *proj) const
+{
+    const float a    = m_a[idx];
+    const float b    = m_b[idx];
+    const float invS = m_invS[idx];
+    const int   nBins = static_cast<int>(m_nBins);
+
+    for (size_t y=0; y<m_nSize; ++y) {
+        const float *pRow = slice+y*m_nSize;
+        float u = m_fCenter - a*m_fMatrixCenter + b*(y-m_fMatrixCenter);
+
+        for (size_t x=0; x<m_nSize; ++x, u+=a) {
+            const int   r0 = static_cast<int>(floor(u));
+            const float d  = u-r0;
+
+            if ((0<=r0) && (r0<nBins))
+                proj[r0]   += pRow[x]*std::max(0.0f,1.0f-d*invS)*invS;
+
+            if ((0<=r0+1) && (r0+1<nBins))
+                proj[r0+1] += pRow[x]*std::max(0.0f,1.0f-(1.0f-d)*invS)*invS;
+        }
+    }
+}
+
+void ParallelBeamGeometry::backprojectRow(size_t y, const float *sino, float *row) const
+{
+    const int nBins = static_cast<int>(m_nBins);
+    const int nSize = static_cast<int>(m_nSize);
+
+    for (size_t t=0; t<m_a.size(); ++t) {
+        const float a     = m_a[t];
+        const float invS  = m_invS[t];
+        const float start = m_fCenter - a*m_fMatrixCenter + m_b[t]*(y-m_fMatrixCenter);
+        const float *pLine = sino+t*m_nBins;
+
+        // Branch free inner loop, out of range bins get zero weight
+        for (int x=0; x<nSize; ++x) {
+            const float u  = start+a*x;
+            const int   r0 = static_cast<int>(floor(u));
+            const float d  = u-r0;
+            const int   i0 = std::min(std::max(r0,0),nBins-1);
+            const int   i1 = std::min(std::max(r0+1,0),nBins-1);
+            const float w0 = ((0<=r0)   && (r0<nBins))   ? std::max(0.0f,1.0f-d*invS)*invS        : 0.0f;
+            const float w1 = ((0<=r0+1) && (r0+1<nBins)) ? std::max(0.0f,1.0f-(1.0f-d)*invS)*invS : 0.0f;
+
+            row[x] += w0*pLine[i0]+w1*pLine[i1];
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#ifndef PARALLELBEAMGEOMETRY_H
+#define PARALLELBEAMGEOMETRY_H
+
+#include "reconalgorithms_global.h"
+#include <vector>
+
+/// \brief Precomputed parallel beam geometry shared by the linear forward and back projectors.
+///
+/// The pixel (x,y) of an N x N slice is projected to the detector position
+/// u = center - (x-N/2) sin(theta) + (y-N/2) cos(theta), i.e. the same geometry as the MuhRec back-projectors.
+/// The pixel footprint on the detector is a triangle with the half width s=max(|sin(theta)|,|cos(theta)|),
+/// which is the footprint of Joseph's linear interpolation method. Both projection directions use the same
+/// footprint, the back-projector is therefore the exact transpose of the forward projector.
+class RECONALGORITHMSSHARED_EXPORT ParallelBeamGeometry
+{
+public:
+    /// \brief Builds the geometry tables.
+    /// \param angles Projection angles in degrees.
+    /// \param center Position of the rotation axis on the detector.
+    /// \param size Width of the slice, the slice is size x size pixels.
+    /// \param bins Number of detector bins.
+    ParallelBeamGeometry(const std::vector<float> &angles, float center, size_t size, size_t bins);
+
+    /// \brief Adds the projection of a slice for one angle to a detector line.
+    /// \param idx Angle index.
+    /// \param slice Pointer to the slice data.
+    /// \param proj Pointer to the detector line.
+    void projectLine(size_t idx, const float *slice, float *proj) const;
+
+    /// \brief Adds the back-projection of a sinogram to one row of a slice.
+    /// \param y Row index in the slice.
+    /// \param sino Pointer to the sinogram with one line per angle.
+    /// \param row Pointer to the slice row.
+    void backprojectRow(size_t y, const float *sino, float *row) const;
+
+    /// \returns The number of angles
+    size_t angles() const { return m_a.size(); }
+
+protected:
+    std::vector<float> m_a;    ///< Detector position increment in x
+    std::vector<float> m_b;    ///< Detector position increment in y
+    std::vector<float> m_invS; ///< Inverse footprint half width
+    float  m_fCenter;
+    float  m_fMatrixCenter;
+    size_t m_nSize;
+    size_t m_nBins;
+};
+
+#endif // PARALLELBEAMGEOMETRY_H
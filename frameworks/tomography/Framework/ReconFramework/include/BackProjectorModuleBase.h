@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 #include <base/timage.h>
+#include <math/volumestatistics.h>
 #include <logging/logger.h>
 #include <profile/Timer.h>
 #include <interactors/interactionbase.h>
@@ -90,6 +91,11 @@ public:
     /// \param N number of bins
 	virtual void GetHistogram(float *x, size_t *y, size_t N)=0;
 
+    /// \brief Computes the statistics of the reconstructed matrix in the masked region, the lines of the matrix are scanned in parallel.
+    /// The results of consecutive slice blocks can be merged to get the statistics of the whole volume.
+    /// \param stats Receives the statistics, the previous contents are replaced.
+    virtual void GetStatistics(kipl::math::VolumeStatistics &stats);
+
     /// \brief Returns the reconstructed voxel size. Default value is the projection pixel size, this must be adjusted by the magnification for cone beam.
    virtual float GetVoxelSize() {return mConfig.ProjectionInfo.fResolution[0];}
 
@@ -53,6 +53,10 @@ public:
     /// \param interactor A reference to an interactor object to enhance the user experience.
     BackProjItem(std::string application,std::string sharedobject, std::string modulename, kipl::interactors::InteractionBase *interactor=nullptr);
 
+    /// Holds a back-projector that was created without a shared object library, e.g. in a unit test.
+    /// \param module The back-projector, it is deleted by the item.
+    BackProjItem(BackProjectorModuleBase *module);
+
     /// Copy constructor
     /// \param The object to copy
 	BackProjItem(BackProjItem & item);
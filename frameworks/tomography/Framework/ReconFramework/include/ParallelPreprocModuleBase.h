@@ -0,0 +1,99 @@
+//<LICENSE>
+
+#ifndef PARALLELPREPROCMODULEBASE_H
+#define PARALLELPREPROCMODULEBASE_H
+#include "ReconFramework_global.h"
+
+#include <map>
+#include <string>
+
+#include <base/timage.h>
+#include <interactors/interactionbase.h>
+
+#include "PreprocModuleBase.h"
+
+/// \brief Base for preprocessing modules that process the projection block as independent planes.
+///
+/// The block is split into sinograms or projections which are dispatched over the OpenMP threads.
+/// Each plane is passed to the module as a strided view into the block and every thread has its own
+/// scratch data that is reused for all planes processed by the thread. Kernels that only need a few
+/// lines at a time work directly on the view, kernels built on the image filters copy the plane to
+/// the contiguous scratch image first.
+class RECONFRAMEWORKSHARED_EXPORT ParallelPreprocModuleBase : public PreprocModuleBase
+{
+public:
+    /// \brief The plane processed by the module kernel
+    enum ePlane {
+        SinogramPlane,   ///< Sinograms, i.e. one detector row of all projections
+        ProjectionPlane  ///< Single projections
+    };
+
+    /// \brief Constructor that forwards the name and interactor to the base.
+    /// \param name The name of the module.
+    /// \param plane The plane that is passed to ProcessPlane.
+    /// \param interactor Progress and abort interface.
+    ParallelPreprocModuleBase(std::string name, ePlane plane, kipl::interactors::InteractionBase *interactor=nullptr);
+
+    virtual ~ParallelPreprocModuleBase(void);
+
+protected:
+    /// \brief A strided view of a plane in the projection block, the view refers to the data of the block.
+    class RECONFRAMEWORKSHARED_EXPORT PlaneView
+    {
+    public:
+        /// \param data Pointer to the first element of the plane
+        /// \param width Number of elements per line
+        /// \param height Number of lines
+        /// \param stride Distance between two lines in elements
+        /// \param index Index of the plane in the block
+        PlaneView(float *data, size_t width, size_t height, size_t stride, size_t index);
+
+        /// \returns A pointer to line i of the plane
+        float * GetLinePtr(size_t i) { return m_pData+i*m_nStride; }
+        /// \returns The width (0) or height (1) of the plane
+        size_t Size(size_t i) const { return i==0 ? m_nWidth : m_nHeight; }
+        /// \returns The index of the plane in the block
+        size_t Index() const { return m_nIndex; }
+
+        /// \brief Copies the plane into a contiguous image, the image is only reallocated if its size changes.
+        void CopyTo(kipl::base::TImage<float,2> &img);
+        /// \brief Copies a contiguous image back into the plane.
+        void CopyFrom(kipl::base::TImage<float,2> &img);
+    protected:
+        float *m_pData;
+        size_t m_nWidth;
+        size_t m_nHeight;
+        size_t m_nStride;
+        size_t m_nIndex;
+    };
+
+    /// \brief Per-thread scratch data. Modules with additional work buffers derive from it and override CreateScratch.
+    class RECONFRAMEWORKSHARED_EXPORT Scratch
+    {
+    public:
+        virtual ~Scratch() {}
+        kipl::base::TImage<float,2> plane; ///< Contiguous work image, e.g. a copy of the current plane
+    };
+
+    /// \brief Dispatches the planes of the block over the threads.
+    /// \param img The projection block
+    /// \param parameters Parameters forwarded to the module kernel
+    virtual int ProcessCore(kipl::base::TImage<float,3> &img, std::map<std::string,std::string> &parameters);
+
+    /// \brief Hook for computations on the whole block before the planes are processed, e.g. block statistics. Runs on a single thread.
+    virtual int PreparePlanes(kipl::base::TImage<float,3> &img, std::map<std::string,std::string> &parameters);
+
+    /// \brief Creates the scratch data of a thread
+    /// \param dims The plane dimensions
+    virtual Scratch * CreateScratch(size_t const * const dims);
+
+    /// \brief The module kernel, called concurrently for different planes.
+    /// \param plane View of the plane to process in place
+    /// \param scratch The scratch data of the calling thread
+    /// \param parameters Module parameters
+    virtual int ProcessPlane(PlaneView &plane, Scratch &scratch, std::map<std::string,std::string> &parameters)=0;
+
+    ePlane m_ePlane; ///< The plane type processed by the module
+};
+
+#endif // PARALLELPREPROCMODULEBASE_H
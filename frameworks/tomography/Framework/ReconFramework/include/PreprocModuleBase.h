@@ -41,6 +41,17 @@ public:
     /// \returns A version string.
     virtual std::string Version();
 
+    /// Tells if the module is a point-wise operation, i.e. each output pixel only depends on the same input pixel.
+    /// Consecutive point-wise modules are fused by the engine into a single pass over the projection data.
+    /// \returns True if ProcessPointwise is implemented by the module.
+    virtual bool IsPointwise();
+
+    /// The point-wise kernel of the module. It is called concurrently for disjoint spans of the projection data
+    /// and must therefore not start parallel regions or change the module state.
+    /// \param data The span to process in place.
+    /// \param N Number of elements in the span.
+    virtual void ProcessPointwise(float *data, size_t N);
+
 protected:
     /// Extracts a sinogram from the projection data block.
     /// \param projections The projection data block
@@ -39,6 +39,23 @@ public:
             float binning=1.0f,
             size_t const * const nCrop=nullptr);
 
+    /// Reading a single file directly into a slice of a projection stack. The cropped image is binned, rotated,
+    /// and flipped in a single pass that writes to the stack, i.e. no intermediate images are created.
+    /// \param filename The name of the file to read.
+    /// \param flip Should the image be flipped horizontally or vertically.
+    /// \param rotate Should the file be rotated, steps of 90deg.
+    /// \param binning Binning factor.
+    /// \param nCrop ROI for cropping the image. If nullptr is provided the whole image will be read.
+    /// \param stack The projection stack, the size of its slices must match the size of the transformed image.
+    /// \param index Index of the slice to write.
+    void Read(std::string filename,
+            kipl::base::eImageFlip flip,
+            kipl::base::eImageRotate rotate,
+            float binning,
+            size_t const * const nCrop,
+            kipl::base::TImage<float,3> &stack,
+            size_t index);
+
     /// Reading a single file with file name given by a file mask and an index number.
     /// \param path Path to the location where the file is saved
     /// \param filemask The mask of the file to read, # are used as place holders for the number.
@@ -87,6 +104,26 @@ public:
                                           float binning=1.0f,
                                           size_t const * const nCrop=nullptr);
 
+    /// Reading a stack from a Nexus file and computing the projection doses in the same pass
+    /// \param filename The name of the file to read.
+    /// \param start The file index number for starting position along z.
+    /// \param end The file index number for ending position along z
+    /// \param flip Should the image be flipped horizontally or vertically.
+    /// \param rotate Should the file be rotated, steps of 90deg.
+    /// \param binning Binning factor.
+    /// \param nCrop ROI for cropping the image.
+    /// \param nDoseROI The area were the dose is to be measured (x0,y0,x1,y1).
+    /// \param doselist Receives the dose of each projection, it must be allocated with end-start elements. The doses are 1 if the dose ROI is empty.
+    /// \returns The projections in the xy-plane.
+    kipl::base::TImage<float, 3> ReadNexusStack(std::string filename,
+                                          size_t start, size_t end,
+                                          kipl::base::eImageFlip flip,
+                                          kipl::base::eImageRotate rotate,
+                                          float binning,
+                                          size_t const * const nCrop,
+                                          size_t const * const nDoseROI,
+                                          float *doselist);
+
     /// Reading tomo from a Nexus file
     /// \param filename The name of the file to read.
     kipl::base::TImage<float, 3> ReadNexusTomo(std::string filename);
@@ -172,6 +209,57 @@ protected:
 	void UpdateCrop(kipl::base::eImageFlip flip,
 			kipl::base::eImageRotate rotate, size_t *dims, size_t *nCrop);
 
+    /// Reads the cropped image in file orientation, the crop is given in the final orientation and binning.
+    /// \param filename The name of the file to read.
+    /// \param flip How should the image be flipped.
+    /// \param rotate How should the image be rotated.
+    /// \param binning Binning factor.
+    /// \param nCrop ROI for cropping the image. If nullptr is provided the whole image will be read.
+    /// \returns The cropped image before binning and orientation
+    kipl::base::TImage<float,2> ReadCropped(std::string filename,
+            kipl::base::eImageFlip flip,
+            kipl::base::eImageRotate rotate,
+            float binning,
+            size_t const * const nCrop);
+
+    /// Reads a range of Nexus frames in parallel and transforms the projection and the dose ROI of each frame.
+    /// \param filename The name of the file to read.
+    /// \param start The index of the first frame.
+    /// \param end The index after the last frame.
+    /// \param flip How should the image be flipped.
+    /// \param rotate How should the image be rotated.
+    /// \param binning Binning factor.
+    /// \param nCrop ROI for cropping the projections, the whole frame is used for nullptr.
+    /// \param stack Receives the projections, it is allocated by the function. No projections are stored for nullptr.
+    /// \param nDoseROI The area were the dose is to be measured, no doses are computed for nullptr.
+    /// \param doselist Receives the doses, it must be allocated with end-start elements.
+    void ReadNexusFrames(std::string filename,
+            size_t start, size_t end,
+            kipl::base::eImageFlip flip,
+            kipl::base::eImageRotate rotate,
+            float binning,
+            size_t const * const nCrop,
+            kipl::base::TImage<float,3> *stack,
+            size_t const * const nDoseROI,
+            float *doselist);
+
+    /// Computes the dose of a projection as the median of the row average intensity.
+    /// \param img The dose ROI of the projection
+    /// \returns The dose value
+    float ProjectionDose(kipl::base::TImage<float,2> &img);
+
+    /// Bins, rotates and flips an image into a destination buffer.
+    /// \param img The image to transform
+    /// \param flip How should the image be flipped.
+    /// \param rotate How should the image be rotated.
+    /// \param binning Binning factor.
+    /// \param dest The destination buffer, it must be allocated with the size of the transformed image.
+    void BinAndOrient(const kipl::base::TImage<float,2> &img,
+            kipl::base::eImageFlip flip,
+            kipl::base::eImageRotate rotate,
+            float binning,
+            float *dest);
+
     /// Performs the rotation and flipping of the image
     /// \param img The image to transform
     /// \param flip How should the image be flipped.
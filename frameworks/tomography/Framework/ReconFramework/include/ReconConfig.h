@@ -147,6 +147,7 @@ public:
         size_t voi[6];                  ///< Subvolume to reconstruct (volume coordinates x0, x1, y0, y1, z0, z1). Relevant for divergent beam NOT USED ANYMORE
 //        bool bUseVOI;                   ///< Reconstruct the data in the defined volume of interest. Relevant for divergent beam
         kipl::io::eFileType FileType;   ///< File type of the reconstructed slices.
+        kipl::io::eTIFFCompression TIFFCompression; ///< Compression of the reconstructed TIFF slices.
         float fVoxelSize[3];            ///< Voxel size of the reconstructed volume, relevant for divergent beam only
 
 
@@ -14,7 +14,10 @@
 #include <interactors/interactionbase.h>
 #include <logging/logger.h>
 #include <base/kiplenums.h>
+#include <math/volumestatistics.h>
+#include <profile/Timer.h>
 #include <string>
+#include <vector>
 
 class RECONFRAMEWORKSHARED_EXPORT ProjectionBlock
 {
@@ -34,6 +37,19 @@ public:
     std::map<std::string, std::string> parameters;
 };
 
+/// \brief A candidate geometry for the trial reconstruction of a single slice, see ReconEngine::ProcessGeometryTrials
+class RECONFRAMEWORKSHARED_EXPORT GeometryTrial
+{
+public:
+    GeometryTrial(float _center=0.0f, float _tilt=0.0f, float _angleOffset=0.0f);
+
+    float center;         ///< Position of the rotation axis on the sinogram at the tilt pivot
+    float tilt;           ///< Tilt angle of the rotation axis in degrees, it shifts the center by (slice-pivot)*tan(tilt)
+    float angleOffset;    ///< Offset added to all projection angles in degrees
+    float entropy;        ///< Histogram entropy of the reconstructed slice, misaligned geometries give a higher entropy
+    float variation;      ///< Mean absolute gradient of the reconstructed slice, misaligned geometries give more streaks
+};
+
 
 /// \brief A processing engine that performs the reconstruction task using a set of preprocessing modules and a back projector module
 ///
@@ -68,6 +84,55 @@ public:
     /// \param bRerunBackproj This switch selects if the entire reconstruction process it to be performed (false) or if it is sufficient to run the backprojector only using stored projections.
     int Run3D(bool bRerunBackproj=false);
 
+    /// \brief Preprocesses and back-projects a block of projections provided by the caller instead of reading them from file.
+    ///
+    /// The preprocessing chain works in-place on the provided block, i.e. a block wrapping an external buffer will be modified.
+    /// \param projections The projection block with one projection per xy-plane.
+    /// \param angles The acquisition angle of each projection in degrees.
+    /// \param weights The back-projection weight of each projection.
+    /// \param doses The dose of each projection. Unit doses are used if the list is empty.
+    /// \param roi The detector region (x0,y0,x1,y1) covered by the block. The full block starting at the origin is assumed if nullptr is provided.
+    /// \returns 0 if the block was reconstructed and 1 if the process was canceled.
+    int ProcessExternalProjections(kipl::base::TImage<float,3> &projections,
+                                   const std::vector<float> &angles,
+                                   const std::vector<float> &weights,
+                                   const std::vector<float> &doses = std::vector<float>(),
+                                   size_t const * const roi = nullptr);
+
+    /// \brief Wraps a projection buffer owned by the caller, e.g. a NumPy array, without copying it.
+    ///
+    /// The preprocessing modifies the projections in-place. A copy of a buffer that can't be wrapped would silently receive the
+    /// result instead of the caller's buffer, such buffers are therefore rejected.
+    /// \param data The first element of the buffer.
+    /// \param shape The number of projections, rows and columns of the buffer.
+    /// \param strides The strides of the buffer in bytes in the same order as the shape.
+    /// \param bWriteable Tells if the buffer can be modified.
+    /// \returns A projection block sharing the buffer.
+    /// \throws ReconException if the buffer is read-only, has the wrong number of dimensions or isn't C-contiguous.
+    static kipl::base::TImage<float,3> WrapExternalProjections(float *data,
+                                                                const std::vector<size_t> &shape,
+                                                                const std::vector<ptrdiff_t> &strides,
+                                                                bool bWriteable);
+
+    /// \brief Back-projects a single preprocessed and filtered sinogram for a list of candidate geometries in one parallel pass.
+    ///
+    /// The slices are reconstructed with the geometry and linear interpolation of the standard back-projectors, the
+    /// projections are neither read nor preprocessed again. This is intended for the interactive selection of the
+    /// center of rotation, the slice stack needs nTrials*N*N floats for a sinogram of width N.
+    /// \param sinogram The filtered sinogram with one projection per line, the width is the projection ROI width.
+    /// \param angles The acquisition angle of each projection in degrees.
+    /// \param weights The back-projection weight of each projection.
+    /// \param slice The detector line of the sinogram, it is used with the tilt pivot for tilted candidates.
+    /// \param trials The candidate geometries, the sharpness metrics are filled in.
+    /// \param slices Receives the reconstructed slice of each candidate, one slice per xy-plane.
+    /// \returns The index of the candidate with the lowest histogram entropy.
+    size_t ProcessGeometryTrials(const kipl::base::TImage<float,2> &sinogram,
+                                 const std::vector<float> &angles,
+                                 const std::vector<float> &weights,
+                                 size_t slice,
+                                 std::vector<GeometryTrial> &trials,
+                                 kipl::base::TImage<float,3> &slices);
+
     /// \brief Starts the preprocessing chain including loading the projection data. This function is called by the user interface to provide data to the configuration dialogs.
     /// \param roi The region of interest to process
     /// \param sLastModule The chain shall only process until this module is reached
@@ -86,8 +151,17 @@ public:
 	bool Serialize(size_t *dims);
 
 	size_t GetHistogram(float *axis, size_t *hist,size_t nBins);
+    /// \brief Statistics of the reconstructed volume, they are collected as the slice blocks are finished.
+    /// The statistics can be merged with the statistics of other engines that reconstruct different parts of the same volume.
+    const kipl::math::VolumeStatistics & GetVolumeStatistics() const {return m_VolumeStatistics;}
+    /// \brief Gray level interval containing a percentage of the reconstructed voxels, e.g. for 16-bit output.
+    /// \param percentage Percentage of the voxels inside the interval
+    /// \param interval Receives the lower and upper bounds
+    void GetGrayInterval(float percentage, float *interval);
 	void GetMatrixDims(size_t *dims) {dims[0]=m_Volume.Size(0); dims[1]=m_Volume.Size(1); dims[2]=m_Volume.Size(2);}
     kipl::base::TImage<float,2> GetSlice(size_t index, kipl::base::eImagePlanes plane=kipl::base::ImagePlaneXY);
+    /// \brief Gives access to the reconstructed volume. The returned image shares the buffer with the engine.
+    kipl::base::TImage<float,3> GetVolume() {return m_Volume;}
     std::string citations();
     std::vector<Publication> publicationList();
     void writePublicationList(const std::string &fname = "");
@@ -101,7 +175,13 @@ protected:
 	int Process3D(size_t *roi);
     int ProcessExistingProjections3D(size_t *roi);
     int BackProject3D(kipl::base::TImage<float,3> & projections, size_t *roi,std::map<std::string, std::string> parameters);
+    /// \brief Applies a chain of point-wise modules in a single pass, each module processes a cache sized chunk before the next module is applied.
+    /// \param chain The point-wise modules in processing order
+    /// \param projections The projection block to process in place
+    void ProcessPointwiseChain(std::vector<PreprocModuleBase *> &chain, kipl::base::TImage<float,3> &projections);
 	bool UpdateProgress(float val, std::string msg);
+    /// \brief Adds the statistics of the slice block in the back-projector to the volume statistics
+    void CollectBlockStatistics();
     size_t validateImage(float *data, size_t N, const string &description);
 	void Done();
 
@@ -120,8 +200,10 @@ protected:
 	BackProjItem * m_BackProjector;
 
 	kipl::base::TImage<float,3> m_Volume;
+    kipl::math::VolumeStatistics m_VolumeStatistics; //!< Statistics of the slice blocks reconstructed since the last start
 	std::map<float,ProjectionInfo> m_ProjectionList;
 	std::map<std::string, float> m_PreprocCoefficients;
+    std::map<std::string, kipl::profile::Timer> m_PointwiseChainTimers; //!< Execution time of the fused point-wise chains, the key is the chain name
 
     std::list<ProjectionBlock> m_ProjectionBlocks;
 
@@ -0,0 +1,72 @@
+//<LICENSE>
+
+#ifndef RECONSHARD_H
+#define RECONSHARD_H
+
+#include "ReconFramework_global.h"
+
+#include <string>
+#include <logging/logger.h>
+
+#include "ReconConfig.h"
+
+/// \brief Partitions a reconstruction into slice range shards that can be reconstructed by independent processes.
+///
+/// Each shard reconstructs a contiguous range of whole slice blocks. Slice stacks are written directly to the
+/// destination since the slice files are numbered by the absolute slice index. A NeXus volume is written to a
+/// partial file per shard and the partial files are copied into a single volume by merge().
+/// A completed shard writes a manifest. The merge uses the manifests to verify that the slice range is covered
+/// without gaps or overlaps before the result is assembled.
+class RECONFRAMEWORKSHARED_EXPORT ReconShard
+{
+    kipl::logging::Logger logger;
+public:
+    /// \brief Initializes a shard
+    /// \param index The index of the shard, 0 <= index < count
+    /// \param count The number of shards the reconstruction is split into
+    ReconShard(size_t index=0, size_t count=1);
+
+    /// \brief Computes the slice range of the shard in projection rows.
+    /// \param config The configuration of the full reconstruction
+    /// \param first The first slice of the shard
+    /// \param last The slice after the last slice of the shard
+    void sliceRange(const ReconConfig &config, size_t &first, size_t &last) const;
+
+    /// \brief Restricts a configuration to the slice range of the shard and redirects NeXus output to the partial file of the shard.
+    /// \param config The configuration of the full reconstruction, it is modified in place.
+    /// \returns false if the shard has no slices to reconstruct
+    bool apply(ReconConfig &config);
+
+    /// \brief Writes the manifest of a completed shard to the destination path.
+    /// \param config The configuration used to reconstruct the shard, apply() must have been called on it
+    void writeManifest(const ReconConfig &config) const;
+
+    /// \brief Verifies that the shard manifests cover the slice range of the configuration and assembles the volume.
+    ///
+    /// Slice stacks are only verified, i.e. the existence of all slice files is checked. The partial NeXus files are copied into a single volume.
+    /// \param config The configuration of the full reconstruction
+    /// \param count The number of shards
+    /// \throws ReconException if a manifest is missing or the shards don't cover the slice range
+    static void merge(const ReconConfig &config, size_t count);
+
+    /// \brief Builds the name of the manifest file of a shard
+    static std::string manifestName(const ReconConfig &config, size_t index, size_t count);
+
+    /// \brief Builds the name of a partial NeXus file by adding the shard number to the file mask
+    static std::string partialName(const std::string &fileMask, size_t index, size_t count);
+
+private:
+    static std::string shardSuffix(size_t index, size_t count);
+    static bool isNeXus(const ReconConfig &config);
+    template <class ImgType>
+    static void mergeNeXus(const ReconConfig &config, size_t count, size_t first, size_t last);
+
+    size_t m_nIndex;  ///< Index of the shard
+    size_t m_nCount;  ///< Number of shards
+    size_t m_nFirst;  ///< First slice of the shard
+    size_t m_nLast;   ///< Slice after the last slice of the shard
+    std::string m_sManifest; ///< Manifest file name, based on the file mask of the full reconstruction
+    std::string m_sFile;     ///< File mask written by the shard
+};
+
+#endif // RECONSHARD_H
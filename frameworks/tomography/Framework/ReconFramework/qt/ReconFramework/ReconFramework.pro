@@ -17,6 +17,7 @@ DEFINES += RECONFRAMEWORK_LIBRARY
 
 SOURCES += \
     ../../src/ReconHelpers.cpp \
+    ../../src/ReconShard.cpp \
     ../../src/ReconFramework.cpp \
     ../../src/ReconFactory.cpp \
     ../../src/ReconException.cpp \
@@ -24,11 +25,13 @@ SOURCES += \
     ../../src/ReconConfig.cpp \
     ../../src/ProjectionReader.cpp \
     ../../src/PreprocModuleBase.cpp \
+    ../../src/ParallelPreprocModuleBase.cpp \
     ../../src/ModuleItem.cpp \
     ../../src/BackProjectorModuleBase.cpp
 
 HEADERS += \
     ../../include/ReconHelpers.h \
+    ../../include/ReconShard.h \
     ../../include/ReconFramework.h \
     ../../include/ReconFactory.h \
     ../../include/ReconException.h \
@@ -36,6 +39,7 @@ HEADERS += \
     ../../include/ReconConfig.h \
     ../../include/ProjectionReader.h \
     ../../include/PreprocModuleBase.h \
+    ../../include/ParallelPreprocModuleBase.h \
     ../../include/ModuleItem.h \
     ../../include/ReconFramework_global.h \
     ../../include/BackProjectorModuleBase.h \
@@ -1,6 +1,9 @@
 //<LICENSE>
 
+#include <algorithm>
+
 #include <math/mathconstants.h>
+#include <math/volumestatistics.h>
 
 #include "../include/BackProjectorModuleBase.h"
 #include "../include/ReconException.h"
@@ -129,6 +132,45 @@ size_t BackProjectorModuleBase::GetNSlices()
 	return volume.Size(2);
 }
 
+void BackProjectorModuleBase::GetStatistics(kipl::math::VolumeStatistics &stats)
+{
+    stats.reset();
+
+    const bool bMasked = !mask.empty();
+    const bool bZXY    = MatrixAlignment==MatrixZXY;
+    // ZXY: one task per mask row, XYZ: one task per slice
+    const ptrdiff_t N  = static_cast<ptrdiff_t>(bZXY ? (bMasked ? mask.size() : volume.Size(2)) : volume.Size(2));
+
+    #pragma omp parallel
+    {
+        kipl::math::VolumeStatistics local(stats.histogram().size());
+
+        #pragma omp for schedule(dynamic)
+        for (ptrdiff_t i=0; i<N; i++) {
+            if (bZXY) {
+                const size_t x0 = bMasked ? mask[i].first  : 0;
+                const size_t x1 = bMasked ? mask[i].second : volume.Size(1);
+                for (size_t x=x0; x<x1; x++)
+                    local.put(volume.GetLinePtr(x,i),volume.Size(0));
+            }
+            else {
+                const size_t nRows=bMasked ? std::min(mask.size(),volume.Size(1)) : volume.Size(1);
+                for (size_t y=0; y<nRows; y++) {
+                    const size_t x0 = bMasked ? mask[y].first  : 0;
+                    const size_t x1 = bMasked ? mask[y].second : volume.Size(0);
+                    if (x0<x1)
+                        local.put(volume.GetLinePtr(y,i)+x0,x1-x0);
+                }
+            }
+        }
+
+        #pragma omp critical
+        {
+            stats.merge(local);
+        }
+    }
+}
+
 bool BackProjectorModuleBase::UpdateStatus(float val, std::string msg)
 {
     if (m_Interactor!=nullptr) {
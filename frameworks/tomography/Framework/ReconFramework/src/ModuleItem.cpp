@@ -38,6 +38,19 @@ BackProjItem::BackProjItem(std::string application, std::string sharedobject, st
     LoadModuleObject(interactor);
 }
 
+BackProjItem::BackProjItem(BackProjectorModuleBase* module)
+    : logger("BackProjItem")
+    , hinstLib(nullptr)
+    , m_fnModuleFactory(nullptr)
+    , m_fnDestroyer(nullptr)
+    , m_Module(module)
+{
+    if (m_Module == nullptr)
+        throw ReconException("The back-projector module is not allocated", __FILE__, __LINE__);
+
+    m_sModuleName = m_Module->Name();
+}
+
 BackProjItem::BackProjItem(BackProjItem& item)
     : logger("ModuleItem")
 {
@@ -150,6 +163,12 @@ void BackProjItem::Destroy()
 {
     logger(kipl::logging::Logger::LogVerbose, "Destroying");
 
+    // A module without library was created by the caller
+    if (hinstLib == nullptr) {
+        delete m_Module;
+        return;
+    }
+
     m_fnDestroyer(m_sApplication.c_str(), reinterpret_cast<void*>(m_Module));
 
 #ifdef _MSC_VER
@@ -0,0 +1,137 @@
+//<LICENSE>
+#include "stdafx.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "../include/ParallelPreprocModuleBase.h"
+#include "../include/ReconException.h"
+
+ParallelPreprocModuleBase::PlaneView::PlaneView(float *data, size_t width, size_t height, size_t stride, size_t index) :
+    m_pData(data),
+    m_nWidth(width),
+    m_nHeight(height),
+    m_nStride(stride),
+    m_nIndex(index)
+{
+}
+
+void ParallelPreprocModuleBase::PlaneView::CopyTo(kipl::base::TImage<float,2> &img)
+{
+    size_t dims[2]={m_nWidth,m_nHeight};
+    img.Resize(dims);
+
+    for (size_t i=0; i<m_nHeight; i++)
+        std::copy_n(GetLinePtr(i),m_nWidth,img.GetLinePtr(i));
+}
+
+void ParallelPreprocModuleBase::PlaneView::CopyFrom(kipl::base::TImage<float,2> &img)
+{
+    if ((img.Size(0)!=m_nWidth) || (img.Size(1)!=m_nHeight))
+        throw ReconException("The image doesn't match the size of the plane view.",__FILE__,__LINE__);
+
+    for (size_t i=0; i<m_nHeight; i++)
+        std::copy_n(img.GetLinePtr(i),m_nWidth,GetLinePtr(i));
+}
+
+ParallelPreprocModuleBase::ParallelPreprocModuleBase(std::string name, ePlane plane, kipl::interactors::InteractionBase *interactor) :
+    PreprocModuleBase(name,interactor),
+    m_ePlane(plane)
+{
+}
+
+ParallelPreprocModuleBase::~ParallelPreprocModuleBase(void)
+{
+}
+
+int ParallelPreprocModuleBase::PreparePlanes(kipl::base::TImage<float,3> & /*img*/, std::map<std::string,std::string> & /*parameters*/)
+{
+    return 0;
+}
+
+ParallelPreprocModuleBase::Scratch * ParallelPreprocModuleBase::CreateScratch(size_t const * const /*dims*/)
+{
+    return new Scratch;
+}
+
+int ParallelPreprocModuleBase::ProcessCore(kipl::base::TImage<float,3> &img, std::map<std::string,std::string> &parameters)
+{
+    PreparePlanes(img,parameters);
+
+    // A sinogram is one detector row of every projection, i.e. the lines are one projection apart
+    const bool   bSinogram = m_ePlane==SinogramPlane;
+    const size_t width     = img.Size(0);
+    const size_t height    = bSinogram ? img.Size(2) : img.Size(1);
+    const size_t stride    = bSinogram ? img.Size(0)*img.Size(1) : img.Size(0);
+    const ptrdiff_t N      = static_cast<ptrdiff_t>(bSinogram ? img.Size(1) : img.Size(2));
+    const size_t dims[2]   = {width,height};
+
+    bool bAbort=false;
+    bool bFailed=false;
+    std::string sError;
+
+    #pragma omp parallel
+    {
+        std::unique_ptr<Scratch> scratch;
+        try {
+            scratch.reset(CreateScratch(dims));
+        }
+        catch (std::exception &e) {
+            #pragma omp critical
+            {
+                bFailed=true;
+                sError=e.what();
+            }
+        }
+
+        #pragma omp for schedule(dynamic)
+        for (ptrdiff_t i=0; i<N; i++) {
+            bool bSkip=false;
+            #pragma omp atomic read
+            bSkip=bAbort;
+
+            if (bSkip || !scratch)
+                continue;
+
+#ifdef _OPENMP
+            // Only the master thread talks to the interactor
+            if ((omp_get_thread_num()==0) && UpdateStatus(static_cast<float>(i)/N,m_sModuleName)) {
+                #pragma omp atomic write
+                bAbort=true;
+            }
+#else
+            if (UpdateStatus(static_cast<float>(i)/N,m_sModuleName))
+                bAbort=true;
+#endif
+
+            PlaneView plane(bSinogram ? img.GetLinePtr(i,0) : img.GetLinePtr(0,i),width,height,stride,i);
+
+            try {
+                ProcessPlane(plane,*scratch,parameters);
+            }
+            catch (std::exception &e) {
+                #pragma omp critical
+                {
+                    bFailed=true;
+                    sError=e.what();
+                }
+                #pragma omp atomic write
+                bAbort=true;
+            }
+        }
+    }
+
+    if (bFailed) {
+        std::ostringstream msg;
+        msg<<m_sModuleName<<" failed to process a plane: "<<sError;
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+
+    return 0;
+}
@@ -33,6 +33,16 @@ std::string PreprocModuleBase::Version()
     return s.str();
 }
 
+bool PreprocModuleBase::IsPointwise()
+{
+    return false;
+}
+
+void PreprocModuleBase::ProcessPointwise(float * /*data*/, size_t /*N*/)
+{
+    throw ReconException(m_sModuleName+" doesn't provide a point-wise kernel",__FILE__,__LINE__);
+}
+
 int PreprocModuleBase::Configure(std::map<std::string, std::string> parameters)
 {
     return static_cast<int>(parameters.size());
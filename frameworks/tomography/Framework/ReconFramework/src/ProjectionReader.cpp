@@ -2,6 +2,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <iostream>
 #include <algorithm>
 #include <base/timage.h>
@@ -206,11 +207,95 @@ Read(std::string filename,
 		kipl::base::eImageRotate rotate,
 		float binning,
 		size_t const * const nCrop)
+{
+    kipl::base::TImage<float,2> img=ReadCropped(filename,flip,rotate,binning,nCrop);
+
+    size_t dims[2];
+    try {
+        kipl::base::BinAndOrientDims(img.Dims(),static_cast<size_t>(binning),rotate,dims);
+    }
+    catch (kipl::base::KiplException &e) {
+        throw ReconException(e.what(),__FILE__,__LINE__);
+    }
+
+    kipl::base::TImage<float,2> res(dims);
+    BinAndOrient(img,flip,rotate,binning,res.GetDataPtr());
+
+    return res;
+}
+
+void ProjectionReader::Read(std::string filename,
+        kipl::base::eImageFlip flip,
+        kipl::base::eImageRotate rotate,
+        float binning,
+        size_t const * const nCrop,
+        kipl::base::TImage<float,3> &stack,
+        size_t index)
 {
     std::ostringstream msg;
 
-    msg.str(""); msg<<"Reading : "<<filename<<", "<<flip<<", "<<rotate<<" "<<binning;
-    logger(logger.LogVerbose,msg.str());
+    kipl::base::TImage<float,2> img=ReadCropped(filename,flip,rotate,binning,nCrop);
+
+    size_t dims[2];
+    try {
+        kipl::base::BinAndOrientDims(img.Dims(),static_cast<size_t>(binning),rotate,dims);
+    }
+    catch (kipl::base::KiplException &e) {
+        throw ReconException(e.what(),__FILE__,__LINE__);
+    }
+
+    if ((dims[0]!=stack.Size(0)) || (dims[1]!=stack.Size(1)) || (stack.Size(2)<=index)) {
+        msg<<"The projection "<<filename<<" ("<<dims[0]<<"x"<<dims[1]<<") doesn't fit in slice "<<index
+           <<" of the projection stack ("<<stack.Size(0)<<"x"<<stack.Size(1)<<"x"<<stack.Size(2)<<")";
+        logger(kipl::logging::Logger::LogError,msg.str());
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+
+    BinAndOrient(img,flip,rotate,binning,stack.GetLinePtr(0,index));
+}
+
+void ProjectionReader::BinAndOrient(const kipl::base::TImage<float,2> &img,
+        kipl::base::eImageFlip flip,
+        kipl::base::eImageRotate rotate,
+        float binning,
+        float *dest)
+{
+    std::ostringstream msg;
+
+	msg<<"Failed to resample or rotate the projection with a ";
+	try {
+        kipl::base::BinAndOrient(img,static_cast<size_t>(binning),flip,rotate,dest);
+	}
+	catch (kipl::base::KiplException &e) {
+		msg<<"KiplException: \n"<<e.what();
+		logger(kipl::logging::Logger::LogError,msg.str());
+		throw ReconException(msg.str(),__FILE__,__LINE__);
+	}
+	catch (std::exception &e) {
+		msg<<"STL exception: \n"<<e.what();
+		logger(kipl::logging::Logger::LogError,msg.str());
+		throw ReconException(msg.str(),__FILE__,__LINE__);
+	}
+	catch (...) {
+		msg<<"unknown exception.";
+		logger(kipl::logging::Logger::LogError,msg.str());
+		throw ReconException(msg.str(),__FILE__,__LINE__);
+	}
+}
+
+kipl::base::TImage<float,2> ProjectionReader::
+ReadCropped(std::string filename,
+		kipl::base::eImageFlip flip,
+		kipl::base::eImageRotate rotate,
+		float binning,
+		size_t const * const nCrop)
+{
+    std::ostringstream msg;
+
+    if (logger.IsEnabled(logger.LogVerbose)) {
+        msg.str(""); msg<<"Reading : "<<filename<<", "<<flip<<", "<<rotate<<" "<<binning;
+        logger(logger.LogVerbose,msg.str());
+    }
 
     size_t dims[8];
 	try {
@@ -282,34 +367,6 @@ Read(std::string filename,
         throw ReconException(msg.str(),__FILE__,__LINE__);
     }
 
-    size_t bins[2]={static_cast<size_t>(binning), static_cast<size_t>(binning)};
-	kipl::base::TImage<float,2> binned;
-	msg.str("");
-	msg<<"Failed to resample or rotate the projection with a ";
-	try {
-		if (1<binning)
-			kipl::base::ReBin(img,binned,bins);
-		else
-			binned=img;
-        kipl::base::TRotate<float> rotator;
-        img=rotator.Rotate(binned,flip,rotate);
-	}
-	catch (kipl::base::KiplException &e) {
-		msg<<"KiplException: \n"<<e.what();
-		logger(kipl::logging::Logger::LogError,msg.str());
-		throw ReconException(msg.str(),__FILE__,__LINE__);
-	}
-	catch (std::exception &e) {
-		msg<<"STL exception: \n"<<e.what();
-		logger(kipl::logging::Logger::LogError,msg.str());
-		throw ReconException(msg.str(),__FILE__,__LINE__);
-	}
-	catch (...) {
-		msg<<"unknown exception.";
-		logger(kipl::logging::Logger::LogError,msg.str());
-		throw ReconException(msg.str(),__FILE__,__LINE__);
-	}
-
 	return img;
 }
 
@@ -557,110 +614,159 @@ kipl::base::TImage<float, 3> ProjectionReader::ReadNexusStack(std::string filena
                                       float binning,
                                       size_t const * const nCrop)
 {
-    std::ostringstream msg;
     kipl::base::TImage<float,3> img;
 
+    ReadNexusFrames(filename,start,end,flip,rotate,binning,nCrop,&img,nullptr,nullptr);
 
-     #ifdef HAVE_NEXUS
-
-            const char *fname = filename.c_str();
-
-             size_t dims[2];
-             try {
-                 GetImageSizeNexus(filename, binning,dims);
-             }
-             catch (ReconException &e) {
-                 throw ReconException(e.what(),__FILE__,__LINE__);
-             }
-             catch (std::exception &e) {
-                 throw ReconException(e.what(),__FILE__,__LINE__);
-             }
-             catch (kipl::base::KiplException &e) {
-                 throw ReconException(e.what(),__FILE__,__LINE__);
-             }
-             catch (...) {
-                 throw ReconException("Unhandled exception",__FILE__,__LINE__);
-             }
-
-
-             size_t local_crop[4];
-
-             memset(local_crop,0,sizeof(size_t)*4);
-             size_t *pCrop=nullptr;
-             if (nCrop!=nullptr) {
-
-                 local_crop[0]=nCrop[0];
-                 local_crop[1]=nCrop[1];
-                 local_crop[2]=nCrop[2];
-                 local_crop[3]=nCrop[3];
-
-                 // PrintCrop("local_crop pre-update",local_crop);
-                 UpdateCrop(flip,rotate,dims,local_crop);
-
-                 pCrop=local_crop;
-
-                 for (size_t i=0; i<4; i++)
-                     pCrop[i]*=binning;
-             }
-
-             size_t dim_img[3] = {pCrop[2]-pCrop[0], pCrop[3]-pCrop[1], end-start}; // img size in original coordinate
-             img.Resize(dim_img);
-             kipl::io::ReadNexusStack(img, fname, start, end, pCrop);
-
-             kipl::base::TImage<float,3> returnimg;
-             size_t dims_3D[3] = {nCrop[2]-nCrop[0], nCrop[3]-nCrop[1], end-start}; // img size in rotated and binned coordinate
-             returnimg.Resize(dims_3D);
-
-
-             for (size_t i=0; i<img.Size(2); ++i) {
-
-                 kipl::base::TImage<float,2> slice = kipl::base::ExtractSlice(img, i);
-                 kipl::base::TImage<float,2> binned(slice.Dims());
-
-                 size_t bins[2]={static_cast<size_t>(binning), static_cast<size_t>(binning)};
-
-                 msg.str("");
-                 msg<<"Failed to resample or rotate the projection with a ";
-                 try {
-                     if (1<binning) // create a new image with a bin
-                         kipl::base::ReBin(slice,binned,bins);
-                     else
-                         binned=slice;
-                     kipl::base::TRotate<float> rotator;
-                     slice=rotator.Rotate(binned,flip,rotate);
-                 }
-                 catch (kipl::base::KiplException &e) {
-                     msg<<"KiplException: \n"<<e.what();
-                     logger(kipl::logging::Logger::LogError,msg.str());
-                     throw ReconException(msg.str(),__FILE__,__LINE__);
-                 }
-                 catch (std::exception &e) {
-                     msg<<"STL exception: \n"<<e.what();
-                     logger(kipl::logging::Logger::LogError,msg.str());
-                     throw ReconException(msg.str(),__FILE__,__LINE__);
-                 }
-                 catch (...) {
-                     msg<<"unknown exception.";
-                     logger(kipl::logging::Logger::LogError,msg.str());
-                     throw ReconException(msg.str(),__FILE__,__LINE__);
-                 }
-
-                 kipl::base::InsertSlice(returnimg,slice,i); // to check this!!!!
-             }
-
-             return returnimg;
-
-//             return img;
-
-     #else
-         logger.warning("HAVE_NEXUS not defined");
-           throw kipl::base::KiplException("Nexus library is not supported",__FILE__,__LINE__);
-             throw ReconException("Nexus library is not supported",__FILE__,__LINE__);
-         return kipl::base::TImage<float,3>();
-     #endif
+    return img;
 }
 
+kipl::base::TImage<float, 3> ProjectionReader::ReadNexusStack(std::string filename,
+                                      size_t start, size_t end,
+                                      kipl::base::eImageFlip flip,
+                                      kipl::base::eImageRotate rotate,
+                                      float binning,
+                                      size_t const * const nCrop,
+                                      size_t const * const nDoseROI,
+                                      float *doselist)
+{
+    kipl::base::TImage<float,3> img;
 
+    if ((nDoseROI!=nullptr) && (nDoseROI[0]*nDoseROI[1]*nDoseROI[2]*nDoseROI[3])) {
+        ReadNexusFrames(filename,start,end,flip,rotate,binning,nCrop,&img,nDoseROI,doselist);
+    }
+    else {
+        ReadNexusFrames(filename,start,end,flip,rotate,binning,nCrop,&img,nullptr,nullptr);
+        std::fill(doselist,doselist+(end-start),1.0f);
+    }
+
+    return img;
+}
+
+void ProjectionReader::ReadNexusFrames(std::string filename,
+        size_t start, size_t end,
+        kipl::base::eImageFlip flip,
+        kipl::base::eImageRotate rotate,
+        float binning,
+        size_t const * const nCrop,
+        kipl::base::TImage<float,3> *stack,
+        size_t const * const nDoseROI,
+        float *doselist)
+{
+#ifdef HAVE_NEXUS
+    std::ostringstream msg;
+
+    size_t dims[2];
+    try {
+        GetImageSizeNexus(filename, binning,dims);
+    }
+    catch (ReconException &e) {
+        throw ReconException(e.what(),__FILE__,__LINE__);
+    }
+    catch (kipl::base::KiplException &e) {
+        throw ReconException(e.what(),__FILE__,__LINE__);
+    }
+    catch (std::exception &e) {
+        throw ReconException(e.what(),__FILE__,__LINE__);
+    }
+
+    // The ROIs are given in the final orientation and binning, the frames are read in file coordinates
+    auto fileROI = [&](size_t const * const roi, size_t *fileroi) {
+        if (roi==nullptr) {
+            fileroi[0]=0;
+            fileroi[1]=0;
+            fileroi[2]=static_cast<size_t>(dims[0]*binning);
+            fileroi[3]=static_cast<size_t>(dims[1]*binning);
+            return;
+        }
+
+        size_t local_dims[2]={dims[0],dims[1]};
+        std::copy(roi,roi+4,fileroi);
+        UpdateCrop(flip,rotate,local_dims,fileroi);
+
+        for (size_t i=0; i<4; i++)
+            fileroi[i]*=binning;
+    };
+
+    size_t crop[4]={0,0,0,0};
+    size_t doseroi[4]={0,0,0,0};
+    size_t box[4];
+
+    if (stack!=nullptr)
+        fileROI(nCrop,crop);
+
+    if (nDoseROI!=nullptr)
+        fileROI(nDoseROI,doseroi);
+
+    if (stack==nullptr)
+        std::copy(doseroi,doseroi+4,box);
+    else if (nDoseROI==nullptr)
+        std::copy(crop,crop+4,box);
+    else {
+        // The frames are stored in chunks, reading the bounding box costs no extra file access
+        box[0]=std::min(crop[0],doseroi[0]);
+        box[1]=std::min(crop[1],doseroi[1]);
+        box[2]=std::max(crop[2],doseroi[2]);
+        box[3]=std::max(crop[3],doseroi[3]);
+    }
+
+    size_t cropPos[2]   = {crop[0]-box[0], crop[1]-box[1]};
+    size_t cropSize[2]  = {crop[2]-crop[0], crop[3]-crop[1]};
+    size_t dosePos[2]   = {doseroi[0]-box[0], doseroi[1]-box[1]};
+    size_t doseSize[2]  = {doseroi[2]-doseroi[0], doseroi[3]-doseroi[1]};
+    const bool bFullCrop = std::equal(crop,crop+4,box);
+
+    size_t doseDims[2]={0,0};
+    try {
+        if (stack!=nullptr) {
+            size_t projDims[2];
+            kipl::base::BinAndOrientDims(cropSize,static_cast<size_t>(binning),rotate,projDims);
+            size_t stackDims[3]={projDims[0],projDims[1],end-start};
+            *stack=kipl::base::TImage<float,3>(stackDims);
+        }
+
+        if (nDoseROI!=nullptr)
+            kipl::base::BinAndOrientDims(doseSize,static_cast<size_t>(binning),rotate,doseDims);
+    }
+    catch (kipl::base::KiplException &e) {
+        throw ReconException(e.what(),__FILE__,__LINE__);
+    }
+
+    auto process = [&](size_t index, kipl::base::TImage<float,2> &frame) {
+        const size_t k=index-start;
+
+        if (stack!=nullptr) {
+            if (bFullCrop)
+                BinAndOrient(frame,flip,rotate,binning,stack->GetLinePtr(0,k));
+            else
+                BinAndOrient(kipl::base::TSubImage<float,2>::Get(frame,cropPos,cropSize),flip,rotate,binning,stack->GetLinePtr(0,k));
+        }
+
+        if (nDoseROI!=nullptr) {
+            kipl::base::TImage<float,2> doseimg(doseDims);
+            BinAndOrient(kipl::base::TSubImage<float,2>::Get(frame,dosePos,doseSize),flip,rotate,binning,doseimg.GetDataPtr());
+            doselist[k]=ProjectionDose(doseimg);
+        }
+    };
+
+    try {
+        kipl::io::ReadNexusFrames<float>(filename.c_str(),start,end,box,process);
+    }
+    catch (kipl::base::KiplException &e) {
+        msg<<"Failed to read "<<filename<<" kipl exception:\n"<<e.what();
+        logger(logger.LogError,msg.str());
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+    catch (std::exception &e) {
+        msg<<"Failed to read "<<filename<<" STL exception:\n"<<e.what();
+        logger(logger.LogError,msg.str());
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+#else
+    logger.warning("HAVE_NEXUS not defined");
+    throw ReconException("Nexus library is not supported",__FILE__,__LINE__);
+#endif
+}
 
 kipl::base::TImage<float,2> ProjectionReader::Read(std::string path, 
 												   std::string filemask, 
@@ -761,24 +867,7 @@ float ProjectionReader::GetProjectionDose(std::string filename,
 
 	img=Read(filename,flip,rotate,binning,nDoseROI);
 
-	float *pImg=img.GetDataPtr();
-
-	float *means=new float[img.Size(1)];
-	memset(means,0,img.Size(1)*sizeof(float));
-
-	for (size_t y=0; y<img.Size(1); y++) {
-		pImg=img.GetLinePtr(y);
-		
-		for (size_t x=0; x<img.Size(0); x++) {
-			means[y]+=pImg[x];
-		}
-		means[y]=means[y]/static_cast<float>(img.Size(0));
-	}
-
-	float dose; 
-	kipl::math::median(means,img.Size(1),&dose);
-	delete [] means;
-	return dose;
+	return ProjectionDose(img);
 }
 
 float ProjectionReader::GetProjectionDoseNexus(string filename, size_t number,
@@ -795,24 +884,7 @@ float ProjectionReader::GetProjectionDoseNexus(string filename, size_t number,
 
     img=ReadNexus(filename,number,flip,rotate,binning,nDoseROI);
 
-    float *pImg=img.GetDataPtr();
-
-    float *means=new float[img.Size(1)];
-    memset(means,0,img.Size(1)*sizeof(float));
-
-    for (size_t y=0; y<img.Size(1); y++) {
-        pImg=img.GetLinePtr(y);
-
-        for (size_t x=0; x<img.Size(0); x++) {
-            means[y]+=pImg[x];
-        }
-        means[y]=means[y]/static_cast<float>(img.Size(0));
-    }
-
-    float dose;
-    kipl::math::median(means,img.Size(1),&dose);
-    delete [] means;
-    return dose;
+    return ProjectionDose(img);
 }
 
 float * ProjectionReader::GetProjectionDoseListNexus(string filename, size_t start, size_t end,
@@ -821,21 +893,28 @@ float * ProjectionReader::GetProjectionDoseListNexus(string filename, size_t sta
                                                      float binning,
                                                      size_t const * const nDoseROI)
 {
-
-    kipl::base::TImage<float,3> img;
-
     if (!(nDoseROI[0]*nDoseROI[1]*nDoseROI[2]*nDoseROI[3]))
         return nullptr; // possibly stupid
 
-    img=ReadNexusStack(filename,start,end,flip,rotate,binning,nDoseROI);
+    float *doselist = new float[end-start];
+    try {
+        ReadNexusFrames(filename,start,end,flip,rotate,binning,nullptr,nullptr,nDoseROI,doselist);
+    }
+    catch (...) {
+        delete [] doselist;
+        throw;
+    }
+
+    return doselist;
 
-    float *pImg=img.GetDataPtr();
+}
 
-    float *means=new float[img.Size(1)];
-    memset(means,0,img.Size(1)*sizeof(float));
+float ProjectionReader::ProjectionDose(kipl::base::TImage<float,2> &img)
+{
+    std::vector<float> means(img.Size(1),0.0f);
 
     for (size_t y=0; y<img.Size(1); y++) {
-        pImg=img.GetLinePtr(y);
+        float *pImg=img.GetLinePtr(y);
 
         for (size_t x=0; x<img.Size(0); x++) {
             means[y]+=pImg[x];
@@ -843,13 +922,10 @@ float * ProjectionReader::GetProjectionDoseListNexus(string filename, size_t sta
         means[y]=means[y]/static_cast<float>(img.Size(0));
     }
 
-    float *doselist = new float[img.Size(2)];
-    for (size_t i=0; i<img.Size(2); ++i) {
-            kipl::math::median(means,img.Size(1),&doselist[i]);
-    }
-    delete [] means;
-    return doselist;
+    float dose;
+    kipl::math::median(means.data(),img.Size(1),&dose);
 
+    return dose;
 }
 
 float ProjectionReader::GetProjectionDose(std::string path,
@@ -917,21 +993,27 @@ kipl::base::TImage<float,3> ProjectionReader::Read( ReconConfig config, size_t c
 			angle  << (it->second.angle)+config.MatrixInfo.fRotation  << " ";
 			weight << (it->second.weight)*fResolutionWeight << " ";
 
-            proj = Read(it->second.name,config.ProjectionInfo.eFlip,config.ProjectionInfo.eRotate,config.ProjectionInfo.fBinning,nCrop);
+            Read(it->second.name,config.ProjectionInfo.eFlip,config.ProjectionInfo.eRotate,config.ProjectionInfo.fBinning,nCrop,img,i);
 
             dose   << GetProjectionDose(it->second.name,config.ProjectionInfo.eFlip,
                     config.ProjectionInfo.eRotate,
                     config.ProjectionInfo.fBinning,
                     config.ProjectionInfo.dose_roi)<<" ";
 
-			memcpy(img.GetLinePtr(0,i),proj.GetDataPtr(),sizeof(float)*proj.Size());
             ++i;
             }
         }
         else{
 
+            std::vector<float> doselist(dims[2]);
             try {
-                img = ReadNexusStack(ProjectionList.begin()->second.name, 0, dims[2], config.ProjectionInfo.eFlip,config.ProjectionInfo.eRotate,config.ProjectionInfo.fBinning,nCrop);
+                img = ReadNexusStack(ProjectionList.begin()->second.name, 0, dims[2],
+                                     config.ProjectionInfo.eFlip,
+                                     config.ProjectionInfo.eRotate,
+                                     config.ProjectionInfo.fBinning,
+                                     nCrop,
+                                     config.ProjectionInfo.dose_roi,
+                                     doselist.data());
             }
             catch (ReconException &e) {
                 throw ReconException(e.what(),__FILE__,__LINE__);
@@ -946,15 +1028,6 @@ kipl::base::TImage<float,3> ProjectionReader::Read( ReconConfig config, size_t c
                 throw ReconException("Unhandled exception",__FILE__,__LINE__);
             }
 
-            float *doselist = new float[dims[2]];
-            doselist = GetProjectionDoseListNexus(ProjectionList.begin()->second.name,
-                                                         0, dims[2],
-                                                        config.ProjectionInfo.eFlip,
-                                                        config.ProjectionInfo.eRotate,
-                                                        config.ProjectionInfo.fBinning,
-                                                        config.ProjectionInfo.dose_roi);
-
-
             for (size_t i=0; i<dims[2]; ++i){
                 dose << doselist[i] << " ";
             }
@@ -210,6 +210,7 @@ void ReconConfig::ParseArgv(std::vector<std::string> &args)
             }
             if (var=="matrixname")   MatrixInfo.sFileMask   = value;
             if (var=="filetype")     string2enum(value,MatrixInfo.FileType);
+            if (var=="tiffcompression") string2enum(value,MatrixInfo.TIFFCompression);
             if (var=="firstindex")   MatrixInfo.nFirstIndex = std::stoul(value);
             if (var=="grayinterval") kipl::strings::String2Array(value,MatrixInfo.fGrayInterval,2);
             if (var=="useroi")       MatrixInfo.bUseROI=kipl::strings::string2bool(value);
@@ -423,6 +424,7 @@ void ReconConfig::ParseMatrix(xmlTextReaderPtr reader)
 	        if (sName=="path") 				MatrixInfo.sDestinationPath    = sValue;
 	        if (sName=="matrixname") 	  	MatrixInfo.sFileMask           = sValue;
 			if (sName=="filetype")			string2enum(sValue,MatrixInfo.FileType);
+            if (sName=="tiffcompression")   string2enum(sValue,MatrixInfo.TIFFCompression);
             if (sName=="firstindex") 		MatrixInfo.nFirstIndex         = std::stoul(sValue);
 	        if (sName=="grayinterval") 
 	        	kipl::strings::String2Array(sValue,MatrixInfo.fGrayInterval,2);
@@ -854,7 +856,8 @@ ReconConfig::cMatrix::cMatrix() :
 	nFirstIndex(0),
 	bUseROI(false),
 //    bUseVOI(false),
-	FileType(kipl::io::TIFF16bits)
+	FileType(kipl::io::TIFF16bits),
+	TIFFCompression(kipl::io::TIFFCompressionNone)
 {
 	nDims[2]=nDims[1]=nDims[0]=0;
     fVoxelSize[2]=fVoxelSize[1]=fVoxelSize[0]=0.0f;
@@ -875,7 +878,8 @@ ReconConfig::cMatrix::cMatrix(const cMatrix &a) :
 	nFirstIndex(a.nFirstIndex),
 	bUseROI(a.bUseROI),
 //    bUseVOI(a.bUseVOI),
-	FileType(a.FileType)
+	FileType(a.FileType),
+	TIFFCompression(a.TIFFCompression)
 {
 	nDims[2] = a.nDims[2];
 	nDims[1] = a.nDims[1];
@@ -914,6 +918,7 @@ ReconConfig::cMatrix & ReconConfig::cMatrix::operator=(const cMatrix &a)
 	fGrayInterval[0]    = a.fGrayInterval[0];
 	fGrayInterval[1]    = a.fGrayInterval[1];
 	FileType = a.FileType;
+	TIFFCompression = a.TIFFCompression;
 	bAutomaticSerialize = a.bAutomaticSerialize;
 
 	bUseROI=a.bUseROI;
@@ -950,6 +955,7 @@ std::string ReconConfig::cMatrix::WriteXML(int indent)
     str<<setw(indent+4)  <<" "<<"<path>"<<sDestinationPath<<"</path>"<<std::endl;
     str<<setw(indent+4)  <<" "<<"<matrixname>"<<sFileMask<<"</matrixname>"<<std::endl;
     str<<setw(indent+4)  <<" "<<"<filetype>"<<FileType<<"</filetype>"<<std::endl;
+    str<<setw(indent+4)  <<" "<<"<tiffcompression>"<<TIFFCompression<<"</tiffcompression>"<<std::endl;
     str<<setw(indent+4)  <<" "<<"<firstindex>"<<nFirstIndex<<"</firstindex>"<<std::endl;
     str<<setw(indent+4)  <<" "<<"<grayinterval>"<<fGrayInterval[0]<<" "<<fGrayInterval[1]<<"</grayinterval>"<<std::endl;
     str<<setw(indent+4)  <<" "<<"<useroi>"<<kipl::strings::bool2string(bUseROI)<<"</useroi>"<<std::endl;
@@ -1,15 +1,21 @@
 //<LICENSE>
 #include "stdafx.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <string.h>
 #include <vector>
+#include <limits>
+#include <cmath>
 
 #include <logging/logger.h>
 #include <base/timage.h>
 #include <strings/miscstring.h>
 #include <base/textractor.h>
 #include <algorithms/datavalidator.h>
+#include <profile/Tracer.h>
+#include <profile/Timer.h>
+#include <math/mathconstants.h>
 #include <io/io_nexus.h>
 #include <io/io_stack.h>
 
@@ -274,6 +280,7 @@ int ReconEngine::Run()
 	std::stringstream msg;
 
 	BuildFileList(&m_Config,&m_ProjectionList);
+    m_VolumeStatistics.reset();
 
 	size_t roi[4]={
 		m_Config.ProjectionInfo.roi[0],
@@ -516,9 +523,11 @@ int ReconEngine::Process(size_t *roi)
 						m_Config.ProjectionInfo.fBinning,
 						m_Config.ProjectionInfo.dose_roi));
 
-		msg.str("");
-		msg<<"Block "<<nProcessedBlocks<<", Projection "<<i<<" (weight="<<fWeight<<", angle="<<fAngle<<")";
-		logger(kipl::logging::Logger::LogVerbose, msg.str());
+        if (logger.IsEnabled(kipl::logging::Logger::LogVerbose)) {
+            msg.str("");
+            msg<<"Block "<<nProcessedBlocks<<", Projection "<<i<<" (weight="<<fWeight<<", angle="<<fAngle<<")";
+            logger(kipl::logging::Logger::LogVerbose, msg.str());
+        }
 
         float moduleCnt=0.0f;
         float fNumberOfModules=static_cast<float>(m_PreprocList.size());
@@ -543,6 +552,7 @@ int ReconEngine::Process(size_t *roi)
     else
     {
 		logger(kipl::logging::Logger::LogVerbose,"Reconstruction finished");
+        CollectBlockStatistics();
 
 		size_t dims[3];
 
@@ -622,6 +632,7 @@ bool ReconEngine::Serialize(size_t *dims)
 	str<<m_Config.MatrixInfo.sDestinationPath<<m_Config.MatrixInfo.sFileMask;
 	
 	bool bTransposed=false;
+	const kipl::io::TIFFWriteOptions tiffOptions(m_Config.MatrixInfo.TIFFCompression);
 
    if (m_Config.MatrixInfo.FileType==kipl::io::NeXusfloat) {
 
@@ -685,13 +696,13 @@ bool ReconEngine::Serialize(size_t *dims)
                     kipl::io::WriteImageStack(img,
                         str.str(),
                         m_Config.MatrixInfo.fGrayInterval[0],m_Config.MatrixInfo.fGrayInterval[1],
-                        0,nSlices,m_Config.ProjectionInfo.roi[1],m_Config.MatrixInfo.FileType,plane,m_Config.MatrixInfo.roi);
+                        0,nSlices,m_Config.ProjectionInfo.roi[1],m_Config.MatrixInfo.FileType,plane,m_Config.MatrixInfo.roi,tiffOptions);
                 }
                 else if (m_Config.ProjectionInfo.beamgeometry == m_Config.ProjectionInfo.BeamGeometry_Cone)
                 {       kipl::io::WriteImageStack(img,
                                                   str.str(),
                                                   m_Config.MatrixInfo.fGrayInterval[0],m_Config.MatrixInfo.fGrayInterval[1],
-                                                  0,nSlices, CBroi[1], m_Config.MatrixInfo.FileType,plane,m_Config.MatrixInfo.roi);
+                                                  0,nSlices, CBroi[1], m_Config.MatrixInfo.FileType,plane,m_Config.MatrixInfo.roi,tiffOptions);
                 }
             }
             else
@@ -702,14 +713,14 @@ bool ReconEngine::Serialize(size_t *dims)
                     kipl::io::WriteImageStack(img,
                         str.str(),
                         m_Config.MatrixInfo.fGrayInterval[0],m_Config.MatrixInfo.fGrayInterval[1],
-                        0,nSlices,m_Config.ProjectionInfo.roi[1],m_Config.MatrixInfo.FileType,plane,nullptr);
+                        0,nSlices,m_Config.ProjectionInfo.roi[1],m_Config.MatrixInfo.FileType,plane,nullptr,tiffOptions);
                 }
                 else if (m_Config.ProjectionInfo.beamgeometry == m_Config.ProjectionInfo.BeamGeometry_Cone)
                 {
                     kipl::io::WriteImageStack(img,
                         str.str(),
                         m_Config.MatrixInfo.fGrayInterval[0],m_Config.MatrixInfo.fGrayInterval[1],
-                        0,nSlices, CBroi[1], m_Config.MatrixInfo.FileType,plane,nullptr);
+                        0,nSlices, CBroi[1], m_Config.MatrixInfo.FileType,plane,nullptr,tiffOptions);
                 }
             }
         }
@@ -826,11 +837,23 @@ void ReconEngine::writePublicationList(const std::string &fname)
 
 size_t ReconEngine::GetHistogram(float *axis, size_t *hist, size_t nBins)
 {
-	m_BackProjector->GetModule()->GetHistogram(axis,hist,nBins);
+    // The statistics cover all slice blocks, the back-projector only holds the last block
+    if (m_VolumeStatistics.n()!=0)
+        m_VolumeStatistics.GetHistogram(axis,hist,nBins);
+    else
+        m_BackProjector->GetModule()->GetHistogram(axis,hist,nBins);
 
 	return nBins;
 }
 
+void ReconEngine::GetGrayInterval(float percentage, float *interval)
+{
+    if (m_VolumeStatistics.n()==0)
+        throw ReconException("The gray interval is only available after a reconstruction",__FILE__,__LINE__);
+
+    m_VolumeStatistics.GrayInterval(percentage,interval[0],interval[1]);
+}
+
 bool ReconEngine::Serialize(ReconConfig::cMatrix *matrixconfig)
 {
 
@@ -886,7 +909,8 @@ bool ReconEngine::Serialize(ReconConfig::cMatrix *matrixconfig)
 		kipl::io::WriteImageStack(m_Volume,
 				str.str(),
 				matrixconfig->fGrayInterval[0],matrixconfig->fGrayInterval[1],
-				0,nSlices,m_FirstSlice,matrixconfig->FileType,plane);
+				0,nSlices,m_FirstSlice,matrixconfig->FileType,plane,nullptr,
+				kipl::io::TIFFWriteOptions(matrixconfig->TIFFCompression));
 	}
 
 
@@ -941,7 +965,9 @@ int ReconEngine::Run3DFull()
 	std::stringstream msg;
 
     logger(kipl::logging::Logger::LogVerbose,"Entering Run3DFull");
+    kipl::profile::TraceSpan reconSpan("Reconstruction","engine");
     m_ProjectionBlocks.clear();
+    m_VolumeStatistics.reset();
 	size_t roi[4]={
 		m_Config.ProjectionInfo.roi[0],
 		m_Config.ProjectionInfo.roi[1],
@@ -1017,6 +1043,7 @@ int ReconEngine::Run3DFull()
 
 
 	kipl::profile::Timer totalTimer;
+    m_PointwiseChainTimers.clear();
 
 	totalTimer.Tic();
 
@@ -1265,9 +1292,27 @@ int ReconEngine::Run3DFull()
 		msg.str("");
 		msg<<"\nModule process time:\n";
 
-        for (auto &module : m_PreprocList)
+        size_t moduleIdx=0;
+        while (moduleIdx<m_PreprocList.size())
         {
-            msg<<module->GetModule()->ModuleName()<<": "<<module->GetModule()->ExecTime()<<"s\n";
+            PreprocModuleBase *module = m_PreprocList[moduleIdx]->GetModule();
+
+            // Fused point-wise chains are reported as one entry, the same grouping as in the preprocessing
+            std::string chainName;
+            size_t nChain=0;
+            for (size_t i=moduleIdx; (i<m_PreprocList.size()) && m_PreprocList[i]->GetModule()->IsPointwise(); ++i, ++nChain)
+                chainName += (nChain==0 ? "" : "+")+m_PreprocList[i]->GetModule()->ModuleName();
+
+            if (nChain<2)
+            {
+                msg<<module->ModuleName()<<": "<<module->ExecTime()<<"s\n";
+                ++moduleIdx;
+            }
+            else
+            {
+                msg<<chainName<<" (fused): "<<m_PointwiseChainTimers[chainName].elapsedTime(kipl::profile::Timer::seconds)<<"s\n";
+                moduleIdx += nChain;
+            }
 		}
 
 		logger(kipl::logging::Logger::LogMessage,msg.str());
@@ -1290,6 +1335,7 @@ int ReconEngine::Run3DBackProjOnly()
     m_BackProjector->GetModule()->Configure(m_Config,m_Config.backprojector.parameters);
 
     m_Volume=0.0f;
+    m_VolumeStatistics.reset();
     int result=ProcessExistingProjections3D(nullptr);
 
     Done();
@@ -1586,7 +1632,17 @@ int ReconEngine::Process3D(size_t *roi)
 
     try
     {
+        kipl::profile::TraceSpan readSpan("Read projections","io");
         ext_projections=m_ProjectionReader.Read(m_Config,extroi,parameters);
+        double readTime=readSpan.stop();
+
+        if (kipl::profile::Tracer::enabled())
+        {
+            kipl::profile::Tracer::addCounter("Bytes read",static_cast<double>(ext_projections.Size()*sizeof(float)));
+            if (0.0<readTime)
+                kipl::profile::Tracer::addCounter("Projections/s (read)",ext_projections.Size(2)/readTime);
+        }
+
         validateImage(ext_projections.GetDataPtr(),ext_projections.Size(),"post reader");
 	}
     catch (ReconException &e)
@@ -1621,17 +1677,41 @@ int ReconEngine::Process3D(size_t *roi)
 
     try
     {
-        for (auto &module : m_PreprocList)
+        size_t moduleIdx=0;
+        while (moduleIdx<m_PreprocList.size())
         {
-            moduleName = module->GetModule()->ModuleName();
-            ++moduleCnt;
+            PreprocModuleBase *module = m_PreprocList[moduleIdx]->GetModule();
+
+            // Consecutive point-wise modules are fused into a single pass over the projections
+            std::vector<PreprocModuleBase *> chain;
+            for (size_t i=moduleIdx; (i<m_PreprocList.size()) && m_PreprocList[i]->GetModule()->IsPointwise(); ++i)
+                chain.push_back(m_PreprocList[i]->GetModule());
+
+            const size_t nModules = std::max(chain.size(),static_cast<size_t>(1));
+            moduleName = module->ModuleName();
+            for (size_t i=1; i<chain.size(); ++i)
+                moduleName += "+"+chain[i]->ModuleName();
+
+            moduleIdx += nModules;
+            moduleCnt += static_cast<float>(nModules);
 
-            //UpdateProgress(moduleCnt/fNumberOfModules,moduleName);
 			msg.str("");
             msg<<"Processing: "<< moduleName;
 			logger(kipl::logging::Logger::LogMessage,msg.str());
             if (!(m_bCancel=UpdateProgress(moduleCnt/fNumberOfModules, msg.str())))
-                module->GetModule()->Process(ext_projections,parameters);
+            {
+                kipl::profile::TraceSpan moduleSpan(moduleName,"preprocessing");
+                if (chain.size()<2)
+                    module->Process(ext_projections,parameters);
+                else
+                {
+                    // The fused modules don't run through Process, the chain is timed as one entry
+                    kipl::profile::Timer &chainTimer=m_PointwiseChainTimers[moduleName];
+                    chainTimer.Tic();
+                    ProcessPointwiseChain(chain,ext_projections);
+                    chainTimer.Toc();
+                }
+            }
 			else
 				break;
             validateImage(ext_projections.GetDataPtr(),ext_projections.Size(),moduleName);
@@ -1679,6 +1759,15 @@ int ReconEngine::Process3D(size_t *roi)
         projections=ext_projections;
     }
 
+    if (kipl::profile::Tracer::enabled())
+    {
+        size_t bufferSize=ext_projections.Size()+(projections.GetDataPtr()!=ext_projections.GetDataPtr() ? projections.Size() : 0UL);
+        size_t matrixDims[3];
+        m_BackProjector->GetModule()->GetMatrixDims(matrixDims);
+        bufferSize+=matrixDims[0]*matrixDims[1]*matrixDims[2]+m_Volume.Size();
+        kipl::profile::Tracer::addCounter("Buffer memory [bytes]",static_cast<double>(bufferSize*sizeof(float)));
+    }
+
     if (m_Config.MatrixInfo.bAutomaticSerialize==false) // Don't store the projections for the reconstruction to disk case
     {
 //        m_ProjectionBlocks.push_back(ProjectionBlock(projections,roi,parameters));
@@ -1742,6 +1831,337 @@ int ReconEngine::Process3D(size_t *roi)
     return res;
 }
 
+int ReconEngine::ProcessExternalProjections(kipl::base::TImage<float,3> &projections,
+                                            const std::vector<float> &angles,
+                                            const std::vector<float> &weights,
+                                            const std::vector<float> &doses,
+                                            size_t const * const roi)
+{
+    std::ostringstream msg;
+    m_bCancel=false;
+    m_VolumeStatistics.reset();
+
+    const size_t nProj=projections.Size(2);
+    if ((angles.size()!=nProj) || (weights.size()!=nProj) || (!doses.empty() && (doses.size()!=nProj)))
+    {
+        msg<<"The number of angles ("<<angles.size()<<"), weights ("<<weights.size()
+           <<") and doses ("<<doses.size()<<") must match the number of projections ("<<nProj<<")";
+        logger(kipl::logging::Logger::LogError,msg.str());
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+
+    if (m_Config.ProjectionInfo.beamgeometry!=ReconConfig::cProjections::BeamGeometry_Parallel)
+        throw ReconException("External projections are only supported for parallel beam geometry",__FILE__,__LINE__);
+
+    size_t blockroi[4]={0,0,projections.Size(0),projections.Size(1)};
+    if (roi!=nullptr)
+        std::copy_n(roi,4,blockroi);
+
+    if ((blockroi[2]-blockroi[0]!=projections.Size(0)) || (blockroi[3]-blockroi[1]!=projections.Size(1)))
+    {
+        msg<<"The ROI ["<<blockroi[0]<<", "<<blockroi[1]<<", "<<blockroi[2]<<", "<<blockroi[3]
+           <<"] does not match the projection block "<<projections;
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+
+    std::ostringstream angle;
+    std::ostringstream weight;
+    std::ostringstream dose;
+    for (size_t i=0; i<nProj; ++i)
+    {
+        angle  << angles[i]+m_Config.MatrixInfo.fRotation << " ";
+        weight << weights[i] << " ";
+        dose   << (doses.empty() ? 1.0f : doses[i]) << " ";
+    }
+
+    std::map<std::string, std::string> parameters;
+    parameters["angles"]  = angle.str();
+    parameters["weights"] = weight.str();
+    parameters["dose"]    = dose.str();
+
+    if (m_Config.MatrixInfo.bAutomaticSerialize==false)
+    {
+        if (m_Config.MatrixInfo.bUseROI)
+        {
+            m_Config.MatrixInfo.nDims[0] = m_Config.MatrixInfo.roi[2]-m_Config.MatrixInfo.roi[0]+1;
+            m_Config.MatrixInfo.nDims[1] = m_Config.MatrixInfo.roi[3]-m_Config.MatrixInfo.roi[1]+1;
+        }
+        else
+        {
+            m_Config.MatrixInfo.nDims[0] = blockroi[2]-blockroi[0];
+            m_Config.MatrixInfo.nDims[1] = m_Config.MatrixInfo.nDims[0];
+        }
+        m_Config.MatrixInfo.nDims[2] = blockroi[3]-blockroi[1];
+
+        m_Volume.Resize(m_Config.MatrixInfo.nDims);
+        m_Volume = 0.0f;
+    }
+    m_FirstSlice = blockroi[1];
+
+    std::string moduleName;
+    try
+    {
+        for (auto &module : m_PreprocList)
+        {
+            moduleName = module->GetModule()->ModuleName();
+            module->GetModule()->SetROI(blockroi);
+        }
+
+        float moduleCnt=0.0f;
+        float fNumberOfModules=static_cast<float>(m_PreprocList.size())+1;
+
+        for (auto &module : m_PreprocList)
+        {
+            moduleName = module->GetModule()->ModuleName();
+            ++moduleCnt;
+
+            msg.str("");
+            msg<<"Processing: "<< moduleName;
+            logger(kipl::logging::Logger::LogMessage,msg.str());
+            if ((m_bCancel=UpdateProgress(moduleCnt/fNumberOfModules, msg.str())))
+                return 1;
+
+            kipl::profile::TraceSpan moduleSpan(moduleName,"preprocessing");
+            module->GetModule()->Process(projections,parameters);
+            moduleSpan.stop();
+            validateImage(projections.GetDataPtr(),projections.Size(),moduleName);
+        }
+    }
+    catch (ModuleException &e)
+    {
+        msg.str("");
+        msg<<"Preprocessing of external projections failed with a module exception in "<<moduleName<<": "<<e.what();
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+    catch (kipl::base::KiplException &e)
+    {
+        msg.str("");
+        msg<<"Preprocessing of external projections failed with a kipl exception in "<<moduleName<<": "<<e.what();
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+    catch (std::exception &e)
+    {
+        msg.str("");
+        msg<<"Preprocessing of external projections failed with an STL exception in "<<moduleName<<": "<<e.what();
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+
+    int res=BackProject3D(projections,blockroi,parameters);
+    Done();
+
+    return res;
+}
+
+kipl::base::TImage<float,3> ReconEngine::WrapExternalProjections(float *data,
+                                                                 const std::vector<size_t> &shape,
+                                                                 const std::vector<ptrdiff_t> &strides,
+                                                                 bool bWriteable)
+{
+    std::ostringstream msg;
+
+    if (data==nullptr)
+        throw ReconException("The projection buffer is not allocated",__FILE__,__LINE__);
+
+    if (!bWriteable)
+        throw ReconException("The projection buffer must be writeable",__FILE__,__LINE__);
+
+    if ((shape.size()!=3) || (strides.size()!=3))
+    {
+        msg<<"The projections must be provided as a 3D buffer (projection, row, column), got "<<shape.size()<<" dimensions";
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+
+    // Only the C-contiguous layout can be wrapped, the strides of singleton dimensions don't matter
+    ptrdiff_t expected=sizeof(float);
+    for (int i=2; 0<=i; --i)
+    {
+        if ((shape[i]!=1) && (strides[i]!=expected))
+        {
+            msg<<"The projection buffer must be C-contiguous, dimension "<<i<<" has the stride "<<strides[i]<<" bytes instead of "<<expected;
+            throw ReconException(msg.str(),__FILE__,__LINE__);
+        }
+        expected*=static_cast<ptrdiff_t>(shape[i]);
+    }
+
+    size_t dims[3]={shape[2],shape[1],shape[0]};
+
+    return kipl::base::TImage<float,3>(data,dims);
+}
+
+size_t ReconEngine::ProcessGeometryTrials(const kipl::base::TImage<float,2> &sinogram,
+                                          const std::vector<float> &angles,
+                                          const std::vector<float> &weights,
+                                          size_t slice,
+                                          std::vector<GeometryTrial> &trials,
+                                          kipl::base::TImage<float,3> &slices)
+{
+    std::ostringstream msg;
+
+    const size_t nProj=sinogram.Size(1);
+    if ((angles.size()!=nProj) || (weights.size()!=nProj))
+    {
+        msg<<"The number of angles ("<<angles.size()<<") and weights ("<<weights.size()
+           <<") must match the number of projections ("<<nProj<<")";
+        logger(kipl::logging::Logger::LogError,msg.str());
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+
+    if (trials.empty())
+        throw ReconException("No candidate geometries were given for the trial reconstruction",__FILE__,__LINE__);
+
+    if (m_Config.ProjectionInfo.beamgeometry!=ReconConfig::cProjections::BeamGeometry_Parallel)
+        throw ReconException("Geometry trials are only supported for parallel beam geometry",__FILE__,__LINE__);
+
+    const ptrdiff_t N       = static_cast<ptrdiff_t>(sinogram.Size(0));
+    const ptrdiff_t nTrials = static_cast<ptrdiff_t>(trials.size());
+    const int       nMaxU   = static_cast<int>(N)-2;
+
+    size_t dims[3]={static_cast<size_t>(N),static_cast<size_t>(N),trials.size()};
+    slices.Resize(dims);
+    slices=0.0f;
+
+    // The circular mask and the matrix center of the standard back-projectors
+    const float matrixCenter=static_cast<float>(N>>1);
+    const float R=matrixCenter-1;
+    std::vector<std::pair<ptrdiff_t,ptrdiff_t> > mask(N,std::make_pair(ptrdiff_t(0),ptrdiff_t(-1)));
+    for (ptrdiff_t y=0; y<N; ++y)
+    {
+        const float fy=static_cast<float>(y)-matrixCenter;
+        if (fy*fy<=R*R)
+        {
+            const float fx=sqrt(R*R-fy*fy);
+            mask[y].first  = static_cast<ptrdiff_t>(ceil(matrixCenter-fx));
+            mask[y].second = std::min(N-1,static_cast<ptrdiff_t>(floor(matrixCenter+fx)));
+        }
+    }
+
+    // Geometry tables for all candidates, the detector position of pixel (x,y) is startU+cos*(y+1)-sin*(x+1)
+    const float dirWeight = 2.0f*(m_Config.ProjectionInfo.eDirection-0.5f);
+    std::vector<float> trialSin(nTrials*nProj);
+    std::vector<float> trialCos(nTrials*nProj);
+    std::vector<float> trialStartU(nTrials*nProj);
+    for (ptrdiff_t t=0; t<nTrials; ++t)
+    {
+        const GeometryTrial &trial=trials[t];
+        const float centerOffset=(static_cast<float>(slice)-m_Config.ProjectionInfo.fTiltPivotPosition)*tan(trial.tilt*fPi/180.0f);
+
+        for (size_t i=0; i<nProj; ++i)
+        {
+            const float angle=dirWeight*(angles[i]+m_Config.MatrixInfo.fRotation+trial.angleOffset)*fPi/180.0f;
+            const size_t idx=t*nProj+i;
+
+            trialSin[idx]    = sin(angle);
+            trialCos[idx]    = cos(angle);
+            trialStartU[idx] = matrixCenter*(trialSin[idx]-trialCos[idx])+trial.center-centerOffset;
+        }
+    }
+
+    msg<<"Reconstructing "<<nTrials<<" geometry trials of a "<<N<<" pixels wide sinogram with "<<nProj<<" projections";
+    logger(kipl::logging::Logger::LogMessage,msg.str());
+    kipl::profile::TraceSpan trialSpan("Geometry trials","backprojection");
+    kipl::profile::Timer timer;
+    timer.Tic();
+
+    // All slice lines of all candidates are independent
+    #pragma omp parallel for schedule(dynamic,4)
+    for (ptrdiff_t k=0; k<nTrials*N; ++k)
+    {
+        const ptrdiff_t t = k/N;
+        const ptrdiff_t y = k%N;
+        const ptrdiff_t x0 = mask[y].first;
+        const ptrdiff_t x1 = mask[y].second;
+        float *pLine = slices.GetLinePtr(y,t);
+
+        for (size_t i=0; i<nProj; ++i)
+        {
+            const size_t idx       = t*nProj+i;
+            const float  fSin      = trialSin[idx];
+            const float  fStartU   = trialStartU[idx]+trialCos[idx]*(y+1);
+            const float  weight    = weights[i];
+            const float *pProj     = sinogram.GetLinePtr(i);
+
+            for (ptrdiff_t x=x0; x<=x1; ++x)
+            {
+                const float fPosU=fStartU-fSin*(x+1);
+                const int   nPosU=static_cast<int>(fPosU);
+
+                if ((nPosU<0) || (nMaxU<nPosU))
+                    continue;
+
+                const float interpB=fPosU-nPosU;
+                pLine[x]+=weight*((1.0f-interpB)*pProj[nPosU]+interpB*pProj[nPosU+1]);
+            }
+        }
+    }
+
+    // Sharpness metrics inside the mask
+    #pragma omp parallel for
+    for (ptrdiff_t t=0; t<nTrials; ++t)
+    {
+        float minVal=std::numeric_limits<float>::max();
+        float maxVal=-std::numeric_limits<float>::max();
+        double variation=0.0;
+        size_t nPixels=0;
+
+        for (ptrdiff_t y=0; y<N; ++y)
+        {
+            const float *pLine=slices.GetLinePtr(y,t);
+            const float *pNext=y+1<N ? slices.GetLinePtr(y+1,t) : nullptr;
+
+            for (ptrdiff_t x=mask[y].first; x<=mask[y].second; ++x)
+            {
+                minVal=std::min(minVal,pLine[x]);
+                maxVal=std::max(maxVal,pLine[x]);
+                ++nPixels;
+
+                if (x<mask[y].second)
+                    variation+=fabs(pLine[x+1]-pLine[x]);
+                if ((pNext!=nullptr) && (mask[y+1].first<=x) && (x<=mask[y+1].second))
+                    variation+=fabs(pNext[x]-pLine[x]);
+            }
+        }
+
+        const size_t nBins=256;
+        std::vector<size_t> hist(nBins,0);
+        const float scale = minVal<maxVal ? (nBins-1)/(maxVal-minVal) : 0.0f;
+
+        for (ptrdiff_t y=0; y<N; ++y)
+        {
+            const float *pLine=slices.GetLinePtr(y,t);
+            for (ptrdiff_t x=mask[y].first; x<=mask[y].second; ++x)
+                ++hist[static_cast<size_t>((pLine[x]-minVal)*scale)];
+        }
+
+        double entropy=0.0;
+        for (auto &h : hist)
+        {
+            if (h!=0)
+            {
+                const double p=static_cast<double>(h)/nPixels;
+                entropy-=p*log(p);
+            }
+        }
+
+        trials[t].entropy   = static_cast<float>(entropy);
+        trials[t].variation = nPixels==0 ? 0.0f : static_cast<float>(variation/nPixels);
+    }
+
+    size_t best=0;
+    for (size_t t=1; t<trials.size(); ++t)
+        if (trials[t].entropy<trials[best].entropy)
+            best=t;
+
+    timer.Toc();
+    trialSpan.stop();
+
+    msg.str("");
+    msg<<"Geometry trials done in "<<timer.elapsedTime(kipl::profile::Timer::seconds)<<" s, the lowest entropy "<<trials[best].entropy
+       <<" has center="<<trials[best].center<<", tilt="<<trials[best].tilt<<", angle offset="<<trials[best].angleOffset;
+    logger(kipl::logging::Logger::LogMessage,msg.str());
+
+    return best;
+}
+
 int ReconEngine::ProcessExistingProjections3D(size_t *roi)
 {
     std::stringstream msg;
@@ -1795,7 +2215,18 @@ int ReconEngine::BackProject3D(kipl::base::TImage<float,3> & projections, size_t
     {
         try {
             logger(kipl::logging::Logger::LogMessage,"Back projection started.");
+            kipl::profile::TraceSpan bpSpan("Back-projection","backprojection");
             m_BackProjector->GetModule()->Process(projections,parameters);
+            double bpTime=bpSpan.stop();
+            CollectBlockStatistics();
+
+            if (kipl::profile::Tracer::enabled() && (0.0<bpTime))
+            {
+                size_t matrixDims[3];
+                m_BackProjector->GetModule()->GetMatrixDims(matrixDims);
+                kipl::profile::Tracer::addCounter("Projections/s (back-projection)",projections.Size(2)/bpTime);
+                kipl::profile::Tracer::addCounter("Voxel updates/s",static_cast<double>(matrixDims[0])*matrixDims[1]*matrixDims[2]*projections.Size(2)/bpTime);
+            }
             logger(kipl::logging::Logger::LogMessage,"Back projection done.");
         }
         catch (ReconException &e) {
@@ -1827,10 +2258,12 @@ int ReconEngine::BackProject3D(kipl::base::TImage<float,3> & projections, size_t
 
         if (m_Config.MatrixInfo.bAutomaticSerialize==true)
         {
+            kipl::profile::TraceSpan serializeSpan("Serialize","io");
             Serialize(dims);
         }
         else
         {
+            kipl::profile::TraceSpan transferSpan("Transfer matrix","engine");
             TransferMatrix(roi);
         }
     }
@@ -1838,6 +2271,21 @@ int ReconEngine::BackProject3D(kipl::base::TImage<float,3> & projections, size_t
     return 0;
 }
 
+void ReconEngine::CollectBlockStatistics()
+{
+    kipl::profile::TraceSpan statSpan("Statistics","engine");
+    kipl::math::VolumeStatistics blockStatistics;
+
+    m_BackProjector->GetModule()->GetStatistics(blockStatistics);
+    m_VolumeStatistics.merge(blockStatistics);
+
+    if (logger.IsEnabled(logger.LogVerbose)) {
+        std::ostringstream msg;
+        msg<<"Block statistics: min="<<blockStatistics.Min()<<", max="<<blockStatistics.Max()<<", mean="<<blockStatistics.E()<<", std="<<blockStatistics.s();
+        logger.verbose(msg.str());
+    }
+}
+
 bool ReconEngine::UpdateProgress(float val, std::string msg)
 {
     if (m_Interactor!=nullptr) {
@@ -1847,6 +2295,42 @@ bool ReconEngine::UpdateProgress(float val, std::string msg)
     return false;
 }
 
+void ReconEngine::ProcessPointwiseChain(std::vector<PreprocModuleBase *> &chain, kipl::base::TImage<float,3> &projections)
+{
+    // The chunk fits in the L1 cache, i.e. only the first module in the chain reads from main memory
+    const size_t nChunk = 4096;
+    const size_t N      = projections.Size();
+    const ptrdiff_t nChunks = static_cast<ptrdiff_t>((N+nChunk-1)/nChunk);
+    float *pData = projections.GetDataPtr();
+
+    bool bFailed=false;
+    std::string sError;
+
+    #pragma omp parallel for schedule(static)
+    for (ptrdiff_t i=0; i<nChunks; ++i)
+    {
+        float *pChunk = pData+i*nChunk;
+        const size_t len = std::min(nChunk,N-i*nChunk);
+
+        try
+        {
+            for (auto &module : chain)
+                module->ProcessPointwise(pChunk,len);
+        }
+        catch (std::exception &e)
+        {
+            #pragma omp critical
+            {
+                bFailed=true;
+                sError=e.what();
+            }
+        }
+    }
+
+    if (bFailed)
+        throw ReconException("Point-wise processing failed: "+sError,__FILE__,__LINE__);
+}
+
 size_t ReconEngine::validateImage(float *data, size_t N, const string &description)
 {
     size_t cnt=0;
@@ -1883,6 +2367,19 @@ void ReconEngine::UnpadProjections(kipl::base::TImage<float,3> &projections, siz
 
 }
 
+//==========================================
+// GeometryTrial
+
+GeometryTrial::GeometryTrial(float _center, float _tilt, float _angleOffset) :
+    center(_center),
+    tilt(_tilt),
+    angleOffset(_angleOffset),
+    entropy(0.0f),
+    variation(0.0f)
+{
+
+}
+
 //==========================================
 // ProjectionBlock
 
@@ -0,0 +1,308 @@
+//<LICENSE>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+#include <base/timage.h>
+#include <io/io_nexus.h>
+#include <io/analyzefileext.h>
+#include <strings/filenames.h>
+#include <strings/miscstring.h>
+
+#include <ParameterHandling.h>
+
+#include "../include/ReconShard.h"
+#include "../include/ReconException.h"
+
+namespace {
+
+struct ShardManifest
+{
+    size_t index;
+    size_t count;
+    size_t first;
+    size_t last;
+    std::string file;
+};
+
+ShardManifest readManifest(const std::string &fname)
+{
+    std::ifstream file(fname.c_str());
+
+    if (!file.is_open())
+        throw ReconException("Missing shard manifest "+fname,__FILE__,__LINE__);
+
+    std::map<std::string,std::string> entries;
+    std::string line;
+    while (std::getline(file,line)) {
+        size_t pos=line.find('=');
+        if (pos!=std::string::npos)
+            entries[line.substr(0,pos)]=line.substr(pos+1);
+    }
+
+    ShardManifest manifest;
+    try {
+        manifest.index = std::stoul(entries.at("index"));
+        manifest.count = std::stoul(entries.at("count"));
+        manifest.first = std::stoul(entries.at("first"));
+        manifest.last  = std::stoul(entries.at("last"));
+        manifest.file  = entries.at("file");
+    }
+    catch (std::exception &e) {
+        throw ReconException("Incomplete shard manifest "+fname+" ("+e.what()+")",__FILE__,__LINE__);
+    }
+
+    if (entries["status"]!="complete")
+        throw ReconException("The shard in "+fname+" did not complete",__FILE__,__LINE__);
+
+    return manifest;
+}
+
+std::string baseName(const std::string &fileMask)
+{
+    size_t pos=fileMask.find_first_of('#');
+    if (pos==std::string::npos)
+        pos=fileMask.find_last_of('.');
+
+    return fileMask.substr(0,pos);
+}
+
+}
+
+ReconShard::ReconShard(size_t index, size_t count) :
+    logger("ReconShard"),
+    m_nIndex(index),
+    m_nCount(count),
+    m_nFirst(0),
+    m_nLast(0),
+    m_sManifest(""),
+    m_sFile("")
+{
+    if ((count==0) || (count<=index)) {
+        std::ostringstream msg;
+        msg<<"Invalid shard "<<index<<" of "<<count<<", the index must be less than the count";
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+}
+
+void ReconShard::sliceRange(const ReconConfig &config, size_t &first, size_t &last) const
+{
+    if (config.ProjectionInfo.imagetype==ReconConfig::cProjections::ImageType_Proj_RepeatSinogram)
+        throw ReconException("Sharding is not supported for repeated sinograms",__FILE__,__LINE__);
+
+    const size_t start = config.ProjectionInfo.roi[1];
+    const size_t stop  = config.ProjectionInfo.roi[3];
+    const size_t nSliceBlock = static_cast<size_t>(std::max(1,GetIntParameter(config.backprojector.parameters,"SliceBlock")));
+
+    // Whole blocks are distributed to avoid a partial block in each shard
+    const size_t nBlocks = (stop-start+nSliceBlock-1)/nSliceBlock;
+    const size_t block0  = m_nIndex*nBlocks/m_nCount;
+    const size_t block1  = (m_nIndex+1)*nBlocks/m_nCount;
+
+    first = std::min(stop,start+block0*nSliceBlock);
+    last  = std::min(stop,start+block1*nSliceBlock);
+}
+
+bool ReconShard::apply(ReconConfig &config)
+{
+    std::ostringstream msg;
+
+    if ((config.MatrixInfo.FileType==kipl::io::TIFF16bitsMultiFrame) || (config.MatrixInfo.FileType==kipl::io::MatlabVolume))
+        throw ReconException("Sharding needs slice stacks or a NeXus volume as output",__FILE__,__LINE__);
+
+    sliceRange(config,m_nFirst,m_nLast);
+    m_sManifest = manifestName(config,m_nIndex,m_nCount);
+    m_sFile     = isNeXus(config) ? partialName(config.MatrixInfo.sFileMask,m_nIndex,m_nCount) : config.MatrixInfo.sFileMask;
+
+    msg<<"Shard "<<m_nIndex<<" of "<<m_nCount<<" reconstructs slices ["<<m_nFirst<<", "<<m_nLast<<")";
+    logger(kipl::logging::Logger::LogMessage,msg.str());
+
+    if (m_nLast<=m_nFirst)
+        return false;
+
+    config.ProjectionInfo.roi[1] = m_nFirst;
+    config.ProjectionInfo.roi[3] = m_nLast;
+
+    config.MatrixInfo.sFileMask = m_sFile;
+
+    return true;
+}
+
+void ReconShard::writeManifest(const ReconConfig &config) const
+{
+    if (m_sManifest.empty())
+        throw ReconException("The shard must be applied to the configuration before the manifest is written",__FILE__,__LINE__);
+
+    const std::string &fname = m_sManifest;
+    const std::string tmpname = fname+".tmp";
+
+    std::ofstream file(tmpname.c_str());
+    if (!file.is_open())
+        throw ReconException("Could not write the shard manifest "+tmpname,__FILE__,__LINE__);
+
+    file<<"index="<<m_nIndex<<"\n"
+        <<"count="<<m_nCount<<"\n"
+        <<"first="<<m_nFirst<<"\n"
+        <<"last="<<m_nLast<<"\n"
+        <<"filetype="<<enum2string(config.MatrixInfo.FileType)<<"\n"
+        <<"file="<<m_sFile<<"\n"
+        <<"status=complete\n";
+    file.close();
+
+    // The manifest only appears when it is complete, a partially written manifest can't be taken for a finished shard
+    std::remove(fname.c_str());
+    if (std::rename(tmpname.c_str(),fname.c_str())!=0)
+        throw ReconException("Could not rename the shard manifest to "+fname,__FILE__,__LINE__);
+}
+
+void ReconShard::merge(const ReconConfig &config, size_t count)
+{
+    kipl::logging::Logger logger("ReconShard::merge");
+    std::ostringstream msg;
+
+    std::vector<ShardManifest> manifests;
+    for (size_t i=0; i<count; ++i) {
+        manifests.push_back(readManifest(manifestName(config,i,count)));
+
+        if ((manifests.back().count!=count) || (manifests.back().index!=i)) {
+            msg<<"The manifest of shard "<<i<<" belongs to shard "<<manifests.back().index<<" of "<<manifests.back().count;
+            throw ReconException(msg.str(),__FILE__,__LINE__);
+        }
+    }
+
+    std::sort(manifests.begin(),manifests.end(),
+              [](const ShardManifest &a, const ShardManifest &b) { return (a.first<b.first) || ((a.first==b.first) && (a.last<b.last)); });
+
+    const size_t first = config.ProjectionInfo.roi[1];
+    const size_t last  = config.ProjectionInfo.roi[3];
+
+    size_t expected=first;
+    for (const auto &manifest : manifests) {
+        if (manifest.first!=expected) {
+            msg<<"Shard "<<manifest.index<<" starts at slice "<<manifest.first<<" but slice "<<expected
+               <<(manifest.first<expected ? " is already covered" : " is missing");
+            throw ReconException(msg.str(),__FILE__,__LINE__);
+        }
+        expected=manifest.last;
+    }
+
+    if (expected!=last) {
+        msg<<"The shards cover the slices ["<<first<<", "<<expected<<") but the reconstruction has the slices ["<<first<<", "<<last<<")";
+        throw ReconException(msg.str(),__FILE__,__LINE__);
+    }
+
+    msg<<"The "<<count<<" shards cover the slices ["<<first<<", "<<last<<")";
+    logger(kipl::logging::Logger::LogMessage,msg.str());
+
+    if (config.MatrixInfo.FileType==kipl::io::NeXusfloat) {
+        mergeNeXus<float>(config,count,first,last);
+    }
+    else if (config.MatrixInfo.FileType==kipl::io::NeXus16bits) {
+        mergeNeXus<unsigned short>(config,count,first,last);
+    }
+    else {
+        std::string path=config.MatrixInfo.sDestinationPath;
+        kipl::strings::filenames::CheckPathSlashes(path,true);
+
+        std::string fname,ext;
+        size_t nMissing=0;
+        for (size_t i=first; i<last; ++i) {
+            kipl::strings::filenames::MakeFileName(path+config.MatrixInfo.sFileMask,static_cast<int>(i),fname,ext,'#','0');
+
+            std::ifstream slice(fname.c_str());
+            if (!slice.is_open()) {
+                if (nMissing==0) {
+                    msg.str("");
+                    msg<<"Missing slice "<<fname;
+                }
+                ++nMissing;
+            }
+        }
+
+        if (nMissing!=0) {
+            msg<<" ("<<nMissing<<" missing slices in total)";
+            throw ReconException(msg.str(),__FILE__,__LINE__);
+        }
+    }
+}
+
+template <class ImgType>
+void ReconShard::mergeNeXus(const ReconConfig &config, size_t count, size_t first, size_t last)
+{
+    kipl::logging::Logger logger("ReconShard::merge");
+    std::ostringstream msg;
+
+    std::string path=config.MatrixInfo.sDestinationPath;
+    kipl::strings::filenames::CheckPathSlashes(path,true);
+
+    const std::string dest=path+config.MatrixInfo.sFileMask;
+
+    size_t dims[3]={0,0,last-first};
+    for (size_t i=0; (i<count) && (dims[0]==0); ++i) {
+        ShardManifest manifest=readManifest(manifestName(config,i,count));
+        if (manifest.first<manifest.last)
+            kipl::io::GetNexusDims((path+manifest.file).c_str(),dims);
+    }
+
+    const float res = config.ProjectionInfo.beamgeometry==ReconConfig::cProjections::BeamGeometry_Cone ?
+                config.MatrixInfo.fVoxelSize[0] : config.ProjectionInfo.fResolution[0];
+
+    kipl::base::TImage<ImgType,3> img;
+    if (std::is_same<ImgType,float>::value)
+        kipl::io::PrepareNeXusFileFloat(dest.c_str(),dims,res,img);
+    else
+        kipl::io::PrepareNeXusFile16bit(dest.c_str(),dims,res,img);
+
+    const size_t nChunk=32;
+    for (size_t i=0; i<count; ++i) {
+        ShardManifest manifest=readManifest(manifestName(config,i,count));
+        const std::string partial=path+manifest.file;
+        const size_t nSlices=manifest.last-manifest.first;
+
+        msg.str("");
+        msg<<"Copying "<<nSlices<<" slices from "<<partial;
+        logger(kipl::logging::Logger::LogMessage,msg.str());
+
+        for (size_t pos=0; pos<nSlices; pos+=nChunk) {
+            const size_t n=std::min(nChunk,nSlices-pos);
+
+            kipl::io::ReadNeXusSlab(img,partial.c_str(),pos,n);
+            kipl::io::WriteNeXusStack(img,dest.c_str(),manifest.first-first+pos,n,kipl::base::ImagePlaneXY,nullptr);
+        }
+    }
+}
+
+std::string ReconShard::manifestName(const ReconConfig &config, size_t index, size_t count)
+{
+    std::string path=config.MatrixInfo.sDestinationPath;
+    kipl::strings::filenames::CheckPathSlashes(path,true);
+
+    return path+baseName(config.MatrixInfo.sFileMask)+shardSuffix(index,count)+".manifest";
+}
+
+std::string ReconShard::partialName(const std::string &fileMask, size_t index, size_t count)
+{
+    size_t pos=fileMask.find_last_of('.');
+    if (pos==std::string::npos)
+        return fileMask+shardSuffix(index,count);
+
+    return fileMask.substr(0,pos)+shardSuffix(index,count)+fileMask.substr(pos);
+}
+
+std::string ReconShard::shardSuffix(size_t index, size_t count)
+{
+    std::ostringstream s;
+    s<<"_shard"<<index<<"of"<<count;
+
+    return s.str();
+}
+
+bool ReconShard::isNeXus(const ReconConfig &config)
+{
+    return (config.MatrixInfo.FileType==kipl::io::NeXusfloat) || (config.MatrixInfo.FileType==kipl::io::NeXus16bits);
+}
@@ -3,13 +3,14 @@
 #ifndef ADAPTIVEFILTER_H_
 #define ADAPTIVEFILTER_H_
 #include "StdPreprocModules_global.h"
+#include <vector>
 #include <base/timage.h>
 #include <math/LUTCollection.h>
-#include <PreprocModuleBase.h>
+#include <ParallelPreprocModuleBase.h>
 #include <ReconConfig.h>
 //#include "ReconEnums.h"
 
-class STDPREPROCMODULESSHARED_EXPORT AdaptiveFilter : public PreprocModuleBase
+class STDPREPROCMODULESSHARED_EXPORT AdaptiveFilter : public ParallelPreprocModuleBase
 {
 public:
     AdaptiveFilter(kipl::interactors::InteractionBase *interactor=nullptr);
@@ -21,9 +22,9 @@ public:
 
 	virtual std::map<std::string, std::string> GetParameters();
     int ProcessSingle(kipl::base::TImage<float,2> &img, std::map<std::string,std::string> &parameters); // moved here by Chiara
-    int ProcessCore(kipl::base::TImage<float,3> &img, std::map<std::string,std::string> &parameters);
 
 protected:
+    virtual int ProcessPlane(PlaneView &plane, Scratch &scratch, std::map<std::string,std::string> &parameters);
     int SimpleFilter(kipl::base::TImage<float,2> &img, std::map<std::string,std::string> &parameters);
     void MaxProfile(kipl::base::TImage<float,3> &img, kipl::base::TImage<float,2> &profile);
     void MinProfile(kipl::base::TImage<float,3> &img, kipl::base::TImage<float,2> &profile);
@@ -2,9 +2,9 @@
 #define CAMERASTRIPECLEAN_H
 
 #include "StdPreprocModules_global.h"
-#include <PreprocModuleBase.h>
+#include <ParallelPreprocModuleBase.h>
 
-class STDPREPROCMODULESSHARED_EXPORT CameraStripeClean : public PreprocModuleBase
+class STDPREPROCMODULESSHARED_EXPORT CameraStripeClean : public ParallelPreprocModuleBase
 {
 public:
     CameraStripeClean();
@@ -15,7 +15,8 @@ public:
     virtual bool SetROI(size_t *roi);
 protected:
     virtual int ProcessCore(kipl::base::TImage<float,2> & img, std::map<std::string, std::string> & coeff);
-    virtual int ProcessCore(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff);
+    using ParallelPreprocModuleBase::ProcessCore;
+    virtual int ProcessPlane(PlaneView &plane, Scratch &scratch, std::map<std::string, std::string> & coeff);
 
     float m_fThreshold;
 };
@@ -19,6 +19,8 @@ public:
 	virtual int Configure(ReconConfig config, std::map<std::string, std::string> parameters);
 	virtual std::map<std::string, std::string> GetParameters();
 	virtual bool SetROI(size_t *roi);
+	virtual bool IsPointwise();
+	virtual void ProcessPointwise(float *data, size_t N);
 protected:
 	virtual int ProcessCore(kipl::base::TImage<float,2> & img, std::map<std::string, std::string> & coeff);
 	virtual int ProcessCore(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff);
@@ -9,9 +9,10 @@
 #define MEDIANMIXRINGCLEAN_H_
 
 #include "StdPreprocModules_global.h"
-#include <PreprocModuleBase.h>
+#include <ParallelPreprocModuleBase.h>
+#include <filters/medianfilter.h>
 
-class STDPREPROCMODULESSHARED_EXPORT MedianMixRingClean: public PreprocModuleBase {
+class STDPREPROCMODULESSHARED_EXPORT MedianMixRingClean: public ParallelPreprocModuleBase {
 public:
 	MedianMixRingClean();
 	virtual ~MedianMixRingClean();
@@ -22,7 +23,17 @@ public:
 	void ProcessSinogram(kipl::base::TImage<float,2> &img, float *profile);
 	kipl::base::TImage<float,2> profile;
 protected:
-	virtual int ProcessCore(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff);
+	/// Per-thread median filter and plane copy
+	class MedianScratch : public Scratch {
+	public:
+		MedianScratch(size_t const * const dims);
+		size_t filtdims[2];
+		kipl::filters::TMedianFilter<float,2> medfilt;
+	};
+
+	virtual int PreparePlanes(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff);
+	virtual Scratch * CreateScratch(size_t const * const dims);
+	virtual int ProcessPlane(PlaneView &plane, Scratch &scratch, std::map<std::string, std::string> & coeff);
 	int ComputeProfile(kipl::base::TImage<float,3> & img);
 
 
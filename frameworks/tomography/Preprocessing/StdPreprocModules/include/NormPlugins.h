@@ -152,6 +152,8 @@ public:
 	virtual void LoadReferenceImages(size_t *roi);
 	virtual std::map<std::string, std::string> GetParameters();
 	virtual int Configure(ReconConfig config, std::map<std::string, std::string> parameters);
+	virtual bool IsPointwise();
+	virtual void ProcessPointwise(float *data, size_t N);
 
 protected:
 	virtual int ProcessCore(kipl::base::TImage<float,2> & img, std::map<std::string, string> & coeff);
@@ -17,6 +17,8 @@ public:
 	virtual std::map<std::string, std::string> GetParameters();
 	virtual bool SetROI(size_t *roi);
 	void PlotPolynomial(float *x, float *y, size_t N, float minX, float maxX);
+	virtual bool IsPointwise();
+	virtual void ProcessPointwise(float *data, size_t N);
 protected:
 	virtual int ProcessCore(kipl::base::TImage<float,2> & img, std::map<std::string, std::string> & coeff);
 	virtual int ProcessCore(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff);
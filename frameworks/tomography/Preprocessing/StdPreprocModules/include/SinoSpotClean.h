@@ -8,9 +8,9 @@
 #ifndef SINOSPOTCLEAN_H_
 #define SINOSPOTCLEAN_H_
 
-#include <PreprocModuleBase.h>
+#include <ParallelPreprocModuleBase.h>
 
-class SinoSpotClean: public PreprocModuleBase {
+class SinoSpotClean: public ParallelPreprocModuleBase {
 public:
 	SinoSpotClean();
 	virtual ~SinoSpotClean();
@@ -26,10 +26,10 @@ public:
 	}
 
 protected:
-	virtual int ProcessCore(kipl::base::TImage<float,3> &img, std::map<std::string,std::string> &parameters);
+	virtual int ProcessPlane(PlaneView &plane, Scratch &scratch, std::map<std::string,std::string> &parameters);
 	virtual int SourceVersion();
 
-	int CleanSinogramSpots(kipl::base::TImage<float,2> &img, int length, float th);
+	int CleanSinogramSpots(PlaneView &plane, kipl::base::TImage<float,2> &img, int length, float th);
 
 	int m_nFilterLength;
 	float m_fThreshold;
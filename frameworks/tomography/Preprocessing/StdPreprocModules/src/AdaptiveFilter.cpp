@@ -11,7 +11,7 @@
 #include <averageimage.h>
 
 AdaptiveFilter::AdaptiveFilter(kipl::interactors::InteractionBase *interactor) :
-    PreprocModuleBase("AdaptiveFilter",interactor),
+    ParallelPreprocModuleBase("AdaptiveFilter",SinogramPlane,interactor),
     mConfig(""),
     pLUT(nullptr),
     m_nFilterSize(7),
@@ -66,18 +66,11 @@ std::map<std::string, std::string> AdaptiveFilter::GetParameters()
     return parameters;
 }
 
-int AdaptiveFilter::ProcessCore(kipl::base::TImage<float,3> &img, std::map<std::string,std::string> &parameters)
+int AdaptiveFilter::ProcessPlane(PlaneView &plane, Scratch &scratch, std::map<std::string,std::string> &parameters)
 {
-
-    kipl::base::TImage<float,2> sinogram;
-
-    const size_t N=img.Size(1);
-    for (size_t i=0; (i<N) && (UpdateStatus(float(i)/N,m_sModuleName)==false); i++) {
-     //   std::cout<<"Processing sinogram "<<i<<std::endl;
-        ExtractSinogram(img,sinogram,i);
-        ProcessSingle(sinogram, parameters);
-        InsertSinogram(sinogram,img,i);
-    }
+    plane.CopyTo(scratch.plane);
+    ProcessSingle(scratch.plane, parameters);
+    plane.CopyFrom(scratch.plane);
 
 	return 0;
 }
@@ -133,8 +126,8 @@ int AdaptiveFilter::SimpleFilter(kipl::base::TImage<float,2> &img, std::map<std:
     // 1. compute smoothed max projection p(alfa) on sinograms, in pi/10 neighborhood-> that is not used later..
     // pi/10 of the neighborhood means 626 columns, each column is 0.58 degree, i want to threshold it on 18 degree, about 31 columns
 
-    float *pm = new float[img.Size(1)];
-    float *av_pm = new float[img.Size(1)];
+    std::vector<float> pm(img.Size(1));
+    std::vector<float> av_pm(img.Size(1));
 
 
     for (size_t i=0; i<img.Size(1); i++) { // for each sinogram row (i.e. for each angle) == iterate ALONG Y
@@ -152,11 +145,11 @@ int AdaptiveFilter::SimpleFilter(kipl::base::TImage<float,2> &img, std::map<std:
 
     float sum;
     // create pad array
-    float *pad_pm = new float[img.Size(1)+2*win]; // +1 ?
+    std::vector<float> pad_pm(img.Size(1)+2*win); // +1 ?
 
-    std::copy(pm+img.Size(1)-win, pm+img.Size(1), pad_pm);
-    std::copy(pm, pm+img.Size(1), pad_pm+win);
-    std::copy(pm, pm+win, pad_pm+win+img.Size(1));
+    std::copy(pm.begin()+img.Size(1)-win, pm.end(), pad_pm.begin());
+    std::copy(pm.begin(), pm.end(), pad_pm.begin()+win);
+    std::copy(pm.begin(), pm.begin()+win, pad_pm.begin()+win+img.Size(1));
 
 
 
@@ -194,9 +187,9 @@ int AdaptiveFilter::SimpleFilter(kipl::base::TImage<float,2> &img, std::map<std:
 
     // 2. compute p+(alfa) and p-(alfa) in +-pi/2 neighborhood, compute this time local minima and local maxima of p(alfa)
 
-    float *pMax = new float[img.Size(1)];
-    float *pMin = new float[img.Size(1)];
-    float *ecc = new float[img.Size(1)];
+    std::vector<float> pMax(img.Size(1));
+    std::vector<float> pMin(img.Size(1));
+    std::vector<float> ecc(img.Size(1));
 
     // padding
 
@@ -227,7 +220,7 @@ int AdaptiveFilter::SimpleFilter(kipl::base::TImage<float,2> &img, std::map<std:
 
         float ws, wo;
         float high, low, mid;
-        float *f_alfa = new float[img.Size(1)]; // fraction of modified projections
+        std::vector<float> f_alfa(img.Size(1)); // fraction of modified projections
         float counts = 0.0f;
 
 
@@ -1,4 +1,6 @@
 //#include "stdafx.h"
+#include <algorithm>
+
 #include "../include/StdPreprocModules_global.h"
 #include "../include/CameraStripeClean.h"
 #include <ParameterHandling.h>
@@ -7,6 +9,7 @@
 #include <filters/filter.h>
 
 CameraStripeClean::CameraStripeClean() :
+    ParallelPreprocModuleBase("CameraStripeClean",ProjectionPlane),
     m_fThreshold(50000.0f)
 {
 }
@@ -36,41 +39,54 @@ bool CameraStripeClean::SetROI(size_t *roi)
 
 int CameraStripeClean::ProcessCore(kipl::base::TImage<float,2> & img, std::map<std::string, std::string> & coeff)
 {
-    kipl::base::TImage<float,2> orig=img;
-    orig.Clone();
+    PlaneView plane(img.GetDataPtr(),img.Size(0),img.Size(1),img.Size(0),0);
+    Scratch scratch;
 
-    float *prev   = orig.GetLinePtr(0);
-    float *center = img.GetLinePtr(1);
-    float *next   = orig.GetLinePtr(2);
+    return ProcessPlane(plane,scratch,coeff);
+}
 
+int CameraStripeClean::ProcessPlane(PlaneView &plane, Scratch &scratch, std::map<std::string, std::string> & coeff)
+{
+    const size_t sx=plane.Size(0);
+    const size_t sy=plane.Size(1);
+
+    if (sy<2)
+        return 0;
+
+    // The plane is changed in place, the scratch image only keeps the original of the previous and the current line
+    size_t dims[2]={sx,2UL};
+    scratch.plane.Resize(dims);
+    float *prev = scratch.plane.GetLinePtr(0);
+    float *orig = scratch.plane.GetLinePtr(1);
+
+    // First line, the next line is still unchanged
+    float *center     = plane.GetLinePtr(0);
+    const float *next = plane.GetLinePtr(1);
+    std::copy_n(center,sx,prev);
+    for (size_t j=0; j<sx; j++) {
+        if (m_fThreshold<center[j]) {
+            center[j]=next[j];
+        }
+    }
 
-    int sx=img.Size(0);
-    for (size_t i=1; i<img.Size(1); i++)
+    for (size_t i=1; i<sy-1; i++)
     {
-        for (size_t j=0; j<img.Size(0); j++) {
+        center = plane.GetLinePtr(i);
+        next   = plane.GetLinePtr(i+1);
+        std::copy_n(center,sx,orig);
+
+        for (size_t j=0; j<sx; j++) {
             if (m_fThreshold<center[j]) {
                 center[j]=0.5f*(prev[j]+next[j]);
             }
         }
-        prev+=sx;
-        center+=sx;
-        next+=sx;
+        std::swap(prev,orig);
     }
 
-    // First line
-    center = img.GetLinePtr(0);
-    prev   = orig.GetLinePtr(1);
-    for (size_t j=0; j<img.Size(0); j++) {
-        if (m_fThreshold<center[j]) {
-            center[j]=prev[j];
-        }
-    }
-
-    // First line
-    center = img.GetLinePtr(img.Size(1)-1);
-    prev   = orig.GetLinePtr(img.Size(1)-2);
+    // Last line
+    center = plane.GetLinePtr(sy-1);
 
-    for (int j=0; j<img.Size(0); j++) {
+    for (size_t j=0; j<sx; j++) {
         if (m_fThreshold<center[j]) {
             center[j]=prev[j];
         }
@@ -78,16 +94,3 @@ int CameraStripeClean::ProcessCore(kipl::base::TImage<float,2> & img, std::map<s
 
     return 0;
 }
-
-int CameraStripeClean::ProcessCore(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff)
-{
-    kipl::base::TImage<float,2> proj(img.Dims());
-
-    for (int j=0; j<img.Size(2); j++) {
-        memcpy(proj.GetDataPtr(),img.GetLinePtr(0,j),proj.Size()*sizeof(float));
-        ProcessCore(proj,coeff);
-        memcpy(img.GetLinePtr(0,j),proj.GetDataPtr(),proj.Size()*sizeof(float));
-    }
-
-    return 0;
-}
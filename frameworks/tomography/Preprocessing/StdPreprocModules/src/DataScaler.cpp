@@ -58,24 +58,31 @@ bool DataScaler::SetROI(size_t *roi)
 	return false;
 }
 
-int DataScaler::ProcessCore(kipl::base::TImage<float,2> & img, std::map<std::string, std::string> & coeff)
+bool DataScaler::IsPointwise()
 {
-	float *pImg = img.GetDataPtr();
+	return true;
+}
 
-	for (size_t i=0; i<img.Size(); i++) {
-		pImg[i]=fSlope*pImg[i]+fOffset;
+void DataScaler::ProcessPointwise(float *data, size_t N)
+{
+	const float slope  = fSlope;
+	const float offset = fOffset;
+
+	for (size_t i=0; i<N; i++) {
+		data[i]=slope*data[i]+offset;
 	}
+}
+
+int DataScaler::ProcessCore(kipl::base::TImage<float,2> & img, std::map<std::string, std::string> & coeff)
+{
+	ProcessPointwise(img.GetDataPtr(),img.Size());
 
 	return 0;
 }
 
 int DataScaler::ProcessCore(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff)
 {
-	float *pImg = img.GetDataPtr();
-
-	for (size_t i=0; i<img.Size(); i++) {
-		pImg[i]=fSlope*pImg[i]+fOffset;
-	}
+	ProcessPointwise(img.GetDataPtr(),img.Size());
 
 	return 0;
 }
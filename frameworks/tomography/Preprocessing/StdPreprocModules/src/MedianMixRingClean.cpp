@@ -14,7 +14,7 @@
 #include "../include/MedianMixRingClean.h"
 
 MedianMixRingClean::MedianMixRingClean() :
-PreprocModuleBase("MedianMixRingClean"),
+ParallelPreprocModuleBase("MedianMixRingClean",ProjectionPlane),
 	m_fSigma(0.0025f),
 	m_fLambda(0.025f)
 {
@@ -48,7 +48,7 @@ bool MedianMixRingClean::SetROI(size_t *roi)
 	return false;
 }
 
-int MedianMixRingClean::ProcessCore(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff)
+int MedianMixRingClean::PreparePlanes(kipl::base::TImage<float,3> & img, std::map<std::string, std::string> & coeff)
 {
 	std::ostringstream msg;
 
@@ -62,27 +62,36 @@ int MedianMixRingClean::ProcessCore(kipl::base::TImage<float,3> & img, std::map<
 	weights=profile;
 	weights.Clone();
 
-    float *pImg=nullptr;
-	float *pWeights=weights.GetDataPtr();
-	mLUT.InPlace(pWeights,weights.Size());
+	mLUT.InPlace(weights.GetDataPtr(),weights.Size());
 
+	return 0;
+}
 
-	kipl::base::TImage<float,2> proj(img.Dims());
-	kipl::base::TImage<float,2> med(img.Dims());
+ParallelPreprocModuleBase::Scratch * MedianMixRingClean::CreateScratch(size_t const * const dims)
+{
+	return new MedianScratch(dims);
+}
 
-    size_t filtdims[2]={5UL, img.Size(1)<5UL ? 1UL : 5UL};
+MedianMixRingClean::MedianScratch::MedianScratch(size_t const * const dims) :
+	filtdims{5UL, dims[1]<5UL ? 1UL : 5UL},
+	medfilt(filtdims)
+{
+}
 
-	kipl::filters::TMedianFilter<float,2> medfilt(filtdims);
-	size_t N=proj.Size();
+int MedianMixRingClean::ProcessPlane(PlaneView &plane, Scratch &scratch, std::map<std::string, std::string> & coeff)
+{
+	MedianScratch &medScratch=dynamic_cast<MedianScratch &>(scratch);
 
-	for (size_t i=0; i<img.Size(2); i++) {
-		pImg=img.GetLinePtr(0,i);
+	plane.CopyTo(medScratch.plane);
+	kipl::base::TImage<float,2> med=medScratch.medfilt(medScratch.plane);
 
-		memcpy(proj.GetDataPtr(),pImg,N*sizeof(float));
-		med=medfilt(proj);
-		float *pMed=med.GetDataPtr();
+	const size_t sx=plane.Size(0);
+	for (size_t i=0; i<plane.Size(1); i++) {
+		float *pImg=plane.GetLinePtr(i);
+		const float *pMed=med.GetLinePtr(i);
+		const float *pWeights=weights.GetLinePtr(i);
 
-		for (size_t j=0; j<N; j++) {
+		for (size_t j=0; j<sx; j++) {
 			pImg[j]=(1-pWeights[j])*pImg[j]+pWeights[j]*pMed[j];
 		}
 	}
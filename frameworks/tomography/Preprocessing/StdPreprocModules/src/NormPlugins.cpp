@@ -926,32 +926,33 @@ std::map<std::string, std::string> LogProjection::GetParameters()
 
 void LogProjection::LoadReferenceImages(size_t *roi) {}
 
-int LogProjection::ProcessCore(kipl::base::TImage<float,2> & img, std::map<std::string, string> & coeff)
+bool LogProjection::IsPointwise()
 {
-	float *pImg=img.GetDataPtr();
+	return true;
+}
 
-	for (size_t i=0; i<img.Size(); i++) {
-		if (0.0f<pImg[i])
-			pImg[i]=fFactor*logf(pImg[i]);
-		else
-			pImg[i]=0.0f;
+void LogProjection::ProcessPointwise(float *data, size_t N)
+{
+	const float factor=fFactor;
 
+	for (size_t i=0; i<N; i++) {
+		if (0.0f<data[i])
+			data[i]=factor*logf(data[i]);
+		else
+			data[i]=0.0f;
 	}
+}
+
+int LogProjection::ProcessCore(kipl::base::TImage<float,2> & img, std::map<std::string, string> & coeff)
+{
+	ProcessPointwise(img.GetDataPtr(),img.Size());
 
 	return 0;
 }
 
 int LogProjection::ProcessCore(kipl::base::TImage<float,3> & img, std::map<std::string, string> & coeff)
 {
-	float *pImg=img.GetDataPtr();
-
-	for (size_t i=0; i<img.Size(); i++) {
-		if (0.0f<pImg[i])
-			pImg[i]=fFactor*logf(pImg[i]);
-		else
-			pImg[i]=0.0f;
-
-	}
+	ProcessPointwise(img.GetDataPtr(),img.Size());
 
 	return 0;
 }
@@ -66,6 +66,16 @@ void PolynomialCorrection::PlotPolynomial(float *x, float *y, size_t N, float mi
     std::copy_n(yy.begin(),yy.size(),y);
 }
 
+bool PolynomialCorrection::IsPointwise()
+{
+    return true;
+}
+
+void PolynomialCorrection::ProcessPointwise(float *data, size_t N)
+{
+    pc.processSpan(data,N);
+}
+
 int PolynomialCorrection::ProcessCore(kipl::base::TImage<float,2> & img, std::map<std::string, std::string> & coeff)
 {
     pc.processInplace(img.GetDataPtr(),img.Size());
@@ -3,7 +3,7 @@
 #include <filters/medianfilter.h>
 
 SinoSpotClean::SinoSpotClean() :
-	PreprocModuleBase("SinoSpotClean"),
+	ParallelPreprocModuleBase("SinoSpotClean",SinogramPlane),
 	m_nFilterLength(5),
 	m_fThreshold(1.0f)
 {
@@ -33,15 +33,11 @@ std::map<std::string, std::string> SinoSpotClean::GetParameters()
 	return parameters;
 }
 
-int SinoSpotClean::ProcessCore(kipl::base::TImage<float,3> &img, std::map<std::string,std::string> &parameters)
+int SinoSpotClean::ProcessPlane(PlaneView &plane, Scratch &scratch, std::map<std::string,std::string> &parameters)
 {
-	kipl::base::TImage<float,2> sino;
-	int N=static_cast<int>(img.Size(2));
-	for (int i=0 ; i<N; i++) {
-		ExtractSinogram(img,sino,i);
-		CleanSinogramSpots(sino,m_nFilterLength,m_fThreshold);
-		InsertSinogram(sino,img,i);
-	}
+	// The median filter needs a contiguous image, the cleaned values are written directly to the plane
+	plane.CopyTo(scratch.plane);
+	CleanSinogramSpots(plane,scratch.plane,m_nFilterLength,m_fThreshold);
 
 	return 0;
 }
@@ -51,7 +47,7 @@ int SinoSpotClean::SourceVersion()
 	return kipl::strings::VersionNumber("$Rev: 1314 $");
 }
 
-int SinoSpotClean::CleanSinogramSpots(kipl::base::TImage<float,2> &img, int length, float th)
+int SinoSpotClean::CleanSinogramSpots(PlaneView &plane, kipl::base::TImage<float,2> &img, int length, float th)
 {
 	int cnt=0;
 
@@ -66,15 +62,20 @@ int SinoSpotClean::CleanSinogramSpots(kipl::base::TImage<float,2> &img, int leng
 	kipl::base::TImage<float,2> filtered;
 
 	filtered=medfilt(img);
-	int N=static_cast<int>(img.Size());
-	float *pImg=img.GetDataPtr();
-	float *pFilt=filtered.GetDataPtr();
-
-	for (int i=0; i<N; i++) {
-		if (th<fabs(pImg[i]-pFilt[i]))
-			pImg[i]=pFilt[i];
+	const size_t sx=img.Size(0);
+
+	for (size_t i=0; i<img.Size(1); i++) {
+		const float *pImg=img.GetLinePtr(i);
+		const float *pFilt=filtered.GetLinePtr(i);
+		float *pPlane=plane.GetLinePtr(i);
+
+		for (size_t j=0; j<sx; j++) {
+			if (th<fabs(pImg[j]-pFilt[j])) {
+				pPlane[j]=pFilt[j];
+				cnt++;
+			}
+		}
 	}
 
-
 	return cnt;
 }
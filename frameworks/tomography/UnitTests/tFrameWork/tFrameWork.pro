@@ -82,7 +82,7 @@ win32 {
 CONFIG(release, debug|release): LIBS += -L$$PWD/../../../../../lib/
 else:CONFIG(debug, debug|release): LIBS += -L$$PWD/../../../../../lib/debug/
 
-LIBS += -lkipl -lModuleConfig -lReconFramework
+LIBS += -lkipl -lModuleConfig -lReconFramework -lImagingAlgorithms -lStdBackProjectors
 
 INCLUDEPATH += $$PWD/../../../../core/modules/ModuleConfig/include
 DEPENDPATH += $$PWD/../../../../core/modules/ModuleConfig/include
@@ -92,3 +92,9 @@ DEPENDPATH += $$PWD/../../../../core/kipl/kipl/include
 
 INCLUDEPATH += $$PWD/../../Framework/ReconFramework/include
 DEPENDPATH += $$PWD/../../Framework/ReconFramework/src
+
+INCLUDEPATH += $$PWD/../../../../core/algorithms/ImagingAlgorithms/include
+DEPENDPATH += $$PWD/../../../../core/algorithms/ImagingAlgorithms/include
+
+INCLUDEPATH += $$PWD/../../Backprojectors/StdBackProjectors/include
+DEPENDPATH += $$PWD/../../Backprojectors/StdBackProjectors/include
@@ -6,10 +6,20 @@
 #include <base/tsubimage.h>
 #include <io/io_fits.h>
 #include <io/io_tiff.h>
+#include <io/analyzefileext.h>
 
 #include <ProjectionReader.h>
 #include <ReconHelpers.h>
 #include <ReconException.h>
+#include <ReconEngine.h>
+#include <ReconShard.h>
+#include <ModuleItem.h>
+#include <MultiProjBP.h>
+#include <math/mathconstants.h>
+#include <strings/filenames.h>
+
+#include <cstdio>
+#include <fstream>
 
 
 class FrameWorkTest : public QObject
@@ -25,8 +35,16 @@ private Q_SLOTS:
     void testBuildFileList_GeneratedGolden();
     void testBuildFileList();
     void testBuildFileList2();
+    void testGeometryTrials();
+    void testReconShard_SliceRange();
+    void testReconShard_Merge();
+    void testExternalProjections();
 
 private:
+    ReconConfig shardConfig(size_t first, size_t last, size_t sliceBlock);
+    void writeShardManifest(const ReconConfig &config, size_t index, size_t count, size_t first, size_t last);
+    std::string shardSliceName(const ReconConfig &config, size_t slice);
+
     kipl::base::TImage<unsigned short,2> m_img;
     kipl::base::TImage<float,2> m_fimg;
 };
@@ -745,6 +763,361 @@ void FrameWorkTest::testBuildFileList2()
 //    QVERIFY(ProjectionList.size()==N);
 
 }
+void FrameWorkTest::testGeometryTrials()
+{
+    // Ramp filtered sinogram of two disks with the rotation axis at a known position
+    const size_t N=128;
+    const size_t nProj=180;
+    const float center=65.3f;
+    size_t dims[2]={N,nProj};
+    kipl::base::TImage<float,2> sino(dims);
+
+    std::vector<float> angles(nProj);
+    std::vector<float> weights(nProj,fPi/nProj);
+    std::vector<float> line(N);
+
+    for (size_t i=0; i<nProj; ++i) {
+        angles[i]=180.0f*i/nProj;
+        const float s=sin(angles[i]*fPi/180.0f);
+        const float c=cos(angles[i]*fPi/180.0f);
+
+        for (size_t u=0; u<N; ++u) {
+            const float d0=u-center;
+            const float d1=u-(center-20.0f*c-15.0f*s);
+            line[u]  = fabs(d0)<45.0f ? 2.0f*sqrt(45.0f*45.0f-d0*d0) : 0.0f;
+            line[u] += fabs(d1)<10.0f ? 2.0f*sqrt(10.0f*10.0f-d1*d1) : 0.0f;
+        }
+
+        // Ram-Lak filter in the spatial domain
+        for (size_t u=0; u<N; ++u) {
+            float sum=0.25f*line[u];
+            for (size_t v=(u+1)%2; v<N; v+=2) {
+                const float d=static_cast<float>(u)-static_cast<float>(v);
+                sum-=line[v]/(fPi*fPi*d*d);
+            }
+            sino(u,i)=sum;
+        }
+    }
+
+    std::vector<GeometryTrial> trials;
+    for (int i=-3; i<=3; ++i)
+        trials.push_back(GeometryTrial(center+i));
+
+    ReconEngine engine;
+    kipl::base::TImage<float,3> slices;
+    size_t best=engine.ProcessGeometryTrials(sino,angles,weights,0,trials,slices);
+
+    QCOMPARE(slices.Size(0),N);
+    QCOMPARE(slices.Size(1),N);
+    QCOMPARE(slices.Size(2),trials.size());
+    QCOMPARE(best,size_t(3));
+    QVERIFY(fabs(slices(N/2-1,N/2-1,best)-1.0f)<0.1f);
+
+    for (size_t i=0; i<trials.size(); ++i)
+        QVERIFY(trials[best].variation<=trials[i].variation);
+
+    QVERIFY_EXCEPTION_THROWN(engine.ProcessGeometryTrials(sino,std::vector<float>(),weights,0,trials,slices),ReconException);
+}
+
+ReconConfig FrameWorkTest::shardConfig(size_t first, size_t last, size_t sliceBlock)
+{
+    ReconConfig config("");
+
+    config.ProjectionInfo.roi[1] = first;
+    config.ProjectionInfo.roi[3] = last;
+    config.backprojector.parameters["SliceBlock"] = std::to_string(sliceBlock);
+    config.MatrixInfo.sDestinationPath = "./";
+    config.MatrixInfo.sFileMask = "shardslice_####.tif";
+    config.MatrixInfo.FileType  = kipl::io::TIFFfloat;
+
+    return config;
+}
+
+void FrameWorkTest::writeShardManifest(const ReconConfig &config, size_t index, size_t count, size_t first, size_t last)
+{
+    std::ofstream file(ReconShard::manifestName(config,index,count).c_str());
+
+    file<<"index="<<index<<"\n"
+        <<"count="<<count<<"\n"
+        <<"first="<<first<<"\n"
+        <<"last="<<last<<"\n"
+        <<"filetype="<<enum2string(config.MatrixInfo.FileType)<<"\n"
+        <<"file="<<config.MatrixInfo.sFileMask<<"\n"
+        <<"status=complete\n";
+}
+
+std::string FrameWorkTest::shardSliceName(const ReconConfig &config, size_t slice)
+{
+    std::string fname,ext;
+    kipl::strings::filenames::MakeFileName(config.MatrixInfo.sDestinationPath+config.MatrixInfo.sFileMask,static_cast<int>(slice),fname,ext,'#','0');
+
+    return fname;
+}
+
+void FrameWorkTest::testReconShard_SliceRange()
+{
+    // 100 slices in blocks of 8, the last block is partial
+    std::vector<size_t> counts={1,3,5,13};
+    for (auto count : counts) {
+        ReconConfig config=shardConfig(10,110,8);
+
+        size_t expected=10;
+        for (size_t i=0; i<count; ++i) {
+            ReconShard shard(i,count);
+            size_t first=0;
+            size_t last=0;
+            shard.sliceRange(config,first,last);
+
+            QCOMPARE(first,expected);
+            QVERIFY(first<last);
+            QVERIFY(((first-10)%8)==0);
+            expected=last;
+        }
+        QCOMPARE(expected,size_t(110));
+    }
+
+    // More shards than slice blocks, the shards without slices are empty
+    ReconConfig config=shardConfig(0,6,4);
+    const size_t count=5;
+    size_t expected=0;
+    size_t nEmpty=0;
+    for (size_t i=0; i<count; ++i) {
+        ReconShard shard(i,count);
+        size_t first=0;
+        size_t last=0;
+        shard.sliceRange(config,first,last);
+
+        QCOMPARE(first,expected);
+        QVERIFY(first<=last);
+        expected=last;
+
+        ReconConfig shardconfig=config;
+        const bool bSlices=shard.apply(shardconfig);
+        QCOMPARE(bSlices,first<last);
+        if (first==last) {
+            ++nEmpty;
+            QCOMPARE(shardconfig.ProjectionInfo.roi[1],config.ProjectionInfo.roi[1]);
+            QCOMPARE(shardconfig.ProjectionInfo.roi[3],config.ProjectionInfo.roi[3]);
+        }
+        else {
+            QCOMPARE(shardconfig.ProjectionInfo.roi[1],first);
+            QCOMPARE(shardconfig.ProjectionInfo.roi[3],last);
+        }
+    }
+    QCOMPARE(expected,size_t(6));
+    QCOMPARE(nEmpty,size_t(3));
+
+    // The index must be less than the count
+    QVERIFY_EXCEPTION_THROWN(ReconShard(3,3),ReconException);
+    QVERIFY_EXCEPTION_THROWN(ReconShard(4,3),ReconException);
+    QVERIFY_EXCEPTION_THROWN(ReconShard(0,0),ReconException);
+
+    // Multi-frame TIFF can't be written by independent shards
+    config.MatrixInfo.FileType=kipl::io::TIFF16bitsMultiFrame;
+    ReconShard shard(0,2);
+    QVERIFY_EXCEPTION_THROWN(shard.apply(config),ReconException);
+}
+
+void FrameWorkTest::testReconShard_Merge()
+{
+    const size_t count=3;
+    ReconConfig config=shardConfig(5,25,4);
+
+    size_t dims[2]={7,5};
+    kipl::base::TImage<float,2> slice(dims);
+
+    // Each shard writes its own slices of the stack
+    for (size_t i=0; i<count; ++i) {
+        ReconShard shard(i,count);
+        ReconConfig shardconfig=config;
+
+        QVERIFY_EXCEPTION_THROWN(shard.writeManifest(shardconfig),ReconException);
+        QVERIFY(shard.apply(shardconfig));
+        QCOMPARE(shardconfig.MatrixInfo.sFileMask,config.MatrixInfo.sFileMask);
+
+        for (size_t idx=shardconfig.ProjectionInfo.roi[1]; idx<shardconfig.ProjectionInfo.roi[3]; ++idx) {
+            slice=static_cast<float>(idx);
+            kipl::io::WriteTIFF32(slice,shardSliceName(config,idx).c_str());
+        }
+
+        shard.writeManifest(shardconfig);
+    }
+
+    ReconShard::merge(config,count);
+
+    kipl::base::TImage<float,2> res;
+    for (size_t idx=5; idx<25; ++idx) {
+        kipl::io::ReadTIFF(res,shardSliceName(config,idx).c_str());
+        QCOMPARE(res.Size(0),dims[0]);
+        QCOMPARE(res.Size(1),dims[1]);
+        QCOMPARE(res[0],static_cast<float>(idx));
+    }
+
+    // A missing slice file is detected
+    std::remove(shardSliceName(config,17).c_str());
+    QVERIFY_EXCEPTION_THROWN(ReconShard::merge(config,count),ReconException);
+    kipl::io::WriteTIFF32(slice,shardSliceName(config,17).c_str());
+    ReconShard::merge(config,count);
+
+    // The manifests are produced for another number of shards
+    QVERIFY_EXCEPTION_THROWN(ReconShard::merge(config,count+1),ReconException);
+
+    // Shards leaving a gap
+    writeShardManifest(config,1,count,10,17);
+    QVERIFY_EXCEPTION_THROWN(ReconShard::merge(config,count),ReconException);
+
+    // Overlapping shards
+    writeShardManifest(config,1,count,8,17);
+    QVERIFY_EXCEPTION_THROWN(ReconShard::merge(config,count),ReconException);
+
+    // Shards not reaching the end of the slice range
+    writeShardManifest(config,1,count,9,17);
+    writeShardManifest(config,2,count,17,24);
+    QVERIFY_EXCEPTION_THROWN(ReconShard::merge(config,count),ReconException);
+
+    writeShardManifest(config,2,count,17,25);
+    ReconShard::merge(config,count);
+
+    // A missing manifest is detected
+    std::remove(ReconShard::manifestName(config,0,count).c_str());
+    QVERIFY_EXCEPTION_THROWN(ReconShard::merge(config,count),ReconException);
+
+    for (size_t i=1; i<count; ++i)
+        std::remove(ReconShard::manifestName(config,i,count).c_str());
+
+    for (size_t idx=5; idx<25; ++idx)
+        std::remove(shardSliceName(config,idx).c_str());
+}
+
+void FrameWorkTest::testExternalProjections()
+{
+    // Ramp filtered projections of a large centered disk and a small off-center disk, the intensity increases with the slice
+    const size_t N=64;
+    const size_t nSlices=4;
+    const size_t nProj=90;
+    const float center=32.0f;
+    const float mc=static_cast<float>(N/2);
+    const size_t px=44;
+    const size_t py=24;
+
+    std::vector<float> angles(nProj);
+    std::vector<float> weights(nProj,fPi/nProj);
+    std::vector<float> line(N);
+    std::vector<float> buffer(nProj*nSlices*N); // Layout (projection, row, column)
+
+    for (size_t i=0; i<nProj; ++i) {
+        angles[i]=180.0f*i/nProj;
+        const float s=sin(angles[i]*fPi/180.0f);
+        const float c=cos(angles[i]*fPi/180.0f);
+        // Detector position of the small disk at pixel (px,py) with counter clockwise rotation
+        const float u0=center+c*(py+1-mc)-s*(px+1-mc);
+
+        for (size_t u=0; u<N; ++u) {
+            const float d0=u-center;
+            const float d1=u-u0;
+            line[u]  = fabs(d0)<24.0f ? 2.0f*sqrt(24.0f*24.0f-d0*d0) : 0.0f;
+            line[u] += fabs(d1)<5.0f ? 2.0f*sqrt(5.0f*5.0f-d1*d1) : 0.0f;
+        }
+
+        for (size_t u=0; u<N; ++u) {
+            float sum=0.25f*line[u];
+            for (size_t v=(u+1)%2; v<N; v+=2) {
+                const float d=static_cast<float>(u)-static_cast<float>(v);
+                sum-=line[v]/(fPi*fPi*d*d);
+            }
+            for (size_t slice=0; slice<nSlices; ++slice)
+                buffer[(i*nSlices+slice)*N+u]=(slice+1)*sum;
+        }
+    }
+
+    // The block wraps the buffer without copying it
+    std::vector<size_t> shape={nProj,nSlices,N};
+    std::vector<ptrdiff_t> strides={static_cast<ptrdiff_t>(nSlices*N*sizeof(float)),static_cast<ptrdiff_t>(N*sizeof(float)),sizeof(float)};
+    kipl::base::TImage<float,3> proj=ReconEngine::WrapExternalProjections(buffer.data(),shape,strides,true);
+
+    QVERIFY(proj.GetDataPtr()==buffer.data());
+    QCOMPARE(proj.Size(0),N);
+    QCOMPARE(proj.Size(1),nSlices);
+    QCOMPARE(proj.Size(2),nProj);
+
+    // Buffers that would have to be copied are rejected
+    QVERIFY_EXCEPTION_THROWN(ReconEngine::WrapExternalProjections(buffer.data(),shape,strides,false),ReconException);
+    QVERIFY_EXCEPTION_THROWN(ReconEngine::WrapExternalProjections(nullptr,shape,strides,true),ReconException);
+
+    std::vector<size_t> flatShape={nProj*nSlices,N};
+    std::vector<ptrdiff_t> flatStrides={strides[1],strides[2]};
+    QVERIFY_EXCEPTION_THROWN(ReconEngine::WrapExternalProjections(buffer.data(),flatShape,flatStrides,true),ReconException);
+
+    std::vector<size_t> stepShape={nProj,nSlices,N/2};
+    std::vector<ptrdiff_t> stepStrides={strides[0],strides[1],2*strides[2]};
+    QVERIFY_EXCEPTION_THROWN(ReconEngine::WrapExternalProjections(buffer.data(),stepShape,stepStrides,true),ReconException);
+
+    std::vector<size_t> transposedShape={N,nSlices,nProj};
+    std::vector<ptrdiff_t> transposedStrides={strides[2],strides[1],strides[0]};
+    QVERIFY_EXCEPTION_THROWN(ReconEngine::WrapExternalProjections(buffer.data(),transposedShape,transposedStrides,true),ReconException);
+
+    // The stride of a singleton dimension is arbitrary
+    std::vector<size_t> singleShape={1,nSlices,N};
+    std::vector<ptrdiff_t> singleStrides={0,strides[1],strides[2]};
+    kipl::base::TImage<float,3> single=ReconEngine::WrapExternalProjections(buffer.data(),singleShape,singleStrides,true);
+    QCOMPARE(single.Size(2),size_t(1));
+
+    ReconConfig config("");
+    config.ProjectionInfo.sFileMask   = "proj_####.tif";
+    config.ProjectionInfo.nFirstIndex = 2;
+    config.ProjectionInfo.fCenter     = center;
+    config.ProjectionInfo.beamgeometry = ReconConfig::cProjections::BeamGeometry_Parallel;
+    config.ProjectionInfo.eDirection  = kipl::base::RotationDirCCW;
+    config.ProjectionInfo.roi[0]=0;
+    config.ProjectionInfo.roi[1]=0;
+    config.ProjectionInfo.roi[2]=N;
+    config.ProjectionInfo.roi[3]=nSlices;
+    config.MatrixInfo.bAutomaticSerialize = false;
+
+    std::map<std::string, std::string> parameters;
+    parameters["ProjectionBufferSize"] = "16";
+    parameters["SliceBlock"]           = "32";
+    parameters["SubVolume"]            = "1 1";
+    parameters["filtertype"]           = "none";
+
+    MultiProjectionBP *bp=new MultiProjectionBP();
+    bp->Configure(config,parameters);
+
+    ReconEngine engine;
+    engine.SetConfig(config);
+    engine.SetBackProjector(new BackProjItem(bp));
+
+    // The lists must match the block
+    QVERIFY_EXCEPTION_THROWN(engine.ProcessExternalProjections(proj,std::vector<float>(nProj-1),weights),ReconException);
+    QVERIFY_EXCEPTION_THROWN(engine.ProcessExternalProjections(proj,angles,std::vector<float>(nProj+1)),ReconException);
+    QVERIFY_EXCEPTION_THROWN(engine.ProcessExternalProjections(proj,angles,weights,std::vector<float>(2,1.0f)),ReconException);
+
+    size_t wrongroi[4]={0,0,N,nSlices+1};
+    QVERIFY_EXCEPTION_THROWN(engine.ProcessExternalProjections(proj,angles,weights,std::vector<float>(),wrongroi),ReconException);
+
+    size_t roi[4]={0,0,N,nSlices};
+    QCOMPARE(engine.ProcessExternalProjections(proj,angles,weights,std::vector<float>(nProj,1.0f),roi),0);
+
+    kipl::base::TImage<float,3> volume=engine.GetVolume();
+    QCOMPARE(volume.Size(0),N);
+    QCOMPARE(volume.Size(1),N);
+    QCOMPARE(volume.Size(2),nSlices);
+
+    for (size_t slice=0; slice<nSlices; ++slice) {
+        const float scale=slice+1.0f;
+        QVERIFY(fabs(volume(N/2,N/2,slice)-scale)<0.1f*scale);
+        QVERIFY(fabs(volume(px,py,slice)-2.0f*scale)<0.2f*scale);
+        QVERIFY(fabs(volume(N-px,N-py,slice)-scale)<0.1f*scale);
+        QVERIFY(fabs(volume(N/2,N/16,slice))<0.1f*scale);
+    }
+
+    // Only parallel beam is supported
+    config.ProjectionInfo.beamgeometry = ReconConfig::cProjections::BeamGeometry_Cone;
+    ReconEngine coneEngine;
+    coneEngine.SetConfig(config);
+    QVERIFY_EXCEPTION_THROWN(coneEngine.ProcessExternalProjections(proj,angles,weights),ReconException);
+}
+
 QTEST_APPLESS_MAIN(FrameWorkTest)
 
 #include "tst_frameworktest.moc"
@@ -1,4 +1,6 @@
 #include <list>
+#include <vector>
+#include <cmath>
 
 #include <QString>
 #include <QtTest>
@@ -9,6 +11,7 @@
 #include <basicforwardprojector.h>
 #include <nnforwardprojector.h>
 #include <linearforwardprojector.h>
+#include <linearbackprojector.h>
 
 class AlgorithmTesterTest : public QObject
 {
@@ -20,6 +23,7 @@ public:
 private Q_SLOTS:
     void testNN();
     void testLinearFwd();
+    void testLinearMatchedPair();
 };
 
 AlgorithmTesterTest::AlgorithmTesterTest()
@@ -89,6 +93,48 @@ void AlgorithmTesterTest::testLinearFwd()
 
   //  QVERIFY2(true, "Failure");
 }
+void AlgorithmTesterTest::testLinearMatchedPair()
+{
+    std::vector<float> angles;
+    for (int i=0; i<37; i++)
+        angles.push_back(i*180.0f/37.0f+3.3f);
+
+    size_t dims[3]={64,64,3};
+    kipl::base::TImage<float,3> slices(dims);
+    for (size_t i=0; i<slices.Size(); i++)
+        slices[i]=static_cast<float>((i*7919) % 101)/101.0f;
+
+    LinearForwardProjector fp;
+    LinearBackProjector bp;
+    const float center=30.3f;
+
+    kipl::base::TImage<float,3> proj;
+    fp.project(slices,angles,center,proj);
+    QCOMPARE(proj.Size(0),slices.Size(0));
+    QCOMPARE(proj.Size(1),angles.size());
+    QCOMPARE(proj.Size(2),slices.Size(2));
+
+    kipl::base::TImage<float,3> sino(proj.Dims());
+    for (size_t i=0; i<sino.Size(); i++)
+        sino[i]=static_cast<float>((i*104729) % 97)/97.0f;
+
+    kipl::base::TImage<float,3> bpslices;
+    bp.backproject(sino,center,angles,bpslices);
+    QCOMPARE(bpslices.Size(0),slices.Size(0));
+    QCOMPARE(bpslices.Size(2),slices.Size(2));
+
+    // The back-projector must be the transpose of the forward projector, i.e. <Ax,y> = <x,A'y>
+    double sumProj=0.0;
+    for (size_t i=0; i<proj.Size(); i++)
+        sumProj+=static_cast<double>(proj[i])*sino[i];
+
+    double sumSlices=0.0;
+    for (size_t i=0; i<slices.Size(); i++)
+        sumSlices+=static_cast<double>(slices[i])*bpslices[i];
+
+    QVERIFY(std::fabs(sumProj-sumSlices)<1e-4*std::fabs(sumProj));
+}
+
 QTEST_APPLESS_MAIN(AlgorithmTesterTest)
 
 #include "tst_algorithmtestertest.moc"
@@ -0,0 +1,137 @@
+//<LICENSE>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include <QString>
+#include <QtTest>
+
+#include <MultiProjBP.h>
+#include <ReconConfig.h>
+#include <base/timage.h>
+#include <math/mathconstants.h>
+
+class TStdBackProjectorsTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    TStdBackProjectorsTest();
+
+private Q_SLOTS:
+    void testBlockProcessing();
+    void testBlockProcessingFiltered();
+
+private:
+    kipl::base::TImage<float,3> makeProjections(float *angles, float *weights);
+    void compareBlockProcessing(const std::string &filtertype);
+
+    static const size_t nProjections=20;
+    static const size_t nSizeU=64;
+    static const size_t nSizeV=8;
+};
+
+TStdBackProjectorsTest::TStdBackProjectorsTest()
+{
+}
+
+kipl::base::TImage<float,3> TStdBackProjectorsTest::makeProjections(float *angles, float *weights)
+{
+    // Projections of an off-center blob with a slice dependent intensity
+    size_t dims[3]={nSizeU,nSizeV,nProjections};
+    kipl::base::TImage<float,3> proj(dims);
+
+    for (size_t i=0; i<nProjections; ++i) {
+        angles[i]  = 180.0f*i/nProjections;
+        weights[i] = fPi/nProjections;
+
+        const float center = nSizeU/2+8.0f*cos(angles[i]*fPi/180.0f);
+        for (size_t v=0; v<nSizeV; ++v) {
+            float *pLine=proj.GetLinePtr(v,i);
+            for (size_t u=0; u<nSizeU; ++u) {
+                const float d=static_cast<float>(u)-center;
+                pLine[u]=(1.0f+0.1f*v)*exp(-d*d/20.0f);
+            }
+        }
+    }
+
+    return proj;
+}
+
+void TStdBackProjectorsTest::testBlockProcessing()
+{
+    compareBlockProcessing("none");
+}
+
+void TStdBackProjectorsTest::testBlockProcessingFiltered()
+{
+    compareBlockProcessing("hamming");
+}
+
+void TStdBackProjectorsTest::compareBlockProcessing(const std::string &filtertype)
+{
+    ReconConfig config("");
+    config.ProjectionInfo.fCenter = nSizeU/2;
+
+    std::map<std::string, std::string> parameters;
+    parameters["ProjectionBufferSize"] = "8";
+    parameters["SliceBlock"]           = "32";
+    parameters["SubVolume"]            = "1 1";
+    parameters["filtertype"]           = filtertype;
+    parameters["cutoff"]               = "0.5";
+
+    float angles[nProjections];
+    float weights[nProjections];
+    kipl::base::TImage<float,3> proj=makeProjections(angles,weights);
+
+    size_t roi[4]={0,0,nSizeU,nSizeV};
+
+    // The reference is back-projected one projection at a time, the buffer is flushed twice before the last projection
+    MultiProjectionBP single;
+    single.Configure(config,parameters);
+    single.SetROI(roi);
+
+    size_t projDims[2]={nSizeU,nSizeV};
+    for (size_t i=0; i<nProjections; ++i) {
+        kipl::base::TImage<float,2> img(projDims);
+        std::copy_n(proj.GetLinePtr(0,i),img.Size(),img.GetDataPtr());
+        single.Process(img,angles[i],weights[i],i==nProjections-1);
+    }
+
+    std::ostringstream angleStr, weightStr;
+    for (size_t i=0; i<nProjections; ++i) {
+        angleStr<<angles[i]<<" ";
+        weightStr<<weights[i]<<" ";
+    }
+
+    std::map<std::string, std::string> blockParameters;
+    blockParameters["angles"]  = angleStr.str();
+    blockParameters["weights"] = weightStr.str();
+
+    MultiProjectionBP block;
+    block.Configure(config,parameters);
+    block.SetROI(roi);
+    block.Process(proj,blockParameters);
+
+    kipl::base::TImage<float,3> expected=single.GetVolume();
+    kipl::base::TImage<float,3> result=block.GetVolume();
+
+    QCOMPARE(result.Size(),expected.Size());
+
+    float maxValue=0.0f;
+    for (size_t i=0; i<expected.Size(); ++i)
+        maxValue=std::max(maxValue,std::abs(expected[i]));
+
+    QVERIFY(0.0f<maxValue);
+
+    // The projections are summed in different batches, only the rounding may differ
+    for (size_t i=0; i<expected.Size(); ++i)
+        QVERIFY2(std::abs(result[i]-expected[i])<=1e-5f*maxValue,"The block back-projection differs from the single projection back-projection");
+}
+
+QTEST_APPLESS_MAIN(TStdBackProjectorsTest)
+
+#include "tst_tstdbackprojectorstest.moc"
@@ -6,6 +6,10 @@
 #include <QtTest>
 
 #include <MorphSpotCleanModule.h>
+#include <CameraStripeClean.h>
+#include <SinoSpotClean.h>
+#include <PolynomialCorrectionModule.h>
+#include <DataScaler.h>
 #include <ModuleException.h>
 #include <strings/filenames.h>
 #include <io/io_tiff.h>
@@ -22,6 +26,9 @@ private Q_SLOTS:
     void testFullLogNorm();
     void testMorpSpotClean_Initialize();
     void testMorpSpotClean_Process();
+    void testCameraStripeClean_Process();
+    void testSinoSpotClean_Process();
+    void testPointwiseKernels();
 };
 
 TStdPreprocModulesTest::TStdPreprocModulesTest()
@@ -142,6 +149,92 @@ void TStdPreprocModulesTest::testMorpSpotClean_Process()
 
 }
 
+void TStdPreprocModulesTest::testCameraStripeClean_Process()
+{
+    CameraStripeClean csc;
+    std::map<std::string,std::string> parameters;
+
+    size_t dims[3]={16,8,4};
+    kipl::base::TImage<float,3> img(dims);
+
+    for (size_t z=0; z<img.Size(2); ++z)
+        for (size_t y=0; y<img.Size(1); ++y)
+            std::fill_n(img.GetLinePtr(y,z),img.Size(0),static_cast<float>(y));
+
+    img(5,3,2)=1.0e6f; // Interior line, replaced by the mean of the neighbors
+    img(2,0,1)=1.0e6f; // First line, replaced by the next line
+    img(9,7,3)=1.0e6f; // Last line, replaced by the previous line
+    img(7,4,0)=1.0e6f; // Two consecutive lines, both use the original neighbors
+    img(7,5,0)=1.0e6f;
+
+    csc.Process(img,parameters);
+
+    QCOMPARE(img(5,3,2),3.0f);
+    QCOMPARE(img(2,0,1),1.0f);
+    QCOMPARE(img(9,7,3),6.0f);
+    QCOMPARE(img(4,3,2),3.0f);
+    QCOMPARE(img(7,4,0),0.5f*(3.0f+1.0e6f));
+    QCOMPARE(img(7,5,0),0.5f*(1.0e6f+6.0f));
+}
+
+void TStdPreprocModulesTest::testSinoSpotClean_Process()
+{
+    SinoSpotClean ssc;
+    std::map<std::string,std::string> parameters;
+
+    size_t dims[3]={16,6,32};
+    kipl::base::TImage<float,3> img(dims);
+    img=0.0f;
+
+    // One spot in each sinogram, the sinograms are distributed over the threads
+    for (size_t y=0; y<img.Size(1); ++y)
+        img(7,y,10+y)=10.0f;
+
+    ssc.Process(img,parameters);
+
+    for (size_t y=0; y<img.Size(1); ++y)
+        QCOMPARE(img(7,y,10+y),0.0f);
+}
+
+void TStdPreprocModulesTest::testPointwiseKernels()
+{
+    ReconConfig config("");
+    std::map<std::string,std::string> parameters;
+    parameters["order"]="3";
+    parameters["coefficents"]="0.1 0.9 0.05 0.01";
+    parameters["offset"]="0.5";
+    parameters["slope"]="2";
+
+    PolynomialCorrection pc;
+    pc.Configure(config,parameters);
+    DataScaler ds;
+    ds.Configure(config,parameters);
+
+    QVERIFY(pc.IsPointwise());
+    QVERIFY(ds.IsPointwise());
+
+    size_t dims[3]={13,7,5};
+    kipl::base::TImage<float,3> img(dims);
+    for (size_t i=0; i<img.Size(); ++i)
+        img[i]=0.01f*static_cast<float>(i);
+
+    kipl::base::TImage<float,3> fused;
+    fused.Clone(img);
+
+    pc.Process(img,parameters);
+    ds.Process(img,parameters);
+
+    // The kernels must give the same result when applied on arbitrary spans
+    for (size_t pos=0; pos<fused.Size(); pos+=17) {
+        size_t N=std::min(static_cast<size_t>(17),fused.Size()-pos);
+        pc.ProcessPointwise(fused.GetDataPtr()+pos,N);
+        ds.ProcessPointwise(fused.GetDataPtr()+pos,N);
+    }
+
+    for (size_t i=0; i<img.Size(); ++i)
+        QCOMPARE(fused[i],img[i]);
+}
+
 QTEST_APPLESS_MAIN(TStdPreprocModulesTest)
 
 #include "tst_tstdpreprocmodulestest.moc"
@@ -4,7 +4,12 @@
 #include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
+#include <vector>
+#include <stdexcept>
+
+#include <base/timage.h>
 #include <ReconEngine.h>
+#include <ReconException.h>
 
 namespace py = pybind11;
 
@@ -16,6 +21,65 @@ void bindReconEngine(py::module &m)
 
     reClass.def("Run3D",&ReconEngine::Run3D,"Starts the reconstruction process.");
 
+    reClass.def("process",
+                [](ReconEngine &re,
+                   py::array &projections,
+                   py::array_t<float, py::array::c_style | py::array::forcecast> &angles,
+                   py::array_t<float, py::array::c_style | py::array::forcecast> &weights,
+                   py::array_t<float, py::array::c_style | py::array::forcecast> &doses,
+                   std::vector<size_t> roi)
+                {
+                    // A converted copy would receive the result instead of the caller's array
+                    if (!py::isinstance<py::array_t<float>>(projections))
+                        throw py::value_error("The projections must be a float32 array");
+
+                    py::buffer_info buf = projections.request();
+
+                    kipl::base::TImage<float,3> proj;
+                    try
+                    {
+                        proj = ReconEngine::WrapExternalProjections(static_cast<float*>(buf.ptr),
+                                                                    std::vector<size_t>(buf.shape.begin(),buf.shape.end()),
+                                                                    std::vector<ptrdiff_t>(buf.strides.begin(),buf.strides.end()),
+                                                                    projections.writeable());
+                    }
+                    catch (ReconException &e)
+                    {
+                        throw py::value_error(e.what());
+                    }
+
+                    auto toVector = [](py::array_t<float, py::array::c_style | py::array::forcecast> &a)
+                    {
+                        return std::vector<float>(a.data(),a.data()+a.size());
+                    };
+
+                    if (!roi.empty() && (roi.size()!=4))
+                        throw std::runtime_error("The roi must have four elements (x0,y0,x1,y1)");
+
+                    std::vector<float> angleList  = toVector(angles);
+                    std::vector<float> weightList = toVector(weights);
+                    std::vector<float> doseList   = toVector(doses);
+
+                    py::gil_scoped_release release;
+                    return re.ProcessExternalProjections(proj,
+                                                         angleList,
+                                                         weightList,
+                                                         doseList,
+                                                         roi.empty() ? nullptr : roi.data());
+                },
+                "Preprocesses and back-projects a block of projections without reading files. "
+                "The projections are processed in-place, i.e. the array is modified. "
+                "The array must be a writeable C-contiguous float32 array, otherwise a ValueError is raised.",
+                py::arg("projections"),
+                py::arg("angles"),
+                py::arg("weights"),
+                py::arg("doses")=py::array_t<float>(0),
+                py::arg("roi")=std::vector<size_t>());
+
+    reClass.def("volume",
+                &ReconEngine::GetVolume,
+                "Returns the reconstructed volume. Use numpy.asarray on the result to access the data without copying.");
+
 //    sfClass.def("configure",
 //                &ImagingAlgorithms::StripeFilter::configure,
 //                "Configures the stripe filter. Note: the dims are given in x,y instead of r,c."
@@ -0,0 +1,109 @@
+//<LICENSE>
+#ifdef HAVEPYBIND11
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <sstream>
+#include <string>
+
+#include <base/timage.h>
+
+namespace py = pybind11;
+
+/// \brief Exposes a kipl image through the buffer protocol.
+///
+/// The numpy shape is the reversed kipl dimension array, i.e. (z,y,x) for a 3D image,
+/// since the first kipl dimension has the fastest index increment.
+template <size_t N>
+void bindTImage(py::module &m, const std::string &name)
+{
+    using Image = kipl::base::TImage<float,N>;
+
+    py::class_<Image> imgClass(m, name.c_str(), py::buffer_protocol());
+
+    imgClass.def(py::init());
+
+    // Wraps the buffer of the python object without copying. The python object is kept alive as long as the image exists.
+    imgClass.def(py::init([](py::buffer b)
+                 {
+                     py::buffer_info info = b.request(true);
+
+                     if (info.format != py::format_descriptor<float>::format())
+                         throw std::runtime_error("The image buffer must contain float32 data");
+
+                     if (info.ndim != static_cast<py::ssize_t>(N))
+                     {
+                         std::ostringstream msg;
+                         msg<<"The image buffer must have "<<N<<" dimensions, got "<<info.ndim;
+                         throw std::runtime_error(msg.str());
+                     }
+
+                     size_t dims[N];
+                     py::ssize_t stride = static_cast<py::ssize_t>(sizeof(float));
+                     for (size_t i=0; i<N; ++i)
+                     {
+                         dims[i] = static_cast<size_t>(info.shape[N-1-i]);
+                         if (info.strides[N-1-i] != stride)
+                             throw std::runtime_error("The image buffer must be C-contiguous");
+                         stride *= info.shape[N-1-i];
+                     }
+
+                     return new Image(static_cast<float *>(info.ptr),dims);
+                 }),
+                 py::keep_alive<1,2>(),
+                 "Wraps a C-contiguous float32 array without copying the data.",
+                 py::arg("array"));
+
+    imgClass.def_buffer([](Image &img) -> py::buffer_info
+                        {
+                            std::vector<py::ssize_t> shape(N);
+                            std::vector<py::ssize_t> strides(N);
+                            py::ssize_t stride = static_cast<py::ssize_t>(sizeof(float));
+
+                            for (size_t i=0; i<N; ++i)
+                            {
+                                shape[N-1-i]   = static_cast<py::ssize_t>(img.Size(i));
+                                strides[N-1-i] = stride;
+                                stride *= static_cast<py::ssize_t>(img.Size(i));
+                            }
+
+                            return py::buffer_info(img.GetDataPtr(),
+                                                   sizeof(float),
+                                                   py::format_descriptor<float>::format(),
+                                                   N,
+                                                   shape,
+                                                   strides);
+                        });
+
+    imgClass.def("dims",
+                 [](const Image &img)
+                 {
+                     return std::vector<size_t>(img.Dims(),img.Dims()+N);
+                 },
+                 "Returns the image dimensions with the fastest index first.");
+
+    imgClass.def("size",
+                 [](const Image &img) { return img.Size(); },
+                 "Returns the number of pixels in the image.");
+
+    imgClass.def("haveExternalBuffer",
+                 &Image::haveExternalBuffer,
+                 "Returns true if the image wraps a buffer owned by another object.");
+
+    imgClass.def("__repr__",
+                 [](const Image &img)
+                 {
+                     std::ostringstream msg;
+                     msg<<img;
+                     return msg.str();
+                 });
+}
+
+void bindTImage(py::module &m)
+{
+    bindTImage<2>(m, "Image2D");
+    bindTImage<3>(m, "Image3D");
+}
+
+#endif
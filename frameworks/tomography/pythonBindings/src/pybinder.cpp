@@ -7,11 +7,13 @@
 
 namespace py = pybind11;
 
+void bindTImage(py::module& m);
 void bindReconFactory(py::module& m);
 void bindReconEngine(py::module& m);
 
 PYBIND11_MODULE(muhrectomo, m)
 {
+    bindTImage(m);
     bindReconFactory(m);
     bindReconEngine(m);
 